@@ -43,6 +43,8 @@ $OUTPUT_DIR/ThreadController_UT
 $OUTPUT_DIR/Timer_UT
 $OUTPUT_DIR/AQueue_UT
 $OUTPUT_DIR/SchTask_UT
+$OUTPUT_DIR/ThreadPool_UT
+$OUTPUT_DIR/SeqLock_UT
 
 # unit tests: buffer
 $OUTPUT_DIR/Buffer_UT
@@ -59,6 +61,8 @@ rm -rf ./logs
 rm -rf /tmp/*log
 rm -rf /tmp/*txt
 $OUTPUT_DIR/LogFile_UT
+$OUTPUT_DIR/MpscRing_UT
+$OUTPUT_DIR/RxCapture_UT
 
 # unit tests: io
 $OUTPUT_DIR/Socket_UT
@@ -77,6 +81,7 @@ $OUTPUT_DIR/FixParser_UT
 $OUTPUT_DIR/FixRecorder_UT
 $OUTPUT_DIR/FixFeeder_UT
 $OUTPUT_DIR/FixSender_UT
+$OUTPUT_DIR/FixShard_UT
 ./t_FixReceiver.sh
 
 { set +x; } 2>/dev/null
@@ -1,6 +1,7 @@
 ﻿// \file f9tws/ExgMktFeeder.cpp
 // \author fonwinz@gmail.com
 #include "f9tws/ExgMktFeeder.hpp"
+#include "fon9/buffer/DcQueueList.hpp"
 
 namespace f9tws {
 
@@ -56,4 +57,24 @@ void ExgMktFeeder::FeedBuffer(fon9::DcQueue& rxbuf) {
    }
 }
 
+
+uint64_t ExgMktFeeder::FeedCapture(fon9::RxCaptureReader& reader, fon9::RxReplayPacer& pacer, int lineId) {
+   fon9::DcQueueList rxbuf;
+   return fon9::RxCaptureReplay(reader, pacer, [this, &rxbuf, lineId](const fon9::RxCaptureRecord& rec, const void* dat) {
+      if (lineId >= 0 && rec.LineId_ != static_cast<uint32_t>(lineId))
+         return;
+      if (!rxbuf.empty()) {
+         rxbuf.Append(dat, rec.Size_);
+         this->FeedBuffer(rxbuf, rec.RxTime_);
+         return;
+      }
+      // 大部分情況: 一筆記錄包含完整的封包, 直接使用記錄內容, 不用複製.
+      fon9::DcQueueFixedMem dcq{dat, rec.Size_};
+      this->FeedBuffer(dcq, rec.RxTime_);
+      auto remain = dcq.PeekCurrBlock();
+      if (remain.second > 0)
+         rxbuf.Append(remain.first, remain.second);
+   });
+}
+
 } // namespaces
@@ -4,6 +4,7 @@
 #define __f9tws_ExgMktFeedert_hpp__
 #include "f9tws/ExgMktFmt.hpp"
 #include "fon9/buffer/DcQueue.hpp"
+#include "fon9/RxCapture.hpp"
 
 namespace f9tws {
 
@@ -19,6 +20,17 @@ public:
    /// 收到的訊息透過這裡處理.
    /// 返回時機: rxbuf 用完, 或 rxbuf 剩餘資料不足一個封包.
    void FeedBuffer(fon9::DcQueue& rxbuf);
+   /// 提供收到資料的時間(例: io::Device::GetRecvTime()), 衍生者可在 ExgMktOnReceived() 透過 RxTime_ 計算延遲.
+   void FeedBuffer(fon9::DcQueue& rxbuf, fon9::TimeStamp rxTime) {
+      this->RxTime_ = rxTime;
+      this->FeedBuffer(rxbuf);
+   }
+
+   /// 重播 fon9::RxCaptureSession 錄製的資料: 依照 pacer 的速度, 將每筆記錄透過 FeedBuffer(rxbuf, rec.RxTime_) 處理.
+   /// - 若 lineId >= 0, 則只處理該線路的記錄.
+   /// - 若不是 IsDgram_, 則記錄之間不足一個封包的資料, 會與下一筆記錄串接.
+   /// \return 讀取的記錄數量.
+   uint64_t FeedCapture(fon9::RxCaptureReader& reader, fon9::RxReplayPacer& pacer, int lineId = -1);
 
    void ClearStatus() {
       this->ReceivedCount_ = 0;
@@ -37,6 +49,8 @@ protected:
    /// 若使用 IsDgram_ 則 FeedBuffer(rxbuf) 每次都只會收到一個完整封包,
    /// 若返回前 rxbuf 有剩餘, 表示資料有誤, 直接拋棄剩餘資料.
    bool     IsDgram_{false};
+   /// 收到資料的時間, 若呼叫端沒有提供, 則為 TimeStamp::Null().
+   fon9::TimeStamp   RxTime_{fon9::TimeStamp::Null()};
 
    /// 當收到封包時透過這裡通知衍生者.
    virtual void ExgMktOnReceived(const ExgMktHeader& pk, unsigned pksz) = 0;
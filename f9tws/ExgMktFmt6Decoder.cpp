@@ -0,0 +1,193 @@
+﻿// \file f9tws/ExgMktFmt6Decoder.cpp
+// \author fonwinz@gmail.com
+#include "f9tws/ExgMktFmt6Decoder.hpp"
+#include "fon9/PackBcdSimd.hpp"
+
+namespace f9tws {
+
+/// Pack BCD 的 1 byte(2 位數字) => 0..99
+struct BcdTable {
+   fon9::byte  Value_[256];
+   BcdTable() {
+      for (unsigned L = 0; L < 256; ++L)
+         this->Value_[L] = static_cast<fon9::byte>((L >> 4) * 10 + (L & 0x0f));
+   }
+};
+static const BcdTable   kBcdTable;
+
+template <unsigned N>
+struct BcdBytes {
+   static uint64_t To(const fon9::byte* pbcd) {
+      return BcdBytes<N - 1>::To(pbcd) * 100 + kBcdTable.Value_[pbcd[N - 1]];
+   }
+};
+template <>
+struct BcdBytes<1> {
+   static uint64_t To(const fon9::byte* pbcd) {
+      return kBcdTable.Value_[*pbcd];
+   }
+};
+template <unsigned N>
+static inline uint64_t BcdTo(const fon9::byte (&pbcd)[N]) {
+   return BcdBytes<N>::To(pbcd);
+}
+
+/// ItemMask_ => 成交、買進、賣出的檔數.
+struct ItemMaskInfo {
+   fon9::byte        DealCount_;
+   fon9::byte        BuyCount_;
+   fon9::byte        SellCount_;
+   /// 全部的檔數, kInvalidPQCount 表示 ItemMask_ 有誤(買進或賣出超過 5 檔).
+   fon9::byte        PQCount_;
+   ExgMktFmt6Updated Updated_;
+};
+enum : fon9::byte {
+   kInvalidPQCount = 0xff,
+};
+struct ItemMaskTable {
+   ItemMaskInfo   Info_[256];
+   ItemMaskTable() {
+      for (unsigned L = 0; L < 256; ++L) {
+         ItemMaskInfo& info = this->Info_[L];
+         info.DealCount_ = static_cast<fon9::byte>(L >> 7);
+         info.BuyCount_ = static_cast<fon9::byte>((L >> 4) & 0x07);
+         info.SellCount_ = static_cast<fon9::byte>((L >> 1) & 0x07);
+         info.PQCount_ = (info.BuyCount_ > fon9::fmkt::SymbBS::kBSCount || info.SellCount_ > fon9::fmkt::SymbBS::kBSCount)
+            ? static_cast<fon9::byte>(kInvalidPQCount)
+            : static_cast<fon9::byte>(info.DealCount_ + info.BuyCount_ + info.SellCount_);
+         info.Updated_ = ExgMktFmt6Updated::None;
+         if (info.DealCount_)
+            info.Updated_ |= ExgMktFmt6Updated::Deal;
+         // Bit 0 = 1: 非最後一個成交價量揭示, 僅揭示成交價量但不揭示最佳五檔.
+         if ((L & 0x7e) || (L & 0x01) == 0)
+            info.Updated_ |= ExgMktFmt6Updated::BS;
+      }
+   }
+};
+static const ItemMaskTable kItemMaskTable;
+
+/// pq[0] = PackBcdTo(ExgMktPriQty::PriV2_); pq[1] = PackBcdTo(ExgMktPriQty::Qty_);
+static inline void AssignPQ(fon9::fmkt::PriQty& dst, const uint32_t* pq) {
+   dst.Pri_.Assign<2>(static_cast<int64_t>(pq[0]));
+   dst.Qty_ = pq[1];
+}
+static inline const uint32_t* AssignBS(fon9::fmkt::PriQty* dst, const uint32_t* pqs, unsigned count) {
+   for (unsigned L = 0; L < count; ++L)
+      AssignPQ(dst[L], pqs + L * 2);
+   for (unsigned L = count; L < fon9::fmkt::SymbBS::kBSCount; ++L)
+      dst[L] = fon9::fmkt::PriQty{};
+   return pqs + count * 2;
+}
+
+static const unsigned kDigit4IndexSize = 10000;
+
+static inline uint64_t StkNoToKey(const char* stkno) {
+   uint64_t key = 0;
+   memcpy(&key, stkno, sizeof(StkNo));
+   return key;
+}
+/// "dddd  " => dddd; 其他 => kDigit4IndexSize;
+static inline unsigned StkNoToDigit4(const StkNo& stkno) {
+   const char* p = stkno.Chars_;
+   const unsigned d0 = static_cast<unsigned>(static_cast<fon9::byte>(p[0]) - '0');
+   const unsigned d1 = static_cast<unsigned>(static_cast<fon9::byte>(p[1]) - '0');
+   const unsigned d2 = static_cast<unsigned>(static_cast<fon9::byte>(p[2]) - '0');
+   const unsigned d3 = static_cast<unsigned>(static_cast<fon9::byte>(p[3]) - '0');
+   if (fon9_LIKELY((d0 < 10) & (d1 < 10) & (d2 < 10) & (d3 < 10) & (p[4] == ' ') & (p[5] == ' ')))
+      return ((d0 * 10 + d1) * 10 + d2) * 10 + d3;
+   return kDigit4IndexSize;
+}
+
+//--------------------------------------------------------------------------//
+
+ExgMktFmt6Decoder::ExgMktFmt6Decoder(fon9::fmkt::SymbInTreeSP symbTree)
+   : Digit4Index_{new fon9::fmkt::SymbIn*[kDigit4IndexSize]()}
+   , SymbTree_{std::move(symbTree)} {
+}
+ExgMktFmt6Decoder::~ExgMktFmt6Decoder() {
+}
+void ExgMktFmt6Decoder::OnFmt6Updated(fon9::fmkt::SymbIn& symb, const ExgMktFmt6v3& fmt6, ExgMktFmt6Updated flags) {
+   (void)symb; (void)fmt6; (void)flags;
+}
+
+fon9::fmkt::SymbIn* ExgMktFmt6Decoder::AddToIndex(fon9::fmkt::SymbSP symb) {
+   const fon9::StrView symbid = ToStrView(symb->SymbId_);
+   if (symbid.size() > sizeof(StkNo))
+      return nullptr;
+   StkNo stkno;
+   memset(stkno.Chars_, ' ', sizeof(stkno.Chars_));
+   memcpy(stkno.Chars_, symbid.begin(), symbid.size());
+   fon9::fmkt::SymbIn* retval = static_cast<fon9::fmkt::SymbIn*>(symb.get());
+   const unsigned      d4 = StkNoToDigit4(stkno);
+   if (d4 < kDigit4IndexSize)
+      this->Digit4Index_[d4] = retval;
+   this->SymbIndex_[StkNoToKey(stkno.Chars_)] = std::move(symb);
+   return retval;
+}
+fon9::fmkt::SymbIn* ExgMktFmt6Decoder::FetchSymb(const StkNo& stkno) {
+   const unsigned d4 = StkNoToDigit4(stkno);
+   if (fon9_LIKELY(d4 < kDigit4IndexSize)) {
+      if (fon9::fmkt::SymbIn* symb = this->Digit4Index_[d4])
+         return symb;
+   }
+   else {
+      auto ifind = this->SymbIndex_.find(StkNoToKey(stkno.Chars_));
+      if (ifind != this->SymbIndex_.end())
+         return static_cast<fon9::fmkt::SymbIn*>(ifind->second.get());
+   }
+   // 索引中沒有此商品: 透過 SymbTree 建立(會鎖定 SymbMap_), 然後加入索引.
+   return this->AddToIndex(this->SymbTree_->FetchSymb(ToStrView(stkno)));
+}
+void ExgMktFmt6Decoder::RebuildIndex() {
+   memset(this->Digit4Index_.get(), 0, sizeof(fon9::fmkt::SymbIn*) * kDigit4IndexSize);
+   this->SymbIndex_.clear();
+   auto symbs = this->SymbTree_->SymbMap_.Lock();
+   this->SymbIndex_.reserve(symbs->size());
+   for (auto& v : *symbs)
+      this->AddToIndex(&fon9::fmkt::GetSymbValue(v));
+}
+
+void ExgMktFmt6Decoder::ExgMktOnReceived(const ExgMktHeader& pk, unsigned pksz) {
+   const fon9::byte fmtNo = pk.FmtNo_[0];
+   if (fmtNo != 0x06 && fmtNo != 0x17)
+      return;
+   ++this->Fmt6Count_;
+   const ExgMktFmt6v3& fmt6 = *static_cast<const ExgMktFmt6v3*>(&pk);
+   const ItemMaskInfo& info = kItemMaskTable.Info_[fmt6.ItemMask_];
+   // 3 = CheckSum + 0x0d + 0x0a;
+   if (fon9_UNLIKELY(info.PQCount_ == kInvalidPQCount
+                     || pksz < sizeof(ExgMktFmt6v3) - sizeof(fmt6.PQs_) + info.PQCount_ * sizeof(ExgMktPriQty) + 3)) {
+      ++this->Fmt6ErrCount_;
+      return;
+   }
+   const fon9::byte* const tm = fmt6.Time_.HHMMSSu6_;
+   const unsigned          tmHH = kBcdTable.Value_[tm[0]];
+   if (fon9_UNLIKELY(tmHH == 99)) // 股票代號"000000"且撮合時間"999999999999",
+      return;                     // 表示普通股競價交易末筆即時行情資料已送出.
+   fon9::fmkt::SymbIn* symb = this->FetchSymb(fmt6.StkNo_);
+   if (fon9_UNLIKELY(symb == nullptr))
+      return;
+   const uint64_t tmu6 = ((tmHH * 60u + kBcdTable.Value_[tm[1]]) * 60u + kBcdTable.Value_[tm[2]]) * uint64_t{1000000}
+                       + BcdBytes<3>::To(tm + 3);
+   // 一次轉換全部的價量(成交 + 買賣最多 11 筆), 使用 SIMD 指令, 比逐一欄位轉換快.
+   uint32_t pqv[(1 + fon9::fmkt::SymbBS::kBSCount * 2) * 2];
+   fon9::PackBcd6x8ArrayTo(fmt6.PQs_, info.PQCount_, pqv);
+   const uint32_t* pqs = pqv;
+   if (info.DealCount_) {
+      fon9::fmkt::SymbDeal::Data& deal = symb->Deal_.Data_;
+      deal.Time_.Assign<6>(tmu6);
+      deal.TotalQty_ = BcdTo(fmt6.TotalQty_);
+      AssignPQ(deal.Deal_, pqs);
+      pqs += 2;
+   }
+   if (IsEnumContains(info.Updated_, ExgMktFmt6Updated::BS)) {
+      fon9::fmkt::SymbBS::Data& bs = symb->BS_.Data_;
+      bs.Time_.Assign<6>(tmu6);
+      pqs = AssignBS(bs.Buys_, pqs, info.BuyCount_);
+      AssignBS(bs.Sells_, pqs, info.SellCount_);
+   }
+   symb->PublishQuote();
+   this->OnFmt6Updated(*symb, fmt6, info.Updated_);
+}
+
+} // namespaces
@@ -0,0 +1,75 @@
+﻿// \file f9tws/ExgMktFmt6Decoder.hpp
+// \author fonwinz@gmail.com
+#ifndef __f9tws_ExgMktFmt6Decoder_hpp__
+#define __f9tws_ExgMktFmt6Decoder_hpp__
+#include "f9tws/ExgMktFeeder.hpp"
+#include "f9tws/ExgMktFmt6.hpp"
+#include "fon9/fmkt/SymbIn.hpp"
+#include <memory>
+#include <unordered_map>
+
+namespace f9tws {
+
+/// ExgMktFmt6Decoder 更新了 SymbIn 的哪些資料.
+enum class ExgMktFmt6Updated : uint8_t {
+   None = 0,
+   /// SymbIn::Deal_
+   Deal = 0x01,
+   /// SymbIn::BS_
+   BS = 0x02,
+};
+fon9_ENABLE_ENUM_BITWISE_OP(ExgMktFmt6Updated);
+
+fon9_WARN_DISABLE_PADDING;
+/// \ingroup fmkt
+/// 解析 Fmt6(上市)、Fmt17(上櫃) 即時行情, 直接寫入 fmkt::SymbIn 的 Deal_, BS_.
+/// - 透過預先建立的 StkNo => SymbIn* 索引找商品, 不用鎖定 SymbTree::SymbMap_;
+///   只有在遇到索引中沒有的商品時, 才會透過 SymbTree::FetchSymb() 建立並加入索引.
+/// - ItemMask_ 使用查表取得成交、買進、賣出的檔數.
+/// - 價量檔位(成交 + 買賣)使用 fon9::PackBcd6x8ArrayTo() 一次轉換(SIMD);
+///   只有撮合時間、累計成交量, 使用查表轉換 Pack BCD(每個 byte 查一次表).
+/// - 只能在單一 thread 呼叫 FeedBuffer(); 寫入 SymbIn 的 Deal_, BS_ 時沒有額外的保護,
+///   寫入後會呼叫 SymbIn::PublishQuote(), 其他 thread 應透過 SymbIn::Quote_ 讀取.
+class f9tws_API ExgMktFmt6Decoder : public ExgMktFeeder {
+   fon9_NON_COPY_NON_MOVE(ExgMktFmt6Decoder);
+
+   /// 4 碼數字的股票代號(例: "2330  "), 直接使用代號當作索引, 共 10000 個元素.
+   using Digit4Index = std::unique_ptr<fon9::fmkt::SymbIn*[]>;
+   /// 所有的商品(包含 Digit4Index_ 裡面的商品), key = StkNo 的 6 bytes.
+   using SymbIndex = std::unordered_map<uint64_t, fon9::fmkt::SymbSP>;
+   Digit4Index Digit4Index_;
+   SymbIndex   SymbIndex_;
+   uint64_t    Fmt6Count_{0};
+   uint64_t    Fmt6ErrCount_{0};
+
+   fon9::fmkt::SymbIn* AddToIndex(fon9::fmkt::SymbSP symb);
+   fon9::fmkt::SymbIn* FetchSymb(const StkNo& stkno);
+
+protected:
+   /// 處理 Fmt6, Fmt17; 其餘格式直接返回.
+   void ExgMktOnReceived(const ExgMktHeader& pk, unsigned pksz) override;
+
+   /// 已將 fmt6 的內容寫入 symb 之後通知, 可在此發行異動.
+   /// 預設: do nothing.
+   virtual void OnFmt6Updated(fon9::fmkt::SymbIn& symb, const ExgMktFmt6v3& fmt6, ExgMktFmt6Updated flags);
+
+public:
+   const fon9::fmkt::SymbInTreeSP  SymbTree_;
+
+   ExgMktFmt6Decoder(fon9::fmkt::SymbInTreeSP symbTree);
+   ~ExgMktFmt6Decoder();
+
+   /// 鎖定 SymbTree_->SymbMap_ 一次, 將現有的商品全部加入索引.
+   /// 通常在載入商品基本資料後呼叫, 避免收到行情時才建立索引.
+   void RebuildIndex();
+
+   /// 收到的 Fmt6, Fmt17 數量(包含 Fmt6ErrCount).
+   uint64_t GetFmt6Count() const { return this->Fmt6Count_; }
+   /// 長度與 ItemMask_ 不符, 或 ItemMask_ 的檔數超過 5 檔的數量.
+   uint64_t GetFmt6ErrCount() const { return this->Fmt6ErrCount_; }
+   size_t GetIndexedSymbCount() const { return this->SymbIndex_.size(); }
+};
+fon9_WARN_POP;
+
+} // namespaces
+#endif//__f9tws_ExgMktFmt6Decoder_hpp__
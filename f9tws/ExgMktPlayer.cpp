@@ -15,12 +15,18 @@ struct ExgMktPlayerArgs {
    fon9::File::PosType  RdTo_{0};
    uint64_t             RdBytes_{0};
    fon9::TimeInterval   RdInterval_{fon9::TimeInterval_Millisecond(1)};
+   /// 僅用於 RxCapture 格式的行情檔: 0=盡速重播; 1=依照原始收到的時間間隔重播; N=N倍速.
+   double               Speed_{1};
 };
 class ExgMktPlayer : public ExgMktFeeder, public fon9::io::Session {
    fon9_NON_COPY_NON_MOVE(ExgMktPlayer);
    fon9::io::Device*    Device_{nullptr};
    fon9::DcQueueList    RdBuffer_;
    fon9::File           MktFile_;
+   /// 若行情檔為 RxCapture 格式, 則使用 Capture_ 讀取, 依照收到的時間重播.
+   using RxCaptureReaderSP = std::unique_ptr<fon9::RxCaptureReader>;
+   RxCaptureReaderSP    Capture_;
+   fon9::RxReplayPacer  Pacer_;
    ExgMktPlayerArgs     Args_;
    fon9::TimeStamp      LastStTime_;
    uint64_t             SentPkCount_{0};
@@ -53,7 +59,7 @@ class ExgMktPlayer : public ExgMktFeeder, public fon9::io::Session {
             //   player->ReadMktFile(fon9::UtcNow());
             //   intrusive_ptr_release(player->Device_);
             //});
-            player->RdTimer_.RunAfter(player->Args_.RdInterval_);
+            player->RdTimer_.RunAfter(player->GetRdInterval());
          }
       }
       void OnBufferConsumedErr(const fon9::ErrC&) override {}
@@ -77,6 +83,9 @@ class ExgMktPlayer : public ExgMktFeeder, public fon9::io::Session {
       this->Device_ = &dev;
    }
    fon9::io::RecvBufferSize OnDevice_LinkReady(fon9::io::Device&) {
+      // 重新連線後, 從目前的記錄開始, 以現在的時間作為重播的起點;
+      // 否則斷線期間應重播的記錄, 會在連線後一次全部送出.
+      this->Pacer_.Reset();
       this->ReadMktFile(fon9::UtcNow());
       return fon9::io::RecvBufferSize::NoRecvEvent;
    }
@@ -84,9 +93,61 @@ class ExgMktPlayer : public ExgMktFeeder, public fon9::io::Session {
       ++this->SentPkCount_;
       NodeSend::Send(*this, &pk, pksz);
    }
+   /// 送出一批資料後, 等候多久再讀下一批.
+   /// RxCapture 盡速重播(Speed=0)時, 不等候: 送出後(NodeSend::Wait())立即讀下一批.
+   fon9::TimeInterval GetRdInterval() const {
+      if (this->Capture_ && this->Pacer_.IsAsFastAsPossible())
+         return fon9::TimeInterval{};
+      return this->Args_.RdInterval_;
+   }
+   void UpdateStatus(fon9::TimeStamp now, fon9::File::PosType pos) {
+      if (now - this->LastStTime_ >= fon9::TimeInterval_Second(1)) {
+         this->LastStTime_ = now;
+         std::string stmsg = fon9::RevPrintTo<std::string>("Pk=", this->SentPkCount_, "|Pos=", pos);
+         this->Device_->Manager_->OnSession_StateUpdated(*this->Device_, &stmsg, fon9::LogLevel::Trace);
+      }
+   }
+   /// 每筆記錄原封不動的送出(保留原本的封包邊界).
+   /// - 若下一筆記錄尚未到達重播時間, 則使用 RdTimer_ 等候.
+   /// - 若送出的資料量超過 RdBytes_, 則等送出後再繼續.
+   void ReadCapture(fon9::TimeStamp now) {
+      const uint64_t          rdLimit = this->Args_.RdBytes_ ? this->Args_.RdBytes_ : 1024;
+      uint64_t                rdBytes = 0;
+      fon9::RxCaptureRecord   rec;
+      for (;;) {
+         const auto  pos = this->Capture_->GetPos();
+         const void* dat = this->Capture_->Next(rec);
+         if (dat == nullptr) {
+            std::string stmsg = fon9::RevPrintTo<std::string>("Pk=", this->SentPkCount_, "|Pos=", pos, "|End");
+            this->Device_->Manager_->OnSession_StateUpdated(*this->Device_, &stmsg, fon9::LogLevel::Info);
+            return;
+         }
+         if (!this->Pacer_.IsAsFastAsPossible()) {
+            const fon9::TimeStamp due = this->Pacer_.GetDueTime(rec.RxTime_, now);
+            if (due > now) {
+               this->Capture_->Seek(pos);
+               this->UpdateStatus(now, pos);
+               intrusive_ptr_add_ref(this->Device_);
+               this->RdTimer_.RunAfter(due - now);
+               return;
+            }
+         }
+         ++this->SentPkCount_;
+         NodeSend::Send(*this, dat, rec.Size_);
+         if ((rdBytes += rec.Size_) >= rdLimit) {
+            this->UpdateStatus(now, this->Capture_->GetPos());
+            NodeSend::Wait(*this);
+            return;
+         }
+      }
+   }
    void ReadMktFile(fon9::TimeStamp now) {
       if (this->Device_->OpImpl_GetState() != fon9::io::State::LinkReady)
          return;
+      if (this->Capture_) {
+         this->ReadCapture(now);
+         return;
+      }
       if (this->Args_.RdTo_ != 0 && this->Args_.RdTo_ <= this->Args_.RdFrom_) {
          std::string stmsg = fon9::RevPrintTo<std::string>("Pk=", this->SentPkCount_, "|Pos=", this->Args_.RdFrom_, "|End=", this->Args_.RdTo_);
          this->Device_->Manager_->OnSession_StateUpdated(*this->Device_, &stmsg, fon9::LogLevel::Info);
@@ -105,11 +166,7 @@ class ExgMktPlayer : public ExgMktFeeder, public fon9::io::Session {
          node->SetDataEnd(node->GetDataEnd() + rdres.GetResult());
          this->RdBuffer_.push_back(node);
          this->FeedBuffer(this->RdBuffer_);
-         if (now - this->LastStTime_ >= fon9::TimeInterval_Second(1)) {
-            this->LastStTime_ = now;
-            std::string stmsg = fon9::RevPrintTo<std::string>("Pk=", this->SentPkCount_, "|Pos=", this->Args_.RdFrom_);
-            this->Device_->Manager_->OnSession_StateUpdated(*this->Device_, &stmsg, fon9::LogLevel::Trace);
-         }
+         this->UpdateStatus(now, this->Args_.RdFrom_);
          NodeSend::Wait(*this);
       }
       else {
@@ -123,6 +180,11 @@ public:
       : MktFile_{std::move(fd)}
       , Args_(args) {
    }
+   ExgMktPlayer(RxCaptureReaderSP&& capture, const ExgMktPlayerArgs& args)
+      : Capture_{std::move(capture)}
+      , Pacer_{args.Speed_}
+      , Args_(args) {
+   }
    ~ExgMktPlayer() {
    }
 };
@@ -134,7 +196,11 @@ public:
    using base::base;
 
    static fon9::io::SessionSP CreateSession(fon9::StrView cfg, std::string& errReason) {
-      // cfg.SessionArgs_: fileName|From=pos|To=pos|Rd=BlockSize|Interval=ti|
+      // cfg.SessionArgs_: fileName|From=pos|To=pos|Rd=BlockSize|Interval=ti|Speed=n
+      // - 若 fileName 為 RxCapture 格式(由 RxCaptureSession 錄製), 則依照收到的時間重播, 此時:
+      //   - 不支援 From, To;
+      //   - Speed=0 盡速重播(不使用 Interval); Speed=1(預設) 依照原始時間間隔; Speed=N 為 N 倍速;
+      //   - 重新連線後, 從斷線時的位置, 以連線的時間作為重播的起點;
       // TODO: std::string ExgMktPlayer::SessionCommand(Device& dev, StrView cmdln);
       //    - pause
       //    - restart [from to speed]
@@ -150,6 +216,8 @@ public:
             args.RdBytes_ = fon9::StrTo(value, args.RdBytes_);
          else if (tag == "Interval")
             args.RdInterval_ = fon9::StrTo(value, args.RdInterval_);
+         else if (tag == "Speed")
+            args.Speed_ = fon9::StrTo(value, fon9::Decimal<uint32_t, 3>{}).To<double>();
          else {
             errReason = fon9::RevPrintTo<std::string>("Create:TwsExgMktPlayer|err=Unknown tag: ", tag);
             return fon9::io::SessionSP{};
@@ -161,6 +229,14 @@ public:
          errReason = fon9::RevPrintTo<std::string>("Create:TwsExgMktPlayer|fname=", fd.GetOpenName(), '|', res);
          return fon9::io::SessionSP{};
       }
+      if (fon9::RxCaptureReader::IsRxCaptureFile(fd)) {
+         std::unique_ptr<fon9::RxCaptureReader> capture{new fon9::RxCaptureReader};
+         if (!(res = capture->Open(fd.GetOpenName()))) {
+            errReason = fon9::RevPrintTo<std::string>("Create:TwsExgMktPlayer|fname=", fd.GetOpenName(), "|RxCapture|", res);
+            return fon9::io::SessionSP{};
+         }
+         return fon9::io::SessionSP{new ExgMktPlayer{std::move(capture), args}};
+      }
       return fon9::io::SessionSP{new ExgMktPlayer{std::move(fd), args}};
    }
    fon9::io::SessionSP CreateSession(fon9::IoManager& mgr, const fon9::IoConfigItem& cfg, std::string& errReason) {
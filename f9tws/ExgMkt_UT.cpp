@@ -2,8 +2,7 @@
 // \author fonwinz@gmail.com
 #define _CRT_SECURE_NO_WARNINGS
 #include "f9tws/ExgMktFeeder.hpp"
-#include "f9tws/ExgMktFmt6.hpp"
-#include "fon9/fmkt/SymbIn.hpp"
+#include "f9tws/ExgMktFmt6Decoder.hpp"
 #include "fon9/RevPrint.hpp"
 #include "fon9/TestTools.hpp"
 
@@ -63,57 +62,285 @@ void CheckExgMktFeederStep(const Feeder& orig, const char* buf, size_t bufsz, si
    std::cout << "\r[OK   ]" << std::endl;
 }
 
-struct Fmt6Parser : public Feeder, public fon9::fmkt::SymbTree {
-   fon9_NON_COPY_NON_MOVE(Fmt6Parser);
-   using baseFeeder = Feeder;
-   using baseTree = fon9::fmkt::SymbTree;
-   Fmt6Parser() : baseTree{fon9::seed::LayoutSP{}} {
+fon9_WARN_DISABLE_PADDING;
+struct Fmt6Decoder : public f9tws::ExgMktFmt6Decoder {
+   fon9_NON_COPY_NON_MOVE(Fmt6Decoder);
+   using base = f9tws::ExgMktFmt6Decoder;
+   uint64_t                   UpdatedCount_{0};
+   f9tws::ExgMktFmt6Updated   LastUpdated_{};
+
+   Fmt6Decoder() : base{new fon9::fmkt::SymbInTree{fon9::seed::LayoutSP{}}} {
+   }
+   void OnFmt6Updated(fon9::fmkt::SymbIn&, const f9tws::ExgMktFmt6v3&, f9tws::ExgMktFmt6Updated flags) override {
+      ++this->UpdatedCount_;
+      this->LastUpdated_ = flags;
    }
+   const fon9::fmkt::SymbIn* GetSymb(fon9::StrView symbid) const {
+      return static_cast<const fon9::fmkt::SymbIn*>(this->SymbTree_->GetSymb(symbid).get());
+   }
+};
+fon9_WARN_POP;
 
-   fon9::fmkt::SymbSP MakeSymb(const fon9::StrView& symbid) override {
-      return new fon9::fmkt::SymbIn{symbid};
+struct TestPQ {
+   uint32_t PriV2_;
+   uint32_t Qty_;
+};
+/// 建立一個 Fmt6 封包, 傳回封包大小.
+static unsigned MakeFmt6(char* pkbuf, uint32_t seqNo, const char* stkno, uint64_t hhmmssu6,
+                         fon9::byte itemMask, uint32_t totalQty, const TestPQ* pqs, unsigned pqCount) {
+   f9tws::ExgMktFmt6v3& fmt6 = *reinterpret_cast<f9tws::ExgMktFmt6v3*>(pkbuf);
+   const unsigned pksz = static_cast<unsigned>(sizeof(fmt6) - sizeof(fmt6.PQs_) + pqCount * sizeof(f9tws::ExgMktPriQty) + 3);
+   fmt6.Esc_ = 27;
+   fon9::ToPackBcd<4>(fmt6.Length_, pksz);
+   fmt6.Market_[0] = 0x01;
+   fmt6.FmtNo_[0] = 0x06;
+   fmt6.VerNo_[0] = 0x03;
+   fon9::ToPackBcd<8>(fmt6.SeqNo_, seqNo);
+   memset(fmt6.StkNo_.Chars_, ' ', sizeof(fmt6.StkNo_.Chars_));
+   memcpy(fmt6.StkNo_.Chars_, stkno, strlen(stkno));
+   fon9::ToPackBcd<12>(fmt6.Time_.HHMMSSu6_, hhmmssu6);
+   fmt6.ItemMask_ = itemMask;
+   fmt6.LmtMask_ = 0;
+   fmt6.StatusMask_ = 0;
+   fon9::ToPackBcd<8>(fmt6.TotalQty_, totalQty);
+   for (unsigned L = 0; L < pqCount; ++L) {
+      fon9::ToPackBcd<6>(fmt6.PQs_[L].PriV2_, pqs[L].PriV2_);
+      fon9::ToPackBcd<8>(fmt6.PQs_[L].Qty_, pqs[L].Qty_);
    }
-   void ExgMktOnReceived(const f9tws::ExgMktHeader& pk, unsigned pksz) override {
-      baseFeeder::ExgMktOnReceived(pk, pksz);
-      auto fmtNo = pk.GetFmtNo();
-      if (fmtNo != 6 && fmtNo != 17)
-         return;
-      const f9tws::ExgMktFmt6v3& fmt6 = *static_cast<const f9tws::ExgMktFmt6v3*>(&pk);
-      const f9tws::ExgMktPriQty* pqs  = fmt6.PQs_;
-      unsigned                   tmHH = fon9::PackBcdTo<unsigned>(fmt6.Time_.HH_);
-      if (fon9_UNLIKELY(tmHH == 99)) // 股票代號"000000"且撮合時間"999999999999",
-         return;                     // 表示普通股競價交易末筆即時行情資料已送出.
-      uint64_t tmu6 = (((tmHH * 60) + fon9::PackBcdTo<unsigned>(fmt6.Time_.MM_)) * 60
-                       + fon9::PackBcdTo<unsigned>(fmt6.Time_.SS_));
-      tmu6 = (tmu6 * 1000000) + fon9::PackBcdTo<unsigned>(fmt6.Time_.U6_);
-      fon9::StrView        stkno{f9tws::ToStrView(fmt6.StkNo_)};
-      SymbMap::Locker      symbs{this->SymbMap_};
-      fon9::fmkt::SymbIn&  symb = *static_cast<fon9::fmkt::SymbIn*>(this->FetchSymb(symbs, stkno).get());
-      if (fmt6.ItemMask_ & 0x80) {
-         symb.Deal_.Data_.Time_.Assign<6>(tmu6);
-         symb.Deal_.Data_.TotalQty_ = fon9::PackBcdTo<fon9::fmkt::Qty>(fmt6.TotalQty_);
-         pqs->AssignTo(symb.Deal_.Data_.Deal_);
-         ++pqs;
+   char cks = 0;
+   for (unsigned L = 1; L < pksz - 3; ++L) {
+      fon9_GCC_WARN_DISABLE("-Wconversion");
+      cks ^= pkbuf[L];
+      fon9_GCC_WARN_POP;
+   }
+   pkbuf[pksz - 3] = cks;
+   pkbuf[pksz - 2] = 0x0d;
+   pkbuf[pksz - 1] = 0x0a;
+   return pksz;
+}
+
+static void CheckPQ(const char* name, const fon9::fmkt::PriQty& pq, const TestPQ& expected) {
+   fon9::fmkt::Pri pri;
+   pri.Assign<2>(expected.PriV2_);
+   if (pq.Pri_ != pri || pq.Qty_ != expected.Qty_) {
+      std::cout << "|" << name << "|pri=" << fon9::RevPrintTo<std::string>(pq.Pri_) << "|qty=" << pq.Qty_
+         << "|expected=" << expected.PriV2_ << "," << expected.Qty_ << "\r[ERROR]" << std::endl;
+      abort();
+   }
+}
+static void CheckBS(const char* name, const fon9::fmkt::PriQty* pqs, const TestPQ* expected, unsigned count) {
+   static const TestPQ kEmptyPQ{0, 0};
+   for (unsigned L = 0; L < fon9::fmkt::SymbBS::kBSCount; ++L)
+      CheckPQ(name, pqs[L], L < count ? expected[L] : kEmptyPQ);
+}
+static void FeedPacket(Fmt6Decoder& decoder, const char* pk, unsigned pksz) {
+   fon9::DcQueueFixedMem dcq{pk, pksz};
+   decoder.FeedBuffer(dcq);
+}
+
+/// 使用自行建立的封包, 檢查 ExgMktFmt6Decoder 的解析結果.
+void TestFmt6Decoder() {
+   std::cout << "[TEST ] ExgMktFmt6Decoder";
+   Fmt6Decoder decoder;
+   decoder.SymbTree_->FetchSymb("1101");
+   decoder.RebuildIndex();
+   if (decoder.GetIndexedSymbCount() != 1) {
+      std::cout << "|RebuildIndex|count=" << decoder.GetIndexedSymbCount() << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   char     pkbuf[f9tws::kExgMktMaxPacketSize];
+   unsigned pksz;
+   // 成交 + 5 檔買進 + 5 檔賣出.
+   const TestPQ pqs1[]{{51200, 3}, // 成交.
+                       {51100, 10}, {51000, 20}, {50900, 30}, {50800, 40}, {50700, 50}, // 買進.
+                       {51200, 11}, {51300, 21}, {51400, 31}, {51500, 41}, {51600, 51}};// 賣出.
+   pksz = MakeFmt6(pkbuf, 1, "2330", 90001123456u, 0x80 | 0x50 | 0x0a, 1234, pqs1, 11);
+   FeedPacket(decoder, pkbuf, pksz);
+   const fon9::fmkt::SymbIn* symb = decoder.GetSymb("2330");
+   if (symb == nullptr || decoder.LastUpdated_ != (f9tws::ExgMktFmt6Updated::Deal | f9tws::ExgMktFmt6Updated::BS)) {
+      std::cout << "|Deal+BS|symb=" << symb << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   CheckPQ("Deal", symb->Deal_.Data_.Deal_, pqs1[0]);
+   CheckBS("Buys", symb->BS_.Data_.Buys_, pqs1 + 1, 5);
+   CheckBS("Sells", symb->BS_.Data_.Sells_, pqs1 + 6, 5);
+   fon9::TimeInterval tm;
+   tm.Assign<6>(((9 * 60 + 0) * 60 + 1) * uint64_t{1000000} + 123456);
+   if (symb->Deal_.Data_.TotalQty_ != 1234 || symb->Deal_.Data_.Time_ != tm || symb->BS_.Data_.Time_ != tm) {
+      std::cout << "|TotalQty=" << symb->Deal_.Data_.TotalQty_
+         << "|Time=" << fon9::RevPrintTo<std::string>(symb->Deal_.Data_.Time_) << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   // 僅成交(Bit 0 = 1: 不揭示最佳五檔), BS 不變.
+   const TestPQ pqs2[]{{51300, 5}};
+   pksz = MakeFmt6(pkbuf, 2, "2330", 90002000000u, 0x81, 1239, pqs2, 1);
+   FeedPacket(decoder, pkbuf, pksz);
+   if (decoder.LastUpdated_ != f9tws::ExgMktFmt6Updated::Deal || symb->Deal_.Data_.TotalQty_ != 1239) {
+      std::cout << "|DealOnly\r[ERROR]" << std::endl;
+      abort();
+   }
+   CheckPQ("DealOnly", symb->Deal_.Data_.Deal_, pqs2[0]);
+   CheckBS("DealOnly.Buys", symb->BS_.Data_.Buys_, pqs1 + 1, 5);
+   // 2 檔買進 + 1 檔賣出, 其餘檔位清除; 使用非 4 碼數字的代號.
+   const TestPQ pqs3[]{{1500, 7}, {1495, 8}, {1505, 9}};
+   pksz = MakeFmt6(pkbuf, 3, "00632R", 90003000000u, 0x20 | 0x02, 0, pqs3, 3);
+   FeedPacket(decoder, pkbuf, pksz);
+   symb = decoder.GetSymb("00632R");
+   if (symb == nullptr || decoder.LastUpdated_ != f9tws::ExgMktFmt6Updated::BS) {
+      std::cout << "|BSOnly|symb=" << symb << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   CheckBS("BSOnly.Buys", symb->BS_.Data_.Buys_, pqs3, 2);
+   CheckBS("BSOnly.Sells", symb->BS_.Data_.Sells_, pqs3 + 2, 1);
+   // 錯誤的封包: 買進 6 檔; 長度不足 ItemMask_ 要求的檔數.
+   pksz = MakeFmt6(pkbuf, 4, "2330", 90004000000u, 0x60, 0, pqs1 + 1, 6);
+   FeedPacket(decoder, pkbuf, pksz);
+   pksz = MakeFmt6(pkbuf, 5, "2330", 90005000000u, 0x80 | 0x50 | 0x0a, 0, pqs1, 1);
+   FeedPacket(decoder, pkbuf, pksz);
+   if (decoder.GetFmt6Count() != 5 || decoder.GetFmt6ErrCount() != 2 || decoder.UpdatedCount_ != 3
+       || decoder.GetIndexedSymbCount() != 3) {
+      std::cout << "|Fmt6Count=" << decoder.GetFmt6Count() << "|ErrCount=" << decoder.GetFmt6ErrCount()
+         << "|UpdatedCount=" << decoder.UpdatedCount_ << "|IndexedSymbCount=" << decoder.GetIndexedSymbCount()
+         << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   std::cout << "\r[OK   ]" << std::endl;
+}
+
+static void PrintReplayResult(double secs, const char* msg, uint64_t pkCount) {
+   fon9::StopWatch::PrintResultNoEOL(secs, msg, pkCount)
+      << "|pk/sec=" << static_cast<uint64_t>(static_cast<double>(pkCount) / secs) << std::endl;
+}
+/// 重播 rdbuf 裡面的行情封包(ExgMktPlayer 使用的行情檔格式: 直接串接的封包).
+/// - 第 1 次: 包含建立商品、建立索引的負擔.
+/// - 第 2 次: 商品都已在索引中.
+void ReplayFmt6(const char* rdbuf, size_t rdsz) {
+   Fmt6Decoder           decoder;
+   fon9::DcQueueFixedMem dcq{rdbuf, rdsz};
+   fon9::StopWatch       stopWatch;
+   decoder.FeedBuffer(dcq);
+   PrintReplayResult(stopWatch.StopTimer(), "Replay (new symbols)", decoder.GetReceivedCount());
+   decoder.ClearStatus();
+   dcq.Reset(rdbuf, rdbuf + rdsz);
+   stopWatch.ResetTimer();
+   decoder.FeedBuffer(dcq);
+   PrintReplayResult(stopWatch.StopTimer(), "Replay (indexed)    ", decoder.GetReceivedCount());
+   std::cout << "Fmt6+17=" << decoder.GetFmt6Count() << "|Fmt6Err=" << decoder.GetFmt6ErrCount()
+      << "|Symbol count=" << decoder.GetIndexedSymbCount() << std::endl;
+   auto symb = decoder.SymbTree_->GetSymb("2330");
+   if (!symb && !decoder.SymbTree_->SymbMap_.Lock()->empty())
+      symb.reset(&fon9::fmkt::GetSymbValue(*decoder.SymbTree_->SymbMap_.Lock()->begin()));
+   if (const fon9::fmkt::SymbIn* symi = static_cast<const fon9::fmkt::SymbIn*>(symb.get())) {
+      fon9::RevBufferList rbuf{256};
+      fon9::FmtDef fmtPri{7,2};
+      fon9::FmtDef fmtQty{7};
+      for (int L = fon9::fmkt::SymbBS::kBSCount; L > 0;) {
+         --L;
+         RevPrint(rbuf, symi->BS_.Data_.Buys_[L].Pri_, fmtPri, " / ", symi->BS_.Data_.Buys_[L].Qty_, fmtQty, '\n');
       }
-      if ((fmt6.ItemMask_ & 0x7e) || (fmt6.ItemMask_ & 1) == 0) {
-         symb.BS_.Data_.Time_.Assign<6>(tmu6);
-         pqs = AssignBS(symb.BS_.Data_.Buys_, pqs, (fmt6.ItemMask_ & 0x70) >> 4);
-         pqs = AssignBS(symb.BS_.Data_.Sells_, pqs, (fmt6.ItemMask_ & 0x0e) >> 1);
+      RevPrint(rbuf, "---\n");
+      for (int L = 0; L < fon9::fmkt::SymbBS::kBSCount; ++L) {
+         RevPrint(rbuf, symi->BS_.Data_.Sells_[L].Pri_, fmtPri, " / ", symi->BS_.Data_.Sells_[L].Qty_, fmtQty, '\n');
       }
+      fon9::RevPrint(rbuf,
+         "SymbId=", symi->SymbId_, "\n"
+         "Last deal: ", symi->Deal_.Data_.Time_, "\n"
+         "      Pri: ", symi->Deal_.Data_.Deal_.Pri_, fmtPri, "\n"
+         "      Qty: ", symi->Deal_.Data_.Deal_.Qty_, fmtQty, "\n"
+         " TotalQty: ", symi->Deal_.Data_.TotalQty_, fmtQty, "\n"
+         "Last Sells - Buys: ", symi->BS_.Data_.Time_, "\n"
+         );
+      std::cout << fon9::BufferTo<std::string>(rbuf.MoveOut()) << std::endl;
+   }
+}
+
+/// 沒有提供行情檔時, 自行建立 symbCount 個商品的 Fmt6 封包, 重複 rounds 次重播.
+void BenchFmt6(unsigned symbCount, unsigned pkCount, unsigned rounds) {
+   std::vector<char> rdbuf(static_cast<size_t>(pkCount) * 128);
+   size_t            rdsz = 0;
+   TestPQ            pqs[11];
+   char              stkno[8];
+   for (unsigned L = 0; L < pkCount; ++L) {
+      const unsigned symbIdx = L % symbCount;
+      snprintf(stkno, sizeof(stkno), "%04u", 1000 + symbIdx);
+      for (unsigned i = 0; i < 11; ++i)
+         pqs[i] = TestPQ{10000 + symbIdx + i, L + i};
+      // 大多數是「成交+5檔」, 每 4 筆有一筆「僅成交」.
+      const bool isDealOnly = (L % 4 == 3);
+      rdsz += MakeFmt6(rdbuf.data() + rdsz, L + 1, stkno, 90000000000u + L,
+                       isDealOnly ? fon9::byte{0x81} : fon9::byte{0x80 | 0x50 | 0x0a}, L, pqs, isDealOnly ? 1u : 11u);
+   }
+   std::cout << "symbCount=" << symbCount << "|pkCount=" << pkCount << "|rounds=" << rounds
+      << "|bytes=" << rdsz << std::endl;
+   Fmt6Decoder           decoder;
+   fon9::DcQueueFixedMem dcq{rdbuf.data(), rdsz};
+   decoder.FeedBuffer(dcq); // 建立商品及索引.
+   decoder.ClearStatus();
+   fon9::StopWatch stopWatch;
+   for (unsigned L = 0; L < rounds; ++L) {
+      dcq.Reset(rdbuf.data(), rdbuf.data() + rdsz);
+      decoder.FeedBuffer(dcq);
+   }
+   PrintReplayResult(stopWatch.StopTimer(), "Replay Fmt6", decoder.GetReceivedCount());
+   if (decoder.GetReceivedCount() != static_cast<uint64_t>(pkCount) * rounds || decoder.GetFmt6ErrCount() != 0) {
+      std::cout << "[ERROR] ReceivedCount=" << decoder.GetReceivedCount() << "|Fmt6Err=" << decoder.GetFmt6ErrCount() << std::endl;
+      abort();
    }
-   static const f9tws::ExgMktPriQty* AssignBS(fon9::fmkt::PriQty* dst, const f9tws::ExgMktPriQty* pqs, int count) {
-      if (count > fon9::fmkt::SymbBS::kBSCount)
-         count = fon9::fmkt::SymbBS::kBSCount;
-      for (int L = 0; L < count; ++L) {
-         pqs->AssignTo(*dst);
-         ++dst;
-         ++pqs;
+}
+
+/// 將 Fmt6 封包錄製成 RxCapture 格式, 再使用 ExgMktFeeder::FeedCapture() 重播.
+/// - 模擬 TCP 接收: 有些封包被切成 2 筆記錄.
+/// - 每筆記錄間隔 1ms, 使用 Speed=0 盡速重播, 及 Speed=50 依時間間隔重播.
+void TestFeedCapture() {
+   std::cout << "[TEST ] ExgMktFeeder.FeedCapture";
+   static const char kCapFileName[] = "ExgMkt_UT.f9rx";
+   remove(kCapFileName);
+   remove((std::string{kCapFileName} + ".cidx").c_str());
+   static const unsigned   kPkCount = 200;
+   const fon9::TimeStamp   rxTimeBase = fon9::UtcNow();
+   unsigned                recCount = 0;
+   {
+      fon9::RxCaptureWriterSP writer{new fon9::RxCaptureWriter};
+      if (!writer->Initialize(kCapFileName)) {
+         std::cout << "|err=RxCaptureWriter.Initialize()" "\r[ERROR]" << std::endl;
+         abort();
+      }
+      char           pkbuf[f9tws::kExgMktMaxPacketSize];
+      const TestPQ   pqs[]{{51200, 3}, {51100, 10}, {51200, 11}};
+      for (unsigned L = 0; L < kPkCount; ++L) {
+         const unsigned pksz = MakeFmt6(pkbuf, L + 1, "2330", 90000000000u + L, 0x80 | 0x10 | 0x02, L, pqs, 3);
+         const unsigned split = (L % 3 == 2 ? pksz / 2 : pksz);
+         writer->Append(0, rxTimeBase + fon9::TimeInterval_Millisecond(recCount++), pkbuf, split);
+         if (split < pksz)
+            writer->Append(0, rxTimeBase + fon9::TimeInterval_Millisecond(recCount++), pkbuf + split, pksz - split);
       }
-      if (count < fon9::fmkt::SymbBS::kBSCount)
-         memset(dst, 0, sizeof(*dst) * (fon9::fmkt::SymbBS::kBSCount - count));
-      return pqs;
+      writer->WaitFlushed();
    }
-};
+   for (double speed : {0.0, 50.0}) {
+      fon9::RxCaptureReader reader;
+      if (!reader.Open(kCapFileName)) {
+         std::cout << "|err=RxCaptureReader.Open()" "\r[ERROR]" << std::endl;
+         abort();
+      }
+      Fmt6Decoder             decoder;
+      fon9::RxReplayPacer     pacer{speed};
+      const fon9::TimeStamp   tmBeg = fon9::UtcNow();
+      const uint64_t          count = decoder.FeedCapture(reader, pacer);
+      const double            span = (fon9::UtcNow() - tmBeg).To<double>();
+      std::cout << "|speed=" << speed << "|span=" << span;
+      // Speed=50: 共 (recCount - 1) ms, 重播時間應 >= (recCount - 1) / 50 ms.
+      if (count != recCount || decoder.GetFmt6Count() != kPkCount || decoder.GetFmt6ErrCount() != 0
+          || decoder.GetDroppedBytes() != 0
+          || (speed > 0 && span < static_cast<double>(recCount - 1) / 1000 / speed)) {
+         std::cout << "|count=" << count << "|Fmt6Count=" << decoder.GetFmt6Count()
+            << "|Dropped=" << decoder.GetDroppedBytes() << "\r[ERROR]" << std::endl;
+         abort();
+      }
+   }
+   remove(kCapFileName);
+   remove((std::string{kCapFileName} + ".cidx").c_str());
+   std::cout << "\r[OK   ]" << std::endl;
+}
 
 unsigned long StrToVal(char* str) {
    unsigned long val = strtoul(str, &str, 10);
@@ -131,9 +358,14 @@ int main(int argc, char* argv[]) {
    if (argc < 4) {
       std::cout << "Usage: TwsExgMktFileName ReadFrom ReadSize [Steps]\n"
          "ReadSize=0 for read to EOF.\n"
-         "Steps=0 for test Fmt6+17 parsing.\n"
+         "Steps=0 for replay Fmt6+17 into SymbIn.\n"
          << std::endl;
-      return 3;
+      // 沒有行情檔: 使用自行建立的封包測試.
+      TestFmt6Decoder();
+      TestFeedCapture();
+      utinfo.PrintSplitter();
+      BenchFmt6(1000, 100 * 1000, 10);
+      return 0;
    }
    std::cout << "Mkt File=" << argv[1] << std::endl;
    FILE* fd = fopen(argv[1], "rb");
@@ -203,44 +435,12 @@ int main(int argc, char* argv[]) {
          CheckExgMktFeederStep(feeder, rdbuf, rdsz, step);
          stopWatch.PrintResult("Fetch packet by step", feeder.ReceivedCount_);
       }
-      else { // 解析 Fmt6 => SymbIn: 實際應用時, 還有序號連續性問題, 所以要花更久的時間.
-         Fmt6Parser fmt6parser;
-         dcq.Reset(rdbuf, rdbuf + rdsz);
-         stopWatch.ResetTimer();
-         fmt6parser.FeedBuffer(dcq);
-         const double tmFmt6 = stopWatch.StopTimer();
-         stopWatch.PrintResult(tmFmt6 - tmFull, "Parse Fmt6+17", feeder.FmtCount_[6] + feeder.FmtCount_[17]);
-         // 測試結果:
+      else { // 重播 Fmt6 => SymbIn: 實際應用時, 還有序號連續性問題, 所以要花更久的時間.
+         ReplayFmt6(rdbuf, rdsz);
+         // 之前(使用 PackBcdTo<>() 及 SymbTree::FetchSymb() 鎖定 SymbMap_)的測試結果:
          // Hardware: HP ProLiant DL380p Gen8 / E5-2680 v2 @ 2.80GHz
          // OS: Ubuntu 16.04.2 LTS
          // Parse Fmt6+17: 2.673751904 secs / 17,034,879 times = 156.957493153 ns
-
-         std::cout << "Symbol count=" << fmt6parser.SymbMap_.Lock()->size() << std::endl;
-         auto symb = fmt6parser.GetSymb("2330");
-         if (!symb && !fmt6parser.SymbMap_.Lock()->empty())
-            symb.reset(&fon9::fmkt::GetSymbValue(*fmt6parser.SymbMap_.Lock()->begin()));
-         if (const fon9::fmkt::SymbIn* symi = static_cast<const fon9::fmkt::SymbIn*>(symb.get())) {
-            fon9::RevBufferList rbuf{256};
-            fon9::FmtDef fmtPri{7,2};
-            fon9::FmtDef fmtQty{7};
-            for (int L = fon9::fmkt::SymbBS::kBSCount; L > 0;) {
-               --L;
-               RevPrint(rbuf, symi->BS_.Data_.Buys_[L].Pri_, fmtPri, " / ", symi->BS_.Data_.Buys_[L].Qty_, fmtQty, '\n');
-            }
-            RevPrint(rbuf, "---\n");
-            for (int L = 0; L < fon9::fmkt::SymbBS::kBSCount; ++L) {
-               RevPrint(rbuf, symi->BS_.Data_.Sells_[L].Pri_, fmtPri, " / ", symi->BS_.Data_.Sells_[L].Qty_, fmtQty, '\n');
-            }
-            fon9::RevPrint(rbuf,
-               "SymbId=", symi->SymbId_, "\n"
-               "Last deal: ", symi->Deal_.Data_.Time_, "\n"
-               "      Pri: ", symi->Deal_.Data_.Deal_.Pri_, fmtPri, "\n"
-               "      Qty: ", symi->Deal_.Data_.Deal_.Qty_, fmtQty, "\n"
-               " TotalQty: ", symi->Deal_.Data_.TotalQty_, fmtQty, "\n"
-               "Last Sells - Buys: ", symi->BS_.Data_.Time_, "\n"
-               );
-            std::cout << fon9::BufferTo<std::string>(rbuf.MoveOut()) << std::endl;
-         }
       }
    }
 
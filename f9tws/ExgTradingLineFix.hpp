@@ -38,8 +38,10 @@ f9tws_API std::string TwsFixArgParser(ExgTradingLineFixArgs& args, fon9::StrView
 /// 建立適合 TSE/OTC 使用的 fixSender.
 /// - 上市 retval->Initialize(recPath + "FIX44_XTAI_BrkId_SocketId.log");
 /// - 上櫃 retval->Initialize(recPath + "FIX44_ROCO_BrkId_SocketId.log");
+/// - recArgs: FixRecorder 的寫檔方式, 通常使用 FixConfig::RecorderArgs_;
 /// retval.empty() 成功, retval = 失敗訊息.
-f9tws_API std::string MakeExgTradingLineFixSender(const ExgTradingLineFixArgs& args, fon9::StrView recPath, f9fix::IoFixSenderSP& out);
+f9tws_API std::string MakeExgTradingLineFixSender(const ExgTradingLineFixArgs& args, fon9::StrView recPath, f9fix::IoFixSenderSP& out,
+                                                  const f9fix::FixRecorderArgs& recArgs = f9fix::FixRecorderArgs{});
 
 //--------------------------------------------------------------------------//
 
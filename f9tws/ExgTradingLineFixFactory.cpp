@@ -28,7 +28,7 @@ fon9::io::SessionSP ExgTradingLineFixFactory::CreateSession(fon9::IoManager& mgr
    fixLogPath.RebuildFileName(fon9::UtcNow());
 
    fon9::fix::IoFixSenderSP fixSender;
-   errReason = f9tws::MakeExgTradingLineFixSender(args, &fixLogPath.GetFileName(), fixSender);
+   errReason = f9tws::MakeExgTradingLineFixSender(args, &fixLogPath.GetFileName(), fixSender, this->FixConfig_.RecorderArgs_);
    if (!errReason.empty())
       return fon9::io::SessionSP{};
    return this->CreateTradingLine(*twsLineMgr, args, std::move(fixSender));
@@ -1,29 +1,15 @@
 ﻿// \file fon9/DefaultThreadPool.cpp
 // \author fonwinz@gmail.com
+#define _CRT_SECURE_NO_WARNINGS  // Windows: getenv()
 #include "fon9/DefaultThreadPool.hpp"
 #include "fon9/sys/OnWindowsMainExit.hpp"
 
 namespace fon9 {
 
-struct DefaultThreadTaskHandler {
-   using MessageType = DefaultThreadTask;
-   DefaultThreadTaskHandler(DefaultThreadPool&) {
-      if (gWaitLogSystemReady)
-         gWaitLogSystemReady();
-   }
-   void OnMessage(DefaultThreadTask& task) {
-      task();
-   }
-   void OnThreadEnd(const std::string& threadName) {
-      (void)threadName;
-   }
-};
-
 fon9_API DefaultThreadPool& GetDefaultThreadPool() {
    struct DefaultThreadPoolImpl : public DefaultThreadPool, sys::OnWindowsMainExitHandle {
       fon9_NON_COPY_NON_MOVE(DefaultThreadPoolImpl);
       DefaultThreadPoolImpl() {
-         // TODO: 從 getenv()、argv 取得參數?
          // 目前有用到的地方:
          //  - log file(FileAppender)
          //  - DN resolve(io/SocketAddressDN.cpp)
@@ -32,9 +18,23 @@ fon9_API DefaultThreadPool& GetDefaultThreadPool() {
          //  - ...
          // 這裡的 threadCount 應該考慮以上不同工作種類的數量, 與 CPU 核心數無關.
          // 因為以上的工作都是: 低 CPU 用量, 且 IO blocking.
-         uint32_t threadCount = 4;
-
-         this->StartThread(threadCount, "fon9.DefaultThreadPool");
+         // 所以預設 ThreadCount=4, 可透過環境變數調整.
+         DefaultThreadPoolArgs args;
+         std::string           errmsg;
+         if (const char* envstr = getenv("fon9DefaultThreadPool")) {
+            RevBufferList rbuf{128};
+            if (!ParseConfig(args, StrView_cstr(envstr), rbuf)) {
+               RevPrint(rbuf, "DefaultThreadPool.Args|env=fon9DefaultThreadPool|cfg=", envstr, '|');
+               errmsg = BufferTo<std::string>(rbuf.MoveOut());
+            }
+         }
+         this->StartThread(args, "fon9.DefaultThreadPool");
+         // log 可能會用到 DefaultThreadPool(例: FileAppender), 所以不能在此直接寫 log, 必須等 ThreadPool_ 建構完畢.
+         if (!errmsg.empty()) {
+            this->EmplaceMessage([errmsg]() {
+               fon9_LOG_ERROR(errmsg);
+            });
+         }
       }
       void OnWindowsMainExit_Notify() {
          this->NotifyForEndNow();
@@ -2,20 +2,24 @@
 /// \author fonwinz@gmail.com
 #ifndef __fon9_DefaultThreadPool_hpp__
 #define __fon9_DefaultThreadPool_hpp__
-#include "fon9/MessageQueue.hpp"
+#include "fon9/ThreadPool.hpp"
+#include "fon9/Log.hpp"
 
 namespace fon9 {
 
 /// \ingroup Thrs
 /// 在 GetDefaultThreadPool() 裡面執行的單一作業。
-using DefaultThreadTask = std::function<void()>;
-struct DefaultThreadTaskHandler;
-using DefaultThreadPool = MessageQueue<DefaultThreadTaskHandler, DefaultThreadTask>;
+using DefaultThreadTask = ThreadTask;
+using DefaultThreadPool = ThreadPool;
+using DefaultThreadPoolArgs = ThreadPoolArgs;
 
 /// \ingroup Thrs
 /// 取得 fon9 提供的一個 thread pool.
 /// * 一般用於不急迫, 但比較花時間的簡單工作, 例如: 寫檔、domain name 查找...
 /// * 程式結束時, 剩餘的工作會被拋棄!
+/// * 第一次呼叫時啟動, 參數從環境變數 "fon9DefaultThreadPool" 取得, 格式請參考 ThreadPoolArgs;
+///   例: `export fon9DefaultThreadPool="ThreadCount=4|Cpus=2,3"`
+///   預設 ThreadCount=4, 不綁定 cpu.
 fon9_API DefaultThreadPool& GetDefaultThreadPool();
 
 } // namespaces
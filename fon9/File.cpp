@@ -6,6 +6,7 @@
 #include "fon9/sys/FileWin32.hpp"
 #else
 #include "fon9/sys/FilePOSIX.hpp"
+#include <sys/mman.h>
 #endif
 
 namespace fon9 {
@@ -30,6 +31,7 @@ static const FileModeDefine_impl FileModeDef_[]{
    DEF_FILEMODE(Trunc),
    DEF_FILEMODE(DenyRead),
    DEF_FILEMODE(DenyWrite),
+   DEF_FILEMODE(DirectIO),
 };
 
 FileMode StrToFileMode(StrView modes) {
@@ -177,4 +179,48 @@ File::Result File::Append(DcQueueList& outbuf) {
    return AppWrite(this->Fdr_, outbuf);
 }
 
+//--------------------------------------------------------------------------//
+File::Result FileMapView::Map(const File& fd, Advice advice) {
+   this->Unmap();
+   File::Result res = fd.GetFileSize();
+   if (!res || res.GetResult() <= 0)
+      return res;
+   const size_t sz = static_cast<size_t>(res.GetResult());
+   if (sz != res.GetResult()) // 32 位元系統, 無法映射超過 4G 的檔案.
+      return std::make_error_condition(std::errc::value_too_large);
+#ifdef fon9_WINDOWS
+   (void)advice;
+   HANDLE hmap = CreateFileMapping(fd.Fdr_.GetFD(), nullptr, PAGE_READONLY, 0, 0, nullptr);
+   if (hmap == nullptr)
+      return GetSysErrC();
+   void* pmap = MapViewOfFile(hmap, FILE_MAP_READ, 0, 0, sz);
+   CloseHandle(hmap); // view 會保留 mapping object, 直到 UnmapViewOfFile().
+   if (pmap == nullptr)
+      return GetSysErrC();
+#else
+   void* pmap = mmap(nullptr, sz, PROT_READ, MAP_SHARED, fd.Fdr_.GetFD(), 0);
+   if (pmap == MAP_FAILED)
+      return GetSysErrC();
+   switch (advice) {
+   case Advice::Normal:     break;
+   case Advice::Sequential: madvise(pmap, sz, MADV_SEQUENTIAL); break;
+   case Advice::Random:     madvise(pmap, sz, MADV_RANDOM);     break;
+   }
+#endif
+   this->Ptr_ = reinterpret_cast<const char*>(pmap);
+   this->Size_ = sz;
+   return res;
+}
+void FileMapView::Unmap() {
+   if (this->Ptr_ == nullptr)
+      return;
+#ifdef fon9_WINDOWS
+   UnmapViewOfFile(this->Ptr_);
+#else
+   munmap(const_cast<char*>(this->Ptr_), this->Size_);
+#endif
+   this->Ptr_ = nullptr;
+   this->Size_ = 0;
+}
+
 } // namespaces
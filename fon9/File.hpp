@@ -38,6 +38,12 @@ enum class FileMode {
    /// 開檔後禁止其他人用寫入模式開檔, 直到檔案關閉為止.
    /// 若已有其他人用寫入模式開檔, 則此次開檔會失敗.
    DenyWrite = 0x0200,
+
+   /// 不經過 OS 的檔案緩衝, 直接寫入儲存媒體.
+   /// - Linux: O_DIRECT; Windows: FILE_FLAG_NO_BUFFERING
+   /// - 讀寫的緩衝區位置、大小、檔案位置, 都必須對齊儲存媒體的 block(一般使用 4096).
+   /// - 若系統不支援, 則開檔失敗.
+   DirectIO = 0x0400,
 };
 fon9_ENABLE_ENUM_BITWISE_OP(FileMode);
 
@@ -69,6 +75,7 @@ fon9_WARN_DISABLE_PADDING;
 /// - 不額外提供 txt 讀寫函式, 如果有需要, fopen()、fgets() 可能會是更好的選擇.
 class fon9_API File {
    fon9_NON_COPYABLE(File);
+   friend class FileMapView;
 
    /// 呼叫 Open() 時的 fname.
    std::string OpenName_;
@@ -188,6 +195,42 @@ public:
       return this->Fdr_.ReleaseFD();
    }
 };
+
+/// \ingroup Misc
+/// 將已開啟的檔案映射到記憶體(唯讀), 讀取端可直接使用 page cache 的內容, 不用複製到緩衝區.
+/// - 映射範圍: 呼叫 Map() 時的檔案大小, 之後檔案增加的內容不在映射範圍內.
+/// - 映射期間不可縮小檔案, 否則存取超過檔尾的 page 會造成 SIGBUS.
+class fon9_API FileMapView {
+   fon9_NON_COPY_NON_MOVE(FileMapView);
+   const char* Ptr_{nullptr};
+   size_t      Size_{0};
+public:
+   /// 存取方式的建議, 用於 madvise(); Windows 不支援, 所以忽略.
+   enum class Advice {
+      Normal,
+      /// 循序讀取: 核心會積極預讀, 並可提早釋放已讀過的 page.
+      Sequential,
+      /// 隨機讀取(或從尾端往前讀): 不預讀.
+      Random,
+   };
+
+   FileMapView() = default;
+   ~FileMapView() {
+      this->Unmap();
+   }
+
+   /// 先 Unmap(), 然後映射 fd 的全部內容.
+   /// \retval success 映射的大小, 若檔案大小為 0, 則不會映射, 此時 data()==nullptr.
+   File::Result Map(const File& fd, Advice advice);
+   void Unmap();
+
+   const char* data() const {
+      return this->Ptr_;
+   }
+   size_t size() const {
+      return this->Size_;
+   }
+};
 fon9_WARN_POP;
 
 } // namespaces
@@ -178,7 +178,9 @@ bool AsyncFileAppender::MakeCallNow(WorkContentLocker&& lk) {
    // 所以在此先釋放上面的 if (intrusive_ptr_add_ref(this) == 0)...
    // 並使用 intrusive_ptr<> pthis 傳遞, 這樣才能確保當要求的 task 沒有執行時, this 仍會正常死亡!
 
-   GetDefaultThreadPool().EmplaceMessage([pthis]() {
+   ThreadPool* thrPoolPtr = this->GetThreadPool();
+   ThreadPool& thrPool = (thrPoolPtr ? *thrPoolPtr : GetDefaultThreadPool());
+   thrPool.EmplaceMessage([pthis]() {
       WorkContentLocker lk2{pthis->Worker_.Lock()};
       lk2->SetAsyncTaken();
       pthis->Worker_.TakeCallLocked(std::move(lk2));
@@ -9,6 +9,7 @@
 
 fon9_BEFORE_INCLUDE_STD;
 #include <future>
+#include <atomic>
 fon9_AFTER_INCLUDE_STD;
 
 namespace fon9 {
@@ -109,13 +110,16 @@ public:
    }
 };
 
+class ThreadPool;
+
 /// \ingroup Misc
-/// - 當收到 Append() 要求時, 丟到 DefaultThreadPool 寫檔.
+/// - 當收到 Append() 要求時, 丟到 DefaultThreadPool(或 SetThreadPool() 指定的 ThreadPool) 寫檔.
 class fon9_API AsyncFileAppender : public intrusive_ref_counter<AsyncFileAppender>, public FileAppender {
    fon9_NON_COPY_NON_MOVE(AsyncFileAppender);
    using base = FileAppender;
 
-   size_t   HighWaterLevelNodeCount_{0};
+   size_t      HighWaterLevelNodeCount_{0};
+   std::atomic<ThreadPool*>   ThreadPool_{nullptr};
 
 protected:
    using base::base;
@@ -145,6 +149,15 @@ public:
    void SetHighWaterLevelNodeCount(size_t highWaterLevelNodeCount) {
       this->HighWaterLevelNodeCount_ = highWaterLevelNodeCount;
    }
+   /// 指定寫檔使用的 ThreadPool, nullptr 表示使用 GetDefaultThreadPool();
+   /// - 可在寫入過程中更換: 已交給原本 ThreadPool 的工作仍在原本的 ThreadPool 執行, 之後的工作才使用新的.
+   /// - threadPool 必須比 this 晚結束, 或在 threadPool 結束前先 WaitFlushed().
+   void SetThreadPool(ThreadPool* threadPool) {
+      this->ThreadPool_.store(threadPool, std::memory_order_release);
+   }
+   ThreadPool* GetThreadPool() const {
+      return this->ThreadPool_.load(std::memory_order_acquire);
+   }
 
    using AsyncFileAppenderSP = intrusive_ptr<AsyncFileAppender>;
 
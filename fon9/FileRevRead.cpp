@@ -9,6 +9,29 @@ FileRevRead::~FileRevRead() {
 File::Result FileRevRead::OnFileRead(File& fd, File::PosType fpos, void* blockBuffer, size_t rdsz) {
    return fd.Read(fpos, blockBuffer, rdsz);
 }
+void FileRevRead::OnFileMapped(const char* pblock, size_t rdsz) {
+   (void)pblock; (void)rdsz;
+}
+File::Result FileRevRead::StartMapped(File& fd, const size_t blockSize, FileMapView::Advice advice) {
+   FileMapView  mapped;
+   File::Result res = mapped.Map(fd, advice);
+   if (!res || res.GetResult() <= 0)
+      return res;
+   this->BlockPos_ = res.GetResult();
+   size_t   rdsz = this->BlockPos_ % blockSize;
+   if (rdsz == 0)
+      rdsz = blockSize;
+   for (;;) {
+      this->BlockPos_ -= rdsz;
+      this->OnFileMapped(mapped.data() + this->BlockPos_, rdsz);
+      if (this->OnFileBlock(rdsz) == LoopControl::Break)
+         break;
+      if (this->BlockPos_ == 0)
+         break;
+      rdsz = blockSize;
+   }
+   return File::Result{this->BlockPos_};
+}
 File::Result FileRevRead::Start(File& fd, void* blockBuffer, const size_t blockSize) {
    File::Result res = fd.GetFileSize();
    if (!res || res.GetResult() <= 0)
@@ -37,22 +60,34 @@ void FileRevSearch::MoveRemainBuffer() {
       this->LastRemainSize_ = 0;
       if (rsz > this->MaxMessageBufferSize_)
          rsz = this->MaxMessageBufferSize_;
-      memcpy(this->BlockBufferPtr_ + this->BlockSize_, this->BlockBufferPtr_, rsz);
-      this->PayloadEnd_ = this->BlockBufferPtr_ + this->BlockSize_ + rsz;
+      memcpy(this->ReadBuffer_ + this->BlockSize_, this->BlockBufferPtr_, rsz);
+      this->PayloadEnd_ = this->ReadBuffer_ + this->BlockSize_ + rsz;
+   }
+   else
+      this->PayloadEnd_ = nullptr;
+   this->BlockBufferPtr_ = this->ReadBuffer_;
+}
+void FileRevSearch::SetMappedBlock(const char* pblock, size_t rdsz) {
+   this->BlockBufferPtr_ = pblock;
+   if (size_t rsz = this->LastRemainSize_) {
+      this->LastRemainSize_ = 0;
+      if (rsz > this->MaxMessageBufferSize_)
+         rsz = this->MaxMessageBufferSize_;
+      this->PayloadEnd_ = this->BlockBufferPtr_ + rdsz + rsz;
    }
    else
       this->PayloadEnd_ = nullptr;
 }
 LoopControl FileRevSearch::RevSearchBlock(File::PosType fpos, char ch, size_t rdsz) {
    (void)fpos;
-   char* pend = this->PayloadEnd_ ? this->PayloadEnd_ : (this->BlockBufferPtr_ + rdsz);
-   while (void* const pfind = const_cast<void*>(memrchr(this->BlockBufferPtr_, ch, rdsz))) {
-      if (this->OnFoundChar(reinterpret_cast<char*>(pfind), pend) == LoopControl::Break) {
+   const char* pend = this->PayloadEnd_ ? this->PayloadEnd_ : (this->BlockBufferPtr_ + rdsz);
+   while (const void* const pfind = memrchr(this->BlockBufferPtr_, ch, rdsz)) {
+      if (this->OnFoundChar(reinterpret_cast<const char*>(pfind), pend) == LoopControl::Break) {
          this->FoundDataEnd_ = pend;
-         this->LastRemainSize_ = static_cast<size_t>(reinterpret_cast<char*>(pfind) - this->BlockBufferPtr_);
+         this->LastRemainSize_ = static_cast<size_t>(reinterpret_cast<const char*>(pfind) - this->BlockBufferPtr_);
          return LoopControl::Break;
       }
-      pend = reinterpret_cast<char*>(pfind);
+      pend = reinterpret_cast<const char*>(pfind);
       if ((rdsz = static_cast<size_t>(pend - this->BlockBufferPtr_)) <= 0)
          break;
    }
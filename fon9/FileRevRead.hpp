@@ -33,6 +33,13 @@ public:
    /// \retval success 最後一次讀取區塊的檔案位置.
    File::Result Start(File& fd, void* blockBuffer, size_t blockSize);
 
+   /// 與 Start() 相同的讀取順序, 但使用 FileMapView 將檔案映射到記憶體, 不複製資料:
+   /// - 不會呼叫 OnFileRead(), 改成透過 this->OnFileMapped(pblock, rdsz) 通知區塊在記憶體中的位置,
+   ///   然後呼叫 this->OnFileBlock(rdsz);
+   /// - pblock 在 StartMapped() 返回後就不能再使用.
+   /// - 若無法映射(例: 32 位元系統的大檔), 則在呼叫任何事件前返回失敗, 此時可改用 Start();
+   File::Result StartMapped(File& fd, size_t blockSize, FileMapView::Advice advice);
+
    File::PosType GetBlockPos() const {
       return this->BlockPos_;
    }
@@ -41,6 +48,9 @@ protected:
    /// 預設: return fd.Read(fpos, blockBuffer, rdsz);
    /// 您可以 override, 並在 fd.Read() 前後執行額外工作.
    virtual File::Result OnFileRead(File& fd, File::PosType fpos, void* blockBuffer, size_t rdsz);
+   /// 使用 StartMapped() 時, 在 OnFileBlock() 之前通知區塊位置.
+   /// 預設: 不做任何事.
+   virtual void OnFileMapped(const char* pblock, size_t rdsz);
 
 private:
    File::PosType BlockPos_;
@@ -63,6 +73,9 @@ public:
    File::Result Start(File& fd) {
       return base::Start(fd, this->BlockBuffer_, kBlockSize);
    }
+   File::Result StartMapped(File& fd, FileMapView::Advice advice) {
+      return base::StartMapped(fd, kBlockSize, advice);
+   }
    char* GetBlockBuffer() {
       return this->BlockBuffer_;
    }
@@ -75,30 +88,37 @@ class fon9_API FileRevSearch {
    fon9_NON_COPY_NON_MOVE(FileRevSearch);
 protected:
    /// RevSearchBlock() 之後, 該次的區塊資料結束位置.
-   char*    PayloadEnd_{nullptr};
+   const char* PayloadEnd_{nullptr};
    /// RevSearchBlock() 之後, BlockBuffer 前方剩餘資料量:
    /// - 沒找到指定字元: RevSearchBlock() 返回 Continue;
    /// - RevSearchBlock() 返回 Break = 尚未尋找的資料量: pfind - this->BlockBufferPtr_;
-   size_t   LastRemainSize_{0};
+   size_t      LastRemainSize_{0};
    /// OnFoundChar(pfind, pend) 返回 Break 時的 pend;
-   char*    FoundDataEnd_{nullptr};
+   const char* FoundDataEnd_{nullptr};
 
    /// 找到指定的字元時的通知.
    /// - *pbeg == 要求尋找的的字元.
    /// - pend = 檔尾 or 上次找到的指定字元位置 or (pbeg + kMaxMessageBufferSize).
-   virtual LoopControl OnFoundChar(char* pbeg, char* pend) = 0;
+   /// - 資料可能在唯讀的映射記憶體(StartMapped()), 所以不能修改.
+   virtual LoopControl OnFoundChar(const char* pbeg, const char* pend) = 0;
 
    virtual ~FileRevSearch();
 
 public:
    const size_t   BlockSize_;
    const size_t   MaxMessageBufferSize_;
-   char* const    BlockBufferPtr_;
+   /// 建構時提供的緩衝區, 使用 FileRevRead::Start() 時, 由 MoveRemainBuffer() 搬移剩餘資料.
+   char* const    ReadBuffer_;
+   /// 目前區塊的開始位置:
+   /// - 使用 FileRevRead::Start() 時: 必定為 ReadBuffer_;
+   /// - 使用 FileRevRead::StartMapped() 時, 由 SetMappedBlock() 設定為映射記憶體(唯讀)中的目前區塊.
+   const char*    BlockBufferPtr_;
 
    FileRevSearch(size_t blockSize, size_t maxMessageBufferSize, void* blockBuffer)
       : BlockSize_{blockSize}
       , MaxMessageBufferSize_{maxMessageBufferSize}
-      , BlockBufferPtr_{reinterpret_cast<char*>(blockBuffer)} {
+      , ReadBuffer_{reinterpret_cast<char*>(blockBuffer)}
+      , BlockBufferPtr_{ReadBuffer_} {
    }
    
    template <size_t blockSize, size_t maxMessageBufferSize>
@@ -128,6 +148,11 @@ public:
    /// - this->LastRemainSize_ = 0;
    /// - 重算下次讀取 this->BlockSize_ 之後的 this->PayloadEnd_;
    void MoveRemainBuffer();
+   /// 使用 FileRevRead::StartMapped() 時, 用來取代 MoveRemainBuffer();
+   /// 映射的記憶體是連續的, 上次 RevSearchBlock() 未用到的資料就在此區塊之後, 不用搬移:
+   /// - this->BlockBufferPtr_ = pblock;
+   /// - 重算 this->PayloadEnd_ = pblock + rdsz + 上次剩餘的資料量(最多 MaxMessageBufferSize_);
+   void SetMappedBlock(const char* pblock, size_t rdsz);
 };
 
 template <class RevReaderT, class RevSearcherT>
@@ -143,6 +168,9 @@ struct RevReadSearcher : public RevReaderT, public RevSearcherT {
       this->MoveRemainBuffer();
       return RevReaderT::OnFileRead(fd, fpos, blockBuffer, rdsz);
    }
+   void OnFileMapped(const char* pblock, size_t rdsz) override {
+      this->SetMappedBlock(pblock, rdsz);
+   }
 };
 
 } // namespace
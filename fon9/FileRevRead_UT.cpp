@@ -23,7 +23,7 @@ int main(int argc, char** args) {
    #endif
    if(argc < 3) {
       printf("Reverse InputFile lines to OutputFile.\n"
-             "Usage:  InputFile OutputFile\n");
+             "Usage:  InputFile OutputFile [mmap]\n");
       return 3;
    }
    fon9::File fdin;
@@ -42,10 +42,10 @@ int main(int argc, char** args) {
          if (this->RevSearchBlock(this->GetBlockPos(), '\n', rdsz) == fon9::LoopControl::Break)
             return fon9::LoopControl::Break;
          if (this->GetBlockPos() == 0 && this->LastRemainSize_ > 0)
-            this->AppendLine(this->BlockBuffer_, this->LastRemainSize_);
+            this->AppendLine(this->BlockBufferPtr_, this->LastRemainSize_);
          return fon9::LoopControl::Continue;
       }
-      virtual fon9::LoopControl OnFoundChar(char* pbeg, char* pend) override {
+      virtual fon9::LoopControl OnFoundChar(const char* pbeg, const char* pend) override {
          ++pbeg; // *pbeg=='\n'; => 應放在行尾.
          if (pbeg == pend && this->LineCount_ == 0)
             ++this->LineCount_;
@@ -53,7 +53,7 @@ int main(int argc, char** args) {
             this->AppendLine(pbeg, static_cast<size_t>(pend - pbeg));
          return fon9::LoopControl::Continue;
       }
-      void AppendLine(char* pbeg, size_t lnsz) {
+      void AppendLine(const char* pbeg, size_t lnsz) {
          this->FdOut_.Append(pbeg, lnsz);
          this->FdOut_.Append("\n", 1);
          ++this->LineCount_;
@@ -62,7 +62,8 @@ int main(int argc, char** args) {
    RevReader reader;
    if (!OpenFile("Output file: ", reader.FdOut_, args[2], fon9::FileMode::Append | fon9::FileMode::CreatePath | fon9::FileMode::Trunc))
       return 3;
-   auto res = reader.Start(fdin);
+   const bool isMapped = (argc > 3 && strcmp(args[3], "mmap") == 0);
+   auto res = isMapped ? reader.StartMapped(fdin, fon9::FileMapView::Advice::Random) : reader.Start(fdin);
    printf("Line count: %lu\n", reader.LineCount_);
    if (!res)
       puts(fon9::RevPrintTo<std::string>("Error: ", res).c_str());
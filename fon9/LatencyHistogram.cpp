@@ -0,0 +1,41 @@
+﻿/// \file fon9/LatencyHistogram.cpp
+/// \author fonwinz@gmail.com
+#include "fon9/LatencyHistogram.hpp"
+#include "fon9/RevPrint.hpp"
+
+namespace fon9 {
+
+uint64_t LatencyHistogram::GetPercentileNs(double pct) const {
+   const uint64_t count = this->GetCount();
+   if (count == 0)
+      return 0;
+   const double   target = static_cast<double>(count) * pct / 100;
+   uint64_t       accu = 0;
+   for (unsigned L = 0; L < kBucketCount; ++L) {
+      accu += this->GetBucket(L);
+      if (static_cast<double>(accu) >= target)
+         return (L + 1 < kBucketCount) ? (static_cast<uint64_t>(2) << L) : this->GetMaxNs();
+   }
+   return this->GetMaxNs();
+}
+
+fon9_API void RevPrint(RevBuffer& rbuf, const LatencyHistogram& hist) {
+   char chSpl = 0;
+   for (unsigned L = LatencyHistogram::kBucketCount; L > 0;) {
+      if (uint64_t n = hist.GetBucket(--L)) {
+         if (chSpl)
+            RevPutChar(rbuf, chSpl);
+         RevPrint(rbuf, '<', static_cast<uint64_t>(2) << L, ':', n);
+         chSpl = ',';
+      }
+   }
+   RevPrint(rbuf, "count=", hist.GetCount(),
+            "|avg=", hist.GetAvgNs(),
+            "|p50=", hist.GetPercentileNs(50),
+            "|p99=", hist.GetPercentileNs(99),
+            "|p999=", hist.GetPercentileNs(99.9),
+            "|max=", hist.GetMaxNs(),
+            "|hist=");
+}
+
+} // namespaces
@@ -0,0 +1,90 @@
+﻿/// \file fon9/LatencyHistogram.hpp
+/// \author fonwinz@gmail.com
+#ifndef __fon9_LatencyHistogram_hpp__
+#define __fon9_LatencyHistogram_hpp__
+#include "fon9/buffer/RevBuffer.hpp"
+#include <atomic>
+
+namespace fon9 {
+
+/// \ingroup Misc
+/// 以 2 的 n 次方(ns)分級的耗時統計, 用來觀察 tail latency.
+/// - 第 0 級: [0..2ns); 第 n 級: [2^n .. 2^(n+1))ns; 最後一級包含全部更大的值.
+/// - 只能有一個寫入者(例: 在 FdrThread 裡面記錄每次迴圈的耗時), 但可以在其他 thread 讀取(結果為近似值).
+class fon9_API LatencyHistogram {
+   fon9_NON_COPY_NON_MOVE(LatencyHistogram);
+public:
+   enum : unsigned {
+      kBucketCount = 40,
+   };
+   LatencyHistogram() {
+      this->Clear();
+   }
+
+   /// 只能在寫入者的 thread 呼叫.
+   void Clear() {
+      for (auto& b : this->Buckets_)
+         b.store(0, std::memory_order_relaxed);
+      this->Count_.store(0, std::memory_order_relaxed);
+      this->SumNs_.store(0, std::memory_order_relaxed);
+      this->MaxNs_.store(0, std::memory_order_relaxed);
+   }
+
+   static unsigned GetBucketIndex(uint64_t ns) {
+      unsigned idx = 0;
+      while ((ns >>= 1) != 0)
+         ++idx;
+      return idx < kBucketCount ? idx : (kBucketCount - 1);
+   }
+
+   /// 只有一個寫入者, 所以用 load + store, 不用 fetch_add.
+   void Add(uint64_t ns) {
+      auto& b = this->Buckets_[GetBucketIndex(ns)];
+      b.store(b.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      this->Count_.store(this->Count_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      this->SumNs_.store(this->SumNs_.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+      if (this->MaxNs_.load(std::memory_order_relaxed) < ns)
+         this->MaxNs_.store(ns, std::memory_order_relaxed);
+   }
+
+   /// 合併 rhs 的統計結果, 例: 各 thread 分別記錄, 最後再合併.
+   /// 只能在寫入者的 thread 呼叫.
+   void Merge(const LatencyHistogram& rhs) {
+      for (unsigned L = 0; L < kBucketCount; ++L)
+         this->Buckets_[L].store(this->GetBucket(L) + rhs.GetBucket(L), std::memory_order_relaxed);
+      this->Count_.store(this->GetCount() + rhs.GetCount(), std::memory_order_relaxed);
+      this->SumNs_.store(this->SumNs_.load(std::memory_order_relaxed) + rhs.SumNs_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      if (this->GetMaxNs() < rhs.GetMaxNs())
+         this->MaxNs_.store(rhs.GetMaxNs(), std::memory_order_relaxed);
+   }
+
+   uint64_t GetCount() const {
+      return this->Count_.load(std::memory_order_relaxed);
+   }
+   uint64_t GetMaxNs() const {
+      return this->MaxNs_.load(std::memory_order_relaxed);
+   }
+   uint64_t GetAvgNs() const {
+      const uint64_t count = this->GetCount();
+      return count ? (this->SumNs_.load(std::memory_order_relaxed) / count) : 0;
+   }
+   uint64_t GetBucket(unsigned idx) const {
+      return this->Buckets_[idx].load(std::memory_order_relaxed);
+   }
+   /// 取得 pct(0..100) 百分位所在分級的上限(ns).
+   /// 例: GetPercentileNs(99) 傳回 1024, 表示至少 99% 的耗時 < 1024ns.
+   uint64_t GetPercentileNs(double pct) const;
+
+private:
+   std::atomic<uint64_t>   Buckets_[kBucketCount];
+   std::atomic<uint64_t>   Count_;
+   std::atomic<uint64_t>   SumNs_;
+   std::atomic<uint64_t>   MaxNs_;
+};
+
+/// 輸出格式: "count=n|avg=ns|p50=ns|p99=ns|p999=ns|max=ns|hist=<2^n:count,...";
+/// hist 只輸出有資料的分級, 例: "hist=<256:12,<512:3" 表示 [128..256)ns 有 12 次, [256..512)ns 有 3 次.
+fon9_API void RevPrint(RevBuffer& rbuf, const LatencyHistogram& hist);
+
+} // namespaces
+#endif//__fon9_LatencyHistogram_hpp__
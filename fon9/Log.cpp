@@ -38,32 +38,53 @@ static void LogWriteToStdout(const LogArgs& /*logArgs*/, BufferList&& buf) {
    assert(dcQueue.empty());
 }
 static FnLogWriter      FnLogWriter_ = &LogWriteToStdout;
+static FnLogLazyWriter  FnLogLazyWriter_;
 static TimeZoneOffset   LogTimeZoneAdjust_;
 void (*gWaitLogSystemReady)();
 
-fon9_API void SetLogWriter(FnLogWriter fnLogWriter, TimeZoneOffset tzadj) {
+fon9_API void SetLogWriter(FnLogWriter fnLogWriter, TimeZoneOffset tzadj, FnLogLazyWriter fnLazyWriter) {
    FnLogWriter_ = fnLogWriter ? fnLogWriter : &LogWriteToStdout;
+   FnLogLazyWriter_ = fnLogWriter ? fnLazyWriter : nullptr;
    LogTimeZoneAdjust_ = tzadj;
 }
 fon9_API void UnsetLogWriter(FnLogWriter fnLogWriter) {
    if (FnLogWriter_ == fnLogWriter) {
       FnLogWriter_ = &LogWriteToStdout;
+      FnLogLazyWriter_ = nullptr;
       LogTimeZoneAdjust_ = TimeZoneOffset{};
    }
 }
+fon9_API FnLogLazyWriter GetLogLazyWriter() {
+   return FnLogLazyWriter_;
+}
 
 fon9_API void LogWrite(const LogArgs& logArgs, BufferList&& buf) {
    FnLogWriter_(logArgs, std::move(buf));
 }
 
-fon9_API void AddLogHeader(RevBufferList& rbuf, TimeStamp utctm, LogLevel level) {
-   RevPrint(rbuf, ThisThread_.GetThreadIdStr(), GetLevelStr(level));
+fon9_API void AddLogHeader(RevBufferList& rbuf, TimeStamp utctm, LogLevel level, StrView thrIdStr) {
+   RevPrint(rbuf, thrIdStr, GetLevelStr(level));
    RevPut_Date_Time_us(rbuf, utctm + LogTimeZoneAdjust_);
 }
+fon9_API void AddLogHeader(RevBufferList& rbuf, TimeStamp utctm, LogLevel level) {
+   AddLogHeader(rbuf, utctm, level, ThisThread_.GetThreadIdStr());
+}
 fon9_API void LogWrite(LogLevel level, RevBufferList&& rbuf) {
    LogArgs logArgs{level};
    AddLogHeader(rbuf, logArgs.UtcTime_, level);
    FnLogWriter_(logArgs, rbuf.MoveOut());
 }
 
+fon9_API BufferList LogLazyFormat(const LogArgs& logArgs, BufferList&& packed) {
+   BufferList     autoFree{std::move(packed)};
+   RevBufferList  rbuf{kLogBlockNodeSize};
+   if (const BufferNode* node = autoFree.front()) {
+      const LogLazyHead& head = *reinterpret_cast<const LogLazyHead*>(LogLazyHead::AlignAddr(node->GetDataBegin()));
+      RevPutChar(rbuf, '\n');
+      head.FnFormat_(rbuf, head);
+      AddLogHeader(rbuf, logArgs.UtcTime_, logArgs.Level_, head.ThreadId_.GetThreadIdStr());
+   }
+   return rbuf.MoveOut();
+}
+
 }// namespace
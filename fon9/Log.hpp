@@ -4,7 +4,10 @@
 #define __fon9_Log_hpp__
 #include "fon9/RevFormat.hpp"
 #include "fon9/TimeStamp.hpp"
+#include "fon9/ThreadId.hpp"
 #include "fon9/buffer/RevBufferList.hpp"
+#include "fon9/buffer/FwdBufferList.hpp"
+#include <cstddef>
 
 namespace fon9 {
 
@@ -66,14 +69,23 @@ fon9_WARN_POP;
 /// logArgs.Time_ = 此筆記錄的時間, 可用來判斷是否需要開啟新檔案.
 typedef void (*FnLogWriter) (const LogArgs& logArgs, BufferList&& buf);
 
+/// \ingroup Misc
+/// fon9_LOG_LAZY() 的寫入函式型別.
+/// packed = 尚未格式化的參數(由 LogWriteLazy() 打包), 可在其他 thread 透過 LogLazyFormat() 轉成文字.
+typedef void (*FnLogLazyWriter) (const LogArgs& logArgs, BufferList&& packed);
+
 /// \ingroup Misc
 /// 設定 Log 訊息的最後寫入函式, 預設: 寫到 stdout(預設值不是 thread safe: 可能會 interlace)
 /// 如果 fnLogWriter = nullptr 則還原為預設 stdout 輸出.
+/// 如果 fnLazyWriter = nullptr 則 fon9_LOG_LAZY() 會在呼叫端格式化, 然後透過 fnLogWriter 寫入.
 /// NOT thread safe!
-fon9_API void SetLogWriter(FnLogWriter fnLogWriter, TimeZoneOffset tzadj);
+fon9_API void SetLogWriter(FnLogWriter fnLogWriter, TimeZoneOffset tzadj, FnLogLazyWriter fnLazyWriter = nullptr);
 /// \ingroup Misc
 /// 如果現在的 LogWriter == fnLogWriter, 則還原成預設值: 寫到 stdout.
 fon9_API void UnsetLogWriter(FnLogWriter fnLogWriter);
+/// \ingroup Misc
+/// 取得 SetLogWriter() 設定的 fnLazyWriter, 可能為 nullptr.
+fon9_API FnLogLazyWriter GetLogLazyWriter();
 
 /// \ingroup Misc
 /// 把 buf 寫入 log: 透過 SetLogWriter() 設定的 log 寫入函式.
@@ -137,6 +149,166 @@ extern void (*gWaitLogSystemReady)();
 /// RevPut_Date_Time_us(rbuf, utctm + tzadj) + ThisThread_.GetThreadIdStr() + GetLevelStr(level)
 /// - tzadj 在 SetLogWriter() 設定.
 fon9_API void AddLogHeader(RevBufferList& rbuf, TimeStamp utctm, LogLevel level);
+/// 在 rbuf 前端增加 log header, 但使用指定的 thrIdStr, 而非 ThisThread_.
+/// 提供給「在其他 thread 格式化」使用, 例: LogLazyFormat().
+fon9_API void AddLogHeader(RevBufferList& rbuf, TimeStamp utctm, LogLevel level, StrView thrIdStr);
+
+//--------------------------------------------------------------------------//
+
+/// \ingroup Misc
+/// fon9_LOG_LAZY() 打包後的記錄開頭, 之後接著參數 tuple, 及參數所需的字串內容.
+struct LogLazyHead {
+   typedef void (*FnFormat) (RevBufferList& rbuf, const LogLazyHead& head);
+   /// 將打包的參數, 透過 RevPrint() 填入 rbuf, 不含 header 及尾端的 '\n'.
+   FnFormat FnFormat_;
+   /// 呼叫 fon9_LOG_LAZY() 的 thread.
+   ThreadId ThreadId_;
+
+   LogLazyHead(FnFormat fnFormat) : FnFormat_{fnFormat}, ThreadId_(GetThisThreadId()) {
+   }
+
+   /// 打包的記錄從 node 的資料開始處, 對齊 kAlign 之後的位置開始存放.
+   enum : size_t { kAlign = alignof(std::max_align_t) };
+   static uintptr_t AlignAddr(const void* p) {
+      return (reinterpret_cast<uintptr_t>(p) + (kAlign - 1)) & ~static_cast<uintptr_t>(kAlign - 1);
+   }
+};
+
+/// \ingroup Misc
+/// 將 LogWriteLazy() 打包的內容, 轉成與 fon9_LOG() 相同格式的文字.
+/// - 使用打包時的 ThreadId, 及 logArgs 的時間、等級.
+/// - 返回前 packed 會被清空.
+fon9_API BufferList LogLazyFormat(const LogArgs& logArgs, BufferList&& packed);
+
+namespace impl {
+/// fon9_LOG_LAZY() 的參數如何保存:
+/// - 字串類(StrView, std::string, char[]): 複製字串內容, 保存為 StrView.
+/// - 其餘: 必須是 trivially copyable, 直接複製.
+template <class T>
+struct LogLazyArg {
+   using Stored = typename std::decay<T>::type;
+   static_assert(std::is_trivially_copyable<Stored>::value, "fon9_LOG_LAZY(): argument must be trivially copyable.");
+   static_assert(!std::is_pointer<Stored>::value || std::is_void<typename std::remove_pointer<Stored>::type>::value,
+                 "fon9_LOG_LAZY(): pointer argument is not allowed, except void*.");
+   static constexpr size_t StrSize(const T&) {
+      return 0;
+   }
+   static const T& Store(char*&, const T& v) {
+      return v;
+   }
+};
+template <class T>
+struct LogLazyArg<const T> : public LogLazyArg<T> {
+};
+template <>
+struct LogLazyArg<StrView> {
+   using Stored = StrView;
+   static size_t StrSize(StrView v) {
+      return v.size();
+   }
+   static StrView Store(char*& pstr, StrView v) {
+      const size_t sz = v.size();
+      memcpy(pstr, v.begin(), sz);
+      pstr += sz;
+      return StrView{pstr - sz, sz};
+   }
+};
+template <>
+struct LogLazyArg<std::string> : public LogLazyArg<StrView> {
+   static size_t StrSize(const std::string& v) {
+      return v.size();
+   }
+   static StrView Store(char*& pstr, const std::string& v) {
+      return LogLazyArg<StrView>::Store(pstr, ToStrView(v));
+   }
+};
+template <size_t arysz>
+struct LogLazyArg<const char[arysz]> : public LogLazyArg<StrView> {
+   static size_t StrSize(const char (&chary)[arysz]) {
+      return StrView{chary}.size();
+   }
+   static StrView Store(char*& pstr, const char (&chary)[arysz]) {
+      return LogLazyArg<StrView>::Store(pstr, StrView{chary});
+   }
+};
+template <size_t arysz>
+struct LogLazyArg<char[arysz]> : public LogLazyArg<StrView> {
+   static size_t StrSize(char (&cstr)[arysz]) {
+      return StrView_eos_or_all(cstr).size();
+   }
+   static StrView Store(char*& pstr, char (&cstr)[arysz]) {
+      return LogLazyArg<StrView>::Store(pstr, StrView_eos_or_all(cstr));
+   }
+};
+template <class ArgT>
+using LogLazyArgT = LogLazyArg<typename std::remove_reference<ArgT>::type>;
+
+template <class... StoredT>
+struct LogLazyRecord : public LogLazyHead {
+   using Args = std::tuple<StoredT...>;
+   static_assert(std::is_trivially_destructible<Args>::value, "fon9_LOG_LAZY(): argument must be trivially destructible.");
+   Args  Args_;
+
+   template <class... ArgsT>
+   LogLazyRecord(char* pstr, ArgsT&&... args)
+      : LogLazyHead{&LogLazyRecord::Format}
+      , Args_{LogLazyArgT<ArgsT>::Store(pstr, args)...} {
+   }
+   template <size_t... I>
+   static void FormatArgs(RevBufferList& rbuf, const Args& args, index_sequence<I...>) {
+      RevPrint(rbuf, std::get<I>(args)...);
+   }
+   static void Format(RevBufferList& rbuf, const LogLazyHead& head) {
+      FormatArgs(rbuf, static_cast<const LogLazyRecord&>(head).Args_, make_index_sequence<sizeof...(StoredT)>{});
+   }
+};
+
+inline size_t LogLazyStrSize() {
+   return 0;
+}
+template <class ArgT, class... ArgsT>
+inline size_t LogLazyStrSize(ArgT&& arg, ArgsT&&... args) {
+   return LogLazyArgT<ArgT>::StrSize(arg) + LogLazyStrSize(std::forward<ArgsT>(args)...);
+}
+} // namespace impl
+
+/// \ingroup Misc
+/// fon9_LOG_LAZY() 的實作:
+/// - 若有設定 FnLogLazyWriter: 將參數打包(不格式化)後交給 FnLogLazyWriter, 由 log writer thread 負責格式化.
+/// - 若沒有設定: 與 fon9_LOG() 相同, 在呼叫端格式化後寫入.
+template <class... ArgsT>
+void LogWriteLazy(LogLevel level, ArgsT&&... args) {
+   FnLogLazyWriter fnLazyWriter = GetLogLazyWriter();
+   if (fnLazyWriter == nullptr) {
+      RevBufferList rbuf{kLogBlockNodeSize};
+      RevPutChar(rbuf, '\n');
+      RevPrint(rbuf, std::forward<ArgsT>(args)...);
+      LogWrite(level, std::move(rbuf));
+      return;
+   }
+   using Record = impl::LogLazyRecord<typename impl::LogLazyArgT<ArgsT>::Stored...>;
+   static_assert(alignof(Record) <= LogLazyHead::kAlign, "fon9_LOG_LAZY(): argument alignment is too large.");
+   const size_t   strsz = impl::LogLazyStrSize(args...);
+   FwdBufferNode* node = FwdBufferNode::Alloc(LogLazyHead::kAlign - 1 + sizeof(Record) + strsz);
+   byte*          prec = reinterpret_cast<byte*>(LogLazyHead::AlignAddr(node->GetDataEnd()));
+   char*          pstr = reinterpret_cast<char*>(prec + sizeof(Record));
+   InplaceNew<Record>(prec, pstr, args...);
+   node->SetDataEnd(prec + sizeof(Record) + strsz);
+   BufferList packed;
+   packed.push_back(node);
+   fnLazyWriter(LogArgs{level}, std::move(packed));
+}
+
+/// \ingroup Misc
+/// 與 fon9_LOG() 相同的 log 格式, 但「參數的格式化」延後到 log writer thread 處理(NanoLog 的做法).
+/// - 參數只能是: 字串類(StrView, std::string, char[], 會複製內容), FmtDef, 或 trivially copyable 的型別(數字, TimeStamp...).
+/// - 因為格式化在其他 thread 進行, 所以不能使用指標(void* 除外)、或需要參考其他物件的型別.
+/// - 記錄的時間為呼叫 fon9_LOG_LAZY() 的時間, ThreadId 為呼叫者的 thread.
+/// - 若 log writer 不支援(例: 預設的 stdout, 或 InitLogWriteToFile() 沒有使用 ring), 則與 fon9_LOG() 相同.
+#define fon9_LOG_LAZY(level, ...) do {                \
+   if (fon9_UNLIKELY(level >= fon9::LogLevel_))       \
+      fon9::LogWriteLazy(level, __VA_ARGS__);         \
+} while(0)
 
 }// namespace
 #endif//__fon9_Log_hpp__
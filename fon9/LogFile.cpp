@@ -3,6 +3,8 @@
 #include "fon9/LogFile.hpp"
 #include "fon9/Log.hpp"
 #include "fon9/CountDownLatch.hpp"
+#include "fon9/MpscRing.hpp"
+#include "fon9/ThreadTools.hpp"
 
 namespace fon9 {
 
@@ -49,17 +51,22 @@ static CountDownLatch LogSystemReadyLatch_{1};
 static void WaitLogSystemReady() {
    LogSystemReadyLatch_.Wait();
 }
+/// 是否為 LogFileImpl::DrainThread_.
+static thread_local bool tlsInLogDrain_;
 
 class LogFileImpl : public LogFileAppender {
    fon9_NON_COPY_NON_MOVE(LogFileImpl);
    using base = LogFileAppender;
 
    std::string OrigStartInfo_;
+   FnLogWriter FnLogWriter_{&LogFileImpl::LogWriteToFile};
+   /// 使用 ring 時, fon9_LOG_LAZY() 的參數由 DrainThread_ 負責格式化.
+   FnLogLazyWriter FnLogLazyWriter_{nullptr};
 
    LogFileImpl(FileRotate& frConfig) {
       LogFileImpl::gLogFile = this;
       frConfig.CheckTime(UtcNow());
-      SetLogWriter(&LogFileImpl::LogWriteToFile, frConfig.GetFileNameMaker().GetTimeChecker().GetTimeZoneOffset());
+      SetLogWriter(this->FnLogWriter_, frConfig.GetFileNameMaker().GetTimeChecker().GetTimeZoneOffset(), this->FnLogLazyWriter_);
    }
 
    static void LogWriteToFile(const LogArgs& logArgs, BufferList&& buf) {
@@ -67,6 +74,114 @@ class LogFileImpl : public LogFileAppender {
       LogFileImpl::gLogFile->Append(std::move(buf));
    }
 
+   //-----------------------------------------------------------------------//
+   // 使用 MpscRing: fon9_LOG_() 不需要 lock, 由 DrainThread_ 依序取出後, 批次放入 LogFileAppender.
+   struct LogRecord {
+      TimeStamp   UtcTime_;
+      LogLevel    Level_;
+      /// Buf_ 是否為 LogWriteLazy() 打包的內容, 若是, 則需要在 DrainThread_ 格式化.
+      bool        IsLazy_;
+      BufferList  Buf_;
+   };
+   using LogRing = MpscRing<LogRecord>;
+   std::unique_ptr<LogRing>   Ring_;
+   std::thread                DrainThread_;
+   std::atomic<bool>          IsDrainEnd_{false};
+   /// 已從 Ring_ 取出, 且已放入 LogFileAppender 的數量.
+   std::atomic<size_t>        DrainedCount_{0};
+   TimeStamp::OrigType        DrainLastSecond_{-1};
+
+   static void LogWriteToRing(const LogArgs& logArgs, BufferList&& buf) {
+      // DrainThread_ 在寫入 LogFileAppender 時, 若有 log(例: 開檔失敗), 則直接寫入, 避免 ring 滿了之後的死結.
+      if (fon9_UNLIKELY(tlsInLogDrain_)) {
+         LogWriteToFile(logArgs, std::move(buf));
+         return;
+      }
+      PushToRing(LogRecord{logArgs.UtcTime_, logArgs.Level_, false, std::move(buf)});
+   }
+   static void LogLazyWriteToRing(const LogArgs& logArgs, BufferList&& packed) {
+      if (fon9_UNLIKELY(tlsInLogDrain_)) {
+         LogWriteToFile(logArgs, LogLazyFormat(logArgs, std::move(packed)));
+         return;
+      }
+      PushToRing(LogRecord{logArgs.UtcTime_, logArgs.Level_, true, std::move(packed)});
+   }
+   static void PushToRing(LogRecord&& rec) {
+      LogFileImpl* rthis = LogFileImpl::gLogFile;
+      while (fon9_UNLIKELY(!rthis->Ring_->TryPush(std::move(rec))))
+         std::this_thread::yield();
+   }
+   void StartRing(size_t ringSize) {
+      if (this->Ring_)
+         return;
+      this->Ring_.reset(new LogRing{ringSize});
+      this->DrainThread_ = std::thread(&LogFileImpl::DrainRun, this);
+   }
+   void StopRing() {
+      if (!this->Ring_)
+         return;
+      this->IsDrainEnd_.store(true, std::memory_order_release);
+      JoinThread(this->DrainThread_);
+   }
+   /// 等候呼叫前已放入 Ring_ 的訊息, 全部放入 LogFileAppender.
+   void WaitRingDrained() {
+      if (!this->Ring_ || tlsInLogDrain_)
+         return;
+      const size_t target = this->Ring_->GetEnqueuedCount();
+      while (this->DrainedCount_.load(std::memory_order_acquire) < target && this->DrainThread_.joinable())
+         std::this_thread::yield();
+   }
+   /// 每次最多取出 kDrainBatchCount 筆, 若有取出任何資料則傳回 true.
+   bool DrainRing() {
+      enum { kDrainBatchCount = 1024 };
+      BufferList  batch;
+      LogRecord   rec;
+      size_t      count = 0;
+      while (count < kDrainBatchCount && this->Ring_->TryPop(rec)) {
+         ++count;
+         // 檔名的切換單位至少為秒, 所以秒數改變時, 才需要檢查是否換檔;
+         // 檢查換檔之前, 必須先將之前的訊息放入, 才能確保訊息寫入正確的檔案.
+         const TimeStamp::OrigType sec = rec.UtcTime_.GetIntPart();
+         if (fon9_UNLIKELY(sec != this->DrainLastSecond_)) {
+            if (!batch.empty())
+               this->Append(std::move(batch));
+            this->CheckRotateTime(rec.UtcTime_);
+            this->DrainLastSecond_ = sec;
+         }
+         if (rec.IsLazy_)
+            batch.push_back(LogLazyFormat(LogArgs{rec.Level_, rec.UtcTime_}, std::move(rec.Buf_)));
+         else
+            batch.push_back(std::move(rec.Buf_));
+      }
+      if (count == 0)
+         return false;
+      if (!batch.empty())
+         this->Append(std::move(batch));
+      this->DrainedCount_.fetch_add(count, std::memory_order_release);
+      return true;
+   }
+   void DrainRun() {
+      tlsInLogDrain_ = true;
+      unsigned idleCount = 0;
+      for (;;) {
+         if (this->DrainRing()) {
+            idleCount = 0;
+            continue;
+         }
+         if (this->IsDrainEnd_.load(std::memory_order_acquire)) {
+            // 結束前, 再檢查一次是否有剩餘的訊息.
+            if (this->DrainRing())
+               continue;
+            break;
+         }
+         // 沒有訊息時: 先 yield 一小段時間, 之後每次睡 1 ms; 這裡的延遲只影響寫檔時間, 不影響 fon9_LOG_().
+         if (++idleCount < 64)
+            std::this_thread::yield();
+         else
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+      }
+   }
+
    static void AddLogInfo(File& fd, RevBufferList& rbuf, TimeStamp utctm, char chHeadNL) {
       AddLogHeader(rbuf, utctm, LogLevel::Important);
       if (chHeadNL)
@@ -78,7 +193,7 @@ class LogFileImpl : public LogFileAppender {
       bool  isFirstStart = this->OrigStartInfo_.empty();
       if (!fd.IsOpened()) {
          if (isFirstStart)
-            UnsetLogWriter(&LogFileImpl::LogWriteToFile);
+            UnsetLogWriter(this->FnLogWriter_);
          fon9_LOG_ERROR("LogFile|open=", fd.GetOpenName(), "|mode=", FileModeToStr(fd.GetOpenMode()), "|err=", openResult.GetError());
          return nullptr;
       }
@@ -86,7 +201,7 @@ class LogFileImpl : public LogFileAppender {
       TimeZoneOffset tzadj = this->GetRotateTimeChecker().GetTimeZoneOffset();
       // 避免: InitLogWriteToFile(); => SetLogWriter(others); => InitLogWriteToFile();
       // 所以這裡開檔成功後, 在設定一次 SetLogWriter(); 讓第2次的 InitLogWriteToFile(); 能順利重設 LogWriter.
-      SetLogWriter(&LogFileImpl::LogWriteToFile, tzadj);
+      SetLogWriter(this->FnLogWriter_, tzadj, this->FnLogLazyWriter_);
 
       TimeStamp      utcnow = UtcNow();
       RevBufferList  rbuf{kLogBlockNodeSize};
@@ -115,8 +230,14 @@ class LogFileImpl : public LogFileAppender {
 
 public:
    static LogFileImpl* gLogFile;
+   bool WaitFlushed() {
+      this->WaitRingDrained();
+      return base::WaitFlushed();
+   }
    ~LogFileImpl() {
       UnsetLogWriter(&LogFileImpl::LogWriteToFile);
+      UnsetLogWriter(&LogFileImpl::LogWriteToRing);
+      this->StopRing();
       this->DisposeAsync();
       if (!this->OrigStartInfo_.empty()) {
          RevBufferList  rbuf{kLogBlockNodeSize};
@@ -127,11 +248,22 @@ public:
       this->Worker_.TakeCall();
       gLogFile = nullptr;
    }
-   static File::Result Init(FileRotateSP frConfig, size_t highWaterLevelNodeCount) {
+   static File::Result Init(FileRotateSP frConfig, size_t highWaterLevelNodeCount, size_t ringSize) {
       if (LogFileImpl::gLogFile)
          frConfig->CheckTime(UtcNow());
       gWaitLogSystemReady = &WaitLogSystemReady;
       static intrusive_ptr<LogFileImpl> LogFile_{new LogFileImpl{*frConfig}};
+      if (ringSize > 0) {
+         gLogFile->StartRing(ringSize);
+         gLogFile->FnLogWriter_ = &LogFileImpl::LogWriteToRing;
+         gLogFile->FnLogLazyWriter_ = &LogFileImpl::LogLazyWriteToRing;
+      }
+      else {
+         // 從 ring 改成直接寫入: 先等 ring 裡面的訊息處理完畢, 避免順序錯亂.
+         gLogFile->FnLogWriter_ = &LogFileImpl::LogWriteToFile;
+         gLogFile->FnLogLazyWriter_ = nullptr;
+         gLogFile->WaitRingDrained();
+      }
       auto resfut = gLogFile->Open(std::move(frConfig), FileMode::CreatePath);
       LogSystemReadyLatch_.CountDown();
       gLogFile->SetHighWaterLevelNodeCount(highWaterLevelNodeCount);
@@ -146,8 +278,9 @@ LogFileImpl* LogFileImpl::gLogFile;
 fon9_API File::Result InitLogWriteToFile(std::string fmtFileName,
                                          FileRotate::TimeScale tmScale,
                                          File::SizeType maxFileSize,
-                                         size_t highWaterLevelNodeCount) {
-   return LogFileImpl::Init(FileRotateSP{new FileRotate(std::move(fmtFileName), tmScale, maxFileSize)}, highWaterLevelNodeCount);
+                                         size_t highWaterLevelNodeCount,
+                                         size_t ringSize) {
+   return LogFileImpl::Init(FileRotateSP{new FileRotate(std::move(fmtFileName), tmScale, maxFileSize)}, highWaterLevelNodeCount, ringSize);
 }
 
 fon9_API bool WaitLogFileFlushed() {
@@ -17,11 +17,17 @@ namespace fon9 {
 /// \param  highWaterLevelNodeCount > 0: 當尚未寫入的資料量超過 highWaterLevelNodeCount:
 ///   - fon9_LOG_() 會等候資料消化後才會返回。
 ///   - TODO: 可選擇: 拋棄之後的log訊息.
+/// \param ringSize > 0: fon9_LOG_() 將訊息放入 lock-free 的 MpscRing 之後就返回, 不會有 lock 的負擔;
+///   - 由 "LogFile.Drain" thread 依序取出, 批次放入 LogFileAppender.
+///   - ringSize 只有在第一次啟用時有效, 之後再呼叫 InitLogWriteToFile() 不會改變 ring 的大小.
+///   - 當 ring 滿了, fon9_LOG_() 會等候(yield)到有空位才返回.
+///   - ringSize == 0: 在呼叫 fon9_LOG_() 的 thread 直接放入 LogFileAppender(需要 lock).
 /// \return File::Open() 的結果.
 fon9_API File::Result InitLogWriteToFile(std::string fmtFileName,
                                          FileRotate::TimeScale tmScale,
                                          File::SizeType maxFileSize,
-                                         size_t highWaterLevelNodeCount);
+                                         size_t highWaterLevelNodeCount,
+                                         size_t ringSize = 1024 * 64);
 
 fon9_API bool WaitLogFileFlushed();
 
@@ -183,12 +183,76 @@ void run_benchmark(Function && fn, unsigned threadCount, char const * const logg
 
 void TestThreadsWriteLatency() {
    // 使用的測試方法: https://github.com/Iyengar111/NanoLog#latency-benchmark-of-guaranteed-logger
-   fon9::InitLogWriteToFile("./logs/fon9-latency.log", fon9::TimeChecker::TimeScale::No, 0, 0);
+   // 比較: ringSize=0: fon9_LOG() 直接放入 LogFileAppender(需要 lock); ringSize>0: 放入 MpscRing(lock-free).
+   // fon9_LOG_LAZY(ring): 參數不在呼叫端格式化, 由 ring 的 DrainThread 負責.
    auto fon9BenchmarkFn = [](unsigned i, char const * const cstr) {
       fon9_LOG_INFO("Logging ", cstr, i, 0, 'K', fon9::Decimal<int64_t, 6>(-42.42));
    };
-   for (auto threadCount : {1u, 2u, 4u, 8u})
-      run_benchmark(fon9BenchmarkFn, threadCount, "fon9_LOG");
+   auto fon9LazyBenchmarkFn = [](unsigned i, char const * const cstr) {
+      fon9_LOG_LAZY(fon9::LogLevel::Info, "Logging ", fon9::StrView_cstr(cstr), i, 0, 'K', fon9::Decimal<int64_t, 6>(-42.42));
+   };
+   for (size_t ringSize : {size_t{0}, size_t{1024 * 64}}) {
+      fon9::InitLogWriteToFile("./logs/fon9-latency.log", fon9::TimeChecker::TimeScale::No, 0, 0, ringSize);
+      for (auto threadCount : {1u, 2u, 4u, 8u, 16u}) {
+         run_benchmark(fon9BenchmarkFn, threadCount, ringSize ? "fon9_LOG(ring)" : "fon9_LOG(lock)");
+         fon9::WaitLogFileFlushed();
+         if (ringSize == 0)
+            continue;
+         run_benchmark(fon9LazyBenchmarkFn, threadCount, "fon9_LOG_LAZY(ring)");
+         fon9::WaitLogFileFlushed();
+      }
+   }
+}
+
+//--------------------------------------------------------------------------//
+
+static std::string       gCapturedLog;
+static fon9::LogArgs     gLazyArgs{fon9::LogLevel::Info};
+static fon9::BufferList  gLazyPacked;
+static void CaptureLogWriter(const fon9::LogArgs&, fon9::BufferList&& buf) {
+   gCapturedLog = fon9::BufferTo<std::string>(buf);
+}
+static void CaptureLogLazyWriter(const fon9::LogArgs& logArgs, fon9::BufferList&& packed) {
+   gLazyArgs = logArgs;
+   gLazyPacked = std::move(packed);
+}
+/// 移除 log header 的時間: "YYYYMMDD-HHMMSS.uuuuuu thrid[LEVEL]..." => " thrid[LEVEL]...";
+static std::string CapturedLogNoTime() {
+   std::string res;
+   res.swap(gCapturedLog);
+   size_t pos = res.find(' ');
+   return pos == std::string::npos ? res : res.substr(pos);
+}
+/// fon9_LOG_LAZY() 的輸出, 必須與 fon9_LOG() 相同(除了時間).
+void TestLazyFormat() {
+   std::cout << "[TEST ] fon9_LOG_LAZY() format";
+   fon9::SetLogWriter(&CaptureLogWriter, fon9::TimeZoneOffset{}, &CaptureLogLazyWriter);
+   char        chbuf[16] = "char[]";
+   std::string str{"std::string"};
+   const auto  tm = fon9::UtcNow();
+   #define TEST_LAZY_ARGS                                                                 \
+      "Lazy|literal", fon9::StrView{"|StrView"}, '|', chbuf, '|', str, "|u=", 123u,        \
+      "|i=", -456, fon9::FmtDef{"8"}, "|dec=", fon9::Decimal<int64_t, 6>(-42.42),         \
+      "|tm=", tm, "|str=", std::string{"tmp"}, fon9::FmtDef{"6"}
+   fon9_LOG_INFO(TEST_LAZY_ARGS);
+   const std::string expected = CapturedLogNoTime();
+   fon9_LOG_LAZY(fon9::LogLevel::Info, TEST_LAZY_ARGS);
+   #undef TEST_LAZY_ARGS
+   // 字串類參數必須複製內容: 呼叫 fon9_LOG_LAZY() 之後改變內容, 不應影響 log.
+   chbuf[0] = 'X';
+   str[0] = 'X';
+   if (!gCapturedLog.empty() || gLazyPacked.empty()) {
+      std::cout << "|packed.empty()=" << gLazyPacked.empty() << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   CaptureLogWriter(gLazyArgs, fon9::LogLazyFormat(gLazyArgs, std::move(gLazyPacked)));
+   fon9::SetLogWriter(nullptr, fon9::TimeZoneOffset{});
+   const std::string lazyres = CapturedLogNoTime();
+   if (expected.empty() || lazyres != expected || !gLazyPacked.empty()) {
+      std::cout << "\n" "expected=" << expected << "lazy    =" << lazyres << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   std::cout << "\r[OK   ]" << std::endl;
 }
 
 //--------------------------------------------------------------------------//
@@ -215,6 +279,7 @@ int main(int argc, char** argv) {
    }
 
    fon9::AutoPrintTestInfo utinfo{"LogFile"};
+   TestLazyFormat();
    auto res = fon9::InitLogWriteToFile("./logs/Scale_Second_{0:f-t+8}.{1:04}.log", fon9::TimeChecker::TimeScale::Second, 1024, 0);
 
    fon9::RevBufferFixedSize<1024> rbuf;
@@ -0,0 +1,126 @@
+﻿/// \file fon9/MpscRing.hpp
+/// \author fonwinz@gmail.com
+#ifndef __fon9_MpscRing_hpp__
+#define __fon9_MpscRing_hpp__
+#include "fon9/sys/Config.hpp"
+
+fon9_BEFORE_INCLUDE_STD;
+#include <atomic>
+#include <memory>
+fon9_AFTER_INCLUDE_STD;
+
+namespace fon9 {
+
+fon9_WARN_DISABLE_PADDING;
+/// \ingroup Thrs
+/// 固定容量的 lock-free 環狀佇列: 可多個 thread 同時放入(multi producer), 但只能有一個 thread 取出(single consumer).
+/// - 每個 slot 有一個序號(Seq_), 用來判斷此 slot 是否可放入 or 可取出:
+///   原始來源 http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+/// - 放入時只有一次 compare_exchange, 取出時不需要 compare_exchange.
+/// - 取出的順序與「取得放入位置」的順序相同.
+/// - T 必須可以 default construct, 且可以 move assign.
+template <class T>
+class MpscRing {
+   fon9_NON_COPY_NON_MOVE(MpscRing);
+   struct Slot {
+      std::atomic<size_t>  Seq_;
+      T                    Value_;
+   };
+   std::unique_ptr<Slot[]> Slots_;
+   const size_t            Mask_;
+   char                    Padding1_[64];
+   std::atomic<size_t>     EnqPos_{0};
+   char                    Padding2_[64];
+   /// 只有 consumer 會改變, 使用 atomic 讓其他 thread 可以取得佇列內的數量.
+   std::atomic<size_t>     DeqPos_{0};
+
+   static size_t RoundUpCapacity(size_t capacity) {
+      size_t res = 2;
+      while (res < capacity)
+         res <<= 1;
+      return res;
+   }
+
+public:
+   /// capacity 會調整為 2 的冪次.
+   explicit MpscRing(size_t capacity)
+      : Slots_{new Slot[RoundUpCapacity(capacity)]}
+      , Mask_{RoundUpCapacity(capacity) - 1} {
+      for (size_t L = 0; L <= this->Mask_; ++L)
+         this->Slots_[L].Seq_.store(L, std::memory_order_relaxed);
+   }
+
+   size_t capacity() const {
+      return this->Mask_ + 1;
+   }
+   /// 已取得放入位置的數量(包含正在放入, 但尚未完成的).
+   size_t GetEnqueuedCount() const {
+      return this->EnqPos_.load(std::memory_order_acquire);
+   }
+   /// 已取出的數量.
+   size_t GetDequeuedCount() const {
+      return this->DeqPos_.load(std::memory_order_acquire);
+   }
+
+   /// 可在任意 thread 呼叫.
+   /// \retval false 佇列已滿, value 維持不變.
+   bool TryPush(T&& value) {
+      return this->TryPushFn([&value](T& dst) {
+         dst = std::move(value);
+      });
+   }
+   /// 直接在 slot 裡面填入資料: fn(T& slotValue); 可避免 T 的 move, 也可重複使用 slot 已配置的資源.
+   /// 可在任意 thread 呼叫.
+   /// \retval false 佇列已滿, 沒有呼叫 fn.
+   template <class FnT>
+   bool TryPushFn(FnT&& fn) {
+      size_t pos = this->EnqPos_.load(std::memory_order_relaxed);
+      for (;;) {
+         Slot&    slot = this->Slots_[pos & this->Mask_];
+         size_t   seq = slot.Seq_.load(std::memory_order_acquire);
+         intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+         if (dif == 0) {
+            if (this->EnqPos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+               fn(slot.Value_);
+               slot.Seq_.store(pos + 1, std::memory_order_release);
+               return true;
+            }
+         }
+         else if (dif < 0)
+            return false;
+         else
+            pos = this->EnqPos_.load(std::memory_order_relaxed);
+      }
+   }
+
+   /// 只能在 consumer thread 呼叫.
+   /// \retval false 佇列為空, 或下一個位置的 producer 尚未放入完畢.
+   bool TryPop(T& out) {
+      return this->TryPopFn([&out](T& src) {
+         out = std::move(src);
+      });
+   }
+   /// 直接使用 slot 裡面的資料: fn(T& slotValue); fn 返回後, 此 slot 就可能被 producer 覆蓋.
+   /// 只能在 consumer thread 呼叫.
+   /// \retval false 佇列為空, 或下一個位置的 producer 尚未放入完畢, 沒有呼叫 fn.
+   template <class FnT>
+   bool TryPopFn(FnT&& fn) {
+      const size_t pos = this->DeqPos_.load(std::memory_order_relaxed);
+      Slot&        slot = this->Slots_[pos & this->Mask_];
+      if (slot.Seq_.load(std::memory_order_acquire) != pos + 1)
+         return false;
+      fn(slot.Value_);
+      slot.Seq_.store(pos + this->Mask_ + 1, std::memory_order_release);
+      this->DeqPos_.store(pos + 1, std::memory_order_release);
+      return true;
+   }
+   /// 下一個要取出的位置, 是否已放入完畢? 可在任意 thread 呼叫(結果為近似值).
+   bool IsFrontReady() const {
+      const size_t pos = this->DeqPos_.load(std::memory_order_acquire);
+      return this->Slots_[pos & this->Mask_].Seq_.load(std::memory_order_acquire) == pos + 1;
+   }
+};
+fon9_WARN_POP;
+
+} // namespaces
+#endif//__fon9_MpscRing_hpp__
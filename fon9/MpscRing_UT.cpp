@@ -0,0 +1,100 @@
+﻿// \file fon9/MpscRing_UT.cpp
+// \author fonwinz@gmail.com
+#include "fon9/MpscRing.hpp"
+#include "fon9/TestTools.hpp"
+#include "fon9/ThreadTools.hpp"
+#include "fon9/StrTo.hpp"
+#include <vector>
+
+//--------------------------------------------------------------------------//
+
+void TestSingleThread() {
+   std::cout << "[TEST ] MpscRing.SingleThread";
+   fon9::MpscRing<std::unique_ptr<int>> ring{5};
+   if (ring.capacity() != 8) {
+      std::cout << "|capacity=" << ring.capacity() << "|expect=8\r[ERROR]" << std::endl;
+      abort();
+   }
+   std::unique_ptr<int> out;
+   for (int round = 0; round < 3; ++round) {
+      for (int L = 0; L < 8; ++L) {
+         if (!ring.TryPush(std::unique_ptr<int>{new int{L}})) {
+            std::cout << "|TryPush() fail.\r[ERROR]" << std::endl;
+            abort();
+         }
+      }
+      std::unique_ptr<int> full{new int{-1}};
+      if (ring.TryPush(std::move(full)) || !full) {
+         std::cout << "|TryPush() when full.\r[ERROR]" << std::endl;
+         abort();
+      }
+      for (int L = 0; L < 8; ++L) {
+         if (!ring.TryPop(out) || *out != L) {
+            std::cout << "|TryPop() fail.\r[ERROR]" << std::endl;
+            abort();
+         }
+      }
+      if (ring.TryPop(out)) {
+         std::cout << "|TryPop() when empty.\r[ERROR]" << std::endl;
+         abort();
+      }
+   }
+   std::cout << "\r[OK   ]" << std::endl;
+}
+
+/// 多個 producer 同時放入, 檢查: 每個 producer 放入的資料, 取出時順序不變, 且沒有遺失.
+void TestProducers(unsigned producerCount, uint64_t countPerProducer, size_t ringSize) {
+   std::cout << "[TEST ] MpscRing.Producers=" << producerCount << "|ringSize=" << ringSize << std::flush;
+   fon9::MpscRing<uint64_t>   ring{ringSize};
+   std::vector<std::thread>   producers;
+   std::atomic<uint64_t>      fullCount{0};
+   fon9::StopWatch            stopWatch;
+   for (unsigned id = 0; id < producerCount; ++id) {
+      producers.emplace_back([&ring, &fullCount, id, countPerProducer]() {
+         for (uint64_t L = 0; L < countPerProducer; ++L) {
+            uint64_t v = (static_cast<uint64_t>(id) << 48) | L;
+            while (!ring.TryPush(std::move(v))) {
+               ++fullCount;
+               std::this_thread::yield();
+            }
+         }
+      });
+   }
+   std::vector<uint64_t> nextSeq(producerCount, 0);
+   const uint64_t        total = countPerProducer * producerCount;
+   uint64_t              v;
+   for (uint64_t L = 0; L < total;) {
+      if (!ring.TryPop(v)) {
+         std::this_thread::yield();
+         continue;
+      }
+      const unsigned id = static_cast<unsigned>(v >> 48);
+      if (id >= producerCount || nextSeq[id] != (v & 0xffffffffffff)) {
+         std::cout << "|id=" << id << "|seq=" << (v & 0xffffffffffff) << "\r[ERROR]" << std::endl;
+         abort();
+      }
+      ++nextSeq[id];
+      ++L;
+   }
+   const double span = stopWatch.StopTimer();
+   fon9::JoinThreads(producers);
+   if (ring.TryPop(v) || ring.GetEnqueuedCount() != total || ring.GetDequeuedCount() != total) {
+      std::cout << "|remain data.\r[ERROR]" << std::endl;
+      abort();
+   }
+   std::cout << "|full=" << fullCount.load() << "\r[OK   ]" << std::endl;
+   fon9::StopWatch::PrintResult(span, "   Push+Pop", total);
+}
+
+int main(int argc, char** argv) {
+   fon9::AutoPrintTestInfo utinfo{"MpscRing"};
+   // argv: [countPerProducer]
+   uint64_t countPerProducer = (argc > 1 ? fon9::StrTo(fon9::StrView_cstr(argv[1]), 0u) : 0u);
+   if (countPerProducer <= 0)
+      countPerProducer = 1000 * 1000;
+
+   TestSingleThread();
+   utinfo.PrintSplitter();
+   for (unsigned producerCount : {1u, 4u, 16u})
+      TestProducers(producerCount, countPerProducer / producerCount, 1024);
+}
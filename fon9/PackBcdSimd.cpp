@@ -0,0 +1,217 @@
+﻿// \file fon9/PackBcdSimd.cpp
+// \author fonwinz@gmail.com
+#include "fon9/PackBcdSimd.hpp"
+#include <atomic>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#  define fon9_PACKBCD_SIMD_X64
+#  include <immintrin.h>
+#  ifdef _MSC_VER
+#     include <intrin.h>
+#     define fon9_PACKBCD_TARGET_SSSE3
+#     define fon9_PACKBCD_TARGET_AVX2
+#  else
+#     define fon9_PACKBCD_TARGET_SSSE3  __attribute__((target("ssse3")))
+#     define fon9_PACKBCD_TARGET_AVX2   __attribute__((target("avx2")))
+#  endif
+#endif
+
+namespace fon9 {
+
+using FnBcdArrayTo = void (*)(const byte* pbcd, size_t count, uint32_t* out);
+
+//--------------------------------------------------------------------------//
+
+static void Bcd8ArrayScalar(const byte* pbcd, size_t count, uint32_t* out) {
+   for (; count > 0; --count) {
+      *out++ = PackBcdTo<8, uint32_t>(pbcd);
+      pbcd += 4;
+   }
+}
+static void Bcd6x8ArrayScalar(const byte* pbcd, size_t count, uint32_t* out) {
+   for (; count > 0; --count) {
+      out[0] = PackBcdTo<6, uint32_t>(pbcd);
+      out[1] = PackBcdTo<8, uint32_t>(pbcd + 3);
+      out += 2;
+      pbcd += 7;
+   }
+}
+
+#ifdef fon9_PACKBCD_SIMD_X64
+fon9_GCC_WARN_DISABLE("-Wold-style-cast"); // _mm_set1_epi8() 之類的 macro 使用了 old style cast.
+/// 每個 uint32 lane 為 4 bytes(8 位數, 高位在前) 的 Pack BCD => 整數.
+fon9_PACKBCD_TARGET_SSSE3 static inline __m128i BcdLanesToU32(__m128i v) {
+   // 每個 byte = hi * 16 + lo; 轉成 hi * 10 + lo = byte - hi * 6;
+   const __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0f));
+   const __m128i hi2 = _mm_add_epi8(hi, hi);
+   v = _mm_sub_epi8(v, _mm_add_epi8(hi2, _mm_add_epi8(hi2, hi2)));
+   // 相鄰 2 個 byte(0..99): 高位 * 100 + 低位 => 16 bits(0..9999).
+   v = _mm_maddubs_epi16(v, _mm_set1_epi16(0x0164));
+   // 相鄰 2 個 16 bits: 高位 * 10000 + 低位 => 32 bits.
+   return _mm_madd_epi16(v, _mm_set1_epi32(0x00012710));
+}
+fon9_PACKBCD_TARGET_AVX2 static inline __m256i BcdLanesToU32(__m256i v) {
+   const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0f));
+   const __m256i hi2 = _mm256_add_epi8(hi, hi);
+   v = _mm256_sub_epi8(v, _mm256_add_epi8(hi2, _mm256_add_epi8(hi2, hi2)));
+   v = _mm256_maddubs_epi16(v, _mm256_set1_epi16(0x0164));
+   return _mm256_madd_epi16(v, _mm256_set1_epi32(0x00012710));
+}
+
+/// 從 pbcd 開始的 16 bytes, 包含 2 筆 { PackBcd<6>; PackBcd<8>; } 的重排方式:
+/// PackBcd<6> 只有 3 bytes, 前方補 0(index=-1: pshufb 填入 0).
+fon9_PACKBCD_TARGET_SSSE3 static inline __m128i Bcd6x8Mask(char ofs) {
+   return _mm_setr_epi8(-1, static_cast<char>(ofs + 0), static_cast<char>(ofs + 1), static_cast<char>(ofs + 2),
+                        static_cast<char>(ofs + 3), static_cast<char>(ofs + 4), static_cast<char>(ofs + 5), static_cast<char>(ofs + 6),
+                        -1, static_cast<char>(ofs + 7), static_cast<char>(ofs + 8), static_cast<char>(ofs + 9),
+                        static_cast<char>(ofs + 10), static_cast<char>(ofs + 11), static_cast<char>(ofs + 12), static_cast<char>(ofs + 13));
+}
+fon9_PACKBCD_TARGET_SSSE3 static inline void Bcd6x8Pair(const byte* pbcd, __m128i mask, uint32_t* out) {
+   const __m128i v = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pbcd)), mask);
+   _mm_storeu_si128(reinterpret_cast<__m128i*>(out), BcdLanesToU32(v));
+}
+/// 從第 idx 筆開始, 每次轉換 2 筆; 最後不足 2 筆時, 與前一筆重疊轉換(結果相同), 避免讀取超過範圍.
+/// 呼叫前必須確定 count >= 3;
+fon9_PACKBCD_TARGET_SSSE3 static inline void Bcd6x8ArrayFrom(const byte* pbcd, size_t count, size_t idx, uint32_t* out) {
+   // 每次讀取 16 bytes, 但 2 筆只有 14 bytes, 所以剩餘 3 筆以上才能直接讀取.
+   const __m128i mask0 = Bcd6x8Mask(0);
+   for (; count - idx >= 3; idx += 2)
+      Bcd6x8Pair(pbcd + idx * 7, mask0, out + idx * 2);
+   if (idx < count) {
+      // 最後 2 筆: 從 (count - 2) 筆的前 2 bytes 開始讀取, 剛好讀到 pbcd + count * 7.
+      idx = count - 2;
+      Bcd6x8Pair(pbcd + idx * 7 - 2, Bcd6x8Mask(2), out + idx * 2);
+   }
+}
+fon9_PACKBCD_TARGET_SSSE3 static void Bcd6x8ArraySsse3(const byte* pbcd, size_t count, uint32_t* out) {
+   if (count < 3)
+      Bcd6x8ArrayScalar(pbcd, count, out);
+   else
+      Bcd6x8ArrayFrom(pbcd, count, 0, out);
+}
+fon9_PACKBCD_TARGET_AVX2 static void Bcd6x8ArrayAvx2(const byte* pbcd, size_t count, uint32_t* out) {
+   if (count < 3)
+      return Bcd6x8ArrayScalar(pbcd, count, out);
+   // 每次轉換 4 筆: 2 個 128 bits lane 各放 2 筆(pshufb 不能跨 lane).
+   // 第 2 個 lane 從 +14 讀取 16 bytes, 所以剩餘 5 筆以上(35 bytes >= 30 bytes)才能直接讀取.
+   const __m256i  mask = _mm256_broadcastsi128_si256(Bcd6x8Mask(0));
+   size_t         idx = 0;
+   for (; count - idx >= 5; idx += 4) {
+      const byte* p = pbcd + idx * 7;
+      __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))),
+                                          _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 14)), 1);
+      v = _mm256_shuffle_epi8(v, mask);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + idx * 2), BcdLanesToU32(v));
+   }
+   Bcd6x8ArrayFrom(pbcd, count, idx, out);
+}
+
+fon9_PACKBCD_TARGET_SSSE3 static inline void Bcd8ArrayFrom(const byte* pbcd, size_t count, size_t idx, uint32_t* out) {
+   for (; count - idx >= 4; idx += 4)
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + idx),
+                       BcdLanesToU32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pbcd + idx * 4))));
+   if (idx < count) {
+      if (count < 4)
+         return Bcd8ArrayScalar(pbcd + idx * 4, count - idx, out + idx);
+      // 最後 4 個與前面重疊轉換, 避免讀取超過範圍.
+      idx = count - 4;
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + idx),
+                       BcdLanesToU32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pbcd + idx * 4))));
+   }
+}
+fon9_PACKBCD_TARGET_SSSE3 static void Bcd8ArraySsse3(const byte* pbcd, size_t count, uint32_t* out) {
+   Bcd8ArrayFrom(pbcd, count, 0, out);
+}
+fon9_PACKBCD_TARGET_AVX2 static void Bcd8ArrayAvx2(const byte* pbcd, size_t count, uint32_t* out) {
+   size_t idx = 0;
+   for (; count - idx >= 8; idx += 8)
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + idx),
+                          BcdLanesToU32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pbcd + idx * 4))));
+   Bcd8ArrayFrom(pbcd, count, idx, out);
+}
+fon9_GCC_WARN_POP;
+
+static bool IsCpuSupportSsse3() {
+#ifdef _MSC_VER
+   int regs[4];
+   __cpuid(regs, 1);
+   return (regs[2] & (1 << 9)) != 0;
+#else
+   return __builtin_cpu_supports("ssse3") != 0;
+#endif
+}
+static bool IsCpuSupportAvx2() {
+#ifdef _MSC_VER
+   int regs[4];
+   __cpuid(regs, 0);
+   if (regs[0] < 7)
+      return false;
+   __cpuid(regs, 1);
+   // OSXSAVE(bit27) + AVX(bit28), 且 OS 有保存 YMM 暫存器.
+   if ((regs[2] & (1 << 27)) == 0 || (regs[2] & (1 << 28)) == 0)
+      return false;
+   if ((_xgetbv(0) & 6) != 6)
+      return false;
+   __cpuidex(regs, 7, 0);
+   return (regs[1] & (1 << 5)) != 0;
+#else
+   return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif // fon9_PACKBCD_SIMD_X64
+
+//--------------------------------------------------------------------------//
+
+static void Bcd8ArrayFirst(const byte* pbcd, size_t count, uint32_t* out);
+static void Bcd6x8ArrayFirst(const byte* pbcd, size_t count, uint32_t* out);
+/// 第一次使用時才判斷 CPU 支援的指令集, 避免 static 初始化順序的問題.
+static std::atomic<FnBcdArrayTo>       FnBcd8Array_{&Bcd8ArrayFirst};
+static std::atomic<FnBcdArrayTo>       FnBcd6x8Array_{&Bcd6x8ArrayFirst};
+static std::atomic<PackBcdSimdLevel>   PackBcdSimdLevel_{PackBcdSimdLevel::Scalar};
+
+static void Bcd8ArrayFirst(const byte* pbcd, size_t count, uint32_t* out) {
+   PackBcdSetSimdLevel(PackBcdSimdLevel::Avx2);
+   FnBcd8Array_.load(std::memory_order_relaxed)(pbcd, count, out);
+}
+static void Bcd6x8ArrayFirst(const byte* pbcd, size_t count, uint32_t* out) {
+   PackBcdSetSimdLevel(PackBcdSimdLevel::Avx2);
+   FnBcd6x8Array_.load(std::memory_order_relaxed)(pbcd, count, out);
+}
+
+fon9_API PackBcdSimdLevel PackBcdSetSimdLevel(PackBcdSimdLevel maxLevel) {
+   PackBcdSimdLevel  level = PackBcdSimdLevel::Scalar;
+   FnBcdArrayTo      fnBcd8Array = &Bcd8ArrayScalar;
+   FnBcdArrayTo      fnBcd6x8Array = &Bcd6x8ArrayScalar;
+#ifdef fon9_PACKBCD_SIMD_X64
+   if (maxLevel >= PackBcdSimdLevel::Avx2 && IsCpuSupportAvx2()) {
+      level = PackBcdSimdLevel::Avx2;
+      fnBcd8Array = &Bcd8ArrayAvx2;
+      fnBcd6x8Array = &Bcd6x8ArrayAvx2;
+   }
+   else if (maxLevel >= PackBcdSimdLevel::Ssse3 && IsCpuSupportSsse3()) {
+      level = PackBcdSimdLevel::Ssse3;
+      fnBcd8Array = &Bcd8ArraySsse3;
+      fnBcd6x8Array = &Bcd6x8ArraySsse3;
+   }
+#else
+   (void)maxLevel;
+#endif
+   FnBcd8Array_.store(fnBcd8Array, std::memory_order_relaxed);
+   FnBcd6x8Array_.store(fnBcd6x8Array, std::memory_order_relaxed);
+   PackBcdSimdLevel_.store(level, std::memory_order_relaxed);
+   return level;
+}
+fon9_API PackBcdSimdLevel PackBcdGetSimdLevel() {
+   if (FnBcd8Array_.load(std::memory_order_relaxed) == &Bcd8ArrayFirst)
+      return PackBcdSetSimdLevel(PackBcdSimdLevel::Avx2);
+   return PackBcdSimdLevel_.load(std::memory_order_relaxed);
+}
+
+fon9_API void PackBcd8ArrayTo(const void* pbcd, size_t count, uint32_t* out) {
+   FnBcd8Array_.load(std::memory_order_relaxed)(reinterpret_cast<const byte*>(pbcd), count, out);
+}
+fon9_API void PackBcd6x8ArrayTo(const void* pbcd, size_t count, uint32_t* out) {
+   FnBcd6x8Array_.load(std::memory_order_relaxed)(reinterpret_cast<const byte*>(pbcd), count, out);
+}
+
+} // namespace fon9
@@ -0,0 +1,46 @@
+﻿/// \file fon9/PackBcdSimd.hpp
+/// \author fonwinz@gmail.com
+#ifndef __fon9_PackBcdSimd_hpp__
+#define __fon9_PackBcdSimd_hpp__
+#include "fon9/PackBcd.hpp"
+#include "fon9/sys/Config.hpp"
+
+namespace fon9 {
+
+/// \ingroup AlNum
+/// 批次轉換 Pack BCD 使用的指令集.
+enum class PackBcdSimdLevel : uint8_t {
+   /// 逐一欄位使用 PackBcdTo<>() 轉換.
+   Scalar,
+   /// 每次轉換 16 bytes: pshufb 重排欄位, pmaddubsw + pmaddwd 合併位數.
+   Ssse3,
+   /// 每次轉換 32 bytes.
+   Avx2,
+};
+
+/// \ingroup AlNum
+/// 取得目前使用的指令集: 預設為 CPU 支援的最高等級.
+fon9_API PackBcdSimdLevel PackBcdGetSimdLevel();
+/// \ingroup AlNum
+/// 設定使用的指令集, 若 CPU 不支援 maxLevel, 則使用可支援的最高等級.
+/// 通常用在測試及效能比較.
+/// \return 實際使用的等級.
+fon9_API PackBcdSimdLevel PackBcdSetSimdLevel(PackBcdSimdLevel maxLevel);
+
+/// \ingroup AlNum
+/// 將連續 count 個 PackBcd<8>(每個 4 bytes) 轉成整數, 填入 out[0..count).
+/// 與 PackBcdTo<>() 相同, 不驗證 Pack BCD 的內容是否正確.
+/// 只會讀取 [pbcd, pbcd + count * 4) 的範圍.
+fon9_API void PackBcd8ArrayTo(const void* pbcd, size_t count, uint32_t* out);
+
+/// \ingroup AlNum
+/// 將連續 count 筆 { PackBcd<6>; PackBcd<8>; } (每筆 7 bytes, 例: 價格 + 數量的檔位)轉成整數.
+/// - out[i * 2] = 第 i 筆的 PackBcd<6>;
+/// - out[i * 2 + 1] = 第 i 筆的 PackBcd<8>;
+/// - out 必須至少有 count * 2 個空間.
+/// 與 PackBcdTo<>() 相同, 不驗證 Pack BCD 的內容是否正確.
+/// 只會讀取 [pbcd, pbcd + count * 7) 的範圍.
+fon9_API void PackBcd6x8ArrayTo(const void* pbcd, size_t count, uint32_t* out);
+
+} // namespace fon9
+#endif//__fon9_PackBcdSimd_hpp__
@@ -2,8 +2,10 @@
 // \author fonwinz@gmail.com
 #define _CRT_SECURE_NO_WARNINGS
 #include "fon9/PackBcd.hpp"
+#include "fon9/PackBcdSimd.hpp"
 #include "fon9/TestTools.hpp"
 #include "fon9/DecBase.hpp"
+#include "fon9/Random.hpp"
 
 template <unsigned kPackedWidth>
 void TestPackBcd() {
@@ -46,6 +48,88 @@ void TestPackBcd() {
    std::cout << "\r[OK   ]" << std::endl;
 }
 
+//--------------------------------------------------------------------------//
+
+static const char* const   kSimdLevelName[] = {"Scalar", "Ssse3", "Avx2"};
+static const unsigned      kMaxArrayCount = 40;
+
+/// 檢查 PackBcd8ArrayTo(), PackBcd6x8ArrayTo() 的結果與 PackBcdTo<>() 相同, 且沒有寫入超過 out 的範圍.
+void TestPackBcdArray() {
+   std::cout << "[TEST ] PackBcdArray|SimdLevel=" << kSimdLevelName[static_cast<unsigned>(fon9::PackBcdGetSimdLevel())] << std::flush;
+   std::uniform_int_distribution<uint32_t> rnd6{0, 999999};
+   std::uniform_int_distribution<uint32_t> rnd8{0, 99999999};
+   fon9::byte  src8[kMaxArrayCount * 4];
+   fon9::byte  src6x8[kMaxArrayCount * 7];
+   uint32_t    expected8[kMaxArrayCount];
+   uint32_t    expected6x8[kMaxArrayCount * 2];
+   for (unsigned L = 0; L < kMaxArrayCount; ++L) {
+      expected8[L] = rnd8(fon9::GetRandomEngine());
+      fon9::ToPackBcd<8>(src8 + L * 4, expected8[L]);
+      // 第 1 筆使用最大值, 檢查是否有溢位.
+      expected6x8[L * 2] = (L == 0 ? 999999u : rnd6(fon9::GetRandomEngine()));
+      expected6x8[L * 2 + 1] = (L == 0 ? 99999999u : rnd8(fon9::GetRandomEngine()));
+      fon9::ToPackBcd<6>(src6x8 + L * 7, expected6x8[L * 2]);
+      fon9::ToPackBcd<8>(src6x8 + L * 7 + 3, expected6x8[L * 2 + 1]);
+   }
+   uint32_t out[kMaxArrayCount * 2 + 1];
+   for (unsigned count = 0; count <= kMaxArrayCount; ++count) {
+      memset(out, 0xff, sizeof(out));
+      fon9::PackBcd8ArrayTo(src8, count, out);
+      if (memcmp(out, expected8, count * sizeof(uint32_t)) != 0 || out[count] != 0xffffffff) {
+         std::cout << "|count=" << count << "|err=PackBcd8ArrayTo()" << "\r[ERROR]" << std::endl;
+         abort();
+      }
+      memset(out, 0xff, sizeof(out));
+      fon9::PackBcd6x8ArrayTo(src6x8, count, out);
+      if (memcmp(out, expected6x8, count * 2 * sizeof(uint32_t)) != 0 || out[count * 2] != 0xffffffff) {
+         std::cout << "|count=" << count << "|err=PackBcd6x8ArrayTo()" << "\r[ERROR]" << std::endl;
+         abort();
+      }
+   }
+   std::cout << "\r[OK   ]" << std::endl;
+}
+
+/// 模擬行情的一個價量檔位(成交 + 買賣各 5 檔 = 11 筆 { PackBcd<6> Pri; PackBcd<8> Qty; }), 轉換 kTimes 次.
+void BenchPackBcdLadder(unsigned kTimes) {
+   static const unsigned kLadderCount = 11;
+   fon9::byte  ladder[kLadderCount * 7];
+   for (unsigned L = 0; L < kLadderCount; ++L) {
+      fon9::ToPackBcd<6>(ladder + L * 7, 12345u + L * 5);
+      fon9::ToPackBcd<8>(ladder + L * 7 + 3, 1000u + L * 7);
+   }
+   uint32_t       out[kLadderCount * 2];
+   uint64_t       sum = 0;
+   char           msg[128];
+   fon9::StopWatch stopWatch;
+   for (unsigned L = 0; L < kTimes; ++L) {
+      const fon9::byte* pbcd = ladder;
+      for (unsigned i = 0; i < kLadderCount; ++i) {
+         out[i * 2] = fon9::PackBcdTo<6, uint32_t>(pbcd);
+         out[i * 2 + 1] = fon9::PackBcdTo<8, uint32_t>(pbcd + 3);
+         pbcd += 7;
+      }
+      sum += out[L % (kLadderCount * 2)];
+      ladder[0] = static_cast<fon9::byte>(L & 0x09); // 避免編譯器把轉換移出迴圈.
+   }
+   snprintf(msg, sizeof(msg), "%-6s|PackBcdTo<>() x %u", "Loop", kLadderCount);
+   stopWatch.PrintResult(msg, kTimes);
+
+   const fon9::PackBcdSimdLevel maxLevel = fon9::PackBcdGetSimdLevel();
+   for (unsigned lv = 0; lv <= static_cast<unsigned>(maxLevel); ++lv) {
+      fon9::PackBcdSetSimdLevel(static_cast<fon9::PackBcdSimdLevel>(lv));
+      stopWatch.ResetTimer();
+      for (unsigned L = 0; L < kTimes; ++L) {
+         fon9::PackBcd6x8ArrayTo(ladder, kLadderCount, out);
+         sum += out[L % (kLadderCount * 2)];
+         ladder[0] = static_cast<fon9::byte>(L & 0x09);
+      }
+      snprintf(msg, sizeof(msg), "%-6s|PackBcd6x8ArrayTo(%u)", kSimdLevelName[lv], kLadderCount);
+      stopWatch.PrintResult(msg, kTimes);
+   }
+   fon9::PackBcdSetSimdLevel(maxLevel);
+   std::cout << "(sum=" << sum << ")" << std::endl;
+}
+
 int main() {
    fon9::AutoPrintTestInfo utinfo{"PackBcd"};
    TestPackBcd<1>();
@@ -59,4 +143,14 @@ int main() {
    // TestPackBcd<8>();
    // TestPackBcd<9>();
    // TestPackBcd<10>();
+
+   const fon9::PackBcdSimdLevel maxLevel = fon9::PackBcdGetSimdLevel();
+   for (unsigned lv = 0; lv <= static_cast<unsigned>(maxLevel); ++lv) {
+      fon9::PackBcdSetSimdLevel(static_cast<fon9::PackBcdSimdLevel>(lv));
+      TestPackBcdArray();
+   }
+   fon9::PackBcdSetSimdLevel(maxLevel);
+
+   utinfo.PrintSplitter();
+   BenchPackBcdLadder(1000 * 1000 * 10);
 }
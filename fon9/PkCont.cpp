@@ -1,21 +1,70 @@
 ﻿// \file fon9/PkCont.cpp
 // \author fonwinz@gmail.com
 #include "fon9/PkCont.hpp"
+#include <thread>
 
 namespace fon9 {
 
-PkContFeeder::PkContFeeder() {
+static size_t RoundUpPow2(size_t v) {
+   size_t res = 2;
+   while (res < v)
+      res <<= 1;
+   return res;
+}
+
+void PkContFeeder::PkBuf::Assign(const void* pk, unsigned pksz) {
+   if (fon9_UNLIKELY(this->Capacity_ < pksz)) {
+      this->Capacity_ = (pksz < 256u ? 256u : ((pksz + 255u) & ~255u));
+      this->Mem_.reset(new byte[this->Capacity_]);
+   }
+   memcpy(this->Mem_.get(), pk, pksz);
+   this->Size_ = pksz;
+}
+
+//--------------------------------------------------------------------------//
+
+PkContFeeder::PkContFeeder() : PkContFeeder{PkContArgs{}, GetDefaultTimerThread()} {
+}
+PkContFeeder::PkContFeeder(TimerThread& timerThread) : PkContFeeder{PkContArgs{}, timerThread} {
+}
+PkContFeeder::PkContFeeder(const PkContArgs& args, TimerThread& timerThread)
+   : Timer_{timerThread}
+   , HoldRing_{new PkHold[RoundUpPow2(args.HoldSize_)]}
+   , HoldMask_{RoundUpPow2(args.HoldSize_) - 1} {
+   const unsigned lineCount = (args.LineCount_ <= 0 ? 1u : args.LineCount_);
+   this->Lines_.reserve(lineCount);
+   for (unsigned L = 0; L < lineCount; ++L)
+      this->Lines_.emplace_back(new Line{args.LineRingSize_});
+   if (lineCount > 1)
+      this->ArrivalRing_.reset(new PkArrival[this->HoldMask_ + 1]);
 }
 PkContFeeder::~PkContFeeder() {
    this->Timer_.StopAndWait();
 }
+void PkContFeeder::LockDraining() {
+   while (this->IsDraining_.exchange(true))
+      std::this_thread::yield();
+}
 void PkContFeeder::Clear() {
    this->Timer_.StopAndWait();
-   PkPendings::Locker pks{this->PkPendings_};
-   pks->clear();
+   this->LockDraining();
+   for (LineSP& line : this->Lines_) {
+      while (line->Ring_.TryPopFn([](PkIngest&) {})) {
+      }
+      PkContLineStat& stat = line->Stat_;
+      stat.ReceivedCount_ = stat.FirstCount_ = stat.DupCount_ = 0;
+      stat.GapCount_ = stat.GapPkCount_ = stat.LastSeq_ = 0;
+      stat.LagHist_.Clear();
+   }
+   for (SeqT L = 0; L <= this->HoldMask_; ++L)
+      this->HoldRing_[L].IsUsed_ = false;
+   this->HoldCount_ = 0;
+   this->HoldMaxSeq_ = 0;
    this->ReceivedCount_ = 0;
    this->DroppedCount_ = 0;
    this->NextSeq_ = 0;
+   this->IsFlushRequested_.store(false, std::memory_order_relaxed);
+   this->IsDraining_.store(false, std::memory_order_release);
 }
 void PkContFeeder::EmitOnTimer(TimerEntry* timer, TimeStamp now) {
    (void)now;
@@ -23,53 +72,159 @@ void PkContFeeder::EmitOnTimer(TimerEntry* timer, TimeStamp now) {
    rthis.PkContOnTimer();
 }
 void PkContFeeder::PkContOnTimer() {
-   PkPendings::Locker pks{this->PkPendings_};
-   for (const auto& i : *pks) {
-      this->PkContOnReceived(i.data(), static_cast<unsigned>(i.size()), i.Seq_);
-      this->NextSeq_ = i.Seq_ + 1;
-      ++this->ReceivedCount_;
+   // 若有其他 thread 正在處理封包, 則由該 thread 負責放棄等候.
+   this->IsFlushRequested_.store(true);
+   this->Drain();
+}
+
+//--------------------------------------------------------------------------//
+
+void PkContFeeder::FeedPacket(unsigned lineIndex, const void* pk, unsigned pksz, SeqT seq, TimeStamp rxTime) {
+   assert(lineIndex < this->Lines_.size());
+   if (rxTime.IsNull() && this->ArrivalRing_)
+      rxTime = UtcNow();
+   Line& line = *this->Lines_[lineIndex];
+   auto  fnPush = [pk, pksz, seq, rxTime](PkIngest& dst) {
+      dst.Seq_ = seq;
+      dst.RxTime_ = rxTime;
+      dst.Buf_.Assign(pk, pksz);
+   };
+   while (fon9_UNLIKELY(!line.Ring_.TryPushFn(fnPush))) {
+      // 佇列已滿: 協助處理佇列內的封包; 若已有其他 thread 正在處理, 則等候其處理完畢.
+      this->Drain();
+      std::this_thread::yield();
+   }
+   this->Drain();
+}
+bool PkContFeeder::HasPendingInput() const {
+   if (this->IsFlushRequested_.load(std::memory_order_relaxed))
+      return true;
+   for (const LineSP& line : this->Lines_) {
+      if (line->Ring_.IsFrontReady())
+         return true;
    }
-   pks->clear();
-}
-void PkContFeeder::FeedPacket(const void* pk, unsigned pksz, SeqT seq) {
-   {  // lock this->PkPendings_;
-      PkPendings::Locker pks{this->PkPendings_};
-      if (fon9_LIKELY(seq == this->NextSeq_)) {
-__PK_RECEIVED:
-         this->PkContOnReceived(pk, pksz, seq);
-         this->NextSeq_ = seq + 1;
-         ++this->ReceivedCount_;
-         if (fon9_LIKELY(pks->empty()))
-            return;
-         auto const ibeg = pks->begin();
-         auto const iend = pks->end();
-         auto i = ibeg;
-         while (i->Seq_ == this->NextSeq_) {
-            this->PkContOnReceived(i->data(), static_cast<unsigned>(i->size()), i->Seq_);
-            ++this->NextSeq_;
-            ++this->ReceivedCount_;
-            if (++i == iend)
-               break;
-         }
-         if (ibeg != i)
-            pks->erase(ibeg, i);
+   return false;
+}
+void PkContFeeder::Drain() {
+   for (;;) {
+      if (this->IsDraining_.exchange(true))
+         return; // 正在處理的 thread, 在結束前會再檢查一次是否有新放入的封包.
+      this->DrainLines();
+      if (this->IsFlushRequested_.exchange(false, std::memory_order_relaxed))
+         this->FlushHolds();
+      this->IsDraining_.store(false, std::memory_order_release);
+      // 在 IsDraining_ = false 之前放入封包的 thread, 可能因看到 IsDraining_ == true 而直接返回,
+      // 所以必須再檢查一次, 避免封包留在佇列裡面.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (!this->HasPendingInput())
          return;
+   }
+}
+void PkContFeeder::DrainLines() {
+   // 各線路輪流取出一個封包, 讓 A/B 線路的封包盡量依照收到的順序處理.
+   bool isPopped;
+   do {
+      isPopped = false;
+      for (LineSP& line : this->Lines_) {
+         Line* pline = line.get();
+         if (pline->Ring_.TryPopFn([this, pline](PkIngest& pk) { this->ProcessPacket(*pline, pk); }))
+            isPopped = true;
       }
-      if (seq < this->NextSeq_) {
-         ++this->DroppedCount_;
-         return;
+   } while (isPopped);
+}
+
+void PkContFeeder::DeliverPacket(const void* pk, unsigned pksz, SeqT seq) {
+   this->PkContOnReceived(pk, pksz, seq);
+   this->NextSeq_ = seq + 1;
+   ++this->ReceivedCount_;
+}
+void PkContFeeder::DeliverHolds() {
+   while (this->HoldCount_ > 0) {
+      PkHold& hold = this->HoldRing_[this->NextSeq_ & this->HoldMask_];
+      if (!hold.IsUsed_ || hold.Seq_ != this->NextSeq_)
+         break;
+      hold.IsUsed_ = false;
+      --this->HoldCount_;
+      this->DeliverPacket(hold.Buf_.Mem_.get(), hold.Buf_.Size_, hold.Seq_);
+   }
+}
+void PkContFeeder::FlushHolds() {
+   for (SeqT seq = this->NextSeq_; this->HoldCount_ > 0 && seq <= this->HoldMaxSeq_; ++seq) {
+      PkHold& hold = this->HoldRing_[seq & this->HoldMask_];
+      if (hold.IsUsed_ && hold.Seq_ == seq) {
+         hold.IsUsed_ = false;
+         --this->HoldCount_;
+         this->DeliverPacket(hold.Buf_.Mem_.get(), hold.Buf_.Size_, hold.Seq_);
       }
-      if (this->NextSeq_ == 0 || this->WaitInterval_.GetOrigValue() == 0)
-         goto __PK_RECEIVED;
-      bool isNeedsRunAfter = pks->empty();
-      auto ires = pks->insert(PkRec{seq});
-      if (!ires.second)
-         return;
-      ires.first->assign(static_cast<const char*>(pk), pksz);
-      if (!isNeedsRunAfter)
-         return;
-   } // auto unlock this->PkPendings_.
-   this->Timer_.RunAfter(this->WaitInterval_);
+   }
+   assert(this->HoldCount_ == 0);
+}
+
+void PkContFeeder::OnFirstArrival(PkContLineStat& stat, const PkIngest& pk) {
+   ++stat.FirstCount_;
+   if (this->ArrivalRing_) {
+      PkArrival& arrival = this->ArrivalRing_[pk.Seq_ & this->HoldMask_];
+      arrival.Seq_ = pk.Seq_;
+      arrival.RxTime_ = pk.RxTime_;
+   }
+}
+void PkContFeeder::ProcessPacket(Line& line, PkIngest& pk) {
+   PkContLineStat& stat = line.Stat_;
+   const SeqT      seq = pk.Seq_;
+   ++stat.ReceivedCount_;
+   if (seq > stat.LastSeq_) {
+      if (stat.LastSeq_ != 0 && seq != stat.LastSeq_ + 1) {
+         ++stat.GapCount_;
+         stat.GapPkCount_ += seq - stat.LastSeq_ - 1;
+      }
+      stat.LastSeq_ = seq;
+   }
+   if (fon9_LIKELY(seq == this->NextSeq_))
+      goto __PK_FIRST_ARRIVAL;
+   if (seq < this->NextSeq_)
+      goto __PK_DUPLICATE;
+   // 若有等候中的封包, 即使 WaitInterval_ 已改成 0, 仍要放入等候區, 等 Timer 觸發時依序處理.
+   if (this->NextSeq_ == 0 || (this->WaitInterval_.GetOrigValue() == 0 && this->HoldCount_ == 0))
+      goto __PK_FIRST_ARRIVAL;
+   if (seq - this->NextSeq_ > this->HoldMask_) {
+      // 超過等候區範圍: 放棄等候, 先處理等候中的封包, 然後直接處理此封包.
+      this->FlushHolds();
+      goto __PK_FIRST_ARRIVAL;
+   }
+   else {
+      PkHold& hold = this->HoldRing_[seq & this->HoldMask_];
+      if (hold.IsUsed_) {
+         assert(hold.Seq_ == seq);
+         goto __PK_DUPLICATE;
+      }
+      this->OnFirstArrival(stat, pk);
+      hold.IsUsed_ = true;
+      hold.Seq_ = seq;
+      std::swap(hold.Buf_, pk.Buf_);
+      if (this->HoldMaxSeq_ < seq)
+         this->HoldMaxSeq_ = seq;
+      if (this->HoldCount_++ == 0)
+         this->Timer_.RunAfter(this->WaitInterval_);
+      return;
+   }
+
+__PK_FIRST_ARRIVAL:
+   this->OnFirstArrival(stat, pk);
+   this->DeliverPacket(pk.Buf_.Mem_.get(), pk.Buf_.Size_, seq);
+   if (this->HoldCount_ > 0)
+      this->DeliverHolds();
+   return;
+
+__PK_DUPLICATE:
+   ++stat.DupCount_;
+   ++this->DroppedCount_;
+   if (this->ArrivalRing_) {
+      const PkArrival& arrival = this->ArrivalRing_[seq & this->HoldMask_];
+      if (arrival.Seq_ == seq) {
+         const int64_t lagUs = (pk.RxTime_ - arrival.RxTime_).GetOrigValue();
+         stat.LagHist_.Add(lagUs > 0 ? static_cast<uint64_t>(lagUs) * 1000u : 0u);
+      }
+   }
 }
 
 } // namespaces
@@ -2,52 +2,102 @@
 // \author fonwinz@gmail.com
 #ifndef __fon9_PkCont_hpp__
 #define __fon9_PkCont_hpp__
-#include "fon9/SortedVector.hpp"
+#include "fon9/MpscRing.hpp"
+#include "fon9/LatencyHistogram.hpp"
 #include "fon9/Timer.hpp"
+#include <vector>
 
 namespace fon9 {
 
+/// \ingroup Misc.
+/// PkContFeeder 的參數.
+struct PkContArgs {
+   /// 資訊源(線路)的數量, 例: 行情的 A/B 備援線路 = 2.
+   unsigned LineCount_{1};
+   /// 每條線路的接收佇列容量(會調整為 2 的冪次).
+   /// 佇列滿時, 放入的 thread 會協助處理佇列內的封包, 直到有空位.
+   unsigned LineRingSize_{256};
+   /// 亂序(缺號)等候區的容量(會調整為 2 的冪次), 以序號為索引.
+   /// 若收到的序號超過等候區範圍, 則放棄等候, 直接處理已收到的封包.
+   unsigned HoldSize_{1024};
+};
+
+fon9_WARN_DISABLE_PADDING;
+/// \ingroup Misc.
+/// PkContFeeder 每條線路的統計.
+/// 由處理封包的 thread 更新, 在其他 thread 讀取時為近似值.
+struct PkContLineStat {
+   fon9_NON_COPY_NON_MOVE(PkContLineStat);
+   PkContLineStat() = default;
+   /// 此線路收到的封包數.
+   uint64_t ReceivedCount_{0};
+   /// 此線路最先收到(採用此線路的內容)的封包數.
+   uint64_t FirstCount_{0};
+   /// 此線路收到重複(已從其他線路, 或此線路先前已收到)的封包數.
+   uint64_t DupCount_{0};
+   /// 此線路本身序號不連續的次數.
+   uint64_t GapCount_{0};
+   /// 此線路本身缺少的封包數量(不論其他線路是否有收到).
+   uint64_t GapPkCount_{0};
+   /// 此線路收到的最大序號.
+   uint64_t LastSeq_{0};
+   /// 此線路收到重複封包時, 落後最先收到者的時間.
+   /// 使用 FeedPacket() 提供的 rxTime, 若沒提供則使用放入線路佇列的時間.
+   LatencyHistogram  LagHist_;
+};
+
 /// \ingroup Misc.
 /// 確保收到封包的連續性.
-/// - 可能有多個資訊源, 但序號相同.
+/// - 可能有多個資訊源(例: A/B 備援線路), 但序號相同.
+///   - 每條線路有自己的 lock-free 接收佇列, 各線路的接收 thread 放入封包時不會互相等候.
+///   - 放入封包後, 由沒有其他 thread 正在處理的那個 thread 負責處理全部線路的封包;
+///     若已有 thread 正在處理, 則直接返回, 由正在處理的 thread 接手.
 /// - 即使同一個資訊源封包也可能亂序.
 /// - 若封包序號小於期望, 視為重複封包, 拋棄之.
 /// - 若封包序號不連續, 則等候一小段時間, 若仍沒收到連續封包, 則放棄等候.
+///   - 等候中的封包放在以序號為索引的固定環狀等候區, 封包緩衝區在接收佇列與等候區之間交換, 不用複製.
 /// - 衍生者解構時應主動呼叫 Clear(); 因為可能正在處理 PkContOnTimer();
 class fon9_API PkContFeeder {
    fon9_NON_COPY_NON_MOVE(PkContFeeder);
 public:
    using SeqT = uint64_t;
 
+   /// 使用 GetDefaultTimerThread();
    PkContFeeder();
+   /// 可使用 GetDefaultWheelTimerThread(); 或自訂的 TimerThread.
+   explicit PkContFeeder(TimerThread& timerThread);
+   PkContFeeder(const PkContArgs& args, TimerThread& timerThread);
    virtual ~PkContFeeder();
 
-   /// 收到的封包透過這裡處理.
+   /// 收到的封包透過這裡處理, 視為從 0 號線路收到.
    /// - 若封包有連續, 則透過 PkContOnReceived() 通知衍生者.
    /// - 若封包不連續:
    ///   - 若 this->NextSeq_ == 0, 則直接轉 this->PkContOnReceived(); 由衍生者處理.
    ///   - 等候一小段時間(this->WaitInterval_), 若無法取得連續封包, 則強制繼續處理.
-   void FeedPacket(const void* pk, unsigned pksz, SeqT seq);
+   void FeedPacket(const void* pk, unsigned pksz, SeqT seq) {
+      this->FeedPacket(0, pk, pksz, seq, TimeStamp::Null());
+   }
+   /// 從 lineIndex 線路收到的封包, 可在任意 thread 呼叫.
+   /// - lineIndex 必須小於 GetLineCount();
+   /// - rxTime 收到封包的時間(例: io::Device::GetRecvTime()), 用來統計線路落後的時間;
+   ///   若為 TimeStamp::Null() 且有多條線路, 則使用 UtcNow().
+   /// - 返回時, 封包可能仍在佇列中, 由其他 thread 接手處理.
+   void FeedPacket(unsigned lineIndex, const void* pk, unsigned pksz, SeqT seq, TimeStamp rxTime);
 
    void Clear();
 
+   unsigned GetLineCount() const {
+      return static_cast<unsigned>(this->Lines_.size());
+   }
+   const PkContLineStat& GetLineStat(unsigned lineIndex) const {
+      return this->Lines_[lineIndex]->Stat_;
+   }
+
 protected:
    SeqT           NextSeq_{0};
    SeqT           ReceivedCount_{0};
    SeqT           DroppedCount_{0};
    TimeInterval   WaitInterval_{TimeInterval_Millisecond(5)};
-   
-   struct PkRec : public std::string {
-      SeqT  Seq_;
-      PkRec(SeqT seq) : Seq_{seq} {
-      }
-      bool operator<(const PkRec& rhs) const {
-         return this->Seq_ < rhs.Seq_;
-      }
-   };
-   using PkPendingsImpl = SortedVectorSet<PkRec>;
-   using PkPendings = MustLock<PkPendingsImpl>;
-   PkPendings  PkPendings_;
 
    virtual void PkContOnTimer();
    static void EmitOnTimer(TimerEntry* timer, TimeStamp now);
@@ -58,10 +108,65 @@ protected:
    /// - 當超過指定時間沒有連續時.
    /// - 此時的 this->NextSeq_ 尚未改變, 仍維持前一次的預期序號.
    ///   因此可以判斷 this->NextSeq_ == seq 表示序號連續.
-   /// - 為了確保資料連續性, 呼叫此處時會將 this->PkPendings_ 鎖住.
-   ///   所以不會在不同 thread 重複進入 PkContOnReceived();
+   /// - 同一時間只會有一個 thread 處理封包, 所以不會在不同 thread 重複進入 PkContOnReceived();
    virtual void PkContOnReceived(const void* pk, unsigned pksz, SeqT seq) = 0;
+
+private:
+   /// 重複使用的封包緩衝區: 只有在封包大於現有容量時才重新配置.
+   struct PkBuf {
+      std::unique_ptr<byte[]> Mem_;
+      unsigned                Capacity_{0};
+      unsigned                Size_{0};
+      void Assign(const void* pk, unsigned pksz);
+   };
+   struct PkIngest {
+      SeqT        Seq_;
+      TimeStamp   RxTime_;
+      PkBuf       Buf_;
+   };
+   struct PkHold {
+      SeqT        Seq_;
+      bool        IsUsed_{false};
+      PkBuf       Buf_;
+   };
+   struct PkArrival {
+      SeqT        Seq_{0};
+      TimeStamp   RxTime_;
+   };
+   struct Line {
+      fon9_NON_COPY_NON_MOVE(Line);
+      MpscRing<PkIngest>   Ring_;
+      PkContLineStat       Stat_;
+      explicit Line(size_t ringSize) : Ring_{ringSize} {
+      }
+   };
+   using LineSP = std::unique_ptr<Line>;
+   std::vector<LineSP>  Lines_;
+   /// 以序號為索引的等候區: HoldRing_[seq & HoldMask_];
+   std::unique_ptr<PkHold[]>     HoldRing_;
+   /// 最先收到的時間, 用來計算其他線路的落後時間: ArrivalRing_[seq & HoldMask_];
+   std::unique_ptr<PkArrival[]>  ArrivalRing_;
+   const SeqT                    HoldMask_;
+   SeqT                          HoldCount_{0};
+   SeqT                          HoldMaxSeq_{0};
+   char                          Padding_[64];
+   /// 是否有 thread 正在處理封包.
+   std::atomic<bool>             IsDraining_{false};
+   /// Timer 要求放棄等候, 由處理封包的 thread 執行.
+   std::atomic<bool>             IsFlushRequested_{false};
+
+   void Drain();
+   bool HasPendingInput() const;
+   /// 必須在 IsDraining_ 的保護下執行.
+   void DrainLines();
+   void ProcessPacket(Line& line, PkIngest& pk);
+   void OnFirstArrival(PkContLineStat& stat, const PkIngest& pk);
+   void DeliverPacket(const void* pk, unsigned pksz, SeqT seq);
+   void DeliverHolds();
+   void FlushHolds();
+   void LockDraining();
 };
+fon9_WARN_POP;
 
 } // namespaces
 #endif//__fon9_PkCont_hpp__
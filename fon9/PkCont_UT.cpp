@@ -11,6 +11,8 @@ struct Feeder : public fon9::PkContFeeder {
    using base = fon9::PkContFeeder;
    Feeder() {
    }
+   Feeder(const fon9::PkContArgs& args) : base{args, fon9::GetDefaultTimerThread()} {
+   }
    using base::NextSeq_;
    using base::ReceivedCount_;
    using base::DroppedCount_;
@@ -23,6 +25,11 @@ struct Feeder : public fon9::PkContFeeder {
       fon9::PutBigEndian(&pk, seq);
       this->FeedPacket(&pk, sizeof(pk), seq);
    }
+   void FeedLine(unsigned lineIndex, SeqT seq) {
+      SeqT pk;
+      fon9::PutBigEndian(&pk, seq);
+      this->FeedPacket(lineIndex, &pk, sizeof(pk), seq, fon9::TimeStamp::Null());
+   }
    void PkContOnReceived(const void* pk, unsigned pksz, SeqT seq) override {
       if (this->ExpectedSeq_ != seq) {
          std::cout << "|err=Unexpected seq=" << seq << "|expected=" << this->ExpectedSeq_
@@ -55,6 +62,104 @@ struct Feeder : public fon9::PkContFeeder {
    }
 };
 
+//--------------------------------------------------------------------------//
+
+static void CheckLineStat(const Feeder& feeder, unsigned lineIndex, uint64_t expReceived, uint64_t expGap, uint64_t expGapPk) {
+   const fon9::PkContLineStat& stat = feeder.GetLineStat(lineIndex);
+   std::cout << "|line" << lineIndex << ":rx=" << stat.ReceivedCount_ << ",first=" << stat.FirstCount_
+      << ",dup=" << stat.DupCount_ << ",gap=" << stat.GapCount_ << '/' << stat.GapPkCount_;
+   if (stat.ReceivedCount_ != expReceived || stat.GapCount_ != expGap || stat.GapPkCount_ != expGapPk
+       || stat.FirstCount_ + stat.DupCount_ != stat.ReceivedCount_) {
+      std::cout << "|err=Unexpected line stat.\r[ERROR]" << std::endl;
+      abort();
+   }
+}
+
+/// A/B 線路各自遺漏不同的封包, 由另一條線路補齊, 不需要等候 Timer.
+void TestArbiterAB() {
+   const Feeder::SeqT   kSeqFrom = 1;
+   const Feeder::SeqT   kSeqTo = 1000;
+   fon9::PkContArgs     args;
+   args.LineCount_ = 2;
+   args.HoldSize_ = 16;
+   Feeder feeder{args};
+   // 若有缺號就等很久, 確保補齊是因為另一條線路, 而不是 Timer.
+   feeder.WaitInterval_ = fon9::TimeInterval_Second(100);
+   feeder.ExpectedSeq_ = kSeqFrom;
+   std::cout << "[TEST ] PkCont.A/B|from=" << kSeqFrom << "|to=" << kSeqTo;
+   uint64_t rxA = 0, rxB = 0, gapA = 0, gapB = 0;
+   for (Feeder::SeqT seq = kSeqFrom; seq <= kSeqTo; ++seq) {
+      // A 線路: 每 7 個遺漏 1 個; B 線路: 每 7 個遺漏 2 個(與 A 不同), 且比 A 慢 3 個封包.
+      if (seq % 7 != 0) {
+         feeder.FeedLine(0, seq);
+         ++rxA;
+      }
+      else if (seq != kSeqTo)
+         ++gapA;
+      if (seq > kSeqFrom + 2) {
+         const Feeder::SeqT seqB = seq - 3;
+         if (seqB % 7 != 3 && seqB % 7 != 4) {
+            feeder.FeedLine(1, seqB);
+            ++rxB;
+         }
+         else if (seqB % 7 == 3)
+            ++gapB;
+      }
+   }
+   for (Feeder::SeqT seqB = kSeqTo - 2; seqB <= kSeqTo; ++seqB) {
+      if (seqB % 7 != 3 && seqB % 7 != 4) {
+         feeder.FeedLine(1, seqB);
+         ++rxB;
+      }
+   }
+   CheckLineStat(feeder, 0, rxA, gapA, gapA);
+   CheckLineStat(feeder, 1, rxB, gapB, gapB * 2);
+   const fon9::PkContLineStat& statA = feeder.GetLineStat(0);
+   const fon9::PkContLineStat& statB = feeder.GetLineStat(1);
+   if (statA.FirstCount_ + statB.FirstCount_ != kSeqTo - kSeqFrom + 1
+       || statB.LagHist_.GetCount() != statB.DupCount_) {
+      std::cout << "|err=Unexpected first/lag count.\r[ERROR]" << std::endl;
+      abort();
+   }
+   feeder.CheckReceivedCount(kSeqTo - kSeqFrom + 1);
+}
+
+/// 2 個 thread 分別從 A/B 線路放入封包, 各自遺漏不同的封包.
+void TestArbiterThreads(Feeder::SeqT pkCount) {
+   fon9::PkContArgs  args;
+   args.LineCount_ = 2;
+   args.HoldSize_ = static_cast<unsigned>(pkCount);
+   Feeder feeder{args};
+   feeder.WaitInterval_ = fon9::TimeInterval_Second(100);
+   feeder.ExpectedSeq_ = 1;
+   std::cout << "[TEST ] PkContAB.threads|pkCount=" << pkCount;
+   fon9::StopWatch stopWatch;
+   std::thread thrA{[&feeder, pkCount]() {
+      for (Feeder::SeqT seq = 1; seq <= pkCount; ++seq) {
+         if (seq % 97 != 0)
+            feeder.FeedLine(0, seq);
+      }
+   }};
+   std::thread thrB{[&feeder, pkCount]() {
+      for (Feeder::SeqT seq = 1; seq <= pkCount; ++seq) {
+         if (seq % 89 != 0 || seq % 97 == 0)
+            feeder.FeedLine(1, seq);
+      }
+   }};
+   thrA.join();
+   thrB.join();
+   const double span = stopWatch.StopTimer();
+   CheckLineStat(feeder, 0, pkCount - pkCount / 97, pkCount / 97, pkCount / 97);
+   const fon9::PkContLineStat& statB = feeder.GetLineStat(1);
+   std::cout << "|lagB=";
+   fon9::RevBufferFixedSize<1024> rbuf;
+   fon9::RevPrint(rbuf, statB.LagHist_);
+   std::cout << rbuf.ToStrT<std::string>();
+   feeder.CheckReceivedCount(pkCount);
+   fon9::StopWatch::PrintResultNoEOL(span, "A/B feed", pkCount * 2)
+      << "|pk/sec=" << static_cast<uint64_t>(static_cast<double>(pkCount * 2) / span) << std::endl;
+}
+
 int main(int argc, char* argv[]) {
    (void)argc; (void)argv;
    fon9::AutoPrintTestInfo utinfo{"PkCont"};
@@ -109,4 +214,8 @@ int main(int argc, char* argv[]) {
       feeder.Feed(seq + L);
    waiter.WaitFor(feeder.WaitInterval_ + fon9::TimeInterval_Millisecond(1));
    feeder.CheckReceivedCount(pkcount += kGapCount + 1);
+
+   utinfo.PrintSplitter();
+   TestArbiterAB();
+   TestArbiterThreads(200 * 1000);
 }
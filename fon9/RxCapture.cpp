@@ -0,0 +1,333 @@
+﻿// \file fon9/RxCapture.cpp
+// \author fonwinz@gmail.com
+#include "fon9/RxCapture.hpp"
+#include "fon9/Endian.hpp"
+#include "fon9/buffer/DcQueue.hpp"
+#include <cstring>
+#include <algorithm>
+#include <thread>
+
+namespace fon9 {
+
+static inline TimeStamp RxCaptureGetTime(const void* p) {
+   return TimeStamp{TimeInterval_Microsecond(GetBigEndian<int64_t>(p))};
+}
+static inline void RxCapturePutTime(void* p, TimeStamp tm) {
+   PutBigEndian(p, static_cast<int64_t>(tm.GetOrigValue()));
+}
+static void RxCaptureMakeHeader(byte* hdr, TimeStamp createTime) {
+   memset(hdr, 0, kRxCaptureHeaderSize);
+   memcpy(hdr, fon9_kCSTR_RxCaptureMagic, 8);
+   PutBigEndian(hdr + 8, static_cast<uint32_t>(kRxCaptureVersion));
+   PutBigEndian(hdr + 12, static_cast<uint32_t>(kRxCaptureHeaderSize));
+   RxCapturePutTime(hdr + 16, createTime);
+}
+static bool RxCaptureCheckHeader(const byte* hdr) {
+   return memcmp(hdr, fon9_kCSTR_RxCaptureMagic, 8) == 0
+      && GetBigEndian<uint32_t>(hdr + 8) == kRxCaptureVersion
+      && GetBigEndian<uint32_t>(hdr + 12) == kRxCaptureHeaderSize;
+}
+static File::Result RxCaptureReadHeader(File& fd) {
+   byte hdr[kRxCaptureHeaderSize];
+   File::Result res = fd.Read(0, hdr, sizeof(hdr));
+   if (res && (res.GetResult() != sizeof(hdr) || !RxCaptureCheckHeader(hdr)))
+      return File::Result{std::errc::invalid_argument};
+   return res;
+}
+
+//--------------------------------------------------------------------------//
+
+RxCaptureWriter::~RxCaptureWriter() {
+   this->WaitFlushed();
+}
+
+File::Result RxCaptureWriter::Initialize(std::string fileName) {
+   if (this->GetStorage().IsOpened())
+      return File::Result{std::errc::text_file_busy};
+   std::string indexFileName = fileName + ".cidx";
+   auto res = this->Open(std::move(fileName), FileMode::Append | FileMode::CreatePath | FileMode::Read | FileMode::DenyWrite).get();
+   if (!res)
+      return res;
+   File& file = this->GetStorage();
+   if (!(res = file.GetFileSize())) {
+      file.Close();
+      return res;
+   }
+   Locker lk{this->Mutex_};
+   this->IndexFile_.Open(std::move(indexFileName), FileMode::Append | FileMode::CreatePath | FileMode::Read);
+   if ((this->NextPos_ = res.GetResult()) == 0) {
+      // 新檔案: 寫入檔頭, 並清除可能殘留的索引.
+      byte hdr[kRxCaptureHeaderSize];
+      RxCaptureMakeHeader(hdr, UtcNow());
+      if (!(res = file.Append(hdr, sizeof(hdr)))) {
+         file.Close();
+         return res;
+      }
+      this->NextPos_ = kRxCaptureHeaderSize;
+      if (this->IndexFile_.IsOpened())
+         this->IndexFile_.SetFileSize(0);
+      this->LastIndexPos_ = 0;
+      this->LastIndexTime_ = TimeStamp{};
+      return File::Result{this->NextPos_};
+   }
+   if (!(res = RxCaptureReadHeader(file))) {
+      file.Close();
+      return res;
+   }
+   // 接續寫入已存在的檔案: 從最後一筆索引開始, 找到最後一筆完整記錄的尾端.
+   // 若尾端有不完整的記錄(例: 程式異常結束), 則截斷, 避免新的記錄接在殘缺記錄之後.
+   PosType pos = kRxCaptureHeaderSize;
+   this->LastIndexPos_ = 0;
+   this->LastIndexTime_ = TimeStamp{};
+   if (this->IndexFile_.IsOpened()) {
+      File::Result isz = this->IndexFile_.GetFileSize();
+      PosType      ipos = (isz ? isz.GetResult() - isz.GetResult() % kRxCaptureIndexEntrySize : 0);
+      byte         ient[kRxCaptureIndexEntrySize];
+      while (ipos > 0) {
+         ipos -= kRxCaptureIndexEntrySize;
+         isz = this->IndexFile_.Read(ipos, ient, sizeof(ient));
+         if (!isz || isz.GetResult() != sizeof(ient))
+            break;
+         const PosType epos = GetBigEndian<uint64_t>(ient + 8);
+         if (epos < kRxCaptureHeaderSize || epos >= this->NextPos_)
+            continue; // 索引指向的記錄已不存在(被截斷?)
+         pos = epos;
+         this->LastIndexPos_ = epos;
+         this->LastIndexTime_ = RxCaptureGetTime(ient);
+         break;
+      }
+   }
+   byte rhdr[kRxCaptureRecordHeaderSize];
+   for (;;) {
+      if (pos + kRxCaptureRecordHeaderSize > this->NextPos_)
+         break;
+      res = file.Read(pos, rhdr, sizeof(rhdr));
+      if (!res || res.GetResult() != sizeof(rhdr))
+         break;
+      const PosType next = pos + kRxCaptureRecordHeaderSize + GetBigEndian<uint32_t>(rhdr);
+      if (next > this->NextPos_)
+         break;
+      pos = next;
+   }
+   if (pos != this->NextPos_) {
+      if (!(res = file.SetFileSize(pos))) {
+         file.Close();
+         return res;
+      }
+      this->NextPos_ = pos;
+   }
+   return File::Result{this->NextPos_};
+}
+
+/// 當此節點被消費時(該筆記錄已寫入), 在寫檔 thread 寫入一筆索引.
+struct RxCaptureWriter::NodeIndex : public BufferNodeVirtual {
+   fon9_NON_COPY_NON_MOVE(NodeIndex);
+   using base = BufferNodeVirtual;
+   friend class BufferNode;// for BufferNode::Alloc();
+   File* IndexFile_;
+   byte  Entry_[kRxCaptureIndexEntrySize];
+protected:
+   NodeIndex(BufferNodeSize blockSize, File* indexFile, TimeStamp rxTime, PosType pos)
+      : base(blockSize, StyleFlag{})
+      , IndexFile_{indexFile} {
+      RxCapturePutTime(this->Entry_, rxTime);
+      PutBigEndian(this->Entry_ + 8, static_cast<uint64_t>(pos));
+   }
+   void OnBufferConsumed() override {
+      this->IndexFile_->Append(this->Entry_, sizeof(this->Entry_));
+   }
+   void OnBufferConsumedErr(const ErrC&) override {
+      // 記錄寫入失敗, 不寫入指向該筆記錄的索引.
+   }
+public:
+   static NodeIndex* Alloc(File* indexFile, TimeStamp rxTime, PosType pos) {
+      return base::Alloc<NodeIndex>(0, indexFile, rxTime, pos);
+   }
+};
+
+void RxCaptureWriter::OnAppendRecord(BufferList& buf, uint32_t size, TimeStamp rxTime) {
+   // 在 this->Mutex_ 保護下呼叫.
+   if (this->LastIndexPos_ == 0
+       || rxTime.GetIntPart() != this->LastIndexTime_.GetIntPart()
+       || this->NextPos_ - this->LastIndexPos_ >= kRxCaptureIndexBytes) {
+      this->LastIndexPos_ = this->NextPos_;
+      this->LastIndexTime_ = rxTime;
+      if (this->IndexFile_.IsOpened())
+         buf.push_back(NodeIndex::Alloc(&this->IndexFile_, rxTime, this->NextPos_));
+   }
+   this->NextPos_ += kRxCaptureRecordHeaderSize + size;
+   ++this->RecordCount_;
+}
+
+static inline void RxCaptureMakeRecordHeader(byte* rhdr, uint32_t size, uint32_t lineId, TimeStamp rxTime) {
+   PutBigEndian(rhdr, size);
+   PutBigEndian(rhdr + 4, lineId);
+   RxCapturePutTime(rhdr + 8, rxTime);
+}
+
+void RxCaptureWriter::Append(uint32_t lineId, TimeStamp rxTime, const void* pk, size_t pksz) {
+   if (rxTime.IsNull())
+      rxTime = UtcNow();
+   const uint32_t size = static_cast<uint32_t>(pksz);
+   byte           rhdr[kRxCaptureRecordHeaderSize];
+   RxCaptureMakeRecordHeader(rhdr, size, lineId, rxTime);
+   BufferList     buf;
+   AppendToBuffer(buf, rhdr, sizeof(rhdr));
+   AppendToBuffer(buf, pk, pksz);
+   // 記錄頭及內容, 必須在同一次 base::Append() 加入, 才不會與其他 thread 的記錄交錯;
+   // 且必須在 Mutex_ 保護下加入, 才能讓檔案位置與索引一致.
+   Locker lk{this->Mutex_};
+   this->OnAppendRecord(buf, size, rxTime);
+   base::Append(std::move(buf));
+}
+
+void RxCaptureWriter::Append(uint32_t lineId, TimeStamp rxTime, const DcQueueList& rxbuf, size_t skipSize) {
+   if (rxTime.IsNull())
+      rxTime = UtcNow();
+   const size_t   total = rxbuf.CalcSize();
+   if (total <= skipSize)
+      return;
+   const uint32_t size = static_cast<uint32_t>(total - skipSize);
+   byte           rhdr[kRxCaptureRecordHeaderSize];
+   RxCaptureMakeRecordHeader(rhdr, size, lineId, rxTime);
+   BufferList     buf;
+   AppendToBuffer(buf, rhdr, sizeof(rhdr));
+   // 第一個節點可能有已取出的資料, 所以要從 PeekCurrBlock() 開始.
+   auto blk = rxbuf.PeekCurrBlock();
+   for (const BufferNode* node = rxbuf.cfront();;) {
+      if (blk.second > skipSize) {
+         AppendToBuffer(buf, blk.first + skipSize, blk.second - skipSize);
+         skipSize = 0;
+      }
+      else
+         skipSize -= blk.second;
+      if (node == nullptr || (node = node->GetNext()) == nullptr)
+         break;
+      blk.first = node->GetDataBegin();
+      blk.second = node->GetDataSize();
+   }
+   Locker lk{this->Mutex_};
+   this->OnAppendRecord(buf, size, rxTime);
+   base::Append(std::move(buf));
+}
+
+//--------------------------------------------------------------------------//
+
+bool RxCaptureReader::IsRxCaptureFile(File& fd) {
+   return RxCaptureReadHeader(fd).HasResult();
+}
+
+File::Result RxCaptureReader::Open(std::string fileName) {
+   std::string indexFileName = fileName + ".cidx";
+   File::Result res = this->File_.Open(std::move(fileName), FileMode::Read);
+   if (!res)
+      return res;
+   if (!(res = RxCaptureReadHeader(this->File_))) {
+      this->File_.Close();
+      return res;
+   }
+   this->Pos_ = kRxCaptureHeaderSize;
+   this->BufPos_ = 0;
+   this->BufSize_ = 0;
+   this->Index_.clear();
+   File idxFile;
+   if (idxFile.Open(std::move(indexFileName), FileMode::Read)) {
+      File::Result isz = idxFile.GetFileSize();
+      if (isz && isz.GetResult() >= kRxCaptureIndexEntrySize) {
+         std::vector<byte> ibuf(static_cast<size_t>(isz.GetResult() - isz.GetResult() % kRxCaptureIndexEntrySize));
+         isz = idxFile.Read(0, ibuf.data(), ibuf.size());
+         if (isz) {
+            const size_t count = static_cast<size_t>(isz.GetResult() / kRxCaptureIndexEntrySize);
+            this->Index_.reserve(count);
+            for (size_t L = 0; L < count; ++L) {
+               const byte* ient = ibuf.data() + L * kRxCaptureIndexEntrySize;
+               IndexEntry  e{RxCaptureGetTime(ient), GetBigEndian<uint64_t>(ient + 8)};
+               // 索引必須遞增, 若有錯亂(例: 系統時間被調整), 則只使用到錯亂之前.
+               if (!this->Index_.empty() && (e.Pos_ <= this->Index_.back().Pos_ || e.RxTime_ < this->Index_.back().RxTime_))
+                  break;
+               this->Index_.push_back(e);
+            }
+         }
+      }
+   }
+   return res;
+}
+
+const byte* RxCaptureReader::Fetch(size_t sz) {
+   if (this->Pos_ >= this->BufPos_ && this->Pos_ + sz <= this->BufPos_ + this->BufSize_)
+      return this->Buffer_.data() + (this->Pos_ - this->BufPos_);
+   static const size_t kMinBufferSize = 64 * 1024;
+   if (this->Buffer_.size() < sz || this->Buffer_.size() < kMinBufferSize)
+      this->Buffer_.resize(std::max(sz, kMinBufferSize));
+   File::Result res = this->File_.Read(this->Pos_, this->Buffer_.data(), this->Buffer_.size());
+   this->BufPos_ = this->Pos_;
+   this->BufSize_ = (res ? static_cast<size_t>(res.GetResult()) : 0);
+   return this->BufSize_ >= sz ? this->Buffer_.data() : nullptr;
+}
+
+const void* RxCaptureReader::Next(RxCaptureRecord& rec) {
+   const byte* rhdr = this->Fetch(kRxCaptureRecordHeaderSize);
+   if (rhdr == nullptr)
+      return nullptr;
+   rec.Size_ = GetBigEndian<uint32_t>(rhdr);
+   rec.LineId_ = GetBigEndian<uint32_t>(rhdr + 4);
+   rec.RxTime_ = RxCaptureGetTime(rhdr + 8);
+   const byte* rec_all = this->Fetch(kRxCaptureRecordHeaderSize + rec.Size_);
+   if (rec_all == nullptr)
+      return nullptr;
+   this->Pos_ += kRxCaptureRecordHeaderSize + rec.Size_;
+   return rec_all + kRxCaptureRecordHeaderSize;
+}
+
+void RxCaptureReader::SeekTime(TimeStamp tm) {
+   auto ifind = std::upper_bound(this->Index_.begin(), this->Index_.end(), tm,
+                                 [](TimeStamp t, const IndexEntry& e) { return t < e.RxTime_; });
+   // ifind = 第一個 RxTime_ > tm 的索引, 所以要從前一個索引(RxTime_ <= tm)開始找;
+   // 但同一秒可能有多個索引, 所以需要再往前找到該秒的第一個索引.
+   while (ifind != this->Index_.begin()) {
+      --ifind;
+      if (ifind->RxTime_ < tm)
+         break;
+   }
+   this->Pos_ = (ifind == this->Index_.end() || !(ifind->RxTime_ < tm)) ? PosType{kRxCaptureHeaderSize} : ifind->Pos_;
+   for (;;) {
+      const PosType   pos = this->Pos_;
+      RxCaptureRecord rec;
+      if (this->Next(rec) == nullptr || rec.RxTime_ >= tm) {
+         this->Pos_ = pos;
+         break;
+      }
+   }
+}
+
+//--------------------------------------------------------------------------//
+
+TimeStamp RxReplayPacer::GetDueTime(TimeStamp rxTime, TimeStamp now) {
+   if (this->FirstRxTime_.IsNull()) {
+      this->FirstRxTime_ = rxTime;
+      this->StartTime_ = now;
+      return now;
+   }
+   if (this->Speed_ <= 0)
+      return now;
+   TimeInterval elapsed = rxTime - this->FirstRxTime_;
+   if (this->Speed_ != 1)
+      elapsed = TimeInterval_Microsecond(static_cast<TimeInterval::OrigType>(static_cast<double>(elapsed.GetOrigValue()) / this->Speed_));
+   return this->StartTime_ + elapsed;
+}
+
+TimeStamp RxReplayPacer::WaitDue(TimeStamp rxTime) {
+   TimeStamp now = UtcNow();
+   const TimeStamp due = this->GetDueTime(rxTime, now);
+   while (now < due) {
+      const TimeInterval ti = due - now;
+      if (ti > TimeInterval_Millisecond(1))
+         std::this_thread::sleep_for(std::chrono::microseconds(ti.GetOrigValue() - 1000));
+      else
+         std::this_thread::yield();
+      now = UtcNow();
+   }
+   return now;
+}
+
+} // namespaces
@@ -0,0 +1,188 @@
+﻿/// \file fon9/RxCapture.hpp
+/// \author fonwinz@gmail.com
+#ifndef __fon9_RxCapture_hpp__
+#define __fon9_RxCapture_hpp__
+#include "fon9/FileAppender.hpp"
+#include "fon9/buffer/DcQueueList.hpp"
+#include <vector>
+#include <mutex>
+
+namespace fon9 {
+
+/// \ingroup Misc
+/// 接收資料記錄檔(例: 交易所行情): 保留每次收到的資料內容, 及收到的時間.
+/// - 檔案開頭: kRxCaptureHeaderSize bytes(big endian):
+///   `char Magic_[8] = "f9RxCap\n"; uint32_t Version_; uint32_t HeaderSize_; int64_t CreateTime_(us); char Reserved_[8];`
+/// - 之後每筆記錄: kRxCaptureRecordHeaderSize bytes 的記錄頭(big endian) + 收到的資料.
+///   `uint32_t Size_; uint32_t LineId_; int64_t RxTime_(us);`
+///   - 每筆記錄為一次收到的資料, 例: Dgram 的一個封包, 或 TCP 的一次 recv().
+/// - 附屬的索引檔(fileName + ".cidx"), 只會在尾端附加, 每筆 16 bytes(big endian):
+///   `int64_t RxTime_(us); uint64_t Pos_;`
+///   - 每當 RxTime_ 換秒(或距離上次索引超過 kRxCaptureIndexBytes), 記錄一次該筆記錄在檔案的位置.
+///   - 索引只用來加速 RxCaptureReader::SeekTime(), 若索引檔遺失, 仍可從頭讀取.
+enum : uint32_t {
+   kRxCaptureVersion = 1,
+   kRxCaptureHeaderSize = 32,
+   kRxCaptureRecordHeaderSize = 16,
+   kRxCaptureIndexEntrySize = 16,
+   kRxCaptureIndexBytes = 1024 * 1024,
+};
+#define fon9_kCSTR_RxCaptureMagic   "f9RxCap\n"
+
+/// \ingroup Misc
+/// 接收資料記錄檔的一筆記錄頭.
+struct RxCaptureRecord {
+   uint32_t    Size_;
+   uint32_t    LineId_;
+   TimeStamp   RxTime_;
+};
+
+fon9_WARN_DISABLE_PADDING;
+/// \ingroup Misc
+/// 寫入接收資料記錄檔, 使用 AsyncFileAppender 在 ThreadPool 寫檔, 不會讓接收資料的 thread 等候.
+/// - 可在多個 thread 同時呼叫 Append(), 例: A/B 備援線路寫入同一個記錄檔, 使用 LineId 區分.
+/// - 索引也在寫檔 thread 寫入: 索引項目放在該筆記錄之後, 記錄寫入後才寫入索引.
+class fon9_API RxCaptureWriter : public AsyncFileAppender {
+   fon9_NON_COPY_NON_MOVE(RxCaptureWriter);
+   using base = AsyncFileAppender;
+   using Locker = std::unique_lock<std::mutex>;
+   std::mutex  Mutex_;
+   File        IndexFile_;
+   PosType     NextPos_{0};
+   PosType     LastIndexPos_{0};
+   TimeStamp   LastIndexTime_;
+   uint64_t    RecordCount_{0};
+
+   struct NodeIndex;
+   /// 在 Mutex_ 保護下, 計算新記錄的位置;
+   /// 若需要索引, 則在 buf 尾端加上 NodeIndex, 在寫檔 thread 寫入索引.
+   void OnAppendRecord(BufferList& buf, uint32_t size, TimeStamp rxTime);
+
+public:
+   RxCaptureWriter() = default;
+   ~RxCaptureWriter();
+
+   /// 開啟記錄檔及索引檔, 若記錄檔已存在, 則接續在尾端寫入.
+   /// 若記錄檔已存在, 但檔頭不正確, 則返回 std::errc::invalid_argument.
+   File::Result Initialize(std::string fileName);
+
+   /// 寫入一筆記錄.
+   /// 若 rxTime.IsNull() 則使用 UtcNow().
+   void Append(uint32_t lineId, TimeStamp rxTime, const void* pk, size_t pksz);
+   /// 將 rxbuf 裡面, 略過前 skipSize bytes 之後的資料, 寫成一筆記錄, 不會移除 rxbuf 的內容.
+   /// 通常用在 Session::OnDevice_Recv(): skipSize 為上次處理後剩餘的資料量.
+   void Append(uint32_t lineId, TimeStamp rxTime, const DcQueueList& rxbuf, size_t skipSize);
+
+   uint64_t GetRecordCount() const {
+      return this->RecordCount_;
+   }
+};
+using RxCaptureWriterSP = intrusive_ptr<RxCaptureWriter>;
+
+/// \ingroup Misc
+/// 讀取接收資料記錄檔.
+/// - 可以讀取正在寫入的記錄檔: 尾端不完整的記錄視為檔尾, 之後可再呼叫 Next() 繼續讀取.
+class fon9_API RxCaptureReader {
+   fon9_NON_COPY_NON_MOVE(RxCaptureReader);
+public:
+   using PosType = File::PosType;
+   struct IndexEntry {
+      TimeStamp   RxTime_;
+      PosType     Pos_;
+   };
+
+   RxCaptureReader() = default;
+
+   /// 開啟記錄檔, 並載入索引檔(若有).
+   /// 若檔頭不正確, 則返回 std::errc::invalid_argument.
+   File::Result Open(std::string fileName);
+   /// 檢查 fileName 是否為接收資料記錄檔(檔頭是否正確).
+   static bool IsRxCaptureFile(File& fd);
+
+   /// 讀取下一筆記錄.
+   /// \retval nullptr  檔尾, 或尾端記錄不完整(可能正在寫入).
+   /// \retval !nullptr 記錄內容(rec.Size_ bytes), 在下次呼叫 Next(), SeekTime(), Rewind() 之前有效.
+   const void* Next(RxCaptureRecord& rec);
+   /// 移到第一筆 RxTime_ >= tm 的記錄: 透過索引找到起點, 再逐筆往後找.
+   void SeekTime(TimeStamp tm);
+   /// 移到第一筆記錄.
+   void Rewind() {
+      this->Pos_ = kRxCaptureHeaderSize;
+   }
+   /// 下一筆記錄在檔案的位置.
+   PosType GetPos() const {
+      return this->Pos_;
+   }
+   /// 移到 pos, 必須是某筆記錄的開頭, 例: 之前呼叫 GetPos() 的結果.
+   void Seek(PosType pos) {
+      this->Pos_ = pos;
+   }
+   const std::vector<IndexEntry>& GetIndex() const {
+      return this->Index_;
+   }
+
+private:
+   /// 確保 Buffer_ 裡面有 [this->Pos_, this->Pos_ + sz) 的資料.
+   const byte* Fetch(size_t sz);
+
+   File                    File_;
+   PosType                 Pos_{kRxCaptureHeaderSize};
+   std::vector<IndexEntry> Index_;
+   std::vector<byte>       Buffer_;
+   /// Buffer_ 的資料在檔案的位置.
+   PosType                 BufPos_{0};
+   size_t                  BufSize_{0};
+};
+
+/// \ingroup Misc
+/// 重播接收資料記錄檔時, 控制重播的時間.
+class fon9_API RxReplayPacer {
+   double      Speed_;
+   TimeStamp   FirstRxTime_{TimeStamp::Null()};
+   TimeStamp   StartTime_;
+public:
+   /// speed:
+   /// - <= 0: 盡速重播, 不等候.
+   /// - 1: 依照原始收到的時間間隔重播.
+   /// - N: N 倍速重播, 例: 2 = 時間間隔為原始的一半.
+   explicit RxReplayPacer(double speed = 1) : Speed_{speed} {
+   }
+   double GetSpeed() const {
+      return this->Speed_;
+   }
+   bool IsAsFastAsPossible() const {
+      return this->Speed_ <= 0;
+   }
+   /// 下次呼叫 GetDueTime() 時, 重新設定起點.
+   void Reset() {
+      this->FirstRxTime_ = TimeStamp::Null();
+   }
+   /// 計算 rxTime 的記錄應在何時重播.
+   /// 第一次呼叫時(或 Reset() 之後), 以 rxTime 對應 now, 作為計算的起點.
+   TimeStamp GetDueTime(TimeStamp rxTime, TimeStamp now);
+   /// 等到 rxTime 的記錄應重播的時間: 距離超過 1ms 時使用 sleep, 之後使用 yield.
+   /// \return 重播的時間(UtcNow()).
+   TimeStamp WaitDue(TimeStamp rxTime);
+};
+fon9_WARN_POP;
+
+/// \ingroup Misc
+/// 依照 pacer 的速度, 重播 reader 的記錄, 直到檔尾.
+/// - fnOnRecord(const RxCaptureRecord& rec, const void* dat);
+/// - 可使用 rec.RxTime_(原始收到的時間), 讓重播的結果與原始收到時一致.
+/// \return 重播的記錄數量.
+template <class FnOnRecord>
+uint64_t RxCaptureReplay(RxCaptureReader& reader, RxReplayPacer& pacer, FnOnRecord&& fnOnRecord) {
+   uint64_t          count = 0;
+   RxCaptureRecord   rec;
+   while (const void* dat = reader.Next(rec)) {
+      if (!pacer.IsAsFastAsPossible())
+         pacer.WaitDue(rec.RxTime_);
+      fnOnRecord(rec, dat);
+      ++count;
+   }
+   return count;
+}
+
+} // namespaces
+#endif//__fon9_RxCapture_hpp__
@@ -0,0 +1,236 @@
+﻿// \file fon9/RxCapture_UT.cpp
+// \author fonwinz@gmail.com
+#define _CRT_SECURE_NO_WARNINGS
+#include "fon9/RxCapture.hpp"
+#include "fon9/buffer/FwdBufferList.hpp"
+#include "fon9/TestTools.hpp"
+#include "fon9/StrTo.hpp"
+
+static const char kCapFileName[] = "RxCapture_UT.f9rx";
+static const fon9::TimeStamp kRxTimeBase = fon9::TimeStamp{fon9::TimeInterval_Second(1700000000)};
+
+static void RemoveCapFile() {
+   remove(kCapFileName);
+   remove((std::string{kCapFileName} + ".cidx").c_str());
+}
+static fon9::RxCaptureWriterSP OpenWriter() {
+   fon9::RxCaptureWriterSP writer{new fon9::RxCaptureWriter};
+   auto res = writer->Initialize(kCapFileName);
+   if (!res) {
+      std::cout << "|Initialize=" << fon9::RevPrintTo<std::string>(res) << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   return writer;
+}
+static void OpenReader(fon9::RxCaptureReader& reader) {
+   auto res = reader.Open(kCapFileName);
+   if (!res) {
+      std::cout << "|Open=" << fon9::RevPrintTo<std::string>(res) << "\r[ERROR]" << std::endl;
+      abort();
+   }
+}
+
+/// 第 i 筆記錄: 每 1ms 一筆, 內容長度 = (i % 50 + 1), 內容 = (byte)i.
+static fon9::TimeStamp RecTime(uint32_t i) {
+   return kRxTimeBase + fon9::TimeInterval_Millisecond(i);
+}
+static void CheckRec(uint32_t i, const fon9::RxCaptureRecord& rec, const void* dat) {
+   if (dat == nullptr) {
+      std::cout << "|i=" << i << "|err=Unexpected EOF" "\r[ERROR]" << std::endl;
+      abort();
+   }
+   const uint32_t sz = i % 50 + 1;
+   if (rec.Size_ != sz || rec.LineId_ != i % 2 || rec.RxTime_ != RecTime(i)) {
+      std::cout << "|i=" << i << "|size=" << rec.Size_ << "|line=" << rec.LineId_
+         << "|err=Bad record header" "\r[ERROR]" << std::endl;
+      abort();
+   }
+   for (uint32_t L = 0; L < sz; ++L) {
+      if (static_cast<const fon9::byte*>(dat)[L] != static_cast<fon9::byte>(i)) {
+         std::cout << "|i=" << i << "|err=Bad record contents" "\r[ERROR]" << std::endl;
+         abort();
+      }
+   }
+}
+static void AppendRec(fon9::RxCaptureWriter& writer, uint32_t i) {
+   fon9::byte dat[64];
+   memset(dat, static_cast<fon9::byte>(i), sizeof(dat));
+   writer.Append(i % 2, RecTime(i), dat, i % 50 + 1);
+}
+
+//--------------------------------------------------------------------------//
+
+static const uint32_t kRecCount = 10000;
+
+void TestWriteRead() {
+   std::cout << "[TEST ] RxCapture.WriteRead";
+   RemoveCapFile();
+   {
+      fon9::RxCaptureWriterSP writer = OpenWriter();
+      for (uint32_t i = 0; i < kRecCount; ++i)
+         AppendRec(*writer, i);
+      writer->WaitFlushed();
+   }
+   fon9::RxCaptureReader   reader;
+   OpenReader(reader);
+   fon9::RxCaptureRecord   rec;
+   for (uint32_t i = 0; i < kRecCount; ++i)
+      CheckRec(i, rec, reader.Next(rec));
+   if (reader.Next(rec) != nullptr) {
+      std::cout << "|err=Expect EOF" "\r[ERROR]" << std::endl;
+      abort();
+   }
+   // 每 1ms 一筆, 共 10 秒, 所以至少有 10 筆索引.
+   const size_t idxCount = reader.GetIndex().size();
+   if (idxCount < kRecCount / 1000) {
+      std::cout << "|index=" << idxCount << "|err=Index too small" "\r[ERROR]" << std::endl;
+      abort();
+   }
+   std::cout << "|index=" << idxCount;
+   // SeekTime().
+   struct SeekCase {
+      fon9::TimeStamp   Time_;
+      uint32_t          Expected_;
+   };
+   const SeekCase seekCases[] = {
+      {kRxTimeBase - fon9::TimeInterval_Second(1), 0},
+      {RecTime(0), 0},
+      {RecTime(999), 999},
+      {RecTime(1000), 1000},
+      {RecTime(5000), 5000},
+      {RecTime(5000) + fon9::TimeInterval_Microsecond(1), 5001},
+      {RecTime(kRecCount - 1), kRecCount - 1},
+      {RecTime(kRecCount), kRecCount},
+   };
+   for (const SeekCase& c : seekCases) {
+      reader.SeekTime(c.Time_);
+      const void* dat = reader.Next(rec);
+      if (c.Expected_ >= kRecCount) {
+         if (dat == nullptr)
+            continue;
+         std::cout << "|err=SeekTime() expect EOF" "\r[ERROR]" << std::endl;
+         abort();
+      }
+      CheckRec(c.Expected_, rec, dat);
+   }
+   reader.Rewind();
+   CheckRec(0, rec, reader.Next(rec));
+   std::cout << "\r[OK   ]" << std::endl;
+}
+
+/// 接續寫入已存在的檔案, 若尾端有殘缺的記錄, 應截斷.
+void TestReopen() {
+   std::cout << "[TEST ] RxCapture.Reopen";
+   {  // 模擬寫到一半當機: 尾端有不完整的記錄.
+      fon9::File fd;
+      fd.Open(kCapFileName, fon9::FileMode::Append);
+      const char partial[] = "\0\0\0\x10\0\0\0\0";
+      fd.Append(partial, sizeof(partial) - 1);
+   }
+   {
+      fon9::RxCaptureWriterSP writer = OpenWriter();
+      AppendRec(*writer, kRecCount);
+      // 使用 DcQueueList: 略過已處理過的資料.
+      fon9::DcQueueList rxbuf;
+      const uint32_t    i = kRecCount + 1;
+      const size_t      sz = i % 50 + 1;
+      for (size_t L = 0; L < 3; ++L) { // 3 個節點: [前次剩餘 5 bytes + 新資料前半] [新資料後半] [空節點]
+         fon9::FwdBufferNode* node = fon9::FwdBufferNode::Alloc(64);
+         size_t nsz = (L == 0 ? 5 + sz / 2 : L == 1 ? sz - sz / 2 : 0);
+         memset(node->GetDataEnd(), static_cast<fon9::byte>(i), nsz);
+         node->SetDataEnd(node->GetDataEnd() + nsz);
+         rxbuf.push_back(node);
+      }
+      rxbuf.PopConsumed(2);
+      writer->Append(i % 2, RecTime(i), rxbuf, 3);
+      writer->WaitFlushed();
+   }
+   fon9::RxCaptureReader   reader;
+   OpenReader(reader);
+   fon9::RxCaptureRecord   rec;
+   for (uint32_t i = 0; i < kRecCount + 2; ++i)
+      CheckRec(i, rec, reader.Next(rec));
+   if (reader.Next(rec) != nullptr) {
+      std::cout << "|err=Expect EOF" "\r[ERROR]" << std::endl;
+      abort();
+   }
+   reader.SeekTime(RecTime(kRecCount + 1));
+   CheckRec(kRecCount + 1, rec, reader.Next(rec));
+   std::cout << "\r[OK   ]" << std::endl;
+}
+
+void TestPacer() {
+   std::cout << "[TEST ] RxReplayPacer";
+   fon9::RxReplayPacer  pacer{2};
+   const fon9::TimeStamp now = fon9::UtcNow();
+   if (pacer.GetDueTime(kRxTimeBase, now) != now
+       || pacer.GetDueTime(kRxTimeBase + fon9::TimeInterval_Millisecond(10), now) != now + fon9::TimeInterval_Millisecond(5)) {
+      std::cout << "|err=GetDueTime()" "\r[ERROR]" << std::endl;
+      abort();
+   }
+   // 重播全部記錄(每筆間隔 1ms), 使用 10 倍速, 應耗時約 1 秒.
+   fon9::RxCaptureReader   reader;
+   OpenReader(reader);
+   pacer = fon9::RxReplayPacer{10};
+   uint32_t          count = 0;
+   const fon9::TimeStamp   tmBeg = fon9::UtcNow();
+   fon9::RxCaptureReplay(reader, pacer, [&count](const fon9::RxCaptureRecord& rec, const void* dat) {
+      CheckRec(count++, rec, dat);
+   });
+   std::cout << "|count=" << count;
+   const double span = (fon9::UtcNow() - tmBeg).To<double>();
+   const double expected = static_cast<double>(kRecCount + 1) / 1000 / 10;
+   std::cout << "|span=" << span << "|expected=" << expected;
+   if (count != kRecCount + 2 || span < expected) {
+      std::cout << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   std::cout << "\r[OK   ]" << std::endl;
+}
+
+//--------------------------------------------------------------------------//
+
+void BenchCapture(uint32_t count) {
+   RemoveCapFile();
+   fon9::byte dat[64];
+   memset(dat, 0, sizeof(dat));
+   fon9::StopWatch stopWatch;
+   {
+      fon9::RxCaptureWriterSP writer = OpenWriter();
+      for (uint32_t i = 0; i < count; ++i)
+         writer->Append(0, fon9::TimeStamp::Null(), dat, sizeof(dat));
+      stopWatch.PrintResult("Capture.Append  ", count);
+      writer->WaitFlushed();
+   }
+   stopWatch.PrintResult("Capture.Flushed ", count);
+
+   fon9::RxCaptureReader reader;
+   OpenReader(reader);
+   fon9::RxReplayPacer   pacer{0};
+   uint64_t              bytes = 0;
+   stopWatch.ResetTimer();
+   const uint64_t rcount = fon9::RxCaptureReplay(reader, pacer, [&bytes](const fon9::RxCaptureRecord& rec, const void*) {
+      bytes += rec.Size_;
+   });
+   stopWatch.PrintResult("Replay.Fast     ", rcount);
+   if (rcount != count || bytes != count * sizeof(dat)) {
+      std::cout << "[ERROR] Replay count=" << rcount << std::endl;
+      abort();
+   }
+}
+
+int main(int argc, char* argv[]) {
+   fon9::AutoPrintTestInfo utinfo{"RxCapture"};
+   // argv: [benchCount]
+   uint32_t benchCount = (argc > 1 ? fon9::StrTo(fon9::StrView_cstr(argv[1]), 0u) : 0u);
+   if (benchCount <= 0)
+      benchCount = 1000 * 1000;
+
+   TestWriteRead();
+   TestReopen();
+   TestPacer();
+
+   utinfo.PrintSplitter();
+   BenchCapture(benchCount);
+   RemoveCapFile();
+}
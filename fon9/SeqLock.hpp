@@ -0,0 +1,101 @@
+﻿/// \file fon9/SeqLock.hpp
+/// \author fonwinz@gmail.com
+#ifndef __fon9_SeqLock_hpp__
+#define __fon9_SeqLock_hpp__
+#include "fon9/sys/Config.hpp"
+
+fon9_BEFORE_INCLUDE_STD;
+#include <atomic>
+#include <thread>
+#include <cstring>
+#include <type_traits>
+fon9_AFTER_INCLUDE_STD;
+
+namespace fon9 {
+
+/// \ingroup Thrs
+/// 一般 CPU 的 cache line 大小.
+#define fon9_kCacheLineSize   64
+
+fon9_WARN_DISABLE_PADDING;
+/// \ingroup Thrs
+/// 使用 seqlock 保護的資料: 只能有一個寫入者, 可有多個讀取者, 讀取者不需要鎖定, 也不會阻擋寫入者.
+/// - 寫入: Seq_ 設為奇數 => 寫入資料 => Seq_ 設為偶數(+2).
+/// - 讀取: 讀取前後的 Seq_ 相同, 且為偶數, 才是一致的資料; 否則重讀.
+/// - 資料存放在 std::atomic<uint64_t> 陣列裡面(使用 relaxed 存取),
+///   所以讀取者與寫入者同時存取時, 不會有 C++ 記憶體模型的 data race.
+/// - 對齊 cache line, 避免與相鄰資料 false sharing;
+///   若使用 new 建立包含 SeqLocked 的物件, 則該物件需要自行提供對齊的 operator new(例: fmkt::SymbIn).
+/// - T 必須是 trivially copyable, 適用於: 一個 thread 更新行情, 多個 thread(策略、風控、推送...)讀取.
+template <class T>
+class alignas(fon9_kCacheLineSize) SeqLocked {
+   fon9_NON_COPY_NON_MOVE(SeqLocked);
+   static_assert(std::is_trivially_copyable<T>::value, "SeqLocked<T>: T must be trivially copyable.");
+   enum : size_t {
+      kWordCount = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t),
+   };
+   std::atomic<uint64_t>   Seq_{0};
+   std::atomic<uint64_t>   Words_[kWordCount];
+
+   void StoreWords(const T& value) {
+      const char* src = reinterpret_cast<const char*>(&value);
+      for (size_t L = 0; L < kWordCount; ++L) {
+         uint64_t word = 0;
+         memcpy(&word, src + L * sizeof(word), L + 1 < kWordCount ? sizeof(word) : sizeof(T) - L * sizeof(word));
+         this->Words_[L].store(word, std::memory_order_relaxed);
+      }
+   }
+
+public:
+   explicit SeqLocked(const T& value = T{}) {
+      this->StoreWords(value);
+   }
+
+   /// 寫入新的資料, 只能在單一 thread(寫入者)呼叫.
+   void Store(const T& value) {
+      const uint64_t seq = this->Seq_.load(std::memory_order_relaxed);
+      this->Seq_.store(seq + 1, std::memory_order_relaxed);
+      // 確保讀取者看到新資料之前, 必定能看到奇數的 Seq_.
+      std::atomic_thread_fence(std::memory_order_release);
+      this->StoreWords(value);
+      this->Seq_.store(seq + 2, std::memory_order_release);
+   }
+
+   /// 嘗試讀取一次, 可在任意 thread 呼叫.
+   /// \retval false 讀取過程中, 寫入者正在更新, out 的內容不一致, 應重讀.
+   bool TryLoad(T& out) const {
+      const uint64_t seq = this->Seq_.load(std::memory_order_acquire);
+      if (seq & 1)
+         return false;
+      uint64_t words[kWordCount];
+      for (size_t L = 0; L < kWordCount; ++L)
+         words[L] = this->Words_[L].load(std::memory_order_relaxed);
+      // 確保上面讀取資料, 在底下再次讀取 Seq_ 之前完成.
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (this->Seq_.load(std::memory_order_relaxed) != seq)
+         return false;
+      memcpy(&out, words, sizeof(T));
+      return true;
+   }
+   /// 讀取一致的資料, 可在任意 thread 呼叫.
+   /// 若正好遇到寫入者正在更新, 則讓出 CPU 後重讀(寫入者可能正好被切換出去).
+   void Load(T& out) const {
+      while (!this->TryLoad(out))
+         std::this_thread::yield();
+   }
+   T Load() const {
+      T out;
+      this->Load(out);
+      return out;
+   }
+
+   /// 更新次數 * 2, 若為奇數表示正在更新.
+   /// 讀取者可用來判斷資料是否有異動(例: 推送前判斷是否與上次相同).
+   uint64_t GetSeq() const {
+      return this->Seq_.load(std::memory_order_acquire);
+   }
+};
+fon9_WARN_POP;
+
+} // namespaces
+#endif//__fon9_SeqLock_hpp__
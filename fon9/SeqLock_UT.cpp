@@ -0,0 +1,213 @@
+﻿// \file fon9/SeqLock_UT.cpp
+// \author fonwinz@gmail.com
+#include "fon9/SeqLock.hpp"
+#include "fon9/fmkt/SymbIn.hpp"
+#include "fon9/MustLock.hpp"
+#include "fon9/ThreadTools.hpp"
+#include "fon9/StrTo.hpp"
+#include "fon9/TestTools.hpp"
+
+//--------------------------------------------------------------------------//
+
+/// SymbIn::Quote_ 必須對齊 cache line; PublishQuote() 之後, 可從 Quote_ 讀到相同的資料.
+void TestSymbInQuote() {
+   std::cout << "[TEST ] SymbIn.Quote";
+   fon9::fmkt::SymbSP   symb{new fon9::fmkt::SymbIn("2330")};
+   fon9::fmkt::SymbIn&  symi = *static_cast<fon9::fmkt::SymbIn*>(symb.get());
+   const uintptr_t      addr = reinterpret_cast<uintptr_t>(&symi.Quote_);
+   if (addr % fon9_kCacheLineSize != 0) {
+      std::cout << "|addr=" << addr << "|err=Quote_ not aligned" "\r[ERROR]" << std::endl;
+      abort();
+   }
+   symi.Ref_.Data_.PriRef_.Assign<2>(51200);
+   symi.Deal_.Data_.Deal_.Pri_.Assign<2>(51300);
+   symi.Deal_.Data_.Deal_.Qty_ = 3;
+   symi.Deal_.Data_.TotalQty_ = 1234;
+   symi.BS_.Data_.Sells_[4].Qty_ = 55;
+   symi.BS_.Data_.Buys_[4].Qty_ = 66;
+   const uint64_t seq = symi.Quote_.GetSeq();
+   symi.PublishQuote();
+   const fon9::fmkt::SymbInQuote quote = symi.Quote_.Load();
+   if (symi.Quote_.GetSeq() != seq + 2
+       || quote.Ref_.PriRef_ != symi.Ref_.Data_.PriRef_
+       || quote.Deal_.Deal_.Pri_ != symi.Deal_.Data_.Deal_.Pri_
+       || quote.Deal_.TotalQty_ != 1234
+       || quote.BS_.Sells_[4].Qty_ != 55
+       || quote.BS_.Buys_[4].Qty_ != 66) {
+      std::cout << "|err=Quote_ not match" "\r[ERROR]" << std::endl;
+      abort();
+   }
+   std::cout << "\r[OK   ]" << std::endl;
+}
+
+//--------------------------------------------------------------------------//
+
+/// 與 SymbInQuote 相同大小; 寫入者每次把全部的 word 都設為相同的值,
+/// 讀取者若讀到不同的 word, 表示讀到了不一致的資料.
+struct TestQuote {
+   uint64_t V_[sizeof(fon9::fmkt::SymbInQuote) / sizeof(uint64_t)];
+   void Set(uint64_t v) {
+      for (uint64_t& i : this->V_)
+         i = v;
+   }
+   bool IsConsistent() const {
+      for (uint64_t i : this->V_)
+         if (i != this->V_[0])
+            return false;
+      return true;
+   }
+};
+
+/// 1 個寫入者, readerCount 個讀取者, 同時存取 SeqLocked<TestQuote>.
+/// 寫入至少 writeCount 次, 且每個讀取者至少讀到 minReads 次.
+void TestConsistency(unsigned readerCount, uint64_t writeCount, uint64_t minReads) {
+   std::cout << "[TEST ] SeqLocked.Consistency|readers=" << readerCount << std::flush;
+   fon9::SeqLocked<TestQuote>  quote;
+   std::atomic<bool>           isWriting{true};
+   std::atomic<uint64_t>       errCount{0};
+   std::atomic<unsigned>       doneReaders{0};
+   std::vector<std::thread>    readers;
+   for (unsigned L = 0; L < readerCount; ++L) {
+      readers.emplace_back([&]() {
+         uint64_t  last = 0, count = 0;
+         TestQuote q;
+         while (isWriting.load(std::memory_order_relaxed)) {
+            quote.Load(q);
+            if (!q.IsConsistent() || q.V_[0] < last)
+               ++errCount;
+            last = q.V_[0];
+            if (++count == minReads)
+               ++doneReaders;
+         }
+      });
+   }
+   TestQuote q;
+   uint64_t  i = 0;
+   while (++i <= writeCount || doneReaders.load(std::memory_order_relaxed) < readerCount) {
+      q.Set(i);
+      quote.Store(q);
+   }
+   --i;
+   isWriting = false;
+   fon9::JoinThreads(readers);
+   std::cout << "|writes=" << i;
+   if (errCount != 0 || quote.Load().V_[0] != i || quote.GetSeq() != i * 2) {
+      std::cout << "|errCount=" << errCount.load() << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   std::cout << "\r[OK   ]" << std::endl;
+}
+
+//--------------------------------------------------------------------------//
+
+/// 比較用: 讀寫都使用 std::mutex 保護.
+struct MutexQuote {
+   fon9::MustLock<fon9::fmkt::SymbInQuote> Quote_;
+   void Store(const fon9::fmkt::SymbInQuote& q) {
+      *this->Quote_.Lock() = q;
+   }
+   bool TryLoad(fon9::fmkt::SymbInQuote& q) const {
+      q = *this->Quote_.ConstLock();
+      return true;
+   }
+};
+struct SeqLockedQuote {
+   fon9::SeqLocked<fon9::fmkt::SymbInQuote> Quote_;
+   void Store(const fon9::fmkt::SymbInQuote& q) {
+      this->Quote_.Store(q);
+   }
+   bool TryLoad(fon9::fmkt::SymbInQuote& q) const {
+      return this->Quote_.TryLoad(q);
+   }
+};
+
+/// 1 個寫入者, readerCount 個讀取者, 同時持續讀寫 ms 毫秒.
+/// - 共 symbCount 個商品, 寫入者依序更新每個商品(模擬行情解析), 讀取者從不同的商品開始依序讀取.
+/// - 讀取失敗時的處理與 SeqLocked::Load() 相同: 讓出 CPU 後重讀.
+/// - 列出: 寫入者每秒寫入次數, 讀取者每秒(全部)讀到一致資料的次數, 讀取者需要重讀的比例.
+static const unsigned kMaxBenchSymbCount = 1000;
+template <class QuoteT>
+void BenchContention(const char* name, unsigned symbCount, unsigned readerCount, unsigned ms) {
+   // 使用 static, 因為 C++11 的 new 無法保證對齊 cache line.
+   static QuoteT              quotes[kMaxBenchSymbCount];
+   if (symbCount > kMaxBenchSymbCount)
+      symbCount = kMaxBenchSymbCount;
+   std::atomic<bool>          isStarted{false};
+   std::atomic<bool>          isRunning{true};
+   std::atomic<uint64_t>      readCount{0};
+   std::atomic<uint64_t>      retryCount{0};
+   uint64_t                   writeCount = 0;
+   std::vector<std::thread>   thrs;
+   thrs.emplace_back([&]() {
+      fon9::fmkt::SymbInQuote q{};
+      unsigned                idx = 0;
+      while (!isStarted.load(std::memory_order_relaxed))
+         std::this_thread::yield();
+      while (isRunning.load(std::memory_order_relaxed)) {
+         q.Deal_.TotalQty_ = ++writeCount;
+         quotes[idx].Store(q);
+         if (++idx >= symbCount)
+            idx = 0;
+      }
+   });
+   for (unsigned L = 0; L < readerCount; ++L) {
+      thrs.emplace_back([&, L]() {
+         uint64_t                 count = 0, retry = 0;
+         unsigned                 idx = (symbCount / (readerCount + 1)) * (L + 1);
+         fon9::fmkt::SymbInQuote  q;
+         while (!isStarted.load(std::memory_order_relaxed))
+            std::this_thread::yield();
+         while (isRunning.load(std::memory_order_relaxed)) {
+            if (quotes[idx].TryLoad(q)) {
+               ++count;
+               if (++idx >= symbCount)
+                  idx = 0;
+            }
+            else {
+               ++retry;
+               std::this_thread::yield();
+            }
+         }
+         readCount += count;
+         retryCount += retry;
+      });
+   }
+   fon9::StopWatch stopWatch;
+   isStarted = true;
+   std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+   isRunning = false;
+   fon9::JoinThreads(thrs);
+   const double   span = stopWatch.StopTimer();
+   const uint64_t reads = readCount.load();
+   const uint64_t retries = retryCount.load();
+   printf("%s|symbs=%5u|readers=%u|writes/sec=%11.0f|reads/sec=%11.0f|retry=%7.3f%%\n",
+          name, symbCount, readerCount,
+          static_cast<double>(writeCount) / span,
+          static_cast<double>(reads) / span,
+          reads + retries ? 100.0 * static_cast<double>(retries) / static_cast<double>(reads + retries) : 0.0);
+}
+
+int main(int argc, char** argv) {
+   fon9::AutoPrintTestInfo utinfo{"SeqLock"};
+   // argv: [benchMilliseconds]
+   unsigned benchMS = (argc > 1 ? fon9::StrTo(fon9::StrView_cstr(argv[1]), 0u) : 0u);
+   if (benchMS <= 0)
+      benchMS = 500;
+
+   TestSymbInQuote();
+   TestConsistency(1, 100 * 1000, 10 * 1000);
+   TestConsistency(3, 100 * 1000, 10 * 1000);
+
+   utinfo.PrintSplitter();
+   std::cout << "sizeof(SymbInQuote)=" << sizeof(fon9::fmkt::SymbInQuote)
+      << "|sizeof(SeqLocked<SymbInQuote>)=" << sizeof(fon9::SeqLocked<fon9::fmkt::SymbInQuote>)
+      << "|hardware threads=" << std::thread::hardware_concurrency()
+      << "|ms=" << benchMS << std::endl;
+   // symbs=1: 全部的讀取者都集中在寫入者正在更新的商品, 為最差的情況.
+   for (unsigned symbCount : {1u, kMaxBenchSymbCount}) {
+      for (unsigned readerCount : {0u, 1u, 2u, 4u}) {
+         BenchContention<MutexQuote>("std::mutex", symbCount, readerCount, benchMS);
+         BenchContention<SeqLockedQuote>("SeqLocked ", symbCount, readerCount, benchMS);
+      }
+   }
+}
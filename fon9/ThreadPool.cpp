@@ -0,0 +1,183 @@
+﻿// \file fon9/ThreadPool.cpp
+// \author fonwinz@gmail.com
+#include "fon9/ThreadPool.hpp"
+#include "fon9/ThreadTools.hpp"
+#include "fon9/StrTo.hpp"
+#include "fon9/Log.hpp"
+#include "fon9/Outcome.hpp"
+
+namespace fon9 {
+
+ConfigParser::Result ThreadPoolArgs::OnTagValue(StrView tag, StrView& value) {
+   if (tag == "ThreadCount") {
+      const char* pvalbeg = value.begin();
+      if ((this->ThreadCount_ = StrTo(value, 0u)) <= 0) {
+         this->ThreadCount_ = 1;
+         value.SetBegin(pvalbeg);
+         return ConfigParser::Result::EValueTooSmall;
+      }
+   }
+   else if (tag == "Cpus") {
+      while (!value.empty()) {
+         StrView v1 = StrFetchTrim(value, ',');
+         if (v1.empty())
+            continue;
+         const char* pend;
+         int n = StrTo(v1, -1, &pend);
+         if (n < 0) {
+            value.SetBegin(v1.begin());
+            return ConfigParser::Result::EInvalidValue;
+         }
+         if (pend != v1.end()) {
+            value.SetBegin(pend);
+            return ConfigParser::Result::EInvalidValue;
+         }
+         this->CpuAffinity_.push_back(static_cast<uint32_t>(n));
+      }
+   }
+   else
+      return ConfigParser::Result::EUnknownTag;
+   return ConfigParser::Result::Success;
+}
+
+//--------------------------------------------------------------------------//
+
+/// 目前 thread 所屬的 ThreadPool 及 WorkQueue 的索引.
+/// 在 pool 的 thread 裡面加入的工作, 放到自己的 WorkQueue.
+static thread_local const ThreadPool*  tlsOwnerPool_;
+static thread_local uint32_t           tlsOwnerIndex_;
+
+static Result3 SetThisThreadCpuAffinity(int cpuId) {
+   if (cpuId < 0)
+      return Result3::kNoResult();
+#if defined(fon9_WINDOWS)
+   if (SetThreadAffinityMask(GetCurrentThread(), (static_cast<DWORD_PTR>(1) << cpuId)) == 0)
+      return GetSysErrC();
+#else
+   cpu_set_t cpuset;
+   CPU_ZERO(&cpuset);
+   CPU_SET(cpuId, &cpuset);
+   if (int iErr = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset))
+      return GetSysErrC(iErr);
+#endif
+   return Result3::kSuccess();
+}
+
+ThreadPool::~ThreadPool() {
+   this->WaitForEndNow();
+}
+
+void ThreadPool::StartThread(const ThreadPoolArgs& args, StrView thrName) {
+   assert(this->State_ == ThreadState::Idle && this->QueueCount_ == 0);
+   this->QueueCount_ = (args.ThreadCount_ <= 0 ? 1u : args.ThreadCount_);
+   this->Queues_.reset(new WorkQueue[this->QueueCount_]);
+   this->Threads_.reserve(this->QueueCount_);
+   this->State_ = ThreadState::ExecutingOrWaiting;
+   RevBufferFixedSize<1024> rbuf;
+   for (uint32_t id = 0; id < this->QueueCount_; ++id) {
+      rbuf.Rewind();
+      RevPrint(rbuf, thrName, '.', id + 1);
+      this->Threads_.emplace_back(&ThreadPool::ThrRun, this, rbuf.ToStrT<std::string>(), id, args.GetCpuAffinity(id));
+   }
+}
+
+void ThreadPool::NotifyForEnd(ThreadState st) {
+   assert(st == ThreadState::EndNow || st == ThreadState::EndAfterWorkDone);
+   ThreadState expected = ThreadState::ExecutingOrWaiting;
+   this->State_.compare_exchange_strong(expected, st);
+   std::lock_guard<std::mutex> lk{this->SleepMutex_};
+   this->SleepCV_.notify_all();
+}
+void ThreadPool::WaitForEnd(ThreadState st) {
+   this->NotifyForEnd(st);
+   JoinThreads(this->Threads_);
+   if (!this->Threads_.empty())
+      this->State_ = ThreadState::Terminated;
+}
+
+uint32_t ThreadPool::SelectQueue() {
+   if (tlsOwnerPool_ == this)
+      return tlsOwnerIndex_;
+   return this->NextQueue_.fetch_add(1, std::memory_order_relaxed) % this->QueueCount_;
+}
+
+ThreadState ThreadPool::AddTask(ThreadTask&& task) {
+   const ThreadState st = this->State_.load(std::memory_order_acquire);
+   if (st != ThreadState::ExecutingOrWaiting)
+      return st;
+   WorkQueue& qu = this->Queues_[this->SelectQueue()];
+   // 必須在放入 qu.Tasks_ 之前增加 PendingCount_, 避免 thread 取出後 PendingCount_ 變成負數.
+   ++this->PendingCount_;
+   {
+      std::lock_guard<std::mutex> lk{qu.Mutex_};
+      qu.Tasks_.emplace_back(std::move(task));
+   }
+   // thread 在睡眠前, 會先增加 SleepingCount_ 然後檢查 PendingCount_(都在 SleepMutex_ 保護下);
+   // 所以這裡若看到 SleepingCount_ == 0, 則 thread 必定能看到增加後的 PendingCount_, 不會遺失喚醒.
+   if (this->SleepingCount_.load() > 0) {
+      std::lock_guard<std::mutex> lk{this->SleepMutex_};
+      this->SleepCV_.notify_one();
+   }
+   return st;
+}
+
+bool ThreadPool::PopTask(uint32_t index, ThreadTask& task, uint64_t& stealCount) {
+   for (uint32_t L = 0; L < this->QueueCount_; ++L) {
+      WorkQueue& qu = this->Queues_[(index + L) % this->QueueCount_];
+      std::unique_lock<std::mutex> lk{qu.Mutex_, std::defer_lock};
+      // 偷別人的工作時, 若該佇列正在使用中, 則先跳過; 若因此沒取到工作, 在 ThrRun() 會因 PendingCount_ > 0 而重試.
+      if (L == 0)
+         lk.lock();
+      else if (!lk.try_lock())
+         continue;
+      if (!qu.Tasks_.empty()) {
+         task = std::move(qu.Tasks_.front());
+         qu.Tasks_.pop_front();
+         if (L != 0)
+            ++stealCount;
+         return true;
+      }
+   }
+   return false;
+}
+
+void ThreadPool::ThrRun(std::string thrName, uint32_t index, int cpuId) {
+   tlsOwnerPool_ = this;
+   tlsOwnerIndex_ = index;
+   if (gWaitLogSystemReady)
+      gWaitLogSystemReady();
+   Result3 cpuAffinityResult = SetThisThreadCpuAffinity(cpuId);
+   fon9_LOG_ThrRun("ThreadPool.ThrRun|name=", thrName, "|Cpu=", cpuId, ':', cpuAffinityResult);
+
+   uint64_t    execCount = 0;
+   uint64_t    stealCount = 0;
+   ThreadTask  task;
+   for (;;) {
+      if (this->PopTask(index, task, stealCount)) {
+         --this->PendingCount_;
+         task();
+         task.Reset();
+         ++execCount;
+         continue;
+      }
+      const ThreadState st = this->State_.load(std::memory_order_acquire);
+      if (st >= ThreadState::EndNow)
+         break;
+      if (this->PendingCount_.load() > 0) {
+         // 有工作正在加入(尚未放入 WorkQueue), 或正在被其他 thread 取出.
+         std::this_thread::yield();
+         continue;
+      }
+      if (st == ThreadState::EndAfterWorkDone)
+         break;
+      std::unique_lock<std::mutex> lk{this->SleepMutex_};
+      ++this->SleepingCount_;
+      while (this->PendingCount_.load() == 0 && this->State_.load() == ThreadState::ExecutingOrWaiting)
+         this->SleepCV_.wait(lk);
+      --this->SleepingCount_;
+   }
+   tlsOwnerPool_ = nullptr;
+   fon9_LOG_ThrRun("ThreadPool.ThrRun.End|name=", thrName, "|exec=", execCount, "|steal=", stealCount);
+}
+
+} // namespaces
@@ -0,0 +1,243 @@
+﻿/// \file fon9/ThreadPool.hpp
+/// \author fonwinz@gmail.com
+#ifndef __fon9_ThreadPool_hpp__
+#define __fon9_ThreadPool_hpp__
+#include "fon9/ThreadController.hpp"
+#include "fon9/ConfigParser.hpp"
+
+fon9_BEFORE_INCLUDE_STD;
+#include <deque>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <condition_variable>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+fon9_AFTER_INCLUDE_STD;
+
+namespace fon9 {
+
+/// \ingroup Thrs
+/// 在 ThreadPool 裡面執行的單一作業: `void operator()();`
+/// - 類似 std::function<void()>, 但只能 move, 不能 copy.
+/// - 若 callable 物件夠小(例: 只捕捉 1~2 個 intrusive_ptr 的 lambda), 則直接放在 ThreadTask 內部, 不用配置記憶體.
+/// - 太大的(或 move 建構可能拋出例外的) callable 物件, 才會使用 new 配置.
+class ThreadTask {
+   enum class Op {
+      Invoke,
+      MoveTo,
+      Destroy,
+   };
+   using Handler = void (*)(Op op, ThreadTask& self, ThreadTask* dst);
+   using Storage = std::aligned_storage<sizeof(void*) * 6, alignof(std::max_align_t)>::type;
+   Storage  Storage_;
+   Handler  Handler_{nullptr};
+
+   template <class FnT>
+   using IsInplace = std::integral_constant<bool,
+      sizeof(FnT) <= sizeof(Storage)
+      && alignof(Storage) % alignof(FnT) == 0
+      && std::is_nothrow_move_constructible<FnT>::value>;
+
+   template <class FnT>
+   static void InplaceHandler(Op op, ThreadTask& self, ThreadTask* dst) {
+      FnT* fn = reinterpret_cast<FnT*>(&self.Storage_);
+      switch (op) {
+      case Op::Invoke:
+         (*fn)();
+         break;
+      case Op::MoveTo:
+         new (&dst->Storage_) FnT(std::move(*fn));
+         fn->~FnT();
+         break;
+      case Op::Destroy:
+         fn->~FnT();
+         break;
+      }
+   }
+   template <class FnT>
+   static void HeapHandler(Op op, ThreadTask& self, ThreadTask* dst) {
+      FnT* fn = *reinterpret_cast<FnT**>(&self.Storage_);
+      switch (op) {
+      case Op::Invoke:
+         (*fn)();
+         break;
+      case Op::MoveTo:
+         *reinterpret_cast<FnT**>(&dst->Storage_) = fn;
+         break;
+      case Op::Destroy:
+         delete fn;
+         break;
+      }
+   }
+
+   template <class FnT, class SrcT>
+   void Construct(SrcT&& src, std::true_type /*isInplace*/) {
+      new (&this->Storage_) FnT(std::forward<SrcT>(src));
+      this->Handler_ = &InplaceHandler<FnT>;
+   }
+   template <class FnT, class SrcT>
+   void Construct(SrcT&& src, std::false_type /*isInplace*/) {
+      *reinterpret_cast<FnT**>(&this->Storage_) = new FnT(std::forward<SrcT>(src));
+      this->Handler_ = &HeapHandler<FnT>;
+   }
+   void MoveFrom(ThreadTask& rhs) {
+      if ((this->Handler_ = rhs.Handler_) != nullptr) {
+         rhs.Handler_(Op::MoveTo, rhs, this);
+         rhs.Handler_ = nullptr;
+      }
+   }
+
+public:
+   ThreadTask() = default;
+   ~ThreadTask() {
+      this->Reset();
+   }
+
+   template <class FnT,
+      class Fn = typename std::decay<FnT>::type,
+      class = typename std::enable_if<!std::is_same<Fn, ThreadTask>::value>::type>
+   ThreadTask(FnT&& fn) {
+      this->Construct<Fn>(std::forward<FnT>(fn), IsInplace<Fn>{});
+   }
+
+   ThreadTask(ThreadTask&& rhs) {
+      this->MoveFrom(rhs);
+   }
+   ThreadTask& operator=(ThreadTask&& rhs) {
+      if (this != &rhs) {
+         this->Reset();
+         this->MoveFrom(rhs);
+      }
+      return *this;
+   }
+   ThreadTask(const ThreadTask&) = delete;
+   ThreadTask& operator=(const ThreadTask&) = delete;
+
+   void Reset() {
+      if (this->Handler_) {
+         this->Handler_(Op::Destroy, *this, nullptr);
+         this->Handler_ = nullptr;
+      }
+   }
+   explicit operator bool() const {
+      return this->Handler_ != nullptr;
+   }
+   void operator()() {
+      assert(this->Handler_ != nullptr);
+      this->Handler_(Op::Invoke, *this, nullptr);
+   }
+
+   /// 測試用: 此 callable 型別是否會直接放在 ThreadTask 內部(不需要配置記憶體)?
+   template <class FnT>
+   static constexpr bool IsInplaceFn() {
+      return IsInplace<typename std::decay<FnT>::type>::value;
+   }
+};
+
+/// \ingroup Thrs
+/// ThreadPool 啟動參數.
+/// args: "ThreadCount=n|Cpus=List"
+struct fon9_API ThreadPoolArgs {
+   /// 若有設定 CpuAffinity, 則每個 thread 會綁定一個固定的 cpu.
+   /// 例如: ThreadCount_=3; CpuAffinity=0,1;
+   ///       則 Thr0=Cpu0; Thr1=Cpu1; Thr2=Cpu0;
+   using CpuAffinity = std::vector<uint32_t>;
+   CpuAffinity CpuAffinity_;
+   uint32_t    ThreadCount_{4};
+
+   ThreadPoolArgs() = default;
+
+   int GetCpuAffinity(size_t threadIndex) const {
+      if (CpuAffinity_.empty())
+         return -1;
+      return static_cast<int>(CpuAffinity_[threadIndex % CpuAffinity_.size()]);
+   }
+
+   /// 用 tag, value 設定參數.
+   /// tag         | value
+   /// ------------|------------------------------
+   /// ThreadCount | > 0
+   /// Cpus        | c0, c1, c2 ... 根據 thread index 依序選擇 c0 或 c1 或 c2...
+   ConfigParser::Result OnTagValue(StrView tag, StrView& value);
+};
+
+fon9_WARN_DISABLE_PADDING;
+/// \ingroup Thrs
+/// 使用 work stealing 的 thread pool.
+/// - 每個 thread 有自己的工作佇列(及自己的 mutex):
+///   - 在 pool 之外加入的工作, 依序(round robin)分配到各個佇列;
+///   - 在 pool 的 thread 裡面加入的工作, 放到該 thread 自己的佇列;
+///   - thread 先處理自己佇列的工作, 若自己的佇列為空, 則到其他 thread 的佇列「偷」工作來做.
+///   - 因此加入工作時, 不會全部的 thread 爭奪同一個 mutex.
+/// - 只有在有 thread 睡眠時, 加入工作才需要喚醒(notify), 忙碌時不會有 condition variable 的負擔.
+/// - 不保證工作的執行順序.
+class fon9_API ThreadPool {
+   fon9_NON_COPY_NON_MOVE(ThreadPool);
+   struct WorkQueue {
+      /// 避免相鄰的 WorkQueue(及 Queues_ 之前的 heap 資料) 與 Mutex_, Tasks_ 在同一個 cache line.
+      /// 放在欄位之前: C++11 的 new WorkQueue[] 不保證 alignas(64), 所以不使用 alignas.
+      char                    Padding_[64];
+      std::mutex              Mutex_;
+      std::deque<ThreadTask>  Tasks_;
+   };
+   std::unique_ptr<WorkQueue[]>  Queues_;
+   uint32_t                      QueueCount_{0};
+   std::atomic<uint32_t>         NextQueue_{0};
+   std::atomic<ThreadState>      State_{ThreadState::Idle};
+   /// 已加入, 但尚未取出的工作數量.
+   std::atomic<size_t>           PendingCount_{0};
+   std::atomic<uint32_t>         SleepingCount_{0};
+   std::mutex                    SleepMutex_;
+   std::condition_variable       SleepCV_;
+   std::vector<std::thread>      Threads_;
+
+   uint32_t SelectQueue();
+   bool PopTask(uint32_t index, ThreadTask& task, uint64_t& stealCount);
+   void ThrRun(std::string thrName, uint32_t index, int cpuId);
+   void NotifyForEnd(ThreadState st);
+   void WaitForEnd(ThreadState st);
+
+public:
+   ThreadPool() = default;
+   /// 若有剩餘未執行的工作，將會被拋棄。
+   ~ThreadPool();
+
+   /// 只能呼叫一次, 必須在 StartThread() 之後, 才能加入工作.
+   void StartThread(const ThreadPoolArgs& args, StrView thrName);
+   size_t GetThreadCount() const {
+      return this->Threads_.size();
+   }
+
+   /// 通知結束，剩餘未執行的工作將被拋棄.
+   void NotifyForEndNow() {
+      this->NotifyForEnd(ThreadState::EndNow);
+   }
+   /// 通知結束, 並在 thread 結束後返回, 不處理剩餘工作.
+   void WaitForEndNow() {
+      this->WaitForEnd(ThreadState::EndNow);
+   }
+   /// 通知工作處理完畢後結束 thread.
+   void NotifyForEndAfterWorkDone() {
+      this->NotifyForEnd(ThreadState::EndAfterWorkDone);
+   }
+   /// 等候 thread 處理完工作後, 結束 thread.
+   void WaitForEndAfterWorkDone() {
+      this->WaitForEnd(ThreadState::EndAfterWorkDone);
+   }
+
+   /// 傳回 ThreadState::ExecutingOrWaiting 表示有加入 ThreadPool.
+   ThreadState AddTask(ThreadTask&& task);
+
+   /// 與 MessageQueue::EmplaceMessage() 的用法相同, 但只接受一個 callable 參數.
+   /// 傳回 ThreadState::ExecutingOrWaiting 表示有加入 ThreadPool.
+   template <class FnT>
+   ThreadState EmplaceMessage(FnT&& fn) {
+      return this->AddTask(ThreadTask{std::forward<FnT>(fn)});
+   }
+};
+fon9_WARN_POP;
+
+} // namespaces
+#endif//__fon9_ThreadPool_hpp__
@@ -0,0 +1,197 @@
+﻿// \file fon9/ThreadPool_UT.cpp
+// \author fonwinz@gmail.com
+#include "fon9/ThreadPool.hpp"
+#include "fon9/MessageQueue.hpp"
+#include "fon9/StrTo.hpp"
+#include "fon9/TestTools.hpp"
+#include <functional>
+
+//--------------------------------------------------------------------------//
+
+static std::atomic<int> gFnAlive{0};
+struct TestFn {
+   int64_t* Dst_;
+   int64_t  Value_;
+   TestFn(int64_t* dst, int64_t v) : Dst_{dst}, Value_{v} {
+      ++gFnAlive;
+   }
+   TestFn(const TestFn& rhs) : Dst_{rhs.Dst_}, Value_{rhs.Value_} {
+      ++gFnAlive;
+   }
+   TestFn(TestFn&& rhs) noexcept : Dst_{rhs.Dst_}, Value_{rhs.Value_} {
+      ++gFnAlive;
+   }
+   ~TestFn() {
+      --gFnAlive;
+   }
+   void operator()() {
+      *this->Dst_ += this->Value_;
+   }
+};
+struct BigTestFn : public TestFn {
+   char  Padding_[128]{};
+   using TestFn::TestFn;
+};
+
+template <class FnT>
+void TestThreadTask(const char* fnName, bool isInplace) {
+   std::cout << "[TEST ] ThreadTask(" << fnName << ")";
+   if (fon9::ThreadTask::IsInplaceFn<FnT>() != isInplace) {
+      std::cout << "|IsInplace=" << !isInplace << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   int64_t dst = 0;
+   {
+      fon9::ThreadTask task1{FnT{&dst, 1}};
+      fon9::ThreadTask task2{std::move(task1)};
+      if (task1 || !task2) {
+         std::cout << "|move ctor\r[ERROR]" << std::endl;
+         abort();
+      }
+      task2();
+      fon9::ThreadTask task3{FnT{&dst, 10}};
+      task3 = std::move(task2);
+      task3();
+      task1 = FnT{&dst, 100};
+      task1();
+      if (gFnAlive != 2) {
+         std::cout << "|alive=" << gFnAlive << "|expect=2\r[ERROR]" << std::endl;
+         abort();
+      }
+   }
+   if (dst != 102 || gFnAlive != 0) {
+      std::cout << "|dst=" << dst << "|alive=" << gFnAlive << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   std::cout << "|IsInplace=" << isInplace << "\r[OK   ]" << std::endl;
+}
+
+//--------------------------------------------------------------------------//
+
+/// 原本的 DefaultThreadPool: 全部的 thread 共用一個 mutex + condition_variable, 每個工作都是一個 std::function.
+struct LegacyTaskHandler;
+using LegacyThreadPool = fon9::MessageQueue<LegacyTaskHandler, std::function<void()>>;
+struct LegacyTaskHandler {
+   using MessageType = std::function<void()>;
+   LegacyTaskHandler(LegacyThreadPool&) {
+   }
+   void OnMessage(MessageType& task) {
+      task();
+   }
+   void OnThreadEnd(const std::string& threadName) {
+      (void)threadName;
+   }
+};
+
+static const unsigned   kPoolThreadCount = 4;
+
+template <class PoolT>
+void StartPool(PoolT& pool, const char* name);
+
+template <>
+void StartPool(LegacyThreadPool& pool, const char* name) {
+   pool.StartThread(kPoolThreadCount, fon9::StrView_cstr(name));
+}
+template <>
+void StartPool(fon9::ThreadPool& pool, const char* name) {
+   fon9::ThreadPoolArgs args;
+   args.ThreadCount_ = kPoolThreadCount;
+   pool.StartThread(args, fon9::StrView_cstr(name));
+}
+
+/// 使用 posterCount 個 threads, 共加入 taskCount 個工作, 計算從開始加入到全部執行完畢的時間.
+/// 每個工作捕捉 2 個指標(類似 Device::MakeCallForWork() 捕捉一個 intrusive_ptr), 所以 ThreadTask 不用配置記憶體.
+template <class PoolT>
+void BenchPool(const char* poolName, unsigned posterCount, uint64_t taskCount) {
+   PoolT pool;
+   StartPool(pool, poolName);
+   std::atomic<uint64_t>   execCount{0};
+   std::atomic<uint64_t>   execSum{0};
+   const uint64_t          countPerPoster = taskCount / posterCount;
+   taskCount = countPerPoster * posterCount;
+
+   fon9::StopWatch          stopWatch;
+   std::vector<std::thread> posters;
+   for (unsigned L = 0; L < posterCount; ++L) {
+      posters.emplace_back([&pool, &execCount, &execSum, countPerPoster]() {
+         for (uint64_t i = 0; i < countPerPoster; ++i) {
+            std::atomic<uint64_t>* pCount = &execCount;
+            std::atomic<uint64_t>* pSum = &execSum;
+            pool.EmplaceMessage([pCount, pSum, i]() {
+               pSum->fetch_add(i, std::memory_order_relaxed);
+               pCount->fetch_add(1, std::memory_order_relaxed);
+            });
+         }
+      });
+   }
+   fon9::JoinThreads(posters);
+   while (execCount.load() < taskCount)
+      std::this_thread::yield();
+   const double span = stopWatch.StopTimer();
+   pool.WaitForEndAfterWorkDone();
+
+   char msg[128];
+   snprintf(msg, sizeof(msg), "%s|posters=%2u", poolName, posterCount);
+   fon9::StopWatch::PrintResultNoEOL(span, msg, taskCount)
+      << "|tasks/sec=" << static_cast<uint64_t>(static_cast<double>(taskCount) / span) << std::endl;
+   if (execSum.load() != (countPerPoster * (countPerPoster - 1) / 2) * posterCount) {
+      std::cout << "[ERROR] execSum=" << execSum.load() << std::endl;
+      abort();
+   }
+}
+
+//--------------------------------------------------------------------------//
+
+/// 在 pool thread 裡面加入的工作, 會放到自己的佇列, 由其他 thread 偷走執行.
+void TestNestedTasks() {
+   std::cout << "[TEST ] ThreadPool.NestedTasks";
+   fon9::ThreadPool pool;
+   fon9::ThreadPoolArgs args;
+   args.ThreadCount_ = kPoolThreadCount;
+   pool.StartThread(args, "Nested");
+   static const unsigned   kFanOut = 100;
+   std::atomic<unsigned>   execCount{0};
+   for (unsigned L = 0; L < kFanOut; ++L) {
+      pool.EmplaceMessage([&pool, &execCount]() {
+         for (unsigned i = 0; i < kFanOut; ++i) {
+            pool.EmplaceMessage([&execCount]() {
+               ++execCount;
+            });
+         }
+         ++execCount;
+      });
+   }
+   while (execCount.load() < kFanOut * (kFanOut + 1))
+      std::this_thread::yield();
+   pool.WaitForEndAfterWorkDone();
+   if (execCount != kFanOut * (kFanOut + 1)) {
+      std::cout << "|execCount=" << execCount << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   if (pool.EmplaceMessage([]() {}) == fon9::ThreadState::ExecutingOrWaiting) {
+      std::cout << "|EmplaceMessage() after end.\r[ERROR]" << std::endl;
+      abort();
+   }
+   std::cout << "\r[OK   ]" << std::endl;
+}
+
+//--------------------------------------------------------------------------//
+
+int main(int argc, char** argv) {
+   fon9::AutoPrintTestInfo utinfo{"ThreadPool"};
+   // argv: [taskCount]
+   uint64_t taskCount = (argc > 1 ? fon9::StrTo(fon9::StrView_cstr(argv[1]), 0u) : 0u);
+   if (taskCount <= 0)
+      taskCount = 1000 * 1000;
+
+   TestThreadTask<TestFn>("small", true);
+   TestThreadTask<BigTestFn>("big", false);
+   TestNestedTasks();
+
+   utinfo.PrintSplitter();
+   std::cout << "poolThreads=" << kPoolThreadCount << "|tasks=" << taskCount << std::endl;
+   for (unsigned posterCount : {1u, 4u, 16u}) {
+      BenchPool<LegacyThreadPool>("MessageQueue", posterCount, taskCount);
+      BenchPool<fon9::ThreadPool>("ThreadPool  ", posterCount, taskCount);
+   }
+}
@@ -17,6 +17,16 @@ TimerThread& GetDefaultTimerThread() {
    static DefaultTimerThread TimerThread_;
    return TimerThread_;
 }
+TimerThread& GetDefaultWheelTimerThread() {
+   struct DefaultWheelTimerThread : public TimerThread, sys::OnWindowsMainExitHandle {
+      fon9_NON_COPY_NON_MOVE(DefaultWheelTimerThread);
+      DefaultWheelTimerThread() : TimerThread{"Default.WheelTimer", TimeInterval_Millisecond(1)} {}
+      void OnWindowsMainExit_Notify() { this->NotifyForEndNow(); }
+      void OnWindowsMainExit_ThreadJoin() { this->WaitForEndNow(); }
+   };
+   static DefaultWheelTimerThread TimerThread_;
+   return TimerThread_;
+}
 
 //--------------------------------------------------------------------------//
 
@@ -26,7 +36,7 @@ void TimerEntry::DisposeAndWait() {
    for (;;) {
       TimerThread::Locker   timerThread{this->TimerThread_.TimerController_};
       if (IsTimerWaitInLine(this->Key_.SeqNo_)) {
-         timerThread->Erase(this->Key_);
+         timerThread->Erase(*this);
          this->Key_.SeqNo_ = TimerSeqNo::Disposed;
          this->Key_.EmitTime_.AssignNull();
       }
@@ -39,7 +49,7 @@ void TimerEntry::StopAndWait() {
       TimerThread::Locker   timerThread{this->TimerThread_.TimerController_};
       if (this->Key_.SeqNo_ == TimerSeqNo::Disposed)
          break;
-      timerThread->Erase(this->Key_);
+      timerThread->Erase(*this);
       this->Key_.SeqNo_ = TimerSeqNo::NoWaiting;
       this->Key_.EmitTime_.AssignNull();
       if (!this->TimerThread_.CheckCurrEmit(timerThread, *this))
@@ -49,13 +59,13 @@ void TimerEntry::StopAndWait() {
 void TimerEntry::DisposeNoWait() {
    TimerThread::Locker   timerThread{this->TimerThread_.TimerController_};
    if (IsTimerWaitInLine(this->Key_.SeqNo_))
-      timerThread->Erase(this->Key_);
+      timerThread->Erase(*this);
    this->Key_.SeqNo_ = TimerSeqNo::Disposed;
 }
 void TimerEntry::StopNoWait() {
    TimerThread::Locker   timerThread{this->TimerThread_.TimerController_};
    if (IsTimerWaitInLine(this->Key_.SeqNo_)) {
-      timerThread->Erase(this->Key_);
+      timerThread->Erase(*this);
       this->Key_.SeqNo_ = TimerSeqNo::NoWaiting;
    }
 }
@@ -64,7 +74,7 @@ void TimerEntry::SetupRun(TimeStamp atTimePoint, const TimeInterval* after) {
    if (this->Key_.SeqNo_ == TimerSeqNo::Disposed)
       return;
    if (IsTimerWaitInLine(this->Key_.SeqNo_))
-      timerThread->Erase(this->Key_);
+      timerThread->Erase(*this);
 
    this->Key_.EmitTime_ = atTimePoint;
    timerThread->LastSeqNo_ = static_cast<TimerSeqNo>(static_cast<underlying_type_t<TimerSeqNo>>(timerThread->LastSeqNo_) + 1);
@@ -72,6 +82,15 @@ void TimerEntry::SetupRun(TimeStamp atTimePoint, const TimeInterval* after) {
       timerThread->LastSeqNo_ = TimerSeqNo::WaitInLine;
    this->Key_.SeqNo_ = timerThread->LastSeqNo_;
 
+   if (timerThread->Wheel_.IsEnabled()) {
+      timerThread->Wheel_.Insert(*this);
+      // 若 TimerThread 正在處理, 則 WheelWakeTick_ == 0, 返回後會重新計算等候時間, 不用通知.
+      if (fon9_LIKELY(this->WheelTick_ >= timerThread->WheelWakeTick_))
+         return;
+      timerThread->WheelWakeTick_ = this->WheelTick_;
+      this->TimerThread_.TimerController_.NotifyOne(timerThread);
+      return;
+   }
    auto ifind = timerThread->Timers_.insert(TimerThread::TimerThreadData::Timers::value_type{this->Key_, this->shared_from_this()}).first;
    if (fon9_LIKELY(ifind != timerThread->Timers_.end() - 1))
       return;
@@ -107,6 +126,15 @@ TimerThread::TimerThread(std::string timerName) {
    this->TimerController_.OnBeforeThreadStart(1);
    this->Thread_ = std::thread(&TimerThread::ThrRun, this, std::move(timerName));
 }
+TimerThread::TimerThread(std::string timerName, TimeInterval wheelTick) {
+   {
+      Locker timerThread{this->TimerController_};
+      timerThread->Wheel_.TickUs_ = (wheelTick.GetOrigValue() > 0 ? wheelTick.GetOrigValue() : 1);
+      timerThread->Wheel_.BaseTime_ = UtcNow();
+   }
+   this->TimerController_.OnBeforeThreadStart(1);
+   this->Thread_ = std::thread(&TimerThread::ThrRun, this, std::move(timerName));
+}
 TimerThread::~TimerThread() {
    this->WaitForEndNow();
 }
@@ -124,6 +152,8 @@ bool TimerThread::CheckCurrEmit(Locker& timerThread, TimerEntry& timer) {
 }
 
 bool TimerThread::RunTimer(Locker& timerThread) {
+   if (timerThread->Wheel_.IsEnabled())
+      return this->RunWheel(timerThread);
    while (this->TimerController_.GetState(timerThread) == ThreadState::ExecutingOrWaiting) {
       if (timerThread->Timers_.empty()) {
          timerThread->CvWaitSecs_ = TimeInterval_Second(-1);
@@ -148,6 +178,41 @@ bool TimerThread::RunTimer(Locker& timerThread) {
    }
    return false;
 }
+bool TimerThread::RunWheel(Locker& timerThread) {
+   Wheel&   wheel = timerThread->Wheel_;
+   timerThread->WheelWakeTick_ = 0;
+   while (this->TimerController_.GetState(timerThread) == ThreadState::ExecutingOrWaiting) {
+      TimeStamp   now = UtcNow();
+      TimerEntry* timer = wheel.PopDue();
+      if (timer == nullptr) {
+         wheel.Advance(now);
+         if ((timer = wheel.PopDue()) == nullptr) {
+            const uint64_t next = wheel.NextEventTick();
+            timerThread->WheelWakeTick_ = next;
+            if (next == UINT64_MAX) {
+               timerThread->CvWaitSecs_ = TimeInterval_Second(-1);
+               return true;
+            }
+            TimeInterval ti = wheel.ToTime(next) - now;
+            if (ti.GetOrigValue() <= 0) {
+               timerThread->WheelWakeTick_ = 0;
+               continue;
+            }
+            timerThread->CvWaitSecs_ = ti;
+            return true;
+         }
+      }
+      timer->Key_.SeqNo_ = TimerSeqNo::NoWaiting;
+      timerThread->CurrEntry_ = timer;
+      timerThread.unlock();
+      // callback in unlock...
+      // timer 從 wheel 取出時, 已擁有 ref count, 在 EmitOnTimer() 裡面 intrusive_ptr_release(timer);
+      timer->EmitOnTimer(now);
+      timerThread.lock();
+      timerThread->CurrEntry_ = nullptr;
+   }
+   return false;
+}
 void TimerThread::ThrRun(std::string timerName) {
    if (gWaitLogSystemReady)
       gWaitLogSystemReady();
@@ -165,4 +230,148 @@ void TimerThread::ThrRun(std::string timerName) {
    fon9_LOG_ThrRun("TimerThread.ThrRun.End|name=", timerName);
 }
 
+//--------------------------------------------------------------------------//
+
+TimerThread::Wheel::~Wheel() {
+   while (TimerEntry* entry = this->PopDue())
+      intrusive_ptr_release(entry);
+   for (auto& level : this->Slots_) {
+      for (TimerEntry*& head : level) {
+         while (head)
+            this->Remove(*head);
+      }
+   }
+   while (this->Overflow_)
+      this->Remove(*this->Overflow_);
+}
+uint64_t TimerThread::Wheel::ToEmitTick(TimeStamp tm) const {
+   const TimeInterval::OrigType us = (tm - this->BaseTime_).GetOrigValue();
+   if (us <= 0)
+      return 0;
+   return static_cast<uint64_t>(us / this->TickUs_ + (us % this->TickUs_ != 0));
+}
+void TimerThread::Wheel::Insert(TimerEntry& entry) {
+   intrusive_ptr_add_ref(&entry);
+   entry.WheelTick_ = this->ToEmitTick(entry.Key_.EmitTime_);
+   if (entry.WheelTick_ <= this->CurTick_)
+      this->PushDue(entry);
+   else
+      this->Place(entry);
+}
+void TimerThread::Wheel::Remove(TimerEntry& entry) {
+   assert(entry.WheelPPrev_ != nullptr);
+   if (this->DueTail_ == &entry.WheelNext_)
+      this->DueTail_ = entry.WheelPPrev_;
+   if ((*entry.WheelPPrev_ = entry.WheelNext_) != nullptr)
+      entry.WheelNext_->WheelPPrev_ = entry.WheelPPrev_;
+   entry.WheelNext_ = nullptr;
+   entry.WheelPPrev_ = nullptr;
+   intrusive_ptr_release(&entry);
+}
+void TimerThread::Wheel::Place(TimerEntry& entry) {
+   assert(entry.WheelTick_ > this->CurTick_);
+   const uint64_t diff = entry.WheelTick_ ^ this->CurTick_;
+   unsigned       level = 0;
+   while (level < kLevels && (diff >> (kSlotBits * (level + 1))) != 0)
+      ++level;
+   TimerEntry*& head = (level < kLevels
+                        ? this->Slots_[level][(entry.WheelTick_ >> (kSlotBits * level)) & (kSlots - 1)]
+                        : this->Overflow_);
+   if ((entry.WheelNext_ = head) != nullptr)
+      head->WheelPPrev_ = &entry.WheelNext_;
+   entry.WheelPPrev_ = &head;
+   head = &entry;
+}
+void TimerThread::Wheel::PushDue(TimerEntry& entry) {
+   entry.WheelNext_ = nullptr;
+   entry.WheelPPrev_ = this->DueTail_;
+   *this->DueTail_ = &entry;
+   this->DueTail_ = &entry.WheelNext_;
+}
+TimerEntry* TimerThread::Wheel::PopDue() {
+   TimerEntry* entry = this->Due_;
+   if (entry == nullptr)
+      return nullptr;
+   if ((this->Due_ = entry->WheelNext_) != nullptr)
+      this->Due_->WheelPPrev_ = &this->Due_;
+   else
+      this->DueTail_ = &this->Due_;
+   entry->WheelNext_ = nullptr;
+   entry->WheelPPrev_ = nullptr;
+   return entry;
+}
+uint64_t TimerThread::Wheel::NextEventTick() const {
+   uint64_t res = UINT64_MAX;
+   // 第 L 層: slot 位置 > CurTick_ 在該層的位置, 才可能有 entry;
+   // 在 (CurTick_ 較高層的位置 + slot 在第 L 層的位置) 時, 需要處理(到期 or cascade).
+   for (unsigned level = 0; level < kLevels; ++level) {
+      const unsigned shift = kSlotBits * level;
+      const uint64_t curIdx = (this->CurTick_ >> shift) & (kSlots - 1);
+      for (uint64_t idx = curIdx + 1; idx < kSlots; ++idx) {
+         if (this->Slots_[level][idx]) {
+            const uint64_t tick = ((this->CurTick_ >> (shift + kSlotBits)) << (shift + kSlotBits)) | (idx << shift);
+            if (tick < res)
+               res = tick;
+            break;
+         }
+      }
+   }
+   if (this->Overflow_) {
+      const unsigned shift = kSlotBits * kLevels;
+      const uint64_t tick = ((this->CurTick_ >> shift) + 1) << shift;
+      if (tick < res)
+         res = tick;
+   }
+   return res;
+}
+void TimerThread::Wheel::Redistribute(TimerEntry*& head) {
+   while (TimerEntry* entry = head) {
+      if ((head = entry->WheelNext_) != nullptr)
+         head->WheelPPrev_ = &head;
+      if (entry->WheelTick_ <= this->CurTick_) {
+         entry->WheelNext_ = nullptr;
+         entry->WheelPPrev_ = nullptr;
+         this->Expired_.push_back(entry);
+      }
+      else
+         this->Place(*entry);
+   }
+}
+void TimerThread::Wheel::ProcessTick(uint64_t tick) {
+   assert(tick > this->CurTick_);
+   this->CurTick_ = tick;
+   if ((tick & ((static_cast<uint64_t>(1) << (kSlotBits * kLevels)) - 1)) == 0)
+      this->Redistribute(this->Overflow_);
+   // 由高層往低層 cascade: 高層的 entries 只會放到較低層 CurTick_ 之後的 slot.
+   for (unsigned level = kLevels - 1; level > 0; --level) {
+      const unsigned shift = kSlotBits * level;
+      if ((tick & ((static_cast<uint64_t>(1) << shift) - 1)) == 0)
+         this->Redistribute(this->Slots_[level][(tick >> shift) & (kSlots - 1)]);
+   }
+   this->Redistribute(this->Slots_[0][tick & (kSlots - 1)]);
+   if (this->Expired_.empty())
+      return;
+   // 同一個 tick 到期的 entries, 依 Key_ 的順序觸發.
+   std::sort(this->Expired_.begin(), this->Expired_.end(), [](const TimerEntry* lhs, const TimerEntry* rhs) {
+      return rhs->Key_ < lhs->Key_;
+   });
+   for (TimerEntry* entry : this->Expired_)
+      this->PushDue(*entry);
+   this->Expired_.clear();
+}
+void TimerThread::Wheel::Advance(TimeStamp now) {
+   const TimeInterval::OrigType us = (now - this->BaseTime_).GetOrigValue();
+   const uint64_t nowTick = (us <= 0 ? 0 : static_cast<uint64_t>(us / this->TickUs_));
+   if (nowTick <= this->CurTick_)
+      return;
+   for (;;) {
+      const uint64_t next = this->NextEventTick();
+      if (next > nowTick)
+         break;
+      this->ProcessTick(next);
+   }
+   // (CurTick_, nowTick] 之間已沒有需要處理的 tick, 可直接移動 CurTick_.
+   this->CurTick_ = nowTick;
+}
+
 } // namespace fon9
@@ -51,6 +51,12 @@ class fon9_API TimerThread;
 /// 第一次呼叫時才會啟動. 啟動後, 程式結束時才會解構.
 fon9_API TimerThread& GetDefaultTimerThread();
 
+/// \ingroup Thrs
+/// 這裡提供一個 fon9 預設的 timing wheel TimerThread, tick = 1 ms.
+/// 適用於數量很多、經常重設、不需要精確觸發時間的 timer, 例如: 大量 FIX session 的 heartbeat 計時.
+/// 第一次呼叫時才會啟動. 啟動後, 程式結束時才會解構.
+fon9_API TimerThread& GetDefaultWheelTimerThread();
+
 fon9_WARN_DISABLE_PADDING;
 /// \ingroup Thrs
 /// 使用一個「額外共用的 TimerThread」提供計時功能.
@@ -95,6 +101,10 @@ class fon9_API TimerEntry : public intrusive_ref_counter<TimerEntry> {
 
    friend class TimerThread;
    TimerEntryKey  Key_;
+   /// 使用 timing wheel 的 TimerThread: 所在串列的鏈結, 及觸發的 tick.
+   TimerEntry*    WheelNext_{nullptr};
+   TimerEntry**   WheelPPrev_{nullptr};
+   uint64_t       WheelTick_{0};
 
    void SetupRun(TimeStamp atTimePoint, const TimeInterval* after);
 public:
@@ -226,14 +236,82 @@ public:
 fon9_WARN_DISABLE_PADDING;
 /// \ingroup Thrs
 /// 實際的 TimerEntry 放在 TimerThread 裡面執行.
+/// 有 2 種計時器容器可選擇, 在建構時決定:
+/// - `TimerThread(std::string timerName);`
+///   使用 SortedVector 依觸發時間排序: 啟動、停止計時為 O(n), 觸發時間精確.
+/// - `TimerThread(std::string timerName, TimeInterval wheelTick);`
+///   使用 hierarchical timing wheel: 啟動、停止計時為 O(1),
+///   觸發時間會對齊到下一個 tick(不會提早, 但最多延遲 1 tick), 同一個 tick 內依觸發時間順序觸發.
 class fon9_API TimerThread {
    fon9_NON_COPY_NON_MOVE(TimerThread);
    friend class TimerEntry;
 
+   /// Hierarchical timing wheel:
+   /// - kLevels 層, 每層 kSlots 個 slot, 第 L 層的每個 slot 涵蓋 kSlots^L 個 tick.
+   /// - 每個 slot 是一個 TimerEntry 的雙向串列(TimerEntry::WheelNext_, WheelPPrev_), 所以加入、移除都是 O(1).
+   /// - entry 放在哪一層, 由 entry.WheelTick_ 與 CurTick_ 最高的相異位元決定,
+   ///   所以同一層裡面的 entries, 與 CurTick_ 較高層的 slot 位置都相同, 不會有繞圈的問題.
+   /// - 時間到達較高層 slot 的起點時, 將該 slot 的 entries 重新分配到較低層(cascade).
+   /// - 超過最高層範圍的 entry, 放在 Overflow_, 等 CurTick_ 跨越最高層的範圍時再重新分配.
+   struct Wheel {
+      fon9_NON_COPY_NON_MOVE(Wheel);
+      Wheel() = default;
+      ~Wheel();
+
+      enum : unsigned {
+         kSlotBits = 6,
+         kSlots = 1u << kSlotBits,
+         kLevels = 6,
+      };
+      /// 0 表示沒有使用 Wheel.
+      TimeInterval::OrigType  TickUs_{0};
+      TimeStamp               BaseTime_;
+      uint64_t                CurTick_{0};
+      /// 已到期, 等候觸發的 entries, 依觸發順序排列.
+      TimerEntry*             Due_{nullptr};
+      TimerEntry**            DueTail_{&Due_};
+      TimerEntry*             Overflow_{nullptr};
+      TimerEntry*             Slots_[kLevels][kSlots]{};
+      /// 同一個 tick 到期的 entries, 依 Key_ 排序後才移到 Due_.
+      std::vector<TimerEntry*> Expired_;
+
+      bool IsEnabled() const {
+         return this->TickUs_ > 0;
+      }
+      /// 取得 tm 所在的 tick, 若 tm 不是 tick 的開始, 則使用下一個 tick, 避免提早觸發.
+      uint64_t ToEmitTick(TimeStamp tm) const;
+      TimeStamp ToTime(uint64_t tick) const {
+         return this->BaseTime_ + TimeInterval_Microsecond(static_cast<TimeInterval::OrigType>(tick) * this->TickUs_);
+      }
+      /// 加入 entry, 增加 entry 的 ref count.
+      void Insert(TimerEntry& entry);
+      /// 移除 entry, 減少 entry 的 ref count.
+      void Remove(TimerEntry& entry);
+      /// 取出一個已到期的 entry, 由呼叫端負責 release.
+      TimerEntry* PopDue();
+      /// 將 now 之前(包含now)到期的 entries 依序移到 Due_.
+      void Advance(TimeStamp now);
+      /// 取得下一個需要處理(到期 or cascade)的 tick, 若沒有任何 entry, 則傳回 UINT64_MAX.
+      uint64_t NextEventTick() const;
+
+   private:
+      void Place(TimerEntry& entry);
+      void PushDue(TimerEntry& entry);
+      void ProcessTick(uint64_t tick);
+      /// 將 head 串列的 entries 重新分配, 若 entry 在 CurTick_ 到期, 則放到 Expired_.
+      void Redistribute(TimerEntry*& head);
+   };
+
    struct TimerThreadData {
-      void Erase(TimerEntryKey& key) {
+      void Erase(TimerEntry& entry) {
+         TimerEntryKey& key = entry.Key_;
          if (key.SeqNo_ == TimerSeqNo::NoWaiting)
             return;
+         if (this->Wheel_.IsEnabled()) {
+            if (IsTimerWaitInLine(key.SeqNo_))
+               this->Wheel_.Remove(entry);
+            return;
+         }
          auto ifind = this->Timers_.find(key);
          if (ifind != this->Timers_.end())
             this->Timers_.erase(ifind);
@@ -242,6 +320,9 @@ class fon9_API TimerThread {
       using Timers = SortedVector<TimerEntryKey, TimerEntrySP>;
       TimerSeqNo        LastSeqNo_{TimerSeqNo::WaitInLine};
       Timers            Timers_;
+      Wheel             Wheel_;
+      /// 使用 Wheel 時, thread 預計醒來的 tick; 若新加入的 timer 更早到期, 則需要喚醒 thread.
+      uint64_t          WheelWakeTick_{UINT64_MAX};
       TimeInterval      CvWaitSecs_;
       /// 如果在 TimerThread 正在觸發, 則會設定此值.
       /// 讓另一 thread 呼叫 TimerEntry::StopAndWait() 時, 可以等到 OnTimer() 真的結束後才返回.
@@ -254,6 +335,7 @@ class fon9_API TimerThread {
 
    bool CheckCurrEmit(Locker& timerThread, TimerEntry& timer);
    bool RunTimer(Locker&);
+   bool RunWheel(Locker&);
 protected:
    void ThrRun(std::string timerName);
    void WaitForEndNow();
@@ -263,8 +345,14 @@ protected:
 
 public:
    TimerThread(std::string timerName);
+   /// 使用 timing wheel, wheelTick 必須 > 0, 建議使用 ms 以上的單位.
+   TimerThread(std::string timerName, TimeInterval wheelTick);
    ~TimerThread();
 
+   bool IsWheel() const {
+      return this->TimerController_.ConstLock()->Wheel_.IsEnabled();
+   }
+
    bool InThisThread() const {
       return (this->Thread_.get_id() == std::this_thread::get_id());
    }
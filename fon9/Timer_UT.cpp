@@ -3,6 +3,7 @@
 #include "fon9/Timer.hpp"
 #include "fon9/TestTools.hpp"
 #include "fon9/RevPrint.hpp"
+#include "fon9/StrTo.hpp"
 
 // 壓力測試方法:
 // - 建立4個 thread
@@ -118,9 +119,9 @@ fon9_WARN_POP;
 
 //--------------------------------------------------------------------------//
 
-void TestTimerThread() {
-   fon9::TimerThread timerThread{"TestTimerThread"};
+void TestTimerThread(fon9::TimerThread& timerThread) {
    gTimerThread = &timerThread;
+   gOnTimerTimes = gSessionCount = gSessionDtor = gUnderOnTimer = gOverOnTimer = gOverBegin = gDtorInTimerThread = 0;
 
    std::thread thrs[4];
    size_t      thrL = 0;
@@ -179,10 +180,101 @@ void TestTimerThread() {
 
 //--------------------------------------------------------------------------//
 
-int main() {
+/// 測試 timing wheel 的觸發時間: 不可提早, 同一個 tick 依照 EmitTime 的順序觸發.
+struct OrderTimer : public fon9::TimerEntry {
+   fon9_NON_COPY_NON_MOVE(OrderTimer);
+   std::vector<const OrderTimer*>* Fired_;
+   std::atomic<unsigned>*          FiredCount_;
+   std::atomic<int>*               Early_;
+   OrderTimer(fon9::TimerThread& timerThread, std::vector<const OrderTimer*>* fired, std::atomic<unsigned>* firedCount, std::atomic<int>* early)
+      : TimerEntry{timerThread}, Fired_{fired}, FiredCount_{firedCount}, Early_{early} {
+   }
+   virtual void OnTimer(fon9::TimeStamp now) override {
+      if (now < this->GetKey().EmitTime_)
+         ++*this->Early_;
+      // 只有 timer thread 會加入 Fired_, 加入後才增加 FiredCount_.
+      this->Fired_->push_back(this);
+      ++*this->FiredCount_;
+   }
+};
+void TestWheelOrder(fon9::TimerThread& timerThread) {
+   std::cout << "[TEST ] Wheel.Order";
+   static const unsigned            kCount = 1000;
+   std::vector<const OrderTimer*>   fired;
+   std::vector<fon9::TimerEntrySP>  timers;
+   std::atomic<unsigned>            firedCount{0};
+   std::atomic<int>                 early{0};
+   fired.reserve(kCount);
+   const fon9::TimeStamp base = fon9::UtcNow() + fon9::TimeInterval_Millisecond(100);
+   // 反向加入: 越晚加入的越早觸發, 並有許多 timer 在同一個 tick 到期; 另外加入 kCount 個立即取消的 timer.
+   for (unsigned L = kCount; L > 0; --L) {
+      timers.emplace_back(new OrderTimer{timerThread, &fired, &firedCount, &early});
+      timers.back()->RunAt(base + fon9::TimeInterval_Microsecond(L * 137));
+      fon9::TimerEntrySP cancel{new OrderTimer{timerThread, &fired, &firedCount, &early}};
+      cancel->RunAt(base + fon9::TimeInterval_Microsecond(L * 71));
+      cancel->StopNoWait();
+   }
+   while (firedCount < kCount)
+      std::this_thread::sleep_for(std::chrono::milliseconds{10});
+   std::this_thread::sleep_for(std::chrono::milliseconds{10});
+   bool isOrdered = (firedCount == kCount);
+   for (size_t L = 1; isOrdered && L < fired.size(); ++L)
+      isOrdered = !(fired[L]->GetKey().EmitTime_ < fired[L - 1]->GetKey().EmitTime_);
+   if (!isOrdered || early != 0) {
+      std::cout << "|fired=" << fired.size() << "|isOrdered=" << isOrdered << "|early=" << early << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   std::cout << "\r[OK   ]" << std::endl;
+}
+
+/// 比較 SortedVector 與 timing wheel: 大量 timer 重設計時(RunAfter: 先移除, 再加入)的效率.
+/// 類似大量 FIX session 在每次收送訊息時, 重設 heartbeat 計時器.
+void BenchArmCancel(fon9::TimerThread& timerThread, const char* name, unsigned timerCount, unsigned rounds) {
+   std::vector<fon9::TimerEntrySP> timers;
+   timers.reserve(timerCount);
+   for (unsigned L = 0; L < timerCount; ++L)
+      timers.emplace_back(new fon9::TimerEntry{timerThread});
+   fon9::StopWatch stopWatch;
+   for (unsigned r = 0; r < rounds; ++r) {
+      for (unsigned L = 0; L < timerCount; ++L)
+         timers[L]->RunAfter(fon9::TimeInterval_Second(30 + (L % 30)));
+   }
+   stopWatch.PrintResult(name, timerCount * rounds);
+   for (auto& timer : timers)
+      timer->StopAndWait();
+}
+
+int main(int argc, char** argv) {
    fon9::AutoPrintTestInfo utinfo{"Timer"};
-   TestTimerThread();
+   {
+      fon9::TimerThread timerThread{"TestTimerThread"};
+      TestTimerThread(timerThread);
+   }
+   utinfo.PrintSplitter();
+   {
+      fon9::TimerThread timerThread{"TestWheelTimer", fon9::TimeInterval_Millisecond(1)};
+      TestWheelOrder(timerThread);
+      TestTimerThread(timerThread);
+   }
+   utinfo.PrintSplitter();
+   // argv: [timerCount] [rounds]
+   unsigned timerCount = (argc > 1 ? fon9::StrTo(fon9::StrView_cstr(argv[1]), 0u) : 0u);
+   unsigned rounds = (argc > 2 ? fon9::StrTo(fon9::StrView_cstr(argv[2]), 0u) : 0u);
+   if (timerCount <= 0)
+      timerCount = 10000;
+   if (rounds <= 0)
+      rounds = 10;
+   std::cout << "timers=" << timerCount << "|rounds=" << rounds << std::endl;
+   {
+      fon9::TimerThread timerThread{"BenchTimerThread"};
+      BenchArmCancel(timerThread, "SortedVector.RunAfter", timerCount, rounds);
+   }
+   {
+      fon9::TimerThread timerThread{"BenchWheelTimer", fon9::TimeInterval_Millisecond(1)};
+      BenchArmCancel(timerThread, "TimingWheel .RunAfter", timerCount, rounds);
+   }
 
    // 測試在 main() 結束後, DefaultTimerThread 是否能正常結束.
    fon9::GetDefaultTimerThread();
+   fon9::GetDefaultWheelTimerThread();
 }
@@ -1,7 +1,10 @@
 ﻿// \file fon9/buffer/MemBlock.hpp
 // \author fonwinz@gmail.com
+#define _CRT_SECURE_NO_WARNINGS  // Windows: getenv()
 #include "fon9/buffer/MemBlockImpl.hpp"
 #include "fon9/StaticPtr.hpp"
+#include "fon9/Log.hpp"
+#include <algorithm>
 
 namespace fon9 {
 
@@ -21,7 +24,51 @@ namespace impl {
 // 不用太頻繁，因為若瞬間有大用量，則應暫時保留較多的緩衝。若用量不大，也沒必要頻繁的整理。
 static const TimeInterval  kMemBlockCenter_CheckInterval{TimeInterval_Millisecond(2000)};
 
-MemBlockCenter::MemBlockCenter() : Timer_{GetDefaultTimerThread()} {
+/// 啟用 arena 模式後不會刪除: 因為直到程式結束前, 都可能還有 MemBlock 使用 arena 的記憶體.
+static MemBlockArena*   MemBlockArena_;
+/// MemBlockArena 啟動的結果, 因為啟動時可能還不能寫 log, 所以在 MemBlockCenter 的 timer 寫入 log.
+static std::string      MemBlockArenaInitMessage_;
+static bool             IsMemBlockCenterCreated_;
+
+fon9_API void MemBlockFreeRaw(void* mem) {
+   if (MemBlockArena_ && MemBlockArena_->IsArenaMem(mem))
+      MemBlockArena_->Free(mem);
+   else
+      ::free(mem);
+}
+fon9_API bool IsMemBlockArenaMem(const void* mem) {
+   return MemBlockArena_ && MemBlockArena_->IsArenaMem(mem);
+}
+static bool InitArena(const MemBlockArenaArgs& args) {
+   MemBlockArena* arena = new MemBlockArena{args};
+   MemBlockArenaInitMessage_.append(arena->InitMessage_);
+   if (!arena->IsReady()) {
+      delete arena;
+      return false;
+   }
+   MemBlockArena_ = arena;
+   return true;
+}
+fon9_API bool MemBlockInitArena(const MemBlockArenaArgs& args) {
+   if (IsMemBlockCenterCreated_ || MemBlockArena_)
+      return false;
+   return InitArena(args);
+}
+/// 從 nodeId 的 arena 取出區塊, 若沒有 arena 或 arena 已用盡, 則使用 malloc().
+static void FillFreeMemList(unsigned nodeId, unsigned lvidx, FreeMemList& fmlist, size_t maxNodeCount) {
+   if (MemBlockArena_)
+      MemBlockArena_->Alloc(nodeId, lvidx, fmlist, maxNodeCount);
+   while (fmlist.size() < maxNodeCount)
+      fmlist.push_front(InplaceNew<FreeMemNode>(malloc(MemBlockLevelSize_[lvidx])));
+}
+static byte* AllocLevelMem(unsigned nodeId, unsigned lvidx) {
+   if (MemBlockArena_)
+      if (byte* pmem = MemBlockArena_->Alloc(nodeId, lvidx))
+         return pmem;
+   return static_cast<byte*>(malloc(MemBlockLevelSize_[lvidx]));
+}
+
+MemBlockCenter::MemBlockCenter(unsigned nodeId) : NodeId_{nodeId}, Timer_{GetDefaultTimerThread()} {
    Timer_.RunAfter(TimeInterval{});
 }
 MemBlockCenter::~MemBlockCenter() {
@@ -97,11 +144,8 @@ void MemBlockCenter::InitLevel(unsigned lvidx, CenterLevel::Locker& lvCenter) {
    FreeMemList  fmlist{CenterLevelNode::ToFreeMemList(recycle.pop_front())};
    for (; curr < count; ++curr) {
       FreeMemList fmlist2{CenterLevelNode::ToFreeMemList(recycle.pop_front())};
-      if (!FreeMemListMerge(fmlist, fmlist2, maxNodeCount)) {
-         do {
-            fmlist.push_front(InplaceNew<FreeMemNode>(malloc(MemBlockLevelSize_[lvidx])));
-         } while (fmlist.size() < maxNodeCount);
-      }
+      if (!FreeMemListMerge(fmlist, fmlist2, maxNodeCount))
+         FillFreeMemList(this->NodeId_, lvidx, fmlist, maxNodeCount);
       CenterLevelNode* cnode = CenterLevelNode::FromFreeMemList(std::move(fmlist));
       fmlist = std::move(fmlist2);
       lvCenter.lock();
@@ -120,18 +164,104 @@ void MemBlockCenter::InitLevel(unsigned lvidx, const size_t* reserveFreeListCoun
    this->InitLevel(lvidx, lvCenter);
 }
 
+void MemBlockCenter::AddLevelStat(unsigned lvidx, MemBlockLevelStat& stat) {
+   CenterLevel::Locker lvCenter{this->Levels_[lvidx]};
+   stat.CenterReservedLists_ += lvCenter->Reserved_.size();
+   stat.CenterReservedCount_ += lvCenter->ReservedCount_;
+   stat.CenterRequiredCount_ += lvCenter->RequiredCount_;
+}
+
+//--------------------------------------------------------------------------//
+
+using ThreadLevelStats = std::array<MemBlockThreadLevelStat, kMemBlockLevelCount>;
+/// 使用 MemBlock 的 threads(TCache), 已結束 threads 的累計, 及各 level 使用中區塊的最大值.
+struct TCacheRegistryImpl {
+   std::vector<MemBlock::TCache*>   Live_;
+   ThreadLevelStats                 Exited_{};
+   std::array<uint64_t, kMemBlockLevelCount> InUseHighWater_{};
+};
+using TCacheRegistry = MustLock<TCacheRegistryImpl, std::mutex>;
+static TCacheRegistry& GetTCacheRegistry() {
+   // 不會刪除: 因為 thread 結束時(~TCache)可能已在 static 物件解構之後.
+   static TCacheRegistry* registry = new TCacheRegistry;
+   return *registry;
+}
+static void AddThreadLevelStats(ThreadLevelStats& dst, const TCacheLevelPools& levels) {
+   for (unsigned lvidx = 0; lvidx < kMemBlockLevelCount; ++lvidx) {
+      const TCacheLevelStat&   src = levels[lvidx].Stat_;
+      MemBlockThreadLevelStat& st = dst[lvidx];
+      st.AllocCount_ += src.AllocCount_.load(std::memory_order_relaxed);
+      st.CenterCount_ += src.CenterCount_.load(std::memory_order_relaxed);
+      st.EmptyCount_ += src.EmptyCount_.load(std::memory_order_relaxed);
+      st.FreeCount_ += src.FreeCount_.load(std::memory_order_relaxed);
+      st.HeldCount_ += src.HeldCount_.load(std::memory_order_relaxed);
+   }
+}
+static inline uint64_t GetInUseCount(const MemBlockThreadLevelStat& st) {
+   // 因為各 thread 的計數不是同時取得的, 所以可能會有 FreeCount_ > AllocCount_ 的情況.
+   return st.AllocCount_ > st.FreeCount_ ? st.AllocCount_ - st.FreeCount_ : 0u;
+}
+static void SumThreadLevelStats(TCacheRegistryImpl& reg, ThreadLevelStats& sum);
+/// 在 MemBlockCenter 的定時檢查時更新 InUseHighWater_;
+static void UpdateInUseHighWater() {
+   ThreadLevelStats        sum;
+   TCacheRegistry::Locker  reg{GetTCacheRegistry()};
+   SumThreadLevelStats(*reg, sum);
+}
+
 void MemBlockCenter::EmitOnTimer(TimerEntry* timer, TimeStamp) {
    MemBlockCenter& rthis = ContainerOf(*static_cast<decltype(MemBlockCenter::Timer_)*>(timer), &MemBlockCenter::Timer_);
+   if (rthis.NodeId_ == 0) {
+      if (fon9_UNLIKELY(!MemBlockArenaInitMessage_.empty())) {
+         fon9_LOG_IMP(MemBlockArenaInitMessage_);
+         MemBlockArenaInitMessage_.clear();
+      }
+      UpdateInUseHighWater();
+   }
    for (unsigned lvidx = 0; lvidx < kMemBlockLevelCount; ++lvidx)
       rthis.InitLevel(lvidx, nullptr);
    timer->RunAfter(kMemBlockCenter_CheckInterval);
 }
 
 using MemBlockCenterSP = intrusive_ptr<MemBlockCenter>;
-static MemBlockCenterSP GetMemBlockCenter() {
-   static MemBlockCenterSP MemBlockCenter{new impl::MemBlockCenter{}};
+/// 沒有 arena 時, 只有一個 MemBlockCenter; 有 arena 時, 每個 NUMA node 一個 MemBlockCenter.
+struct MemBlockCenters {
+   fon9_NON_COPY_NON_MOVE(MemBlockCenters);
+   unsigned          Count_;
+   MemBlockCenterSP  Centers_[kMemBlockMaxNodeCount];
+   MemBlockCenters() {
+      IsMemBlockCenterCreated_ = true;
+      if (!MemBlockArena_) {
+         if (const char* envstr = getenv("fon9MemBlockArena")) {
+            MemBlockArenaArgs          args;
+            RevBufferFixedSize<1024>   rbuf;
+            if (!ParseConfig(args, StrView_cstr(envstr), rbuf)) {
+               RevPrint(rbuf, "MemBlockArena.Args|env=fon9MemBlockArena|cfg=", envstr, '|');
+               MemBlockArenaInitMessage_ = rbuf.ToStrT<std::string>();
+            }
+            InitArena(args);
+         }
+      }
+      this->Count_ = MemBlockArena_ ? MemBlockArena_->GetNodeCount() : 1u;
+      for (unsigned nodeId = 0; nodeId < this->Count_; ++nodeId)
+         this->Centers_[nodeId].reset(new impl::MemBlockCenter{nodeId});
+   }
+};
+static MemBlockCenters& GetMemBlockCenters() {
+   static MemBlockCenters Centers_;
+   return Centers_;
+}
+static MemBlockCenterSP GetMemBlockCenter(unsigned nodeId) {
+   MemBlockCenters&  centers = GetMemBlockCenters();
+   MemBlockCenterSP& center = centers.Centers_[nodeId < centers.Count_ ? nodeId : 0];
    // 如果系統正在結束 MemBlockCenter 已死, 此時應傳回 nullptr, 然後使用 MemBlock::UseMalloc();
-   return MemBlockCenter->use_count() ? MemBlockCenter : nullptr;
+   return center->use_count() ? center : nullptr;
+}
+/// 有 arena 時, 根據目前 thread 所在的 NUMA node 選擇 MemBlockCenter.
+/// thread 應在第一次使用 MemBlock 之前設定 cpu affinity, 之後才能取得正確 node 的記憶體.
+static MemBlockCenterSP GetThisThreadMemBlockCenter() {
+   GetMemBlockCenters();
+   return GetMemBlockCenter(MemBlockArena_ ? MemBlockArena_->GetThisThreadNodeId() : 0u);
 }
 
 fon9_API bool MemBlockInit(MemBlockSize size, size_t reserveFreeListCount, size_t maxNodeCount) {
@@ -140,7 +270,9 @@ fon9_API bool MemBlockInit(MemBlockSize size, size_t reserveFreeListCount, size_
       return false;
    if (MemBlockLevelMaxNodeCount_[lvidx] < maxNodeCount)
       MemBlockLevelMaxNodeCount_[lvidx] = maxNodeCount;
-   GetMemBlockCenter()->InitLevel(lvidx, &reserveFreeListCount);
+   MemBlockCenters& centers = GetMemBlockCenters();
+   for (unsigned nodeId = 0; nodeId < centers.Count_; ++nodeId)
+      centers.Centers_[nodeId]->InitLevel(lvidx, &reserveFreeListCount);
    return true;
 }
 } // namespace impl
@@ -153,14 +285,29 @@ class MemBlock::TCache {
    TCacheLevelPools        Levels_;
 public:
    const MemBlockCenterSP  Center_;
-   TCache() : Center_{GetMemBlockCenter()} {
+   const unsigned          NodeId_;
+   const ThreadId::IdType  ThreadId_;
+   TCache()
+      : Center_{GetThisThreadMemBlockCenter()}
+      , NodeId_{Center_ ? Center_->GetNodeId() : 0u}
+      , ThreadId_{GetThisThreadId().ThreadId_} {
+      TCacheRegistry::Locker{GetTCacheRegistry()}->Live_.push_back(this);
    }
    ~TCache() {
+      {
+         TCacheRegistry::Locker reg{GetTCacheRegistry()};
+         reg->Live_.erase(std::find(reg->Live_.begin(), reg->Live_.end(), this));
+         AddThreadLevelStats(reg->Exited_, this->Levels_);
+      }
       this->Center_->Recycle(this->Levels_);
    }
+   /// 僅能讀取 TCacheLevelPool::Stat_;
+   const TCacheLevelPools& GetLevels() const {
+      return this->Levels_;
+   }
    static byte* UseMalloc(MemBlock& mblk, MemBlockSize sz) {
       if (fon9_UNLIKELY(mblk.MemPtr_))
-         free(mblk.MemPtr_);
+         MemBlockFreeRaw(mblk.MemPtr_);
       if (fon9_LIKELY((mblk.Size_ = -static_cast<SSizeT>(sz)) <= 0))
          if (fon9_LIKELY((mblk.MemPtr_ = reinterpret_cast<byte*>(malloc(sz))) != nullptr))
             return mblk.MemPtr_;
@@ -182,12 +329,16 @@ public:
          lv.FreeMemCurr_ = std::move(lv.FreeMemNext_);
       byte* pmem = reinterpret_cast<byte*>(lv.FreeMemCurr_.pop_front());
       if (fon9_UNLIKELY(pmem == nullptr)) {
-         if ((pmem = this->Center_->Alloc(lvidx, lv)) == nullptr) {
-            ++lv.EmptyCount_;
-            if ((pmem = static_cast<byte*>(malloc(newsz))) == nullptr)
+         if ((pmem = this->Center_->Alloc(lvidx, lv)) != nullptr)
+            TCacheLevelStat::Inc(lv.Stat_.CenterCount_);
+         else {
+            TCacheLevelStat::Inc(lv.Stat_.EmptyCount_);
+            if ((pmem = AllocLevelMem(this->NodeId_, lvidx)) == nullptr)
                return nullptr;
          }
       }
+      TCacheLevelStat::Inc(lv.Stat_.AllocCount_);
+      lv.UpdateHeldCount();
       mblk.Size_ = static_cast<SSizeT>(newsz);
       return mblk.MemPtr_ = pmem;
    }
@@ -196,29 +347,99 @@ public:
          return;
       const unsigned lvidx = MemBlockSizeToIndex(sz);
       if (fon9_UNLIKELY(lvidx >= kMemBlockLevelCount)) {
-         ::free(ptr);
+         MemBlockFreeRaw(ptr);
          return;
       }
       assert(sz == MemBlockLevelSize_[lvidx]);
+      TCacheLevelPool& lv = this->Levels_[lvidx];
+      TCacheLevelStat::Inc(lv.Stat_.FreeCount_);
+      // 其他 node 的 arena 記憶體, 直接還給該 node, 避免 this thread 之後取得非本地的記憶體.
+      if (fon9_UNLIKELY(MemBlockArena_ && MemBlockArena_->IsArenaMem(ptr)
+                        && MemBlockArena_->GetNodeId(ptr) != this->NodeId_)) {
+         MemBlockArena_->Free(ptr);
+         return;
+      }
       // 重建 node = 初始值. 然後放入 list.
       FreeMemNode*      node = InplaceNew<FreeMemNode>(ptr);
       const size_t      maxNodeCount = MemBlockLevelMaxNodeCount_[lvidx];
-      TCacheLevelPool&  lv = this->Levels_[lvidx];
       FreeMemList*      fmlist = (lv.FreeMemCurr_.size() < maxNodeCount ? &lv.FreeMemCurr_
                                   : lv.FreeMemNext_.size() < maxNodeCount ? &lv.FreeMemNext_
                                   : nullptr);
-      if (fon9_LIKELY(fmlist)) {
+      if (fon9_LIKELY(fmlist))
          fmlist->push_front(node);
-         return;
+      else {
+         this->Center_->FreeFull(lvidx, std::move(lv.FreeMemCurr_));
+         lv.FreeMemCurr_.push_front(node);
       }
-      this->Center_->FreeFull(lvidx, std::move(lv.FreeMemCurr_));
-      lv.FreeMemCurr_.push_front(node);
+      lv.UpdateHeldCount();
    }
 };
 static thread_local StaticPtr<MemBlock::TCache> TCache_;
 
 //--------------------------------------------------------------------------//
 
+namespace impl {
+static void SumThreadLevelStats(TCacheRegistryImpl& reg, ThreadLevelStats& sum) {
+   sum = reg.Exited_;
+   for (const MemBlock::TCache* tcache : reg.Live_)
+      AddThreadLevelStats(sum, tcache->GetLevels());
+   for (unsigned lvidx = 0; lvidx < kMemBlockLevelCount; ++lvidx) {
+      const uint64_t inUse = GetInUseCount(sum[lvidx]);
+      if (reg.InUseHighWater_[lvidx] < inUse)
+         reg.InUseHighWater_[lvidx] = inUse;
+   }
+}
+fon9_API void MemBlockGetLevelStats(MemBlockLevelStats& stats) {
+   ThreadLevelStats                          sum;
+   std::array<uint64_t, kMemBlockLevelCount> highWater;
+   {
+      TCacheRegistry::Locker reg{GetTCacheRegistry()};
+      SumThreadLevelStats(*reg, sum);
+      highWater = reg->InUseHighWater_;
+   }
+   stats.fill(MemBlockLevelStat{});
+   for (unsigned lvidx = 0; lvidx < kMemBlockLevelCount; ++lvidx) {
+      const MemBlockThreadLevelStat& src = sum[lvidx];
+      MemBlockLevelStat&             st = stats[lvidx];
+      st.BlockSize_ = MemBlockLevelSize_[lvidx];
+      st.AllocCount_ = src.AllocCount_;
+      st.CenterCount_ = src.CenterCount_;
+      st.EmptyCount_ = src.EmptyCount_;
+      st.HitCount_ = src.AllocCount_ - src.CenterCount_ - src.EmptyCount_;
+      st.FreeCount_ = src.FreeCount_;
+      st.InUseCount_ = GetInUseCount(src);
+      st.InUseHighWater_ = highWater[lvidx];
+      st.TCacheHeldCount_ = src.HeldCount_;
+      st.MaxNodeCount_ = MemBlockLevelMaxNodeCount_[lvidx];
+   }
+   MemBlockCenters& centers = GetMemBlockCenters();
+   for (unsigned nodeId = 0; nodeId < centers.Count_; ++nodeId) {
+      for (unsigned lvidx = 0; lvidx < kMemBlockLevelCount; ++lvidx)
+         centers.Centers_[nodeId]->AddLevelStat(lvidx, stats[lvidx]);
+   }
+}
+fon9_API void MemBlockGetThreadStats(MemBlockThreadStats& stats) {
+   stats.clear();
+   {
+      TCacheRegistry::Locker reg{GetTCacheRegistry()};
+      stats.resize(reg->Live_.size());
+      auto ist = stats.begin();
+      for (const MemBlock::TCache* tcache : reg->Live_) {
+         ist->ThreadId_ = tcache->ThreadId_;
+         ist->NodeId_ = tcache->NodeId_;
+         ist->Levels_.fill(MemBlockThreadLevelStat{});
+         AddThreadLevelStats(ist->Levels_, tcache->GetLevels());
+         ++ist;
+      }
+   }
+   std::sort(stats.begin(), stats.end(), [](const MemBlockThreadStat& lhs, const MemBlockThreadStat& rhs) {
+      return lhs.ThreadId_ < rhs.ThreadId_;
+   });
+}
+} // namespace impl
+
+//--------------------------------------------------------------------------//
+
 byte* MemBlock::Alloc(MemBlockSize sz) {
    if (fon9_LIKELY(TCache_)) {
 __TCACHE_READY:
@@ -237,7 +458,7 @@ void MemBlock::FreeBlock(void* mem, MemBlockSize sz) {
       if (fon9_LIKELY(TCache_))
          TCache_->Free(mem, sz);
       else
-         free(mem);
+         MemBlockFreeRaw(mem);
    }
 }
 
@@ -20,6 +20,8 @@ fon9_WARN_DISABLE_PADDING;
 /// - 記憶體數量等級(可能的情況):
 ///   - 256B, 512B, 1024B, 2KB, 4KB... 最大64K
 ///   - 也就是: 要求量<=256B 分配 256B; 要求量<=512B 分配 512B; ...
+/// - 可透過 impl::MemBlockInitArena() 或環境變數 "fon9MemBlockArena" 啟用 arena 模式:
+///   每個等級的記憶體從大塊 slab(可使用 hugepage) 切出, 每個 NUMA node 一組 slab, thread 只取得所在 node 的記憶體.
 class fon9_API MemBlock {
    fon9_NON_COPYABLE(MemBlock);
    /// <0 表示直接使用 MemPtr_ 直接從 malloc(-Size_) 得到, 釋放時須直接呼叫 free();
@@ -35,7 +37,10 @@ public:
       this->Alloc(sz);
    }
 
-   MemBlock(MemBlock&& r) : MemPtr_(r.Release()), Size_(r.Size_) {
+   MemBlock(MemBlock&& r) : MemPtr_(r.MemPtr_), Size_(r.Size_) {
+      // 不可使用 MemPtr_(r.Release()): 因為 Release() 會先清除 r.Size_, 造成 this->Size_ 為 0,
+      // 歸還時就無法得知原本的大小(arena 的記憶體不可直接 free()).
+      r.Release();
    }
    MemBlock& operator=(MemBlock&& r) {
       if (this->MemPtr_ != r.MemPtr_) {
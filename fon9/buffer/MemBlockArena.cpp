@@ -0,0 +1,297 @@
+﻿// \file fon9/buffer/MemBlockArena.cpp
+// \author fonwinz@gmail.com
+#include "fon9/buffer/MemBlockImpl.hpp"
+#include "fon9/RevPrint.hpp"
+#include "fon9/StrTo.hpp"
+#include "fon9/ErrC.hpp"
+#ifndef fon9_WINDOWS
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace fon9 { namespace impl {
+
+/// slab 的大小必須是 hugepage(2MB) 的倍數, 且 Base_ 必須對齊 hugepage.
+static const size_t  kHugePageSize = 2 * 1024 * 1024;
+
+/// "n[K|M|G]"
+static bool StrToSizeUnit(StrView& value, size_t& dst) {
+   const char* pend;
+   uint64_t    sz = StrTo(value, uint64_t{0}, &pend);
+   if (pend == value.begin())
+      return false;
+   StrView unit{pend, value.end()};
+   switch (StrTrim(&unit).Get1st()) {
+   case -1:                   break;
+   case 'k': case 'K':  sz <<= 10;  break;
+   case 'm': case 'M':  sz <<= 20;  break;
+   case 'g': case 'G':  sz <<= 30;  break;
+   default:
+      value.SetBegin(unit.begin());
+      return false;
+   }
+   if (unit.size() > 1) {
+      value.SetBegin(unit.begin() + 1);
+      return false;
+   }
+   dst = static_cast<size_t>(sz);
+   return true;
+}
+
+ConfigParser::Result MemBlockArenaArgs::OnTagValue(StrView tag, StrView& value) {
+   if (tag == "HugePage") {
+      if (value == "N")
+         this->HugePage_ = MemBlockHugePage::None;
+      else if (value == "T")
+         this->HugePage_ = MemBlockHugePage::Transparent;
+      else if (value == "TLB")
+         this->HugePage_ = MemBlockHugePage::HugeTLB;
+      else
+         return ConfigParser::Result::EInvalidValue;
+   }
+   else if (tag == "SlabSize") {
+      if (!StrToSizeUnit(value, this->SlabSize_))
+         return ConfigParser::Result::EInvalidValue;
+   }
+   else if (tag == "MaxSizePerNode") {
+      if (!StrToSizeUnit(value, this->MaxSizePerNode_))
+         return ConfigParser::Result::EInvalidValue;
+   }
+   else if (tag == "Numa")
+      this->IsNumaAware_ = (toupper(value.Get1st()) == 'Y');
+   else
+      return ConfigParser::Result::EUnknownTag;
+   return ConfigParser::Result::Success;
+}
+
+//--------------------------------------------------------------------------//
+
+static size_t RoundUp(size_t sz, size_t unit) {
+   return sz <= unit ? unit : ((sz + unit - 1) / unit) * unit;
+}
+
+#ifdef fon9_WINDOWS
+static unsigned GetNumaNodeCount() {
+   ULONG highest;
+   if (!GetNumaHighestNodeNumber(&highest))
+      return 1;
+   return static_cast<unsigned>(highest + 1);
+}
+#else
+static unsigned GetNumaNodeCount() {
+   // 內容例: "0" or "0-3"
+   FILE* fd = fopen("/sys/devices/system/node/possible", "r");
+   if (fd == nullptr)
+      return 1;
+   char  buf[64];
+   char* pbuf = fgets(buf, sizeof(buf), fd);
+   fclose(fd);
+   if (pbuf == nullptr)
+      return 1;
+   StrView  nodes = StrView_cstr(buf);
+   StrTrim(&nodes);
+   if (const char* pdash = nodes.Find('-'))
+      nodes.SetBegin(pdash + 1);
+   return StrTo(nodes, 0u) + 1;
+}
+/// 使用 MPOL_PREFERRED: 優先使用 nodeId 的記憶體, 若該 node 記憶體不足, 仍可使用其他 node 的記憶體, 避免因此造成 SIGBUS.
+/// 直接使用 syscall, 避免相依 libnuma.
+static int SysMbindPreferred(void* addr, size_t len, unsigned nodeId) {
+   enum { kMPOL_PREFERRED = 1 };
+   unsigned long nodemask = (1ul << nodeId);
+   return static_cast<int>(syscall(SYS_mbind, addr, len, kMPOL_PREFERRED, &nodemask, sizeof(nodemask) * 8, 0));
+}
+#endif
+
+static const char* HugePageToStr(MemBlockHugePage hp) {
+   switch (hp) {
+   default:
+   case MemBlockHugePage::None:        return "N";
+   case MemBlockHugePage::Transparent: return "T";
+   case MemBlockHugePage::HugeTLB:     return "TLB";
+   }
+}
+
+MemBlockArena::MemBlockArena(const MemBlockArenaArgs& args)
+   : SlabSize_{RoundUp(args.SlabSize_, kHugePageSize)}
+   , NodeCount_{args.IsNumaAware_ ? GetNumaNodeCount() : 1u}
+   , HugePage_{args.HugePage_} {
+   // 這裡可能在第一次使用 MemBlock 時被呼叫, 所以不能使用 RevBufferList(會用到 MemBlock).
+   RevBufferFixedSize<1024> rbuf;
+   if (this->NodeCount_ > kMemBlockMaxNodeCount)
+      this->NodeCount_ = kMemBlockMaxNodeCount;
+   this->SizePerNode_ = RoundUp(args.MaxSizePerNode_, this->SlabSize_);
+   const size_t rsize = this->SizePerNode_ * this->NodeCount_;
+#ifdef fon9_WINDOWS
+   // Windows: 先保留位址空間, 在 CommitSlab() 時才透過 VirtualAllocExNuma() 指定 node 並 commit.
+   this->Base_ = static_cast<byte*>(VirtualAlloc(nullptr, rsize, MEM_RESERVE, PAGE_NOACCESS));
+   if (this->Base_ == nullptr)
+      RevPrint(rbuf, "|err=", GetSysErrC());
+#else
+   // 多保留一個 hugepage 的空間, 用來對齊 kHugePageSize.
+   // MAP_NORESERVE: 實際使用(page fault)時才會分配實體記憶體.
+   void* pmap = mmap(nullptr, rsize + kHugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+   if (pmap == MAP_FAILED)
+      RevPrint(rbuf, "|err=", GetSysErrC());
+   else {
+      byte* const pbeg = static_cast<byte*>(pmap);
+      byte* const pend = pbeg + rsize + kHugePageSize;
+      this->Base_ = reinterpret_cast<byte*>((reinterpret_cast<uintptr_t>(pbeg) + kHugePageSize - 1) & ~static_cast<uintptr_t>(kHugePageSize - 1));
+      if (this->Base_ != pbeg)
+         munmap(pbeg, static_cast<size_t>(this->Base_ - pbeg));
+      if (this->Base_ + rsize != pend)
+         munmap(this->Base_ + rsize, static_cast<size_t>(pend - (this->Base_ + rsize)));
+      if (this->HugePage_ != MemBlockHugePage::None && madvise(this->Base_, rsize, MADV_HUGEPAGE) != 0)
+         RevPrint(rbuf, "|madvise.err=", GetSysErrC());
+      if (this->NodeCount_ > 1) {
+         for (unsigned nodeId = 0; nodeId < this->NodeCount_; ++nodeId) {
+            if (SysMbindPreferred(this->Base_ + nodeId * this->SizePerNode_, this->SizePerNode_, nodeId) != 0) {
+               RevPrint(rbuf, "|mbind.err=", GetSysErrC());
+               break;
+            }
+         }
+      }
+   }
+#endif
+   if (this->Base_) {
+      this->ReservedSize_ = rsize;
+      this->Nodes_.reset(new Node[this->NodeCount_]);
+      this->SlabLevels_.reset(new uint8_t[rsize / this->SlabSize_]);
+   }
+   RevPrint(rbuf, "MemBlockArena|nodes=", this->NodeCount_,
+            "|slab=", this->SlabSize_, "|maxPerNode=", this->SizePerNode_,
+            "|hugePage=", HugePageToStr(this->HugePage_),
+            "|ready=", this->IsReady() ? 'Y' : 'N');
+   this->InitMessage_ = rbuf.ToStrT<std::string>();
+}
+MemBlockArena::~MemBlockArena() {
+   if (this->Base_ == nullptr)
+      return;
+#ifdef fon9_WINDOWS
+   VirtualFree(this->Base_, 0, MEM_RELEASE);
+#else
+   munmap(this->Base_, this->ReservedSize_);
+#endif
+}
+
+unsigned MemBlockArena::GetThisThreadNodeId() const {
+   if (this->NodeCount_ <= 1)
+      return 0;
+#ifdef fon9_WINDOWS
+   PROCESSOR_NUMBER  pn;
+   USHORT            nodeId;
+   GetCurrentProcessorNumberEx(&pn);
+   if (!GetNumaProcessorNodeEx(&pn, &nodeId))
+      return 0;
+#else
+   unsigned cpuId, nodeId;
+   if (syscall(SYS_getcpu, &cpuId, &nodeId, nullptr) != 0)
+      return 0;
+#endif
+   return nodeId < this->NodeCount_ ? static_cast<unsigned>(nodeId) : 0u;
+}
+
+bool MemBlockArena::CommitSlab(unsigned nodeId, byte* slab, bool& isHugeTLBFallback) {
+#ifdef fon9_WINDOWS
+   // Windows 的 large page 需要 SeLockMemoryPrivilege, 且必須在 VirtualAlloc() 時一次 commit, 所以這裡不支援 hugepage.
+   (void)isHugeTLBFallback;
+   return VirtualAllocExNuma(GetCurrentProcess(), slab, this->SlabSize_, MEM_COMMIT, PAGE_READWRITE, nodeId) != nullptr;
+#else
+   if (this->HugePage_ != MemBlockHugePage::HugeTLB)
+      return true;
+   // 使用 MAP_FIXED 將 slab 改成 hugetlb 的 mapping, 新的 mapping 必須重新設定 mbind().
+   void* pmap = mmap(slab, this->SlabSize_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_HUGETLB, -1, 0);
+   if (pmap == MAP_FAILED) {
+      // 系統沒有足夠的 hugepages(vm.nr_hugepages): 改用一般的 mapping + THP.
+      isHugeTLBFallback = true;
+      pmap = mmap(slab, this->SlabSize_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE, -1, 0);
+      if (pmap == MAP_FAILED)
+         return false;
+      madvise(slab, this->SlabSize_, MADV_HUGEPAGE);
+   }
+   if (this->NodeCount_ > 1)
+      SysMbindPreferred(slab, this->SlabSize_, nodeId);
+   return true;
+#endif
+}
+bool MemBlockArena::NewSlab(unsigned nodeId, unsigned lvidx, Node::Locker& node) {
+   if (node->NextSlabOffset_ + this->SlabSize_ > this->SizePerNode_) {
+      node.unlock();
+      return false;
+   }
+   const size_t   slabOffset = node->NextSlabOffset_;
+   const size_t   offset = nodeId * this->SizePerNode_ + slabOffset;
+   byte* const    slab = this->Base_ + offset;
+   node->NextSlabOffset_ += this->SlabSize_;
+   node->Levels_[lvidx].IsSlabCommitting_ = true;
+   node.unlock();
+
+   bool       isHugeTLBFallback = false;
+   const bool isCommitted = this->CommitSlab(nodeId, slab, isHugeTLBFallback);
+   // 在 slab 的區塊交出之前設定, 之後 Free() 才會用到, 由 lock 確保其他 thread 看得到.
+   if (isCommitted)
+      this->SlabLevels_[offset / this->SlabSize_] = static_cast<uint8_t>(lvidx);
+
+   node.lock();
+   LevelSlab& lv = node->Levels_[lvidx];
+   lv.IsSlabCommitting_ = false;
+   if (isHugeTLBFallback)
+      ++node->HugeTLBFallbackCount_;
+   if (!isCommitted) {
+      // 若之後沒有其他 level 保留 slab, 則歸還此位置, 下次可再嘗試.
+      if (node->NextSlabOffset_ == slabOffset + this->SlabSize_)
+         node->NextSlabOffset_ = slabOffset;
+      node.unlock();
+      return false;
+   }
+   // IsSlabCommitting_ 期間, 其他 thread 不會為此 level 配置 slab, 所以 lv 的 slab 必定已用完.
+   assert(lv.Curr_ == lv.End_);
+   lv.Curr_ = slab;
+   lv.End_ = slab + this->SlabSize_;
+   node.unlock();
+   return true;
+}
+
+void MemBlockArena::Alloc(unsigned nodeId, unsigned lvidx, FreeMemList& fmlist, size_t maxNodeCount) {
+   assert(nodeId < this->NodeCount_ && lvidx < kMemBlockLevelCount);
+   const MemBlockSize blksz = MemBlockLevelSize_[lvidx];
+   while (fmlist.size() < maxNodeCount) {
+      Node::Locker   node{this->Nodes_[nodeId]};
+      LevelSlab&     lv = node->Levels_[lvidx];
+      while (fmlist.size() < maxNodeCount) {
+         if (FreeMemNode* mnode = lv.Free_.pop_front()) {
+            fmlist.push_front(mnode);
+            continue;
+         }
+         if (lv.Curr_ == lv.End_)
+            break;
+         fmlist.push_front(InplaceNew<FreeMemNode>(lv.Curr_));
+         lv.Curr_ += blksz;
+      }
+      if (fmlist.size() >= maxNodeCount)
+         break;
+      if (lv.IsSlabCommitting_) {
+         // 其他 thread 正在配置此 level 的 slab: 解鎖等候(此時 Free() 及其他 level 仍可使用此 node).
+         node.unlock();
+         std::this_thread::yield();
+         continue;
+      }
+      if (!this->NewSlab(nodeId, lvidx, node))
+         break;
+   }
+}
+byte* MemBlockArena::Alloc(unsigned nodeId, unsigned lvidx) {
+   FreeMemList fmlist;
+   this->Alloc(nodeId, lvidx, fmlist, 1);
+   return reinterpret_cast<byte*>(fmlist.ReleaseList());
+}
+void MemBlockArena::Free(void* mem) {
+   assert(this->IsArenaMem(mem));
+   const size_t   offset = this->GetOffset(mem);
+   const unsigned lvidx = this->SlabLevels_[offset / this->SlabSize_];
+   FreeMemNode*   mnode = InplaceNew<FreeMemNode>(mem);
+   Node::Locker   node{this->Nodes_[offset / this->SizePerNode_]};
+   node->Levels_[lvidx].Free_.push_front(mnode);
+}
+
+} } // namespaces
@@ -6,7 +6,11 @@
 #include "fon9/SinglyLinkedList.hpp"
 #include "fon9/SpinMutex.hpp"
 #include "fon9/Timer.hpp"
+#include "fon9/ConfigParser.hpp"
+#include "fon9/ThreadId.hpp"
 #include <array>
+#include <vector>
+#include <atomic>
 
 namespace fon9 {
 
@@ -46,35 +50,188 @@ constexpr std::array<MemBlockSize, kMemBlockLevelCount> MemBlockLevelSize_{
 //--------------------------------------------------------------------------//
 
 namespace impl {
+/// 歸還一塊 level 記憶體: 若為 MemBlockArena 分配的, 則還給 arena, 否則使用 ::free().
+fon9_API void MemBlockFreeRaw(void* mem);
+
 struct FreeMemNode : public SinglyLinkedListNode<FreeMemNode> {
    fon9_NON_COPY_NON_MOVE(FreeMemNode);
    FreeMemNode() = default;
    inline friend void FreeNode(FreeMemNode* mnode) {
-      ::free(mnode);
+      MemBlockFreeRaw(mnode);
    }
 };
 using FreeMemList = SinglyLinkedList<FreeMemNode>;
 
 //--------------------------------------------------------------------------//
 
+enum : unsigned {
+   /// arena 模式最多支援的 NUMA node 數量, 超過的 node 使用 node 0 的記憶體.
+   kMemBlockMaxNodeCount = 32
+};
+
+enum class MemBlockHugePage : uint8_t {
+   /// 使用一般的 page.
+   None,
+   /// 使用 Transparent Huge Pages: madvise(MADV_HUGEPAGE);
+   Transparent,
+   /// 使用 MAP_HUGETLB(需要系統預先保留 hugepages: vm.nr_hugepages), 若失敗則改用 Transparent.
+   HugeTLB,
+};
+
+/// \ingroup Buffer
+/// MemBlockArena 的參數.
+/// args: "HugePage=N|T|TLB|SlabSize=2M|MaxSizePerNode=1G|Numa=Y|N"
+struct fon9_API MemBlockArenaArgs {
+   /// 每個 slab 的大小, 會調整成 2MB 的倍數, 每個 slab 只提供一種 level 的記憶體.
+   size_t            SlabSize_{2 * 1024 * 1024};
+   /// 每個 NUMA node 最多使用的記憶體量(啟動時保留的虛擬位址空間), 超過後改用 malloc().
+   size_t            MaxSizePerNode_{1024 * 1024 * 1024};
+   MemBlockHugePage  HugePage_{MemBlockHugePage::Transparent};
+   /// false: 不區分 NUMA node, 全部使用一組 slab.
+   bool              IsNumaAware_{true};
+
+   /// 用 tag, value 設定參數.
+   /// tag            | value
+   /// ---------------|------------------------------
+   /// HugePage       | N=None; T=Transparent; TLB=HugeTLB
+   /// SlabSize       | n[K|M|G]
+   /// MaxSizePerNode | n[K|M|G]
+   /// Numa           | Y or N
+   ConfigParser::Result OnTagValue(StrView tag, StrView& value);
+};
+
+/// \ingroup Buffer
+/// 啟用 arena 模式: 每個 level 的記憶體從大塊的 slab 切出, 每個 NUMA node 一組 slab.
+/// - 必須在第一次使用 MemBlock 之前呼叫, 否則傳回 false.
+/// - 若沒有呼叫, 則在第一次使用 MemBlock 時, 若有設定環境變數 "fon9MemBlockArena", 則使用該設定啟用 arena.
+/// - arena 的記憶體不會還給 OS, 歸還時會放回該 slab 所屬 node 的 free list.
+fon9_API bool MemBlockInitArena(const MemBlockArenaArgs& args);
+
+/// \ingroup Buffer
+/// mem 是否為 MemBlockArena 分配的記憶體.
+fon9_API bool IsMemBlockArenaMem(const void* mem);
+
+fon9_WARN_DISABLE_PADDING;
+/// MemBlock 的 arena 模式: 每個 NUMA node 保留一段連續的虛擬位址空間,
+/// 依需求一次配置一個 slab(可使用 hugepage), 每個 slab 只切成一種 level 的區塊.
+/// 因為位址連續, 所以可以快速判斷某塊記憶體是否屬於 arena, 及其所屬的 node.
+class MemBlockArena {
+   fon9_NON_COPY_NON_MOVE(MemBlockArena);
+   struct LevelSlab {
+      FreeMemList Free_;
+      byte*       Curr_{nullptr};
+      byte*       End_{nullptr};
+      /// 已有 thread 在 lock 之外 CommitSlab(), 其他 thread 等候完成, 不重複配置 slab.
+      bool        IsSlabCommitting_{false};
+   };
+   struct NodeImpl {
+      std::array<LevelSlab, kMemBlockLevelCount> Levels_;
+      size_t   NextSlabOffset_{0};
+      size_t   HugeTLBFallbackCount_{0};
+   };
+   using Node = MustLock<NodeImpl, SpinBusy>;
+
+   byte*                      Base_{nullptr};
+   size_t                     ReservedSize_{0};
+   size_t                     SizePerNode_;
+   size_t                     SlabSize_;
+   unsigned                   NodeCount_;
+   const MemBlockHugePage     HugePage_;
+   std::unique_ptr<Node[]>    Nodes_;
+   /// 每個 slab 所屬的 level: [node * SlabCountPerNode + slabIndex];
+   std::unique_ptr<uint8_t[]> SlabLevels_;
+
+   /// 在 node 配置新的 slab 給 lvidx 使用, 返回前 lv.Curr_, lv.End_ 已設定.
+   /// - 在 lock 裡面保留 slab 的位置, 在 lock 之外 CommitSlab()(mmap, mbind 可能很慢), 然後再 lock 設定 lv.
+   /// - 返回時 node 已解鎖; 若 false 表示 arena 已用盡(或 commit 失敗).
+   bool NewSlab(unsigned nodeId, unsigned lvidx, Node::Locker& node);
+   /// 在 lock 之外呼叫.
+   bool CommitSlab(unsigned nodeId, byte* slab, bool& isHugeTLBFallback);
+   /// 若 mem 在 Base_ 之前, 則會因 unsigned 溢位而傳回很大的數字.
+   size_t GetOffset(const void* mem) const {
+      return static_cast<size_t>(reinterpret_cast<uintptr_t>(mem) - reinterpret_cast<uintptr_t>(this->Base_));
+   }
+
+public:
+   /// arena 啟動結果的說明, 例: 保留位址空間失敗的原因, 在 MemBlockCenter 的 timer 寫入 log.
+   std::string InitMessage_;
+
+   MemBlockArena(const MemBlockArenaArgs& args);
+   ~MemBlockArena();
+
+   /// 保留虛擬位址空間失敗.
+   bool IsReady() const {
+      return this->Base_ != nullptr;
+   }
+   unsigned GetNodeCount() const {
+      return this->NodeCount_;
+   }
+   bool IsArenaMem(const void* mem) const {
+      return this->GetOffset(mem) < this->ReservedSize_;
+   }
+   /// mem 必須是 IsArenaMem(mem) == true;
+   unsigned GetNodeId(const void* mem) const {
+      return static_cast<unsigned>(this->GetOffset(mem) / this->SizePerNode_);
+   }
+   /// 取得目前 thread 所在的 NUMA node, 若超過 GetNodeCount() 則傳回 0.
+   unsigned GetThisThreadNodeId() const;
+
+   /// 從 nodeId 取出 lvidx 的區塊, 直到 fmlist.size() >= maxNodeCount 或 arena 已用盡.
+   void Alloc(unsigned nodeId, unsigned lvidx, FreeMemList& fmlist, size_t maxNodeCount);
+   /// 從 nodeId 取出一個 lvidx 的區塊, arena 已用盡則傳回 nullptr.
+   byte* Alloc(unsigned nodeId, unsigned lvidx);
+   /// 將 mem 放回所屬 node 的 free list.
+   void Free(void* mem);
+};
+fon9_WARN_POP;
+
+//--------------------------------------------------------------------------//
+
 enum class TCacheLevelFlag {
    Registered = 0x01,
 };
 fon9_ENABLE_ENUM_BITWISE_OP(TCacheLevelFlag);
 
+/// TCache 每個 level 的統計.
+/// 只有所屬的 thread 會更新(所以不用 lock 指令), 其他 thread(例: seed::MemBlockTree) 僅讀取.
+struct TCacheLevelStat {
+   fon9_NON_COPY_NON_MOVE(TCacheLevelStat);
+   TCacheLevelStat() = default;
+   /// 取得區塊的次數.
+   std::atomic<uint64_t>   AllocCount_{0};
+   /// TCache 已用完, 從 MemBlockCenter 取得一個串列的次數.
+   std::atomic<uint64_t>   CenterCount_{0};
+   /// MemBlockCenter 也沒有, 改用 malloc()(或 arena) 的次數.
+   std::atomic<uint64_t>   EmptyCount_{0};
+   /// 在此 thread 歸還區塊的次數(可能是其他 thread 取得的).
+   std::atomic<uint64_t>   FreeCount_{0};
+   /// TCache 目前保留的區塊數量.
+   std::atomic<uint64_t>   HeldCount_{0};
+
+   static void Inc(std::atomic<uint64_t>& counter) {
+      counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+   }
+};
+
 fon9_WARN_DISABLE_PADDING;
 struct TCacheLevelPool {
    fon9_NON_COPY_NON_MOVE(TCacheLevelPool);
    TCacheLevelPool() = default;
    FreeMemList       FreeMemCurr_;
    FreeMemList       FreeMemNext_;
-   size_t            EmptyCount_{0};
+   TCacheLevelStat   Stat_;
    TCacheLevelFlag   Flags_{};
+
+   void UpdateHeldCount() {
+      this->Stat_.HeldCount_.store(this->FreeMemCurr_.size() + this->FreeMemNext_.size(), std::memory_order_relaxed);
+   }
 };
 using TCacheLevelPools = std::array<TCacheLevelPool, kMemBlockLevelCount>;
 
 //--------------------------------------------------------------------------//
 
+struct MemBlockLevelStat;
+
 class MemBlockCenter : public intrusive_ref_counter<MemBlockCenter> {
    fon9_NON_COPY_NON_MOVE(MemBlockCenter);
    class CenterLevelNode : private FreeMemNode {
@@ -134,23 +291,89 @@ class MemBlockCenter : public intrusive_ref_counter<MemBlockCenter> {
 
    using CenterLevelArray = std::array<CenterLevel, kMemBlockLevelCount>;
    CenterLevelArray  Levels_;
+   /// arena 模式時, 此 center 所屬的 NUMA node.
+   const unsigned    NodeId_;
 
    static void EmitOnTimer(TimerEntry* timer, TimeStamp now);
    DataMemberEmitOnTimer<&MemBlockCenter::EmitOnTimer> Timer_;
 
    void InitLevel(unsigned lvidx, CenterLevel::Locker& lvCenter);
 public:
-   MemBlockCenter();
+   MemBlockCenter(unsigned nodeId);
    ~MemBlockCenter();
 
+   unsigned GetNodeId() const {
+      return this->NodeId_;
+   }
+
    byte* Alloc(unsigned lvidx, TCacheLevelPool& lv);
    void FreeFull(unsigned lvidx, FreeMemList&& fmlist);
    void Recycle(TCacheLevelPools& levels);
    void InitLevel(unsigned lvidx, const size_t* reserveFreeListCount);
+   /// 將此 center 的 lvidx 狀態累加到 stat.
+   void AddLevelStat(unsigned lvidx, MemBlockLevelStat& stat);
 };
 fon9_WARN_POP;
 
 fon9_API bool MemBlockInit(MemBlockSize size, size_t reserveFreeListCount, size_t maxNodeCount);
+
+//--------------------------------------------------------------------------//
+
+/// \ingroup Buffer
+/// MemBlock 某個 level 的統計, 包含已結束的 thread.
+/// 可用來評估 MemBlockInit() 的保留數量: 若 EmptyCount_ 持續增加, 表示保留量不足.
+struct MemBlockLevelStat {
+   MemBlockSize   BlockSize_;
+   /// 取得區塊的次數.
+   uint64_t       AllocCount_;
+   /// 直接從 TCache 取得的次數.
+   uint64_t       HitCount_;
+   /// TCache 用完, 從 MemBlockCenter 取得一個串列的次數.
+   uint64_t       CenterCount_;
+   /// MemBlockCenter 也用完, 改用 malloc()(或 arena) 的次數.
+   uint64_t       EmptyCount_;
+   /// 歸還區塊的次數.
+   uint64_t       FreeCount_;
+   /// 使用中的區塊數量 = AllocCount_ - FreeCount_;
+   uint64_t       InUseCount_;
+   /// InUseCount_ 的最大值: 在 MemBlockCenter 定時檢查時, 及每次 MemBlockGetLevelStats() 時更新.
+   uint64_t       InUseHighWater_;
+   /// 全部 thread 的 TCache 保留的區塊數量.
+   uint64_t       TCacheHeldCount_;
+   /// 全部 MemBlockCenter 保留的串列數量.
+   uint64_t       CenterReservedLists_;
+   /// MemBlockInit() 設定的最少保留串列數量(全部 MemBlockCenter 的合計).
+   uint64_t       CenterReservedCount_;
+   /// 使用此 level 的 thread 數量, 每個 thread 會要求 MemBlockCenter 多保留一個串列.
+   uint64_t       CenterRequiredCount_;
+   /// 每個串列最多的區塊數量.
+   uint64_t       MaxNodeCount_;
+};
+using MemBlockLevelStats = std::array<MemBlockLevelStat, kMemBlockLevelCount>;
+/// \ingroup Buffer
+/// 取得各 level 的統計.
+fon9_API void MemBlockGetLevelStats(MemBlockLevelStats& stats);
+
+/// \ingroup Buffer
+/// 一個 thread 在某個 level 的統計.
+struct MemBlockThreadLevelStat {
+   uint64_t AllocCount_;
+   uint64_t CenterCount_;
+   uint64_t EmptyCount_;
+   uint64_t FreeCount_;
+   uint64_t HeldCount_;
+};
+/// \ingroup Buffer
+/// 一個(尚未結束的) thread 的統計.
+struct MemBlockThreadStat {
+   ThreadId::IdType  ThreadId_;
+   unsigned          NodeId_;
+   std::array<MemBlockThreadLevelStat, kMemBlockLevelCount> Levels_;
+};
+using MemBlockThreadStats = std::vector<MemBlockThreadStat>;
+/// \ingroup Buffer
+/// 取得有使用 MemBlock 且尚未結束的 threads 統計, 依照 ThreadId_ 排序.
+fon9_API void MemBlockGetThreadStats(MemBlockThreadStats& stats);
 } // namespace impl
 } // namespace fon9
 #endif//__fon9_buffer_MemBlockImpl_hpp__
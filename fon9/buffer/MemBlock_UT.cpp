@@ -3,6 +3,7 @@
 #include "fon9/buffer/MemBlockImpl.hpp"
 #include "fon9/MessageQueue.hpp"
 #include "fon9/TestTools.hpp"
+#include "fon9/buffer/RevBuffer.hpp"
 
 //--------------------------------------------------------------------------//
 
@@ -126,10 +127,124 @@ fon9_WARN_POP;
 
 //--------------------------------------------------------------------------//
 
-int main() {
+/// arena 模式: 每個 level 分配的記憶體, 都必須來自 arena; 歸還後可再次取得.
+void TestArena() {
+   std::cout << "[TEST ] MemBlockArena";
+   for (unsigned lvidx = 0; lvidx < fon9::kMemBlockLevelCount; ++lvidx) {
+      std::vector<fon9::MemBlock> blks(1000);
+      for (fon9::MemBlock& blk : blks) {
+         blk.Alloc(fon9::MemBlockLevelSize_[lvidx]);
+         if (!fon9::impl::IsMemBlockArenaMem(blk.begin())) {
+            std::cout << "|size=" << fon9::MemBlockLevelSize_[lvidx] << "|not arena mem\r[ERROR]" << std::endl;
+            abort();
+         }
+         memset(blk.begin(), static_cast<int>(lvidx), blk.size());
+      }
+      // 在其他 thread 歸還.
+      std::thread{[&blks]() { blks.clear(); }}.join();
+   }
+   // 多個 thread 同時取得同一個 level 的區塊: 會同時需要新的 slab(在 lock 之外 commit),
+   // 每個區塊都必須來自 arena, 且不可重複.
+   const unsigned kThrCount = 4;
+   std::vector<std::vector<fon9::MemBlock>> thrBlks(kThrCount);
+   std::vector<std::thread> thrs;
+   for (unsigned thrIdx = 0; thrIdx < kThrCount; ++thrIdx) {
+      thrs.emplace_back([&thrBlks, thrIdx]() {
+         std::vector<fon9::MemBlock>& blks = thrBlks[thrIdx];
+         blks.resize(1024 * 8);
+         for (fon9::MemBlock& blk : blks) {
+            blk.Alloc(1024);
+            memset(blk.begin(), static_cast<int>(thrIdx), blk.size());
+         }
+      });
+   }
+   for (std::thread& thr : thrs)
+      thr.join();
+   for (unsigned thrIdx = 0; thrIdx < kThrCount; ++thrIdx) {
+      for (fon9::MemBlock& blk : thrBlks[thrIdx]) {
+         if (!fon9::impl::IsMemBlockArenaMem(blk.begin())
+             || blk.begin()[0] != thrIdx || blk.begin()[blk.size() - 1] != thrIdx) {
+            std::cout << "|threads|size=" << blk.size() << "|not arena mem or overlapped\r[ERROR]" << std::endl;
+            abort();
+         }
+      }
+   }
+   std::cout << "\r[OK   ]" << std::endl;
+}
+
+//--------------------------------------------------------------------------//
+
+/// 在一個新的 thread 取得 kCount 個 512B 區塊, 檢查 MemBlockGetLevelStats(), MemBlockGetThreadStats() 的結果.
+void TestStats() {
+   std::cout << "[TEST ] MemBlockStats";
+   static const unsigned   kCount = 100;
+   static const unsigned   kLvIdx = 2;
+   fon9::impl::MemBlockLevelStats before, after;
+   fon9::impl::MemBlockGetLevelStats(before);
+   std::thread{[&before]() {
+      std::vector<fon9::MemBlock> blks(kCount);
+      for (fon9::MemBlock& blk : blks)
+         blk.Alloc(fon9::MemBlockLevelSize_[kLvIdx]);
+      fon9::impl::MemBlockLevelStats   lvstats;
+      fon9::impl::MemBlockGetLevelStats(lvstats);
+      if (lvstats[kLvIdx].InUseCount_ < before[kLvIdx].InUseCount_ + kCount
+          || lvstats[kLvIdx].InUseHighWater_ < lvstats[kLvIdx].InUseCount_) {
+         std::cout << "|InUse=" << lvstats[kLvIdx].InUseCount_ << "|HighWater=" << lvstats[kLvIdx].InUseHighWater_ << "\r[ERROR]" << std::endl;
+         abort();
+      }
+      blks.clear();
+      fon9::impl::MemBlockThreadStats  thrstats;
+      fon9::impl::MemBlockGetThreadStats(thrstats);
+      const auto thrId = fon9::GetThisThreadId().ThreadId_;
+      auto ifind = std::find_if(thrstats.begin(), thrstats.end(), [thrId](const fon9::impl::MemBlockThreadStat& st) {
+         return st.ThreadId_ == thrId;
+      });
+      if (ifind == thrstats.end()) {
+         std::cout << "|ThreadId=" << thrId << "|not found\r[ERROR]" << std::endl;
+         abort();
+      }
+      const fon9::impl::MemBlockThreadLevelStat& lv = ifind->Levels_[kLvIdx];
+      if (lv.AllocCount_ != kCount || lv.FreeCount_ != kCount || lv.HeldCount_ == 0
+          || lv.CenterCount_ + lv.EmptyCount_ == 0) {
+         std::cout << "|Alloc=" << lv.AllocCount_ << "|Free=" << lv.FreeCount_ << "|Held=" << lv.HeldCount_
+            << "|Center=" << lv.CenterCount_ << "|Empty=" << lv.EmptyCount_ << "\r[ERROR]" << std::endl;
+         abort();
+      }
+   }}.join();
+   // thread 結束後, 統計會累加到 [已結束的 threads].
+   fon9::impl::MemBlockGetLevelStats(after);
+   if (after[kLvIdx].AllocCount_ < before[kLvIdx].AllocCount_ + kCount
+       || after[kLvIdx].FreeCount_ < before[kLvIdx].FreeCount_ + kCount
+       || after[kLvIdx].InUseHighWater_ < before[kLvIdx].InUseCount_ + kCount) {
+      std::cout << "|Alloc=" << after[kLvIdx].AllocCount_ << "|Free=" << after[kLvIdx].FreeCount_
+         << "|HighWater=" << after[kLvIdx].InUseHighWater_ << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   std::cout << "|InUseHighWater=" << after[kLvIdx].InUseHighWater_ << "\r[OK   ]" << std::endl;
+}
+
+//--------------------------------------------------------------------------//
+
+int main(int argc, char** argv) {
 #if defined(_MSC_VER) && defined(_DEBUG)
    _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 #endif
+   // argv[1] = MemBlockArenaArgs, 例: "HugePage=TLB|SlabSize=2M|MaxSizePerNode=1G"
+   // 必須在第一次使用 MemBlock 之前啟用 arena.
+   const bool isArena = (argc > 1);
+   if (isArena) {
+      fon9::impl::MemBlockArenaArgs args;
+      fon9::RevBufferFixedSize<1024> rbuf;
+      rbuf.RewindEOS();
+      if (!fon9::ParseConfig(args, fon9::StrView_cstr(argv[1]), rbuf)) {
+         std::cout << "MemBlockArenaArgs|err=" << rbuf.GetCurrent() << std::endl;
+         return 1;
+      }
+      if (!fon9::impl::MemBlockInitArena(args)) {
+         std::cout << "MemBlockInitArena|err=fail" << std::endl;
+         return 1;
+      }
+   }
    fon9::AutoPrintTestInfo utinfo{"Buffer"};
    std::cout << "MemBlock 測試說明:\n"
                 "1.MemBlock不是用來取代malloc(), 所以這裡速度的比較意義不大.\n"
@@ -165,6 +280,13 @@ int main() {
       }
    }
 
+   if (isArena) {
+      utinfo.PrintSplitter();
+      TestArena();
+   }
+   utinfo.PrintSplitter();
+   TestStats();
+
    utinfo.PrintSplitter();
    static const unsigned   kTimes = 1000 * 1000;
 
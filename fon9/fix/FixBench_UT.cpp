@@ -0,0 +1,397 @@
+﻿// \file fon9/fix/FixBench_UT.cpp
+// \author fonwinz@gmail.com
+#define _CRT_SECURE_NO_WARNINGS
+#include "fon9/TestTools.hpp"
+#include "fon9/fix/IoFixSession.hpp"
+#include "fon9/fix/IoFixSender.hpp"
+#include "fon9/fix/FixAdminMsg.hpp"
+#include "fon9/fix/FixApDef.hpp"
+#include "fon9/io/SimpleManager.hpp"
+#include "fon9/io/Server.hpp"
+#include "fon9/LatencyHistogram.hpp"
+#include "fon9/DefaultThreadPool.hpp"
+#include "fon9/StrTo.hpp"
+
+#ifdef fon9_WINDOWS
+#include "fon9/io/win/IocpTcpClient.hpp"
+#include "fon9/io/win/IocpTcpServer.hpp"
+using IoService = fon9::io::IocpService;
+using IoServiceSP = fon9::io::IocpServiceSP;
+using TcpClient = fon9::io::IocpTcpClient;
+using TcpServer = fon9::io::IocpTcpServer;
+#else
+#include "fon9/io/FdrTcpClient.hpp"
+#include "fon9/io/FdrTcpServer.hpp"
+#include "fon9/io/FdrServiceEpoll.hpp"
+using IoService = fon9::io::FdrServiceEpoll;
+using IoServiceSP = fon9::io::FdrServiceSP;
+using TcpClient = fon9::io::FdrTcpClient;
+using TcpServer = fon9::io::FdrTcpServer;
+#endif
+
+// FIX 效能量測, 用來比較調整前後的差異(例: FixRecorder 的寫檔方式、IoService 的參數).
+// - Parse/Build/Send+Record/RecvRecord: 在單一 thread 逐筆量測, 每筆耗時包含一次取時間的負擔(參考 "Clock" 的結果).
+// - RoundTrip: 在 loopback 建立一組 IoFixSession(Initiator + Acceptor),
+//   Initiator 送出 NewOrderSingle, Acceptor 收到後立即回覆 ExecutionReport,
+//   Initiator 收到 ExecutionReport 時, 計算從「送出時間」到收到回報的耗時.
+//   - rate=0: 收到回報後才送下一筆(pingpong), 送出時間為實際送出的時間.
+//   - rate>0: 依固定速率送出(不等回報), 送出時間為「預定送出時間」,
+//     若送出端落後, 落後的時間也會計入, 避免低估高負載時的延遲.
+// - 每項結果列出: 耗時分布(p50/p99/p999, 2 的 n 次方 ns 分級) 及 throughput.
+// - FixRecorder 的寫檔方式由 "RecorderArgs" 指定(參考 FixRecorderArgs), 寫入後列出寫檔的統計資料.
+
+namespace f9fix = fon9::fix;
+
+static f9fix::FixRecorderArgs RecorderArgs_;
+
+static void PrintWriteStats(f9fix::FixRecorder& fixr) {
+   const f9fix::FixRecorderWriteStats st = fixr.GetWriteStats();
+   std::cout << "   rec:  mode=" << f9fix::FixRecorderWriteModeToStr(st.Mode_).ToString()
+             << "|queuing=" << st.QueuingNodeCount_ << ',' << st.QueuingBytes_
+             << "|syncTimes=" << st.SyncTimes_
+             << "|lastSync=" << fon9::RevPrintTo<std::string>(st.LastSyncLatency_) << std::endl;
+}
+
+static inline uint64_t NowNs() {
+   return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static void PrintBenchResult(const char* name, double span, uint64_t count, const fon9::LatencyHistogram& hist) {
+   fon9::StopWatch::PrintResultNoEOL(span, name, count)
+      << "|msgs/sec=" << static_cast<uint64_t>(static_cast<double>(count) / span) << std::endl;
+   std::cout << "   lat:  " << fon9::RevPrintTo<std::string>(hist) << std::endl;
+}
+
+template <class FnT>
+void BenchOp(const char* name, uint64_t count, FnT&& fn) {
+   fon9::LatencyHistogram hist;
+   fon9::StopWatch        stopWatch;
+   for (uint64_t L = 0; L < count; ++L) {
+      const uint64_t t0 = NowNs();
+      fn(L);
+      hist.Add(NowNs() - t0);
+   }
+   PrintBenchResult(name, stopWatch.StopTimer(), count, hist);
+}
+
+/// NewOrderSingle 的 AP 欄位, ClOrdID = idx.
+static void RevPrintNewOrderSingle(f9fix::FixBuilder& fixb, uint64_t idx) {
+   fixb.PutUtcNow();
+   fon9::RevPrint(fixb.GetBuffer(),
+                  f9fix_SPLTAGEQ(ClOrdID), idx,
+                  f9fix_SPLTAGEQ(Symbol) "2330"
+                  f9fix_SPLTAGEQ(Side) "1"
+                  f9fix_SPLTAGEQ(OrderQty) "1000"
+                  f9fix_SPLTAGEQ(OrdType) "2"
+                  f9fix_SPLTAGEQ(Price) "512.5"
+                  f9fix_SPLTAGEQ(TransactTime));
+}
+/// 與 FixSender::Send() 相同的方式填入 header, 然後 Final().
+static fon9::BufferList FinalNewOrderSingle(f9fix::FixBuilder& fixb, const f9fix::CompIDs& compIds, f9fix::FixSeqNum seq) {
+   fon9::RevBuffer& rbuf = fixb.GetBuffer();
+   fon9::RevPrint(rbuf, compIds.Header_);
+   fixb.PutUtcNow();
+   fon9::RevPrint(rbuf, f9fix_SPLTAGEQ(SendingTime));
+   fon9::RevPrint(rbuf, f9fix_SPLFLDMSGTYPE(NewOrderSingle), f9fix_SPLTAGEQ(MsgSeqNum), seq);
+   return fixb.Final(f9fix_BEGIN_HEADER_V44);
+}
+
+//--------------------------------------------------------------------------//
+
+static const char kFixBenchRecorderFileName[] = "./FixBenchR.log";
+static const char kFixBenchInitiatorRecorderFileName[] = "./FixBenchI.log";
+static const char kFixBenchAcceptorRecorderFileName[] = "./FixBenchA.log";
+
+static void RemoveRecorderFiles() {
+   for (const char* fname : {kFixBenchRecorderFileName, kFixBenchInitiatorRecorderFileName, kFixBenchAcceptorRecorderFileName}) {
+      std::remove(fname);
+      std::remove((std::string{fname} + ".sidx").c_str());
+   }
+}
+
+void BenchOffline(uint64_t count) {
+   const f9fix::CompIDs compIds{"IComp", "ISub", "AComp", "ASub"};
+   f9fix::FixBuilder    fixb;
+   RevPrintNewOrderSingle(fixb, 1);
+   const std::string    nos = fon9::BufferTo<std::string>(FinalNewOrderSingle(fixb, compIds, 1));
+
+   BenchOp("Clock     ", count, [](uint64_t) {});
+
+   f9fix::FixParser fixpr;
+   BenchOp("Parse     ", count, [&fixpr, &nos](uint64_t) {
+      fon9::StrView fixmsg{&nos};
+      if (fixpr.Parse(fixmsg) <= f9fix::FixParser::NeedsMore) {
+         std::cout << "[ERROR] Parse()" << std::endl;
+         abort();
+      }
+   });
+
+   BenchOp("Build     ", count, [&compIds](uint64_t L) {
+      f9fix::FixBuilder fixmsg;
+      RevPrintNewOrderSingle(fixmsg, L);
+      FinalNewOrderSingle(fixmsg, compIds, static_cast<f9fix::FixSeqNum>(L + 1));
+   });
+
+   // 沒有設定 Device, 所以 Send() 只有: 建立訊息 + 寫入 FixRecorder.
+   f9fix::IoFixSenderSP fixout{new f9fix::IoFixSender{f9fix_BEGIN_HEADER_V44, f9fix::CompIDs{compIds}}};
+   fixout->GetFixRecorder().Initialize(kFixBenchRecorderFileName, RecorderArgs_);
+   BenchOp("Send+Rec  ", count, [&fixout](uint64_t L) {
+      f9fix::FixBuilder fixmsg;
+      RevPrintNewOrderSingle(fixmsg, L);
+      fixout->Send(f9fix_SPLFLDMSGTYPE(NewOrderSingle), std::move(fixmsg));
+   });
+   f9fix::FixRecorder& fixr = fixout->GetFixRecorder();
+   PrintWriteStats(fixr);
+   BenchOp("RecvRecord", count, [&fixr, &nos](uint64_t) {
+      fixr.WriteInputConform(&nos);
+   });
+   PrintWriteStats(fixr);
+}
+
+//--------------------------------------------------------------------------//
+
+fon9_WARN_DISABLE_PADDING;
+/// 量測 RoundTrip 的狀態.
+/// - StartNs_ 由送出端(main thread)填入;
+/// - 其餘由 Initiator 的接收 thread 更新, RecvCount_ 增加之後, main thread 才可讀取.
+struct RoundTripState {
+   std::vector<uint64_t>   StartNs_;
+   uint64_t                LastRecvNs_{0};
+   std::atomic<uint64_t>   RecvCount_{0};
+   fon9::LatencyHistogram  RttHist_;
+
+   void Reset(uint64_t count) {
+      this->StartNs_.assign(count, 0);
+      this->LastRecvNs_ = 0;
+      this->RttHist_.Clear();
+      this->RecvCount_.store(0, std::memory_order_release);
+   }
+   void OnRecvExecutionReport(const f9fix::FixRecvEvArgs& rxargs) {
+      const uint64_t now = NowNs();
+      const f9fix::FixParser::FixField* fldClOrdID = rxargs.Msg_.GetField(f9fix_kTAG_ClOrdID);
+      const uint64_t idx = fldClOrdID ? fon9::StrTo(fldClOrdID->Value_, static_cast<uint64_t>(0)) : this->StartNs_.size();
+      if (idx >= this->StartNs_.size()) {
+         std::cout << "[ERROR] Unknown ExecutionReport: " << rxargs.MsgStr_.ToString() << std::endl;
+         abort();
+      }
+      this->RttHist_.Add(now - this->StartNs_[idx]);
+      this->LastRecvNs_ = now;
+      this->RecvCount_.fetch_add(1, std::memory_order_release);
+   }
+};
+static RoundTripState   RoundTrip_;
+
+/// Acceptor 收到 NewOrderSingle, 立即回覆 ExecutionReport(New).
+static void OnRecvNewOrderSingle(const f9fix::FixRecvEvArgs& rxargs) {
+   const f9fix::FixParser::FixField* fldClOrdID = rxargs.Msg_.GetField(f9fix_kTAG_ClOrdID);
+   const fon9::StrView               clOrdID = fldClOrdID ? fldClOrdID->Value_ : fon9::StrView{};
+   f9fix::FixBuilder                 fixb;
+   fon9::RevPrint(fixb.GetBuffer(),
+                  f9fix_SPLTAGEQ(OrderID), clOrdID,
+                  f9fix_SPLTAGEQ(ExecID), clOrdID,
+                  f9fix_SPLTAGEQ(ClOrdID), clOrdID,
+                  f9fix_SPLTAGEQ(ExecType) f9fix_kVAL_ExecType_New
+                  f9fix_SPLTAGEQ(OrdStatus) f9fix_kVAL_OrdStatus_New
+                  f9fix_SPLTAGEQ(Symbol) "2330"
+                  f9fix_SPLTAGEQ(Side) "1"
+                  f9fix_SPLTAGEQ(LeavesQty) "1000"
+                  f9fix_SPLTAGEQ(CumQty) "0"
+                  f9fix_SPLTAGEQ(AvgPx) "0");
+   rxargs.FixSender_->Send(f9fix_SPLFLDMSGTYPE(ExecutionReport), std::move(fixb));
+}
+
+static const uint32_t kHeartBtInt = 30;
+
+struct FixBenchMgr : public f9fix::IoFixManager {
+   fon9_NON_COPY_NON_MOVE(FixBenchMgr);
+   const bool           IsInitiator_;
+   f9fix::IoFixSenderSP FixOut_;
+   f9fix::FixConfig     FixConfig_;
+   std::atomic<bool>    IsApReady_{false};
+
+   FixBenchMgr(bool isInitiator) : IsInitiator_{isInitiator} {
+      if (isInitiator) {
+         this->FixOut_.reset(new f9fix::IoFixSender{f9fix_BEGIN_HEADER_V44, f9fix::CompIDs{"IComp", "ISub", "AComp", "ASub"}});
+         this->FixOut_->GetFixRecorder().Initialize(kFixBenchInitiatorRecorderFileName, RecorderArgs_);
+      }
+      else {
+         this->FixOut_.reset(new f9fix::IoFixSender{f9fix_BEGIN_HEADER_V44, f9fix::CompIDs{"AComp", "ASub", "IComp", "ISub"}});
+         this->FixOut_->GetFixRecorder().Initialize(kFixBenchAcceptorRecorderFileName, RecorderArgs_);
+      }
+      f9fix::FixSession::InitFixConfig(this->FixConfig_);
+      if (isInitiator)
+         this->FixConfig_.Fetch(f9fix_kMSGTYPE_ExecutionReport).FixMsgHandler_ = [](const f9fix::FixRecvEvArgs& rxargs) {
+            RoundTrip_.OnRecvExecutionReport(rxargs);
+         };
+      else
+         this->FixConfig_.Fetch(f9fix_kMSGTYPE_NewOrderSingle).FixMsgHandler_ = &OnRecvNewOrderSingle;
+   }
+
+   void OnFixSessionDisconnected(f9fix::IoFixSession&, f9fix::FixSenderSP&& fixout) override {
+      if (f9fix::IoFixSender* devout = dynamic_cast<f9fix::IoFixSender*>(fixout.get()))
+         devout->OnFixSessionDisconnected();
+   }
+   void OnFixSessionConnected(f9fix::IoFixSession& fixses) override {
+      if (this->IsInitiator_) {
+         f9fix::FixBuilder fixb;
+         fon9::RevPrint(fixb.GetBuffer(), f9fix_kFLD_EncryptMethod_None);
+         this->FixOut_->OnFixSessionConnected(fixses.GetDevice());
+         this->OnLogonInitiate(fixses, kHeartBtInt, std::move(fixb), this->FixOut_);
+      }
+   }
+   void OnRecvLogonRequest(f9fix::FixRecvEvArgs& rxargs) override {
+      if (this->FixOut_->GetFixRecorder().CompIDs_.Check(rxargs.Msg_) != 0) {
+         rxargs.FixSession_->SendLogout(fon9::StrView{"Bad Logon, CompID problem."});
+         return;
+      }
+      this->FixOut_->OnFixSessionConnected(static_cast<f9fix::IoFixSession*>(rxargs.FixSession_)->GetDevice());
+      if (!this->OnLogonAccepted(rxargs, this->FixOut_))
+         this->FixOut_->OnFixSessionDisconnected();
+   }
+   void OnFixSessionApReady(f9fix::IoFixSession&) override {
+      this->IsApReady_ = true;
+   }
+};
+
+/// TcpServer 收到新的連線時, 建立 Acceptor 的 IoFixSession.
+struct FixBenchServer : public fon9::io::SessionServer {
+   fon9_NON_COPY_NON_MOVE(FixBenchServer);
+   FixBenchMgr& FixMgr_;
+   FixBenchServer(FixBenchMgr& mgr) : FixMgr_(mgr) {
+   }
+   fon9::io::SessionSP OnDevice_Accepted(fon9::io::DeviceServer&) override {
+      return fon9::io::SessionSP{new f9fix::IoFixSession{this->FixMgr_, this->FixMgr_.FixConfig_}};
+   }
+};
+fon9_WARN_POP;
+
+static bool WaitFor(const std::function<bool()>& pred, unsigned secs) {
+   const auto until = std::chrono::steady_clock::now() + std::chrono::seconds{secs};
+   while (!pred()) {
+      if (std::chrono::steady_clock::now() > until)
+         return false;
+      std::this_thread::yield();
+   }
+   return true;
+}
+
+void RunRoundTrip(f9fix::IoFixSender& fixout, uint64_t count, uint64_t rate) {
+   RoundTripState& rt = RoundTrip_;
+   rt.Reset(count);
+   const uint64_t intervalNs = (rate ? (1000000000 / rate) : 0);
+   const uint64_t startNs = NowNs();
+   for (uint64_t L = 0; L < count; ++L) {
+      uint64_t sendNs;
+      if (intervalNs) {
+         sendNs = startNs + L * intervalNs;
+         while (NowNs() < sendNs)
+            std::this_thread::yield();
+      }
+      else {
+         while (rt.RecvCount_.load(std::memory_order_acquire) < L)
+            std::this_thread::yield();
+         sendNs = NowNs();
+      }
+      rt.StartNs_[L] = sendNs;
+      f9fix::FixBuilder fixb;
+      RevPrintNewOrderSingle(fixb, L);
+      fixout.Send(f9fix_SPLFLDMSGTYPE(NewOrderSingle), std::move(fixb));
+   }
+   if (!WaitFor([&rt, count]() { return rt.RecvCount_.load(std::memory_order_acquire) >= count; }, 30)) {
+      std::cout << "[ERROR] RoundTrip timeout|recv=" << rt.RecvCount_.load() << "|expected=" << count << std::endl;
+      abort();
+   }
+   char name[64];
+   snprintf(name, sizeof(name), "RoundTrip |rate=%-7u", static_cast<unsigned>(rate));
+   PrintBenchResult(name, static_cast<double>(rt.LastRecvNs_ - startNs) / 1e9, count, rt.RttHist_);
+   PrintWriteStats(fixout.GetFixRecorder());
+}
+
+void BenchRoundTrip(IoServiceSP iosv, unsigned port, uint64_t count, fon9::StrView rates) {
+   FixBenchMgr          acceptorMgr{false};
+   FixBenchMgr          initiatorMgr{true};
+   fon9::io::ManagerCSP ioMgr{new fon9::io::SimpleManager{}};
+   fon9::io::DeviceSP   srv{new TcpServer(iosv, new FixBenchServer{acceptorMgr}, ioMgr)};
+   srv->Initialize();
+   srv->AsyncOpen(fon9::RevPrintTo<std::string>(port));
+   srv->WaitGetDeviceId();
+
+   f9fix::IoFixSessionSP initiator{new f9fix::IoFixSession{initiatorMgr, initiatorMgr.FixConfig_}};
+   fon9::io::DeviceSP    cli{new TcpClient(iosv, initiator, ioMgr)};
+   cli->Initialize();
+   cli->AsyncOpen(fon9::RevPrintTo<std::string>("127.0.0.1:", port));
+   if (!WaitFor([&initiatorMgr]() { return initiatorMgr.IsApReady_.load(); }, 10)) {
+      std::cout << "[ERROR] FixSession not ApReady|port=" << port << std::endl;
+      abort();
+   }
+   while (!rates.empty()) {
+      fon9::StrView rate = fon9::StrFetchTrim(rates, ',');
+      if (!rate.empty())
+         RunRoundTrip(*initiatorMgr.FixOut_, count, fon9::StrTo(rate, static_cast<uint64_t>(0)));
+   }
+   cli->AsyncDispose("quit");
+   cli->WaitGetDeviceId();
+   srv->AsyncDispose("quit");
+   srv->WaitGetDeviceId();
+   initiator.reset();
+   // 等候 Device 相關的工作結束.
+   std::this_thread::sleep_for(std::chrono::milliseconds{100});
+}
+
+//--------------------------------------------------------------------------//
+
+int main(int argc, char** argv) {
+#if defined(_MSC_VER) && defined(_DEBUG)
+   _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
+#endif
+   fon9::AutoPrintTestInfo utinfo{"FixBench"};
+   // argv: [count] [roundTripCount] [rates] [port] ["IoServiceArgs"] ["RecorderArgs"]
+   uint64_t       count = (argc > 1 ? fon9::StrTo(fon9::StrView_cstr(argv[1]), static_cast<uint64_t>(0)) : 0u);
+   uint64_t       rtCount = (argc > 2 ? fon9::StrTo(fon9::StrView_cstr(argv[2]), static_cast<uint64_t>(0)) : 0u);
+   fon9::StrView  rates = (argc > 3 ? fon9::StrView_cstr(argv[3]) : fon9::StrView{"0,10000,50000"});
+   unsigned       port = (argc > 4 ? fon9::StrTo(fon9::StrView_cstr(argv[4]), 0u) : 0u);
+   fon9::StrView  iosvCfg = (argc > 5 ? fon9::StrView_cstr(argv[5]) : fon9::StrView{"ThreadCount=1|Wait=Block"});
+   fon9::StrView  recCfg = (argc > 6 ? fon9::StrView_cstr(argv[6]) : fon9::StrView{"Mode=Async"});
+   if (count <= 0)
+      count = 100 * 1000;
+   if (rtCount <= 0)
+      rtCount = 20 * 1000;
+   if (port <= 0)
+      port = 19300;
+   std::cout << "count=" << count << "|roundTripCount=" << rtCount << "|rates=" << rates.ToString()
+             << "|port=" << port << "|IoServiceArgs=" << iosvCfg.ToString()
+             << "|RecorderArgs=" << recCfg.ToString() << std::endl;
+   fon9::RevBufferList rbuf{128};
+   if (!fon9::ParseConfig(RecorderArgs_, recCfg, rbuf)) {
+      std::cout << "[ERROR] RecorderArgs.Parse|" << fon9::BufferTo<std::string>(rbuf.MoveOut()) << std::endl;
+      return 3;
+   }
+
+   fon9::LogLevel_ = fon9::LogLevel::Warn;
+   fon9::GetDefaultTimerThread();
+   fon9::GetDefaultThreadPool();
+   std::this_thread::sleep_for(std::chrono::milliseconds{10});
+   RemoveRecorderFiles();
+
+   BenchOffline(count);
+
+   utinfo.PrintSplitter();
+   fon9::io::IoServiceArgs iosvArgs;
+   if (!fon9::ParseConfig(iosvArgs, iosvCfg, rbuf)) {
+      std::cout << "[ERROR] IoServiceArgs.Parse|" << fon9::BufferTo<std::string>(rbuf.MoveOut()) << std::endl;
+      return 3;
+   }
+   IoService::MakeResult err;
+#ifdef fon9_WINDOWS
+   IoServiceSP iosv = IoService::MakeService(iosvArgs, "FixBench", err);
+#else
+   IoServiceSP iosv = fon9::io::MakeDefaultFdrService(iosvArgs, "FixBench", err);
+#endif
+   if (!iosv) {
+      std::cout << "[ERROR] IoService.MakeService|" << fon9::RevPrintTo<std::string>(err) << std::endl;
+      return 3;
+   }
+   BenchRoundTrip(iosv, port, rtCount, rates);
+   RemoveRecorderFiles();
+}
@@ -2,7 +2,8 @@
 /// \author fonwinz@gmail.com
 #ifndef __fon9_fix_FixConfig_hpp__
 #define __fon9_fix_FixConfig_hpp__
-#include "fon9/fix/FixBase.hpp"
+#include "fon9/fix/FixInterestTags.hpp"
+#include "fon9/fix/FixRecorderArgs.hpp"
 #include "fon9/TimeStamp.hpp"
 #include "fon9/StrTools.hpp"
 #include "fon9/SortedVector.hpp"
@@ -44,6 +45,9 @@ struct FixRecvEvArgs {
    FixParser&  Msg_;
    /// FIX Message.
    StrView     MsgStr_;
+   /// 收到此訊息的時間, 由 Device 提供(例: "RecvTs=Sw" 的 kernel 接收時間), 可用來計算處理延遲.
+   /// 若 Device 沒有提供, 則為 TimeStamp::Null().
+   TimeStamp   RxTime_{TimeStamp::Null()};
 
    /// 在呼叫 FixMsgHandler 時, 這裡會提供:
    /// - FixSeqSt::Conform 序號符合規範
@@ -98,6 +102,12 @@ struct FixMsgTypeConfig {
    /// 當 FixReceiver 收到 SessionReject or BusinessReject 時.
    /// 根據原訊息的 MsgType 決定後續處理.
    FixRejectHandler  FixRejectHandler_;
+   /// FixMsgHandler_ 需要的欄位, 預設為 empty() 表示需要全部欄位.
+   /// - 例如: ExecutionReport 只需要其中的 10 多個欄位,
+   ///   設定後 FixSession 的 FixParser 只會保留這些欄位(及 Session 需要的 header 欄位),
+   ///   全部出現過之後就結束解析.
+   /// - 如果 FixRejectHandler_ 需要從原訊息取得額外的欄位, 也必須加入.
+   FixInterestTags   InterestTags_;
 };
 
 /// \ingroup fix
@@ -122,6 +132,13 @@ public:
 
    /// 根據 msgType 取得相關設定.
    const FixMsgTypeConfig* Get(StrView msgType) const;
+   /// 根據 msgType 取得 FixMsgTypeConfig::InterestTags_,
+   /// 若沒有設定, 或 InterestTags_.empty(), 則傳回 nullptr.
+   /// 可做為 FixParser::InterestTagsSelector 使用.
+   const FixInterestTags* GetInterestTags(StrView msgType) const {
+      const FixMsgTypeConfig* cfg = this->Get(msgType);
+      return (cfg == nullptr || cfg->InterestTags_.empty()) ? nullptr : &cfg->InterestTags_;
+   }
 
    /// 從 LinkReady 到收到登入訊息, 如果超過此時間, 則斷線.
    TimeInterval   TiWaitForLogon_{TimeInterval_Second(3)};
@@ -150,6 +167,10 @@ public:
    /// 當有 Replay 的需求時(FixSender::Replay), 一律使用 FixSender::GapFill.
    /// 例如: 券商與交易所之間的連線, 券商端斷線後重連, 可能全都不重送.
    bool  IsNoReplay_{false};
+
+   /// 使用此 FixConfig 的 Session, 其 FixRecorder 的寫檔方式.
+   /// 在 FixRecorder::Initialize() 時使用, 之後再調整不會影響已初始化的 FixRecorder.
+   FixRecorderArgs   RecorderArgs_;
 };
 fon9_WARN_POP;
 
@@ -0,0 +1,97 @@
+﻿/// \file fon9/fix/FixInterestTags.hpp
+/// \author fonwinz@gmail.com
+#ifndef __fon9_fix_FixInterestTags_hpp__
+#define __fon9_fix_FixInterestTags_hpp__
+#include "fon9/fix/FixBase.hpp"
+#include "fon9/sys/Config.hpp"
+#include <vector>
+#include <initializer_list>
+
+namespace fon9 { namespace fix {
+
+/// \ingroup fix
+/// 某 MsgType 需要的欄位(預先編譯好的 bitmap), 提供給 FixParser 選擇性解析.
+/// - 不在此集合內的欄位, 解析時僅跳過, 不會放到 FixParser 的欄位表.
+/// - 當 Add() 加入的欄位都出現過了, 就結束解析, 不處理剩餘的欄位.
+///   - 所以若加入的欄位屬於 repeating group, 僅能確保取得第一次出現的值.
+/// - Session 層需要的 header 欄位(MsgSeqNum, MsgType, CompID, SubID, SendingTime, PossDupFlag, OrigSendingTime),
+///   及跳過 RawData 需要的 RawDataLength, 一律保留; 但不列入「是否都出現過」的判斷.
+///   依照 FIX 規範, header 必定在 body 之前, 所以不會因提早結束而遺漏.
+/// - 沒有任何 lock, 通常在系統初始階段設定(例: FixMsgTypeConfig::InterestTags_).
+class FixInterestTags {
+   using Bits = std::vector<uint32_t>;
+   /// 需要保留的欄位.
+   Bits     KeepBits_;
+   /// 透過 Add() 加入的欄位.
+   Bits     AddedBits_;
+   uint32_t AddedCount_{0};
+
+   static bool IsBitOn(const Bits& bits, FixTag tag) {
+      const size_t idx = tag / 32u;
+      return idx < bits.size() && (bits[idx] & (1u << (tag % 32u))) != 0;
+   }
+   static void SetBitOn(Bits& bits, FixTag tag) {
+      const size_t idx = tag / 32u;
+      if (bits.size() <= idx)
+         bits.resize(idx + 1);
+      bits[idx] |= (1u << (tag % 32u));
+   }
+   void SetKeep(FixTag tag) {
+      SetBitOn(this->KeepBits_, tag);
+   }
+
+public:
+   FixInterestTags() = default;
+   FixInterestTags(std::initializer_list<FixTag> tags) {
+      this->Add(tags);
+   }
+
+   void Add(FixTag tag) {
+      if (IsBitOn(this->AddedBits_, tag))
+         return;
+      if (this->AddedCount_ == 0) {
+         this->SetKeep(f9fix_kTAG_MsgSeqNum);
+         this->SetKeep(f9fix_kTAG_MsgType);
+         this->SetKeep(f9fix_kTAG_SenderCompID);
+         this->SetKeep(f9fix_kTAG_SenderSubID);
+         this->SetKeep(f9fix_kTAG_TargetCompID);
+         this->SetKeep(f9fix_kTAG_TargetSubID);
+         this->SetKeep(f9fix_kTAG_SendingTime);
+         this->SetKeep(f9fix_kTAG_PossDupFlag);
+         this->SetKeep(f9fix_kTAG_OrigSendingTime);
+         this->SetKeep(f9fix_kTAG_RawDataLength);
+      }
+      SetBitOn(this->AddedBits_, tag);
+      this->SetKeep(tag);
+      ++this->AddedCount_;
+   }
+   void Add(std::initializer_list<FixTag> tags) {
+      for (FixTag tag : tags)
+         this->Add(tag);
+   }
+   void Clear() {
+      this->KeepBits_.clear();
+      this->AddedBits_.clear();
+      this->AddedCount_ = 0;
+   }
+
+   /// 沒有 Add() 任何欄位, 表示需要全部欄位.
+   bool empty() const {
+      return this->AddedCount_ == 0;
+   }
+   /// 透過 Add() 加入的欄位數量.
+   uint32_t AddedCount() const {
+      return this->AddedCount_;
+   }
+   /// 解析時是否需要保留此欄位.
+   bool IsKeep(FixTag tag) const {
+      return IsBitOn(this->KeepBits_, tag);
+   }
+   /// 是否為透過 Add() 加入的欄位.
+   bool IsAdded(FixTag tag) const {
+      return IsBitOn(this->AddedBits_, tag);
+   }
+};
+
+} } // namespaces
+#endif//__fon9_fix_FixInterestTags_hpp__
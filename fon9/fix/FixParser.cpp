@@ -1,7 +1,9 @@
 ﻿// \file fon9/fix/FixParser.cpp
 // \author fonwinz@gmail.com
 #include "fon9/fix/FixParser.hpp"
+#include "fon9/fix/FixSimd.hpp"
 #include "fon9/StrTo.hpp"
+#include <algorithm>
 
 namespace fon9 { namespace fix {
 
@@ -16,6 +18,8 @@ void FixParser::Clear() {
    this->MsgSeqNum_ = 0;
    this->ExpectSize_ = 0;
    this->MIndexNext_ = 0;
+   this->IndexedBody_.Reset(nullptr);
+   this->InterestTags_ = nullptr;
    if (this->FieldList_.empty())
       return;
    for (FixField* fld : this->FieldList_)
@@ -24,6 +28,9 @@ void FixParser::Clear() {
 }
 
 FixParser::Result FixParser::Verify(StrView& fixmsg, VerifyItem vitem) {
+   return this->VerifyImpl(fixmsg, vitem, false);
+}
+FixParser::Result FixParser::VerifyImpl(StrView& fixmsg, VerifyItem vitem, bool isBuildIndex) {
    const size_t msgsz = fixmsg.size();
    if (this->ExpectSize_ > 0 && msgsz < this->ExpectSize_)
       return NeedsMore;
@@ -81,8 +88,23 @@ FixParser::Result FixParser::Verify(StrView& fixmsg, VerifyItem vitem) {
           || pend[3] != '=')
          return EFormat;
       byte cks = Pic9StrTo<3, byte>(pend + 4);// static_cast<byte>(((pend[4] - '0') * 10 + (pend[5] - '0')) * 10 + (pend[6] - '0'));
-      while (pbeg < pend)
-         cks = static_cast<byte>(cks - static_cast<byte>(*pbeg++));
+      if (FixGetSimdLevel() == FixSimdLevel::Scalar) {
+         while (pbeg < pend)
+            cks = static_cast<byte>(cks - static_cast<byte>(*pbeg++));
+      }
+      else if (!isBuildIndex)
+         cks = static_cast<byte>(cks - FixByteSum(pbeg, pend));
+      else {
+         // header(包含 bodyLength 之後的 SOH) 只計算合計; body 在計算合計的同時, 建立 '=' 及 SOH 的位置索引.
+         const char* const pbody = fixmsg.begin() + 1;
+         const size_t      bodysz = static_cast<size_t>(pend - pbody);
+         if (this->DelimIndex_.size() < bodysz)
+            this->DelimIndex_.resize(bodysz);
+         uint32_t bodySum;
+         this->IndexedCount_ = FixScanDelims(pbody, pend, this->DelimIndex_.data(), &bodySum);
+         this->IndexedBody_.Reset(pbody, pend);
+         cks = static_cast<byte>(cks - FixByteSum(pbeg, pbody) - bodySum);
+      }
       if (cks != f9fix_kCHAR_SPL) {
          this->Clear();
          this->ExpectSize_ = static_cast<ExpectSize>(expsz);
@@ -93,42 +115,97 @@ FixParser::Result FixParser::Verify(StrView& fixmsg, VerifyItem vitem) {
    return static_cast<Result>(expsz);
 }
 FixParser::Result FixParser::Parse(StrView& fixmsg, Until until) {
-   Result rcode = this->Verify(fixmsg, until== Until::FullMessage ? VerifyAll : VerifyLengthOnly);
+   Result rcode = (until == Until::FullMessage
+                   ? this->VerifyImpl(fixmsg, VerifyAll, true)
+                   : this->VerifyImpl(fixmsg, VerifyLengthOnly, false));
    if (rcode == NeedsMore || rcode == ECheckSum)
       return rcode;
+   const StrView indexedBody = this->IndexedBody_;
    this->Clear();
    if (rcode < NeedsMore)
       return rcode;
+   this->IndexedBody_ = indexedBody;
    Result pcode = this->ParseFields(fixmsg, until);
    if (pcode < 0) // 發生錯誤, 傳回錯誤代碼.
       return pcode;
    return rcode;
 }
+StrView* FixParser::AllocFieldValue(FixField& fld) {
+   if (fon9_UNLIKELY(fld.ValueCount_ >= kMaxDupFieldCount + 1))
+      return nullptr;
+   if (fon9_LIKELY(fld.ValueCount_ == 0))
+      return &fld.Value_;
+   if (fld.ValueCount_ == 1) {
+      fld.MIndex_ = this->MIndexNext_;
+      fon9_GCC_WARN_DISABLE("-Wconversion"); // warning: conversion to ‘uint16_t’ from ‘int’ may alter its value[-Wconversion]
+      this->MIndexNext_ += kMaxDupFieldCount;
+      fon9_GCC_WARN_POP;
+      if (this->MFields_.size() < this->MIndexNext_)
+         this->MFields_.resize(this->MIndexNext_ + kMaxDupFieldCount * 4u);
+   }
+   return &this->MFields_[fld.MIndex_ * static_cast<size_t>(kMaxDupFieldCount) + (fld.ValueCount_ - 1)];
+}
+bool FixParser::SelectInterestTags(StrView msgType) {
+   const FixInterestTags* tags = this->InterestTagsSelector_(msgType);
+   if (tags == nullptr || tags->empty())
+      return false;
+   this->InterestTags_ = tags;
+   this->InterestRemain_ = tags->AddedCount();
+   // 在 MsgType 之前(包含 MsgType), 已保留的欄位.
+   for (auto ifld = this->FieldList_.begin(); ifld != this->FieldList_.end(); ++ifld) {
+      if (tags->IsAdded((*ifld)->Tag_) && std::find(this->FieldList_.begin(), ifld, *ifld) == ifld) {
+         if (--this->InterestRemain_ == 0)
+            return true;
+      }
+   }
+   return false;
+}
 FixParser::Result FixParser::ParseFields(StrView& fixmsg, Until until) {
+   // 如果有設定 InterestTagsSelector_, 則在解析到 MsgType 之後, 才能決定需要哪些欄位.
+   bool isSelecting = false;
+   this->InterestTags_ = nullptr;
+   if (until == Until::FullMessage && this->InterestTagsSelector_) {
+      if (const FixField* fldMsgType = this->GetField(f9fix_kTAG_MsgType)) {
+         // 在 Parse(until != FullMessage) 之後的 ParseFields(), 已經解析過 MsgType.
+         if (this->SelectInterestTags(fldMsgType->Value_)) {
+            this->IndexedBody_.Reset(nullptr);
+            return ParseEnd;
+         }
+      }
+      else
+         isSelecting = true;
+   }
+   if (until == Until::FullMessage && FixGetSimdLevel() != FixSimdLevel::Scalar) {
+      if (this->IndexedBody_.begin() != fixmsg.begin() || this->IndexedBody_.end() != fixmsg.end()) {
+         // 沒有經過 Parse() 的 VerifyImpl(), 例: 重新載入的訊息: 在此建立索引.
+         const size_t msgsz = fixmsg.size();
+         if (this->DelimIndex_.size() < msgsz)
+            this->DelimIndex_.resize(msgsz);
+         uint32_t byteSum;
+         this->IndexedCount_ = FixScanDelims(fixmsg.begin(), fixmsg.end(), this->DelimIndex_.data(), &byteSum);
+      }
+      this->IndexedBody_.Reset(nullptr);
+      const uint32_t* idx = this->DelimIndex_.data();
+      return this->ParseFieldsByIndex(fixmsg, idx, idx + this->IndexedCount_, isSelecting);
+   }
+   this->IndexedBody_.Reset(nullptr);
    const char* msgend = fixmsg.end();
+   StrView     skipped;
    while (fixmsg.begin() < msgend) {
       const FixTag tag = StrTo(&fixmsg, 0u);
       if (fon9_UNLIKELY(tag == 0 || fixmsg.Get1st() != '='))
          return EFormat;
       fixmsg.SetBegin(fixmsg.begin() + 1); //移除 '='
 
-      FixField& fld = this->FieldArray_[tag];
-      if (fon9_UNLIKELY(fld.ValueCount_ >= kMaxDupFieldCount + 1))
-         return EDupField;
-      fld.Tag_ = tag;
-      StrView* pValue;
-      if (fon9_LIKELY(fld.ValueCount_ == 0))
-         pValue = &fld.Value_;
-      else {
-         if (fld.ValueCount_ == 1) {
-            fld.MIndex_ = this->MIndexNext_;
-            fon9_GCC_WARN_DISABLE("-Wconversion"); // warning: conversion to ‘uint16_t’ from ‘int’ may alter its value[-Wconversion]
-            this->MIndexNext_ += kMaxDupFieldCount;
-            fon9_GCC_WARN_POP;
-            if (this->MFields_.size() < this->MIndexNext_)
-               this->MFields_.resize(this->MIndexNext_ + kMaxDupFieldCount * 4u);
-         }
-         pValue = &this->MFields_[fld.MIndex_ * static_cast<size_t>(kMaxDupFieldCount) + (fld.ValueCount_ - 1)];
+      // 不需要的欄位, 仍要取出 value(例: RawData), 才能找到下一個欄位的位置.
+      const bool isKeep = (this->InterestTags_ == nullptr || this->InterestTags_->IsKeep(tag));
+      FixField*  pfld = nullptr;
+      StrView*   pValue = &skipped;
+      if (fon9_LIKELY(isKeep)) {
+         pfld = &this->FieldArray_[tag];
+         if (fon9_UNLIKELY((pValue = this->AllocFieldValue(*pfld)) == nullptr))
+            return EDupField;
+         pfld->Tag_ = tag;
       }
 
       if (fon9_LIKELY(tag != f9fix_kTAG_RawData))
@@ -150,10 +227,23 @@ FixParser::Result FixParser::ParseFields(StrView& fixmsg, Until until) {
             fixmsg.SetBegin(pValue->end() + 1);// +1 移除 f9fix_kCHAR_SPL
          }
       }
+      if (fon9_UNLIKELY(!isKeep))
+         continue;
+      FixField& fld = *pfld;
       ++fld.ValueCount_;
       this->FieldList_.push_back(&fld);
-      if (fon9_LIKELY(until == Until::FullMessage))
+      if (fon9_LIKELY(until == Until::FullMessage)) {
+         if (fon9_UNLIKELY(isSelecting)) {
+            if (tag == f9fix_kTAG_MsgType) {
+               isSelecting = false;
+               if (this->SelectInterestTags(fld.Value_))
+                  break;
+            }
+         }
+         else if (this->IsInterestDone(fld))
+            break;
          continue;
+      }
       switch (tag) {
       default: continue;
       #define CASE_TAG_UNTIL(tagName)  case f9fix_kTAG_##tagName: until -= Until::tagName;  break
@@ -169,6 +259,81 @@ FixParser::Result FixParser::ParseFields(StrView& fixmsg, Until until) {
    this->MsgSeqNum_ = (fldMsgSeqNum ? StrTo(fldMsgSeqNum->Value_, 0u) : 0);
    return ParseEnd;
 }
+FixParser::Result FixParser::ParseFieldsByIndex(StrView& fixmsg, const uint32_t* idx, const uint32_t* const idxend, bool isSelecting) {
+   const char* const pbody = fixmsg.begin();
+   const char* const msgend = fixmsg.end();
+   const char*       pfld = pbody;
+   StrView           skipped;
+   while (pfld < msgend) {
+      // idx 指向 pfld 之後的第一個分隔符號, 必須是 '=', 且 [pfld, peq) 必須全都是數字.
+      const char* peq = (idx == idxend ? msgend : pbody + *idx);
+      FixTag      tag = 0;
+      const char* pdig = pfld;
+      for (; pdig < peq; ++pdig) {
+         const unsigned n = static_cast<unsigned>(static_cast<byte>(*pdig) - '0');
+         if (n > 9)
+            break;
+         tag = tag * 10 + n;
+      }
+      if (fon9_UNLIKELY(tag == 0 || pdig != peq || peq == msgend || *peq != '=')) {
+         fixmsg.SetBegin(pdig);
+         return EFormat;
+      }
+      ++idx;
+      const char* const pval = peq + 1;
+      fixmsg.SetBegin(pval);
+
+      const bool isKeep = (this->InterestTags_ == nullptr || this->InterestTags_->IsKeep(tag));
+      FixField*  pfldKeep = nullptr;
+      StrView*   pValue = &skipped;
+      if (fon9_LIKELY(isKeep)) {
+         pfldKeep = &this->FieldArray_[tag];
+         if (fon9_UNLIKELY((pValue = this->AllocFieldValue(*pfldKeep)) == nullptr))
+            return EDupField;
+         pfldKeep->Tag_ = tag;
+      }
+
+      const FixField* fldRawDataLength;
+      if (fon9_LIKELY(tag != f9fix_kTAG_RawData)
+          || (fldRawDataLength = GetField(f9fix_kTAG_RawDataLength)) == nullptr) {
+         // 下一個 SOH 就是此欄位的結尾, value 裡面可能包含 '=', 必須跳過.
+         while (idx != idxend && pbody[*idx] != f9fix_kCHAR_SPL)
+            ++idx;
+         const char* const pspl = (idx == idxend ? msgend : pbody + *idx++);
+         pValue->Reset(pval, pspl);
+         pfld = pspl + 1;
+      }
+      else { // RawData 可包含任意字元, 所以要用 RawDataLength 來判斷長度, 並跳過 RawData 裡面的分隔符號.
+         uint32_t rawDataLength = StrTo(fldRawDataLength->Value_, static_cast<uint32_t>(-1));
+         if (fon9_UNLIKELY(rawDataLength > static_cast<size_t>(msgend - pval)))
+            return ERawData;
+         if (fon9_UNLIKELY(pval[rawDataLength] != f9fix_kCHAR_SPL))
+            return ERawData;
+         pValue->Reset(pval, pval + rawDataLength);
+         pfld = pValue->end() + 1;// +1 移除 f9fix_kCHAR_SPL
+         while (idx != idxend && pbody + *idx < pfld)
+            ++idx;
+      }
+      if (fon9_UNLIKELY(!isKeep))
+         continue;
+      FixField& fld = *pfldKeep;
+      ++fld.ValueCount_;
+      this->FieldList_.push_back(&fld);
+      if (fon9_UNLIKELY(isSelecting)) {
+         if (tag == f9fix_kTAG_MsgType) {
+            isSelecting = false;
+            if (this->SelectInterestTags(fld.Value_))
+               break;
+         }
+      }
+      else if (this->IsInterestDone(fld))
+         break;
+   }
+   fixmsg.SetBegin(pfld < msgend ? pfld : msgend);
+   const FixField* fldMsgSeqNum = this->GetField(f9fix_kTAG_MsgSeqNum);
+   this->MsgSeqNum_ = (fldMsgSeqNum ? StrTo(fldMsgSeqNum->Value_, 0u) : 0);
+   return ParseEnd;
+}
 StrView FixParser::GetValue(const FixField& fld, unsigned index) const {
    return index >= fld.ValueCount_ ? StrView{nullptr}
       : index == 0 ? fld.Value_
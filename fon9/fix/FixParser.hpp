@@ -2,10 +2,11 @@
 /// \author fonwinz@gmail.com
 #ifndef __fon9_fix_FixParser_hpp__
 #define __fon9_fix_FixParser_hpp__
-#include "fon9/fix/FixBase.hpp"
+#include "fon9/fix/FixInterestTags.hpp"
 #include "fon9/CharVector.hpp"
 #include "fon9/LevelArray.hpp"
 #include <vector>
+#include <functional>
 
 namespace fon9 { namespace fix {
 
@@ -21,6 +22,11 @@ namespace fon9 { namespace fix {
 ///   - 通常一個 FixSession 擁有一個 FixParser 處理解析後的結果.
 ///   - 直到 FixSession 結束後釋放 FixParser.
 /// - 不解析 "8=BeginString" 及 "9=BodyLength", 所以 GetField(8) 及 GetField(9) 都傳回 nullptr.
+/// - 若 FixGetSimdLevel() != FixSimdLevel::Scalar:
+///   - Verify() 使用 FixByteSum() 計算 check sum.
+///   - Parse(until=FullMessage) 在計算 check sum 時, 同時建立 '=' 及 SOH 的位置索引,
+///     ParseFields() 再依照索引填入欄位, 不用再逐一字元尋找分隔符號.
+/// - 若有設定 SetInterestTagsSelector(), 則可依照 MsgType 選擇性解析需要的欄位, 請參考 FixInterestTags.
 class fon9_API FixParser {
    fon9_NON_COPY_NON_MOVE(FixParser);
 public:
@@ -156,6 +162,23 @@ public:
    /// \retval <NeedsMore 表示訊息有誤.
    Result ParseFields(StrView& fixmsg, Until until);
 
+   /// 根據 MsgType 取得需要的欄位, 傳回 nullptr 或 empty() 表示需要全部欄位.
+   /// 傳回的 FixInterestTags 必須在 FixParser 使用期間保持有效.
+   using InterestTagsSelector = std::function<const FixInterestTags*(StrView msgType)>;
+   /// 設定選擇性解析.
+   /// - 僅在 until == Until::FullMessage 時有效.
+   /// - 解析到 MsgType 之後, 透過 selector 取得需要的欄位:
+   ///   - 之後不需要的欄位僅跳過, GetField() 傳回 nullptr, 也不會出現在 begin()..end().
+   ///   - 需要的欄位都出現過了, 就結束解析.
+   void SetInterestTagsSelector(InterestTagsSelector selector) {
+      this->InterestTagsSelector_ = std::move(selector);
+   }
+   /// 上次 ParseFields() 選擇性解析所使用的欄位集合.
+   /// \retval nullptr 表示解析了全部欄位.
+   const FixInterestTags* GetInterestTags() const {
+      return this->InterestTags_;
+   }
+
    /// 取得 ParseFields() 解析之後的欄位內容.
    /// \retval nullptr  欄位不存在
    /// \retval !nullptr 在 Clear() 之後的 ParseFields() 欄位至少出現過一次.
@@ -188,6 +211,22 @@ public:
       return this->FieldList_.size();
    }
 private:
+   Result VerifyImpl(StrView& fixmsg, VerifyItem vitem, bool isBuildIndex);
+   /// 依照 DelimIndex_ 解析全部欄位.
+   Result ParseFieldsByIndex(StrView& fixmsg, const uint32_t* idx, const uint32_t* idxend, bool isSelecting);
+   /// 取得存放 fld 此次出現的值的位置, 若超過可重複次數則傳回 nullptr.
+   StrView* AllocFieldValue(FixField& fld);
+   /// 解析到 MsgType 之後, 透過 InterestTagsSelector_ 設定 InterestTags_.
+   /// \retval true 需要的欄位都已出現過, 可以結束解析.
+   bool SelectInterestTags(StrView msgType);
+   /// 在保留 fld 之後呼叫, 判斷需要的欄位是否都已出現過.
+   bool IsInterestDone(const FixField& fld) {
+      return this->InterestTags_ != nullptr
+         && fld.ValueCount_ == 1
+         && this->InterestTags_->IsAdded(fld.Tag_)
+         && --this->InterestRemain_ == 0;
+   }
+
    using FieldArray = LevelArray<FixTag, FixField>;
    CharVector  ExpectHeader_;
    FieldArray  FieldArray_;
@@ -197,6 +236,17 @@ private:
    uint16_t    MIndexNext_{0};
    using MFields = std::vector<StrView>;
    MFields     MFields_;
+   /// 在 VerifyImpl() 建立的 body 的 '=' 及 SOH 位置, 相對於 IndexedBody_.
+   using DelimIndex = std::vector<uint32_t>;
+   DelimIndex  DelimIndex_;
+   /// DelimIndex_ 對應的 body: ParseFields(fixmsg) 的 fixmsg 必須與此相同, 才能使用 DelimIndex_.
+   StrView     IndexedBody_{nullptr};
+   size_t      IndexedCount_{0};
+
+   InterestTagsSelector    InterestTagsSelector_;
+   const FixInterestTags*  InterestTags_{nullptr};
+   /// InterestTags_ 透過 Add() 加入的欄位, 還有幾個尚未出現.
+   uint32_t                InterestRemain_{0};
 };
 fon9_ENABLE_ENUM_BITWISE_OP(FixParser::Until);
 fon9_ENABLE_ENUM_BITWISE_OP(FixParser::VerifyItem);
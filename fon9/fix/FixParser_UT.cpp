@@ -4,6 +4,7 @@
 #include "fon9/TestTools.hpp"
 #include "fon9/fix/FixParser.hpp"
 #include "fon9/fix/FixBuilder.hpp"
+#include "fon9/fix/FixSimd.hpp"
 #include "fon9/Timer.hpp"
 
 namespace f9fix = fon9::fix;
@@ -78,19 +79,10 @@ f9fix::FixParser::Result TestFixParser(const char* testName,
    return res;
 }
 
-int main(int argc, char** args) {
-   (void)argc; (void)args;
-
-#if defined(_MSC_VER) && defined(_DEBUG)
-   _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
-#endif
-
-   fon9::AutoPrintTestInfo utinfo{"FixParser/FixBuilder"};
-   fon9::GetDefaultTimerThread();
-   std::this_thread::sleep_for(std::chrono::milliseconds{10});
+#define _   f9fix_kCSTR_SPL
 
+void TestFixParserAll() {
    f9fix::FixParser   fixpr;
-   #define _   f9fix_kCSTR_SPL
 
    // 一般訊息.
    const FldValue vs1[] = {{35,"A"},{56,"Client"},{49,"Server"},{34,"1"},{52,"20170426-00:49:26.625"},{108,"3000"},{98,"0"}};
@@ -153,4 +145,146 @@ int main(int argc, char** args) {
                  "98=0" _ "98=1" _ "98=2" _ "98=3" _ "98=4" _
                  "99=A" _ "99=B" _ "99=C" _ "99=D" _ "99=E" _ "10=240" _,
                  vs7, fon9::numofele(vs7));
+
+   // Test: 沒有經過 Parse() 直接呼叫 ParseFields(), 例: FixRecorder 重新載入的訊息.
+   std::cout << "[TEST ] ParseFields() without Parse().";
+   fixpr.Clear();
+   fixmsg = fon9::StrView{"35=A" _ "49=Client" _ "56=Server" _ "34=8" _ "95=3" _ "96=a=\x01" _ "99=A" _ "99=B"};
+   if (fixpr.ParseFields(fixmsg, f9fix::FixParser::Until::FullMessage) != f9fix::FixParser::ParseEnd
+       || !fixmsg.empty() || fixpr.count() != 8 || fixpr.GetMsgSeqNum() != 8
+       || fixpr.GetField(96)->Value_ != fon9::StrView{"a=\x01"}
+       || fixpr.GetValue(*fixpr.GetField(99), 1) != fon9::StrView{"B"}) {
+      std::cout << "|count=" << fixpr.count() << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   std::cout << "\r[OK   ]" << std::endl;
+}
+
+//--------------------------------------------------------------------------//
+
+static const char* const   kSimdLevelName[] = {"Scalar", "Sse2", "Avx2"};
+
+static std::string MakeFixMessage(fon9::StrView body) {
+   f9fix::FixBuilder fbuf;
+   fon9::RevPrint(fbuf.GetBuffer(), f9fix_kCHAR_SPL, body);
+   return fon9::BufferTo<std::string>(fbuf.Final(f9fix_BEGIN_HEADER("FIX.4.4")));
+}
+
+/// 選擇性解析: 只保留需要的欄位, 需要的欄位都出現過之後就結束解析.
+void TestFixParserInterestTags() {
+   std::cout << "[TEST ] InterestTags.";
+   const f9fix::FixInterestTags  execRptTags{11, 17, 39};
+   f9fix::FixParser              fixpr;
+   fixpr.SetInterestTagsSelector([&execRptTags](fon9::StrView msgType) {
+      return msgType == "8" ? &execRptTags : nullptr;
+   });
+   // RawData 不需要, 但仍要依照 RawDataLength 跳過; #43 在需要的欄位之後, 不會解析.
+   const std::string execRpt = MakeFixMessage("35=8" _ "49=S" _ "56=T" _ "34=9" _ "95=4" _ "96=1=" _ "2" _
+                                              "37=OID" _ "11=CID" _ "99=x" _ "17=EX1" _ "99=y" _ "39=2" _ "43=Y" _ "58=text");
+   const f9fix::FixTag  expectTags[] = {35, 49, 56, 34, 95, 11, 17, 39};
+   auto checkResult = [&](const char* step) {
+      bool isOK = (fixpr.GetInterestTags() == &execRptTags && fixpr.count() == fon9::numofele(expectTags)
+                   && fixpr.GetMsgSeqNum() == 9 && fixpr.GetField(17)->Value_ == "EX1");
+      size_t idx = 0;
+      for (auto fld : fixpr) {
+         if (!isOK)
+            break;
+         isOK = (fld->Tag_ == expectTags[idx++]);
+      }
+      if (!isOK || fixpr.GetField(96) || fixpr.GetField(99) || fixpr.GetField(43)) {
+         std::cout << "|step=" << step << "|count=" << fixpr.count() << "\r[ERROR]" << std::endl;
+         abort();
+      }
+   };
+   fon9::StrView fixmsg = fon9::ToStrView(execRpt);
+   if (fixpr.Parse(fixmsg) != static_cast<f9fix::FixParser::Result>(execRpt.size())) {
+      std::cout << "|Parse() error.\r[ERROR]" << std::endl;
+      abort();
+   }
+   checkResult("Parse");
+   // 沒有經過 Parse() 直接呼叫 ParseFields(), 例: FixReceiver 保留的訊息.
+   fixmsg = fon9::ToStrView(execRpt);
+   fixmsg.SetBegin(strstr(execRpt.c_str(), _ "35=") + 1);
+   fixmsg.SetEnd(fixmsg.end() - f9fix::kFixTailWidth);
+   fixpr.Clear();
+   fixpr.ParseFields(fixmsg, f9fix::FixParser::Until::FullMessage);
+   checkResult("ParseFields");
+   // Parse(Until::MsgType) 之後再解析全部.
+   fixmsg = fon9::ToStrView(execRpt);
+   fixpr.Parse(fixmsg, f9fix::FixParser::Until::MsgType);
+   fixpr.ParseFields(fixmsg, f9fix::FixParser::Until::FullMessage);
+   checkResult("Until:MsgType");
+
+   // 沒有設定 InterestTags 的 MsgType, 解析全部欄位.
+   const std::string newOrder = MakeFixMessage("35=D" _ "49=S" _ "56=T" _ "34=10" _ "11=CID" _ "38=1000" _ "43=Y");
+   fixmsg = fon9::ToStrView(newOrder);
+   if (fixpr.Parse(fixmsg) <= f9fix::FixParser::NeedsMore || fixpr.GetInterestTags() || fixpr.count() != 7) {
+      std::cout << "|MsgType=D|count=" << fixpr.count() << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   std::cout << "\r[OK   ]" << std::endl;
+}
+
+/// 使用 Parse(FullMessage) 解析 fixmsg: 包含檢查 check sum, 及取出全部欄位(或 interestTags 指定的欄位).
+static void BenchFixParser(const char* msgName, const std::string& fixmsg, const f9fix::FixInterestTags* interestTags = nullptr) {
+   static const unsigned   kTimes = 1000 * 1000;
+   f9fix::FixParser        fixpr;
+   if (interestTags)
+      fixpr.SetInterestTagsSelector([interestTags](fon9::StrView) { return interestTags; });
+   fon9::StopWatch         stopWatch;
+   for (unsigned L = 0; L < kTimes; ++L) {
+      fon9::StrView msg = fon9::ToStrView(fixmsg);
+      if (fixpr.Parse(msg) <= f9fix::FixParser::NeedsMore) {
+         std::cout << msgName << "|Parse() error." << std::endl;
+         abort();
+      }
+   }
+   const double span = stopWatch.StopTimer();
+   char msg[128];
+   snprintf(msg, sizeof(msg), "%-6s|%s|size=%u|fields=%u", kSimdLevelName[static_cast<unsigned>(f9fix::FixGetSimdLevel())],
+            msgName, static_cast<unsigned>(fixmsg.size()), static_cast<unsigned>(fixpr.count()));
+   fon9::StopWatch::PrintResultNoEOL(span, msg, kTimes)
+      << "|MB/sec=" << static_cast<double>(fixmsg.size()) * kTimes / span / (1024 * 1024) << std::endl;
+}
+
+int main(int argc, char** args) {
+   (void)argc; (void)args;
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+   _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
+#endif
+
+   fon9::AutoPrintTestInfo utinfo{"FixParser/FixBuilder"};
+   fon9::GetDefaultTimerThread();
+   std::this_thread::sleep_for(std::chrono::milliseconds{10});
+
+   // 每個 CPU 支援的指令集, 都必須得到相同的結果.
+   const f9fix::FixSimdLevel maxLevel = f9fix::FixGetSimdLevel();
+   for (unsigned lv = 0; lv <= static_cast<unsigned>(maxLevel); ++lv) {
+      f9fix::FixSetSimdLevel(static_cast<f9fix::FixSimdLevel>(lv));
+      utinfo.PrintSplitter();
+      std::cout << "FixSimdLevel=" << kSimdLevelName[lv] << std::endl;
+      TestFixParserAll();
+      TestFixParserInterestTags();
+   }
+
+   utinfo.PrintSplitter();
+   const std::string newOrderSingle = MakeFixMessage(
+      "35=D" _ "49=BROKER01" _ "56=EXCHANGE" _ "34=1024" _ "52=20190301-01:30:00.123" _ "50=TRADER7" _ "57=TSE" _
+      "11=A000123456" _ "1=9801234" _ "21=1" _ "55=2330" _ "207=TW" _ "54=1" _ "60=20190301-01:30:00.120" _
+      "38=5000" _ "40=2" _ "44=245.50" _ "59=0" _ "15=TWD" _ "528=A" _ "18=0" _ "10000=TSE.F9" _ "10001=N");
+   const std::string executionReport = MakeFixMessage(
+      "35=8" _ "49=EXCHANGE" _ "56=BROKER01" _ "34=2048" _ "52=20190301-01:30:00.456" _ "57=TRADER7" _ "43=N" _
+      "37=E0000987654321" _ "11=A000123456" _ "17=X20190301000000123" _ "150=F" _ "39=1" _ "1=9801234" _
+      "55=2330" _ "207=TW" _ "54=1" _ "38=5000" _ "40=2" _ "44=245.50" _ "59=0" _ "32=2000" _ "31=245.50" _
+      "151=3000" _ "14=2000" _ "6=245.50" _ "60=20190301-01:30:00.450" _ "15=TWD" _ "30=TSE" _ "375=BRK8" _
+      "58=Partially filled by continuous trading session" _ "528=A" _ "10000=TSE.F9");
+   // drop copy 通常只需要 ExecutionReport 的部分欄位.
+   const f9fix::FixInterestTags execRptTags{37, 11, 17, 150, 39, 1, 55, 54, 32, 31, 151, 14};
+   for (unsigned lv = 0; lv <= static_cast<unsigned>(maxLevel); ++lv) {
+      f9fix::FixSetSimdLevel(static_cast<f9fix::FixSimdLevel>(lv));
+      BenchFixParser("NewOrderSingle ", newOrderSingle);
+      BenchFixParser("ExecutionReport", executionReport);
+      BenchFixParser("ExecRpt.12Tags ", executionReport, &execRptTags);
+   }
 }
@@ -4,7 +4,152 @@
 
 namespace fon9 { namespace fix {
 
+/// 當此節點被消費時(在此之前的資料都已寫入), 通知 FixRecorder 在此批資料寫完後 fdatasync().
+struct FixRecorder::NodeSync : public BufferNodeVirtual {
+   fon9_NON_COPY_NON_MOVE(NodeSync);
+   using base = BufferNodeVirtual;
+   friend class BufferNode;// for BufferNode::Alloc();
+   FixRecorder* Owner_;
+protected:
+   NodeSync(BufferNodeSize blockSize, FixRecorder* owner)
+      : base(blockSize, StyleFlag{})
+      , Owner_{owner} {
+   }
+   void OnBufferConsumed() override {
+      this->Owner_->IsSyncRequired_ = true;
+   }
+   void OnBufferConsumedErr(const ErrC&) override {
+      this->Owner_->IsSyncRequired_ = true;
+   }
+public:
+   static NodeSync* Alloc(FixRecorder* owner) {
+      return base::Alloc<NodeSync>(0, owner);
+   }
+};
+
+/// 送出序號的索引(FixSentIndex::MovePending()), 放在記錄檔的寫入佇列:
+/// - 在寫檔 thread 寫入附屬檔, 不會在 FixRecorder 的 lock 之下寫檔.
+/// - 在此之前的資料(索引指向的送出訊息)都已寫入, 附屬檔不會超前記錄檔.
+struct FixRecorder::NodeSentIndex : public BufferNodeVirtual {
+   fon9_NON_COPY_NON_MOVE(NodeSentIndex);
+   using base = BufferNodeVirtual;
+   friend class BufferNode;// for BufferNode::Alloc();
+   FixRecorder* Owner_;
+   std::string  Records_;
+protected:
+   NodeSentIndex(BufferNodeSize blockSize, FixRecorder* owner, std::string&& recs)
+      : base(blockSize, StyleFlag{})
+      , Owner_{owner}
+      , Records_{std::move(recs)} {
+   }
+   void OnBufferConsumed() override {
+      this->Owner_->SentIndex_.WriteRecords(this->Records_);
+   }
+   void OnBufferConsumedErr(const ErrC&) override {
+      // 記錄檔寫入失敗, 附屬檔也不寫入, 重啟時由 FixRecorder 檢查並補上.
+   }
+public:
+   static NodeSentIndex* Alloc(FixRecorder* owner, std::string&& recs) {
+      return base::Alloc<NodeSentIndex>(0, owner, std::move(recs));
+   }
+};
+
+/// FixRecorderWriteMode::Direct: 使用 FileMode::DirectIO 另外開啟的寫入用檔案.
+/// - 寫入的位置、大小、緩衝區, 都對齊 kAlignSize;
+///   尾端不足一個 block 的資料, 補 0 後寫入, 然後調整檔案大小, 並保留在 Buffer_ 的前端, 下次與新資料一起寫入.
+/// - 讀取仍使用 FixRecorder 原本開啟的檔案.
+struct FixRecorder::DirectWriter {
+   fon9_NON_COPY_NON_MOVE(DirectWriter);
+   enum : size_t {
+      kAlignSize = 4096,
+      kBufferSize = kAlignSize * 64,
+   };
+   File           File_;
+   std::unique_ptr<char[]> Alloc_{new char[kBufferSize + kAlignSize]};
+   char* const    Buffer_{Alloc_.get() + (kAlignSize - reinterpret_cast<uintptr_t>(Alloc_.get()) % kAlignSize) % kAlignSize};
+   /// Buffer_ 裡面尚未寫入(或尚未填滿一個 block)的資料量.
+   size_t         TailSize_{0};
+   /// Buffer_[0] 在檔案中的位置, 必定對齊 kAlignSize.
+   File::PosType  BlockPos_{0};
+
+   DirectWriter() = default;
+
+   File::Result Open(File& src) {
+      File::Result res = this->File_.Open(src.GetOpenName(), FileMode::Write | FileMode::DirectIO);
+      if (!res)
+         return res;
+      if (!(res = src.GetFileSize()))
+         return res;
+      this->BlockPos_ = res.GetResult() - res.GetResult() % kAlignSize;
+      this->TailSize_ = static_cast<size_t>(res.GetResult() - this->BlockPos_);
+      if (this->TailSize_ > 0) {
+         if (!(res = src.Read(this->BlockPos_, this->Buffer_, this->TailSize_)))
+            return res;
+         if (res.GetResult() != this->TailSize_)
+            return File::Result{std::errc::io_error};
+      }
+      // 有些檔案系統可以用 O_DIRECT 開檔, 但寫入時才失敗,
+      // 所以在此寫回尾端不足一個 block 的資料(內容不變), 確定可以正常寫入.
+      return this->WriteBlocks();
+   }
+   File::Result WriteBlocks() {
+      const size_t used = this->TailSize_;
+      if (used == 0)
+         return File::Result{0};
+      const size_t wrsz = (used + kAlignSize - 1) / kAlignSize * kAlignSize;
+      memset(this->Buffer_ + used, 0, wrsz - used);
+      File::Result res = this->File_.Write(this->BlockPos_, this->Buffer_, wrsz);
+      if (!res)
+         return res;
+      if (res.GetResult() != wrsz)
+         return File::Result{std::errc::io_error};
+      if (wrsz != used && !(res = this->File_.SetFileSize(this->BlockPos_ + used)))
+         return res;
+      if (const size_t full = used - used % kAlignSize) {
+         this->BlockPos_ += full;
+         if ((this->TailSize_ = used - full) > 0)
+            memmove(this->Buffer_, this->Buffer_ + full, this->TailSize_);
+      }
+      return File::Result{used};
+   }
+   void Append(DcQueueList& buf) {
+      while (!buf.empty()) {
+         this->TailSize_ += buf.Read(this->Buffer_ + this->TailSize_, kBufferSize - this->TailSize_);
+         File::Result res = this->WriteBlocks();
+         if (!res) {
+            buf.ConsumeErr(res.GetError());
+            return;
+         }
+      }
+   }
+};
+
+//--------------------------------------------------------------------------//
+
+struct FixRecorder::SyncTimer : public TimerEntry {
+   fon9_NON_COPY_NON_MOVE(SyncTimer);
+   FixRecorder* const   Owner_;
+   SyncTimer(TimerThread& timerThread, FixRecorder* owner) : TimerEntry{timerThread}, Owner_{owner} {
+   }
+   void OnTimer(TimeStamp /*now*/) override {
+      Locker lk{this->Owner_->Worker_.Lock()};
+      if (this->Owner_->UnsyncCount_ == 0)
+         return;
+      this->Owner_->UnsyncCount_ = 0;
+      WorkContentController* app = static_cast<WorkContentController*>(&WorkContentController::StaticCast(*lk));
+      app->AddWork(std::move(lk), NodeSync::Alloc(this->Owner_));
+   }
+};
+
+//--------------------------------------------------------------------------//
+
+FixRecorder::FixRecorder(const StrView& beginHeader, CompIDs&& compIDs)
+   : SyncTimer_{new SyncTimer{GetDefaultTimerThread(), this}}
+   , BeginHeader_{beginHeader}
+   , CompIDs_(std::move(compIDs)) {
+}
 FixRecorder::~FixRecorder() {
+   this->SyncTimer_->DisposeAndWait();
    this->DisposeAsync();
    RevBufferList rbuf{256 + sizeof(NumOutBuf)};
    RevPrint(rbuf, f9fix_kCSTR_HdrInfo, UtcNow(), " f9fix.FixRecorder dtor.\n\n"); // 尾端多一個換行,可以比較容易區分重啟.
@@ -12,11 +157,14 @@ FixRecorder::~FixRecorder() {
    WorkContentController* app = static_cast<WorkContentController*>(&WorkContentController::StaticCast(*lk));
    app->AddWork(std::move(lk), rbuf.MoveOut());
    this->Worker_.TakeCallLocked(std::move(lk));
+   if (this->WriteMode_ != FixRecorderWriteMode::Async)
+      this->SyncStorage();
 }
 
-File::Result FixRecorder::Initialize(std::string fileName) {
+File::Result FixRecorder::Initialize(std::string fileName, const FixRecorderArgs& args) {
    if (this->GetStorage().IsOpened())
       return File::Result{std::errc::text_file_busy};
+   std::string sentIndexFileName = fileName + ".sidx";
    auto res = this->Open(std::move(fileName), FileMode::Append | FileMode::CreatePath | FileMode::Read | FileMode::DenyWrite).get();
    if (!res)
       return res;
@@ -24,7 +172,11 @@ File::Result FixRecorder::Initialize(std::string fileName) {
    fixParser.ResetExpectHeader(ToStrView(this->BeginHeader_));
    LastSeqSearcher   seqSearcher{fixParser};
    File&             file = this->GetStorage();
-   res = seqSearcher.Start(file);
+   // 啟動時通常只需要檔尾的少量資料, 使用 mmap 直接在 page cache 上搜尋, 不用複製到緩衝區.
+   // 從尾端往前讀, 核心的循序預讀幫不上忙, 所以使用 Random.
+   res = seqSearcher.StartMapped(file, FileMapView::Advice::Random);
+   if (!res) // 無法映射到記憶體, 改用一般的讀檔方式.
+      res = seqSearcher.Start(file);
    if (!res)
       file.Close();
    else {
@@ -33,24 +185,109 @@ File::Result FixRecorder::Initialize(std::string fileName) {
       if ((this->NextRecvSeq_ = seqSearcher.NextRecvSeq_) == 0)
          this->NextRecvSeq_ = 1;
       this->IdxInfoSizeInterval_ = 0;
+      const File::Result fsize = file.GetFileSize();
+      this->FileSize_ = (fsize ? fsize.GetResult() : 0);
+      this->WrittenSize_ = this->FileSize_;
+      this->InitWriteMode(args);
+      this->LoadSentIndex(std::move(sentIndexFileName));
       this->Write(f9fix_kCSTR_HdrInfo,
                   "f9fix.FixRecorder Initialized:"
                   "|NextSendSeq=", this->NextSendSeq_,
-                  "|NextRecvSeq=", this->NextRecvSeq_);
+                  "|NextRecvSeq=", this->NextRecvSeq_,
+                  "|WriteMode=", FixRecorderWriteModeToStr(this->WriteMode_));
    }
    return res;
 }
+void FixRecorder::InitWriteMode(const FixRecorderArgs& args) {
+   this->WriteMode_ = args.Mode_;
+   this->SyncInterval_ = args.SyncInterval_;
+   if ((this->SyncCount_ = args.SyncCount_) == 0 && this->SyncInterval_ <= TimeInterval{})
+      this->SyncCount_ = 1;
+   if (this->WriteMode_ != FixRecorderWriteMode::Direct)
+      return;
+   this->DirectWriter_.reset(new DirectWriter);
+   const File::Result res = this->DirectWriter_->Open(this->GetStorage());
+   if (!res) {
+      // 若已開檔成功(但寫入失敗), 仍保留 DirectWriter_ 的檔案, 不要關閉:
+      // 因為關閉同一個檔案的任一 fd, 就會解除本程序在該檔案的 fcntl 鎖(FileMode::DenyWrite).
+      this->WriteMode_ = FixRecorderWriteMode::GroupCommit;
+      this->Write(f9fix_kCSTR_HdrError, "f9fix.FixRecorder.DirectIO|err=", res, "|use=GroupCommit");
+   }
+}
+void FixRecorder::AddSyncRequest(BufferList& buf) {
+   ++this->UnsyncCount_;
+   if (this->SyncCount_ > 0 && this->UnsyncCount_ >= this->SyncCount_) {
+      this->UnsyncCount_ = 0;
+      buf.push_back(NodeSync::Alloc(this));
+   }
+   else if (this->UnsyncCount_ == 1 && this->SyncInterval_ > TimeInterval{})
+      this->SyncTimer_->RunAfter(this->SyncInterval_);
+}
+void FixRecorder::SetSyncTimerThread(TimerThread& timerThread) {
+   TimerEntrySP oldTimer;
+   {
+      Locker lk{this->Worker_.Lock()};
+      if (&this->SyncTimer_->TimerThread_ == &timerThread)
+         return;
+      oldTimer = std::move(this->SyncTimer_);
+      this->SyncTimer_.reset(new SyncTimer{timerThread, this});
+      if (this->UnsyncCount_ > 0 && this->SyncInterval_ > TimeInterval{})
+         this->SyncTimer_->RunAfter(this->SyncInterval_);
+   }
+   // oldTimer 的 OnTimer() 需要 Lock(), 所以必須在 unlock 之後才能等候.
+   oldTimer->DisposeAndWait();
+}
+void FixRecorder::SyncStorage() {
+   const auto start = std::chrono::steady_clock::now();
+   if (this->WriteMode_ == FixRecorderWriteMode::Direct)
+      this->DirectWriter_->File_.Sync();
+   else
+      this->GetStorage().Sync();
+   this->LastSyncLatencyNs_.store(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start).count()), std::memory_order_relaxed);
+   this->SyncTimes_.fetch_add(1, std::memory_order_relaxed);
+}
+void FixRecorder::ConsumeAppendBuffer(DcQueueList& buffer) {
+   const size_t bufsz = buffer.CalcSize();
+   if (this->WriteMode_ == FixRecorderWriteMode::Direct)
+      this->DirectWriter_->Append(buffer);
+   else
+      base::ConsumeAppendBuffer(buffer);
+   this->WrittenSize_.fetch_add(bufsz - buffer.CalcSize(), std::memory_order_relaxed);
+   if (this->IsSyncRequired_) {
+      this->IsSyncRequired_ = false;
+      this->SyncStorage();
+   }
+}
+FixRecorderWriteStats FixRecorder::GetWriteStats() {
+   FixRecorderWriteStats st;
+   Locker lk{this->Worker_.Lock()};
+   st.Mode_ = this->WriteMode_;
+   st.QueuingNodeCount_ = lk->GetTotalNodeCount();
+   st.QueuingBytes_ = this->FileSize_ - this->WrittenSize_.load(std::memory_order_relaxed);
+   st.SyncTimes_ = this->SyncTimes_.load(std::memory_order_relaxed);
+   st.LastSyncLatency_ = TimeInterval::Make<9>(this->LastSyncLatencyNs_.load(std::memory_order_relaxed));
+   return st;
+}
 
 void FixRecorder::WriteBuffer(Locker&& lk, RevBufferList&& rbuf) {
    BufferList wbuf = rbuf.MoveOut();
-   if (fon9_UNLIKELY((this->IdxInfoSizeInterval_ += CalcDataSize(wbuf.cfront())) > kIdxInfoSizeInterval)) {
+   const size_t bufsz = CalcDataSize(wbuf.cfront());
+   this->FileSize_ += bufsz;
+   if (fon9_UNLIKELY((this->IdxInfoSizeInterval_ += bufsz) > kIdxInfoSizeInterval)) {
       this->IdxInfoSizeInterval_ = 0;
       RevPrint(rbuf, f9fix_kCSTR_HdrIdx
                f9fix_kCSTR_HdrNextSendSeq, this->NextSendSeq_,
                f9fix_kCSTR_HdrNextRecvSeq, this->NextRecvSeq_,
                '\n');
-      wbuf.push_back(rbuf.MoveOut());
+      BufferList idxbuf = rbuf.MoveOut();
+      this->FileSize_ += CalcDataSize(idxbuf.cfront());
+      wbuf.push_back(std::move(idxbuf));
    }
+   if (fon9_UNLIKELY(this->WriteMode_ != FixRecorderWriteMode::Async))
+      this->AddSyncRequest(wbuf);
+   if (fon9_UNLIKELY(this->SentIndex_.IsFlushRequired()))
+      wbuf.push_back(NodeSentIndex::Alloc(this, this->SentIndex_.MovePending()));
    WorkContentController* app = static_cast<WorkContentController*>(&WorkContentController::StaticCast(*lk));
    app->AddWork(std::move(lk), std::move(wbuf));
 }
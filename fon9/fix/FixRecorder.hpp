@@ -4,12 +4,30 @@
 #define __fon9_fix_FixRecorder_hpp__
 #include "fon9/fix/FixParser.hpp"
 #include "fon9/fix/FixCompID.hpp"
+#include "fon9/fix/FixSentIndex.hpp"
+#include "fon9/fix/FixRecorderArgs.hpp"
 #include "fon9/buffer/RevBufferList.hpp"
 #include "fon9/FileAppender.hpp"
+#include "fon9/Timer.hpp"
 
 namespace fon9 { namespace fix {
 
 fon9_WARN_DISABLE_PADDING;
+/// \ingroup fix
+/// FixRecorder 寫檔的統計資料, 請參考 FixRecorder::GetWriteStats().
+struct FixRecorderWriteStats {
+   /// 實際使用的寫檔方式: 若要求 Direct 但檔案系統不支援, 則為 GroupCommit.
+   FixRecorderWriteMode Mode_;
+   /// 尚未寫入的節點數量(queue depth).
+   size_t         QueuingNodeCount_;
+   /// 尚未寫入的資料量(bytes).
+   File::SizeType QueuingBytes_;
+   /// 已呼叫 fdatasync() 的次數.
+   uint64_t       SyncTimes_;
+   /// 最後一次 fdatasync() 的耗時, 尚未呼叫過則為 0.
+   TimeInterval   LastSyncLatency_;
+};
+
 /// \ingroup fix
 /// FIX Message 記錄器.
 /// - 每個 Session 一個記錄器.
@@ -38,17 +56,68 @@ fon9_WARN_DISABLE_PADDING;
 ///               FIX 有 Sequence Reset 機制, 當發生此情況時, 必定會跟隨一個 RST 訊息.
 ///        其他 = 額外資訊, 參考 f9fix_kCSTR_Hdr*
 ///   \endcode
+/// - 送出訊息的序號索引, 存放在附屬檔: 記錄檔名 + ".sidx", 請參考 FixSentIndex.
+///   - 取回已送出的訊息時, 可直接從索引取得位置, 不用從檔尾往前搜尋.
+///   - 開檔時檢查附屬檔: 若不存在或與記錄檔不一致則重建; 若落後記錄檔則補上.
+/// - 寫檔方式(是否 fdatasync、是否使用 O_DIRECT), 在 Initialize() 時由 FixRecorderArgs 決定.
 class fon9_API FixRecorder : protected AsyncFileAppender {
    fon9_NON_COPY_NON_MOVE(FixRecorder);
    using base = AsyncFileAppender;
    FixSeqNum   NextSendSeq_{0};
    FixSeqNum   NextRecvSeq_{0};
    size_t      IdxInfoSizeInterval_;
-   
+   /// 已交給 AsyncFileAppender 的資料量, 也就是下一筆寫入資料在檔案中的位置.
+   File::PosType  FileSize_{0};
+   /// 在 Initialize() 成功建立索引之後才能使用.
+   bool           IsSentIndexReady_{false};
+   FixSentIndex   SentIndex_;
+
+   /// 開啟送出序號的索引, 檢查索引的最後一筆是否正確, 然後從記錄檔補上索引之後的送出訊息.
+   void LoadSentIndex(std::string fname);
+   /// 檢查 rec 是否與記錄檔的內容相符.
+   bool IsSentIndexRecordValid(const FixSentIndex::Record& rec);
+   /// 從記錄檔的 pos 開始往檔尾, 將送出的訊息加入索引.
+   void ScanSentIndex(File::PosType pos, bool isSkipFirstLine);
+
+   FixRecorderWriteMode WriteMode_{FixRecorderWriteMode::Async};
+   uint32_t       SyncCount_{0};
+   TimeInterval   SyncInterval_{};
+   /// 在 Lock() 保護下: 尚未要求 fdatasync() 的記錄筆數.
+   uint32_t       UnsyncCount_{0};
+   /// 僅在寫檔 thread 使用: 有 NodeSync 要求, 此批資料寫完後需要 fdatasync().
+   bool           IsSyncRequired_{false};
+   /// 已寫入的資料量, 與 FileSize_ 的差距就是尚未寫入的資料量.
+   std::atomic<File::PosType> WrittenSize_{0};
+   std::atomic<uint64_t>      SyncTimes_{0};
+   std::atomic<uint64_t>      LastSyncLatencyNs_{0};
+
+   struct NodeSync;
+   struct NodeSentIndex;
+   struct DirectWriter;
+   /// WriteMode_ == FixRecorderWriteMode::Direct 時使用.
+   std::unique_ptr<DirectWriter> DirectWriter_;
+
+   /// SyncInterval_ 的計時, 在 Lock() 保護下使用.
+   /// 因為 TimerEntry 建構後無法更換 TimerThread, 所以使用 TimerEntrySP, 請參考 SetSyncTimerThread();
+   struct SyncTimer;
+   TimerEntrySP   SyncTimer_;
+
+   /// 在 Initialize() 開檔成功後, 依照 args 設定寫檔方式.
+   void InitWriteMode(const FixRecorderArgs& args);
+   /// 在 Lock() 保護下, 加入一筆記錄後呼叫:
+   /// 若累積筆數已達 SyncCount_, 則在 buf 尾端加上 NodeSync; 否則若是第一筆, 則啟動 SyncTimer_.
+   void AddSyncRequest(BufferList& buf);
+   void SyncStorage();
+
    struct FixRevSercher;
    struct LastSeqSearcher;
    struct SentMessageSearcher;
    friend intrusive_ptr<FixRecorder>;
+
+protected:
+   /// 依照 WriteMode_ 寫檔, 若此批資料有 fdatasync() 要求, 則在寫完後處理.
+   void ConsumeAppendBuffer(DcQueueList& buffer) override;
+
 public:
    using Locker = base::WorkContentLocker;
 
@@ -70,19 +139,31 @@ public:
       kIdxInfoSizeInterval = kReloadSentBufferSize - 1024 * 2,
    };
 
-   FixRecorder(const StrView& beginHeader, CompIDs&& compIDs)
-      : BeginHeader_{beginHeader}
-      , CompIDs_(std::move(compIDs)) {
-   }
+   FixRecorder(const StrView& beginHeader, CompIDs&& compIDs);
    virtual ~FixRecorder();
 
    using base::WaitFlushed;
+   /// 指定寫檔使用的 ThreadPool, 請參考 FixShard::AttachRecorder();
+   using base::SetThreadPool;
+   using base::GetThreadPool;
+   /// 指定 SyncInterval_(group commit) 計時使用的 TimerThread, 預設為 GetDefaultTimerThread();
+   /// 可在寫入過程中更換, 若舊的 TimerThread 正在計時, 則改由新的 TimerThread 重新計時.
+   /// 請參考 FixShard::AttachRecorder();
+   void SetSyncTimerThread(TimerThread& timerThread);
+   TimerThread& GetSyncTimerThread() {
+      Locker lk{this->Worker_.Lock()};
+      return this->SyncTimer_->TimerThread_;
+   }
 
    /// 初次建立 FixRecorder:
    /// 1. 開啟記錄檔.
    /// 2. 取得 NextRecvSeq_, NextSeqSeq_
+   /// 3. 依照 args 設定寫檔方式.
    /// 若重複呼叫(之前已成功過), 則返回 std::errc::text_file_busy;
-   File::Result Initialize(std::string fileName);
+   File::Result Initialize(std::string fileName, const FixRecorderArgs& args = FixRecorderArgs{});
+
+   /// 取得寫檔的統計資料, 可用來觀察寫檔方式對送出端的影響.
+   FixRecorderWriteStats GetWriteStats();
 
    FixSeqNum GetNextSendSeq(const Locker&) const {
       return this->NextSendSeq_;
@@ -123,12 +204,33 @@ public:
 
    /// 送出後, 設定 this->NextSendSeq_, 並寫入送出的訊息;
    /// lineMessage 必須為一行完整的訊息: "S " + timestamp + ' ' + FIX Message + '\n';
+   /// - sentSeq = lineMessage 送出訊息的序號, 用來建立送出序號的索引.
+   ///   若 lineMessage 沒有送出的訊息(只有 "RST|S=n"), 則 sentSeq 必須為 0.
+   /// - 若 lineMessage 尾端有 "RST|S=nextSendSeq", 則 isRstSend 必須為 true.
    /// 請參考 FixSender::Send()
    /// 返回前 lk 可能已被解鎖!
-   void WriteAfterSend(Locker&& lk, RevBufferList&& lineMessage, FixSeqNum nextSendSeq) {
+   void WriteAfterSend(Locker&& lk, RevBufferList&& lineMessage, FixSeqNum nextSendSeq, FixSeqNum sentSeq, bool isRstSend) {
       this->NextSendSeq_ = nextSendSeq;
+      if (sentSeq > 0)
+         this->SentIndex_.Append(FixSentIndex::RecordKind::Sent, sentSeq, this->FileSize_);
+      if (isRstSend)
+         this->SentIndex_.Append(FixSentIndex::RecordKind::RstSend, nextSendSeq, this->FileSize_);
       this->WriteBuffer(std::move(lk), std::move(lineMessage));
    }
+   /// 批次送出後, 設定 this->NextSendSeq_ = firstSeq + count, 並寫入送出的訊息;
+   /// lineMessages 必須依序包含 count 行送出的訊息, 序號為 firstSeq 開始連續的 count 個.
+   /// getLineSize(idx) 傳回第 idx 行的大小, 用來建立送出序號的索引.
+   /// 返回前 lk 可能已被解鎖!
+   template <class GetLineSizeFn>
+   void WriteAfterSendBatch(Locker&& lk, RevBufferList&& lineMessages, FixSeqNum firstSeq, size_t count, GetLineSizeFn&& getLineSize) {
+      File::PosType pos = this->FileSize_;
+      for (size_t idx = 0; idx < count; ++idx) {
+         this->SentIndex_.Append(FixSentIndex::RecordKind::Sent, firstSeq + static_cast<FixSeqNum>(idx), pos);
+         pos += getLineSize(idx);
+      }
+      this->NextSendSeq_ = firstSeq + static_cast<FixSeqNum>(count);
+      this->WriteBuffer(std::move(lk), std::move(lineMessages));
+   }
 
    /// 寫入依正常順序收到的 FIX Message.
    /// 返回前 ++this->NextRecvSeq_;
@@ -145,7 +247,11 @@ public:
    /// 寫入 buf, 前後都不加料.
    /// 返回前 lk 可能已被解鎖!
    void Append(Locker&& lk, BufferList&& buf) {
-      this->IdxInfoSizeInterval_ += CalcDataSize(buf.cfront());
+      const size_t bufsz = CalcDataSize(buf.cfront());
+      this->IdxInfoSizeInterval_ += bufsz;
+      this->FileSize_ += bufsz;
+      if (fon9_UNLIKELY(this->WriteMode_ != FixRecorderWriteMode::Async))
+         this->AddSyncRequest(buf);
       WorkContentController* app = static_cast<WorkContentController*>(&WorkContentController::StaticCast(*lk));
       app->AddWork(std::move(lk), std::move(buf));
    }
@@ -160,6 +266,11 @@ public:
       const char* FoundDataEnd_;
       friend struct SentMessageSearcher;
       bool InitStart(FixRecorder& fixRecorder, FixSeqNum seqFrom);
+      /// 使用 fixRecorder 的送出序號索引, 取得序號 >= seqFrom 的第一筆送出訊息.
+      /// \retval >0 找到了, 已設定 CurMsg_ 及 FixParser_.
+      /// \retval =0 索引裡面沒有序號 >= seqFrom 的訊息.
+      /// \retval <0 無法使用索引(例: 索引與記錄檔不一致), 必須從檔尾往前搜尋.
+      int StartByIndex(FixRecorder& fixRecorder, FixSeqNum seqFrom);
 
    public:
       FixParser  FixParser_;
@@ -0,0 +1,64 @@
+﻿// \file fon9/fix/FixRecorderArgs.cpp
+// \author fonwinz@gmail.com
+#include "fon9/fix/FixRecorderArgs.hpp"
+#include "fon9/StrTo.hpp"
+
+namespace fon9 { namespace fix {
+
+static const StrView fixRecorderWriteModeStrMap[]{
+   fon9_MAKE_ENUM_CLASS_StrView_NoSeq(0, FixRecorderWriteMode, Async),
+   fon9_MAKE_ENUM_CLASS_StrView_NoSeq(1, FixRecorderWriteMode, GroupCommit),
+   fon9_MAKE_ENUM_CLASS_StrView_NoSeq(2, FixRecorderWriteMode, Direct),
+};
+
+fon9_API FixRecorderWriteMode StrToFixRecorderWriteMode(StrView value, FixRecorderWriteMode nullValue) {
+   int idx = 0;
+   for (const StrView& v : fixRecorderWriteModeStrMap) {
+      if (v == value)
+         return static_cast<FixRecorderWriteMode>(idx);
+      ++idx;
+   }
+   return nullValue;
+}
+
+fon9_API StrView FixRecorderWriteModeToStr(FixRecorderWriteMode value) {
+   size_t idx = static_cast<size_t>(value);
+   if (idx >= numofele(fixRecorderWriteModeStrMap))
+      return StrView("Unknown");
+   return fixRecorderWriteModeStrMap[idx];
+}
+
+//--------------------------------------------------------------------------//
+
+ConfigParser::Result FixRecorderArgs::OnTagValue(StrView tag, StrView& value) {
+   if (tag == "Mode") {
+      const FixRecorderWriteMode mode = StrToFixRecorderWriteMode(value, static_cast<FixRecorderWriteMode>(0xff));
+      if (mode == static_cast<FixRecorderWriteMode>(0xff))
+         return ConfigParser::Result::EInvalidValue;
+      this->Mode_ = mode;
+   }
+   else if (tag == "SyncInterval") {
+      const char*  pend;
+      TimeInterval ti = StrTo(value, TimeInterval::Null(), &pend);
+      if (ti.IsNull() || pend != value.end()) {
+         value.SetBegin(pend);
+         return ConfigParser::Result::EInvalidValue;
+      }
+      if (ti < TimeInterval{})
+         return ConfigParser::Result::EValueTooSmall;
+      this->SyncInterval_ = ti;
+   }
+   else if (tag == "SyncCount") {
+      const char* pend;
+      this->SyncCount_ = StrTo(value, 0u, &pend);
+      if (pend != value.end()) {
+         value.SetBegin(pend);
+         return ConfigParser::Result::EInvalidValue;
+      }
+   }
+   else
+      return ConfigParser::Result::EUnknownTag;
+   return ConfigParser::Result::Success;
+}
+
+} } // namespaces
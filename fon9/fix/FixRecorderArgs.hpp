@@ -0,0 +1,53 @@
+﻿/// \file fon9/fix/FixRecorderArgs.hpp
+/// \author fonwinz@gmail.com
+#ifndef __fon9_fix_FixRecorderArgs_hpp__
+#define __fon9_fix_FixRecorderArgs_hpp__
+#include "fon9/ConfigParser.hpp"
+#include "fon9/TimeInterval.hpp"
+
+namespace fon9 { namespace fix {
+
+/// \ingroup fix
+/// FixRecorder 的寫檔方式: 在「耐久性(主機當機時可能遺失多少記錄)」與「送出延遲」之間取捨.
+/// 寫檔一律在 DefaultThreadPool(或 FixShard::WriterPool_) 處理, 所以送出端都不用等候寫入儲存媒體.
+enum class FixRecorderWriteMode : uint8_t {
+   /// 寫入 OS 的檔案緩衝後就結束, 何時寫入儲存媒體由 OS 決定.
+   /// 程式異常結束不會遺失記錄, 但主機當機時可能會遺失最後的記錄.
+   Async,
+   /// 與 Async 相同方式寫入, 但依照 FixRecorderArgs::SyncInterval_, SyncCount_ 呼叫 fdatasync();
+   /// 同一批寫入的記錄, 共用一次 fdatasync().
+   GroupCommit,
+   /// 另外使用 O_DIRECT(Windows: FILE_FLAG_NO_BUFFERING) 開啟寫入用的檔案, 透過對齊的緩衝區寫入, 不經過 OS 的檔案緩衝.
+   /// - 檔案大小(metadata)仍需要 fdatasync() 才會寫入儲存媒體, 所以同樣依照 SyncInterval_, SyncCount_ 處理.
+   /// - 若檔案系統不支援, 則改用 GroupCommit, 並在記錄檔寫入一條錯誤訊息.
+   Direct,
+};
+
+fon9_API FixRecorderWriteMode StrToFixRecorderWriteMode(StrView value, FixRecorderWriteMode nullValue);
+fon9_API StrView FixRecorderWriteModeToStr(FixRecorderWriteMode value);
+
+fon9_WARN_DISABLE_PADDING;
+/// \ingroup fix
+/// FixRecorder 的寫檔參數.
+/// args: "Mode=GroupCommit|SyncInterval=5ms|SyncCount=100"
+struct fon9_API FixRecorderArgs {
+   FixRecorderWriteMode Mode_{FixRecorderWriteMode::Async};
+   /// GroupCommit, Direct: 從第一筆尚未 fdatasync() 的記錄開始, 最多經過多久必須 fdatasync().
+   /// 0 = 不檢查時間.
+   TimeInterval   SyncInterval_{};
+   /// GroupCommit, Direct: 累積多少筆尚未 fdatasync() 的記錄, 就必須 fdatasync().
+   /// 0 = 不檢查筆數; 若 SyncInterval_ 也是 0, 則每批寫入後都會 fdatasync().
+   uint32_t       SyncCount_{0};
+
+   /// 用 tag, value 設定參數.
+   /// tag          | value
+   /// -------------|------------------------------
+   /// Mode         | "Async" or "GroupCommit" or "Direct"
+   /// SyncInterval | >= 0, 例: "5ms", "0.5"(秒)
+   /// SyncCount    | >= 0
+   ConfigParser::Result OnTagValue(StrView tag, StrView& value);
+};
+fon9_WARN_POP;
+
+} } // namespaces
+#endif//__fon9_fix_FixRecorderArgs_hpp__
@@ -27,6 +27,17 @@ static const char* SkipTimestamp(const char* pbeg, const char* pend) {
 static inline FixSeqNum GetSeqNum(const char* pbeg, const char* pend, const char** endptr) {
    return StrTo(StrView{pbeg,pend}, static_cast<FixSeqNum>(0), endptr);
 }
+// pbeg = "S timestamp FIX Message" 的開頭.
+// \retval nullptr  格式錯誤.
+// \retval !nullptr FIX Message 的開始位置, fixParser.GetMsgSeqNum() 為此筆訊息的序號.
+static const char* ParseSentLine(FixParser& fixParser, const char* pbeg, const char* pend) {
+   if (*pbeg != f9fix_kCSTR_HdrSend[0] || (pbeg = SkipTimestamp(pbeg, pend)) == nullptr)
+      return nullptr;
+   StrView fixmsg{pbeg, pend};
+   fixParser.Clear();
+   fixParser.ParseFields(fixmsg, FixParser::Until::MsgSeqNum);
+   return pbeg;
+}
 //--------------------------------------------------------------------------//
 const char* FixRecorder::FixRevSercher::ParseControlMsgSeqNum(const char* pbeg, const char* pend,
                                                               FixSeqNum* outNextSend, FixSeqNum* outNextRecv) {
@@ -102,7 +113,7 @@ void FixRecorder::LastSeqSearcher::ParseFixLine_MsgSeqNum_ToNextSeq(const char*
       if (seqn > 0)
          ++seqn;
 }
-LoopControl FixRecorder::LastSeqSearcher::OnFoundChar(char* pbeg, char* pend) {
+LoopControl FixRecorder::LastSeqSearcher::OnFoundChar(const char* pbeg, const char* pend) {
    assert(pbeg < pend);
    switch (*++pbeg) {
    default: return LoopControl::Continue;
@@ -171,13 +182,13 @@ LoopControl FixRecorder::SentMessageSearcher::OnFileBlock(size_t rdsz) {
       return LoopControl::Continue;
 __RETURN_BREAK_READ_LOOP:
    if (this->FoundDataEnd_ < pend)
-      this->FoundDataEnd_ = const_cast<char*>(pend);
+      this->FoundDataEnd_ = pend;
    return LoopControl::Break;
 }
-LoopControl FixRecorder::SentMessageSearcher::OnFoundChar(char* pbeg, char* pend) {
+LoopControl FixRecorder::SentMessageSearcher::OnFoundChar(const char* pbeg, const char* pend) {
    assert(*pbeg == f9fix_kCHAR_HdrCtrlMsgSeqNum);
    FixSeqNum nextSendSeq = 0;
-   pend = const_cast<char*>(this->ParseControlMsgSeqNum(pbeg, pend, &nextSendSeq, nullptr));
+   pend = this->ParseControlMsgSeqNum(pbeg, pend, &nextSendSeq, nullptr);
    if (nextSendSeq <= 0)
       return LoopControl::Continue;
    if (nextSendSeq <= this->ExpectSeq_ || (this->RstFlags_ & RstSend) != 0) {
@@ -192,6 +203,137 @@ LoopControl FixRecorder::SentMessageSearcher::OnFoundChar(char* pbeg, char* pend
    return LoopControl::Continue;
 }
 //--------------------------------------------------------------------------//
+void FixRecorder::LoadSentIndex(std::string fname) {
+   File::Result res = this->SentIndex_.Open(fname);
+   if (!res) {
+      this->Write(f9fix_kCSTR_HdrError, "f9fix.FixRecorder.SentIndex.Open|fname=", fname, '|', res);
+      return;
+   }
+   File::PosType scanFrom = 0;
+   bool          isSkipFirstLine = false;
+   StrView       rebuild;
+   if (const FixSentIndex::Record* rec = this->SentIndex_.LastRecord()) {
+      if (this->IsSentIndexRecordValid(*rec)) {
+         // 從最後一筆索引的位置開始補上, 如果最後一筆是 Sent, 則該行已在索引內.
+         scanFrom = rec->Pos_;
+         isSkipFirstLine = (rec->Kind_ == FixSentIndex::RecordKind::Sent);
+      }
+      else {
+         // 索引與記錄檔不一致(例: 記錄檔被換掉了), 必須重建.
+         if (!(res = this->SentIndex_.Clear())) {
+            this->Write(f9fix_kCSTR_HdrError, "f9fix.FixRecorder.SentIndex.Clear|fname=", fname, '|', res);
+            return;
+         }
+         rebuild = "|rebuild=Stale";
+      }
+   }
+   this->ScanSentIndex(scanFrom, isSkipFirstLine);
+   this->SentIndex_.Flush();
+   this->IsSentIndexReady_ = true;
+   this->Write(f9fix_kCSTR_HdrInfo,
+               "f9fix.FixRecorder.SentIndex:"
+               "|count=", this->SentIndex_.size(),
+               "|scanFrom=", scanFrom,
+               "|scanSize=", this->FileSize_ - scanFrom,
+               rebuild);
+}
+bool FixRecorder::IsSentIndexRecordValid(const FixSentIndex::Record& rec) {
+   if (rec.Pos_ >= this->FileSize_)
+      return false;
+   char         buf[kMaxFixMsgBufferSize + kTimeStampWidth + 4];
+   File::Result res = this->GetStorage().Read(rec.Pos_, buf, sizeof(buf));
+   if (!res || res.GetResult() <= 0)
+      return false;
+   // RstSend 記錄的位置: "S timestamp SequenceReset" 或 "RST|S=".
+   if (rec.Kind_ != FixSentIndex::RecordKind::Sent)
+      return buf[0] == f9fix_kCSTR_HdrSend[0] || buf[0] == f9fix_kCHAR_HdrCtrlMsgSeqNum;
+   const char* lnEnd = reinterpret_cast<const char*>(memchr(buf, '\n', res.GetResult()));
+   if (lnEnd == nullptr)
+      return false;
+   FixParser fixParser;
+   return ParseSentLine(fixParser, buf, lnEnd) != nullptr && fixParser.GetMsgSeqNum() == rec.Seq_;
+}
+// 將 [pbeg..pend) 之間的完整行加入 sidx, 尾端不完整的行不處理.
+// pos = pbeg 的檔案位置.
+// \retval nullptr  沒有任何完整的行.
+// \retval !nullptr 下一個未處理的位置.
+static const char* ScanSentLines(FixSentIndex& sidx, FixParser& fixParser, bool& isSkipFirstLine,
+                                 File::PosType pos, const char* pbeg, const char* const pend) {
+   static const char kRstSend[] = f9fix_kCSTR_HdrRst f9fix_kCSTR_HdrNextSendSeq;
+   const char* const pstart = pbeg;
+   const char* lnEnd = reinterpret_cast<const char*>(memchr(pbeg, '\n', static_cast<size_t>(pend - pbeg)));
+   if (lnEnd == nullptr)
+      return nullptr;
+   do {
+      if (isSkipFirstLine)
+         isSkipFirstLine = false;
+      else {
+         const File::PosType lnPos = pos + static_cast<File::PosType>(pbeg - pstart);
+         if (*pbeg == f9fix_kCSTR_HdrSend[0]) {
+            if (ParseSentLine(fixParser, pbeg, lnEnd) && fixParser.GetMsgSeqNum() > 0)
+               sidx.Append(FixSentIndex::RecordKind::Sent, fixParser.GetMsgSeqNum(), lnPos);
+         }
+         else if (*pbeg == f9fix_kCHAR_HdrCtrlMsgSeqNum
+                  && static_cast<size_t>(lnEnd - pbeg) > sizeof(kRstSend) - 1
+                  && memcmp(pbeg, kRstSend, sizeof(kRstSend) - 1) == 0) {
+            sidx.Append(FixSentIndex::RecordKind::RstSend,
+                        GetSeqNum(pbeg + sizeof(kRstSend) - 1, lnEnd, nullptr),
+                        lnPos);
+         }
+         // 在 Initialize() 裡面, 還沒有送出訊息, 不會有寫檔 thread 同時寫入附屬檔, 所以直接寫入.
+         if (sidx.IsFlushRequired())
+            sidx.Flush();
+      }
+      pbeg = lnEnd + 1;
+   } while ((lnEnd = reinterpret_cast<const char*>(memchr(pbeg, '\n', static_cast<size_t>(pend - pbeg)))) != nullptr);
+   return pbeg;
+}
+void FixRecorder::ScanSentIndex(File::PosType pos, bool isSkipFirstLine) {
+   FixParser   fixParser;
+   FileMapView mapped;
+   // 重建索引時, 可能需要從頭掃描整個檔案, 使用 mmap + Sequential 讓核心積極預讀.
+   if (mapped.Map(this->GetStorage(), FileMapView::Advice::Sequential) && this->FileSize_ <= mapped.size()) {
+      if (pos < this->FileSize_)
+         ScanSentLines(this->SentIndex_, fixParser, isSkipFirstLine, pos,
+                       mapped.data() + pos, mapped.data() + this->FileSize_);
+      return;
+   }
+   std::unique_ptr<char[]> buf{new char[kReloadSentBufferSize]};
+   while (pos < this->FileSize_) {
+      File::Result res = this->GetStorage().Read(pos, buf.get(), kReloadSentBufferSize);
+      if (!res || res.GetResult() <= 0)
+         break;
+      const char* pnext = ScanSentLines(this->SentIndex_, fixParser, isSkipFirstLine, pos,
+                                        buf.get(), buf.get() + res.GetResult());
+      if (pnext == nullptr) // 超過緩衝區大小的一行, 不會是 FIX Message, 直接跳過.
+         pos += static_cast<File::PosType>(res.GetResult());
+      else
+         pos += static_cast<File::PosType>(pnext - buf.get());
+   }
+}
+int FixRecorder::ReloadSent::StartByIndex(FixRecorder& fixRecorder, FixSeqNum seqFrom) {
+   FixSentIndex::Record rec;
+   {
+      Locker lk{fixRecorder.Lock()};
+      if (!fixRecorder.IsSentIndexReady_ || !fixRecorder.SentIndex_.IsCovered(seqFrom))
+         return -1;
+      if (!fixRecorder.SentIndex_.LowerBound(seqFrom, rec))
+         return 0;
+   }
+   File::Result res = fixRecorder.GetStorage().Read(rec.Pos_, this->Buffer_, kReloadSentBufferSize);
+   if (!res)
+      return -1;
+   const char* const lnEnd = reinterpret_cast<const char*>(memchr(this->Buffer_, '\n', res.GetResult()));
+   if (lnEnd == nullptr)
+      return -1;
+   const char* const pmsg = ParseSentLine(this->FixParser_, this->Buffer_, lnEnd);
+   if (pmsg == nullptr || this->FixParser_.GetMsgSeqNum() != rec.Seq_)
+      return -1;
+   this->CurBufferPos_ = rec.Pos_;
+   this->FoundDataEnd_ = this->Buffer_ + res.GetResult();
+   this->CurMsg_.Reset(pmsg, lnEnd);
+   return 1;
+}
 bool FixRecorder::ReloadSent::InitStart(FixRecorder& fixRecorder, FixSeqNum seqFrom) {
    this->FixParser_.ResetExpectHeader(ToStrView(fixRecorder.BeginHeader_));
    this->CurBufferPos_ = 0;
@@ -204,6 +346,12 @@ bool FixRecorder::ReloadSent::InitStart(FixRecorder& fixRecorder, FixSeqNum seqF
 StrView FixRecorder::ReloadSent::Find(FixRecorder& fixRecorder, FixSeqNum seq) {
    if (!this->InitStart(fixRecorder, seq))
       return StrView{};
+   const int idxres = this->StartByIndex(fixRecorder, seq);
+   if (idxres >= 0) {
+      if (idxres > 0 && this->FixParser_.GetMsgSeqNum() == seq)
+         return this->CurMsg_;
+      return this->CurMsg_ = nullptr;
+   }
    SentMessageSearcher  searcher{*this};
    File::Result         res = searcher.Start(*this, seq, fixRecorder.GetStorage());
    if (fon9_LIKELY(res && !searcher.FoundLine_.empty())) {
@@ -215,6 +363,24 @@ StrView FixRecorder::ReloadSent::Find(FixRecorder& fixRecorder, FixSeqNum seq) {
 StrView FixRecorder::ReloadSent::Start(FixRecorder& fixRecorder, FixSeqNum seqFrom) {
    if (!this->InitStart(fixRecorder, seqFrom))
       return StrView{};
+   const int idxres = this->StartByIndex(fixRecorder, seqFrom);
+   if (idxres > 0) {
+      fixRecorder.Write(f9fix_kCSTR_HdrInfo,
+                        "ReloadSent:"
+                        "|seq=", seqFrom,
+                        "|foundAt=", this->CurBufferPos_,
+                        "|foundSeq=", this->FixParser_.GetMsgSeqNum(),
+                        "|by=SentIndex");
+      return this->CurMsg_;
+   }
+   if (idxres == 0) {
+      fixRecorder.Write(f9fix_kCSTR_HdrInfo,
+                        "ReloadSent:"
+                        "|seq=", seqFrom,
+                        "|err=Not found."
+                        "|by=SentIndex");
+      return this->CurMsg_ = nullptr;
+   }
    SentMessageSearcher  searcher{*this};
    File::Result         res = searcher.Start(*this, seqFrom, fixRecorder.GetStorage());
    if (!res)
@@ -64,12 +64,15 @@ struct FixRecorder::LastSeqSearcher : public FileRevReadBuffer<kLastSeqSearcherB
    FixSeqNum   NextRecvSeq_ = 0;
 
    virtual LoopControl OnFileBlock(size_t rdsz) override;
+   void OnFileMapped(const char* pblock, size_t rdsz) override {
+      this->SetMappedBlock(pblock, rdsz);
+   }
 
    /// *pbeg=='\n', 解析:
    /// - f9fix_kCSTR_HdrCtrlMsgSeqNum line.
    /// - "R timestamp FIX Message"
    /// - "S timestamp FIX Message"
-   LoopControl OnFoundChar(char* pbeg, char* pend) override;
+   LoopControl OnFoundChar(const char* pbeg, const char* pend) override;
 
    void ParseFixLine_MsgSeqNum_ToNextSeq(const char* pbeg, const char* pend, FixSeqNum& seqn);
 };
@@ -92,7 +95,7 @@ struct FixRecorder::SentMessageSearcher : public RevReadSearcher<FileRevRead, Fi
 
    File::Result Start(ReloadSent& reloader, FixSeqNum expectSeq, File& fd);
    LoopControl OnFileBlock(size_t rdsz) override;
-   LoopControl OnFoundChar(char* pbeg, char* pend) override;
+   LoopControl OnFoundChar(const char* pbeg, const char* pend) override;
 
    void SetAtAfter(const char* p) {
       this->PtrAtAfter_ = p;
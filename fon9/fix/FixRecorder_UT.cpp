@@ -6,6 +6,7 @@
 #include "fon9/fix/FixBuilder.hpp"
 #include "fon9/Timer.hpp"
 #include "fon9/DefaultThreadPool.hpp"
+#include "fon9/ConfigParser.hpp"
 
 namespace f9fix = fon9::fix;
 
@@ -33,7 +34,7 @@ void TestFixRecorder(f9fix::FixRecorder& fixr, const unsigned kTimes) {
       fon9::RevBufferList  rbuf{1024};
       fon9::RevPrint(rbuf, f9fix_kCSTR_HdrSend, fon9::UtcNow(), ' ', sbuf, '\n');
       // send(sbuf);
-      fixr.WriteAfterSend(std::move(lk), std::move(rbuf), ++seq);
+      fixr.WriteAfterSend(std::move(lk), std::move(rbuf), seq + 1, seq, false);
       // unlock;
    }
 }
@@ -63,6 +64,100 @@ void CheckReloadSent(f9fix::FixRecorder& fixr, f9fix::FixSeqNum seqFrom, f9fix::
       abort();
    }
 }
+void CheckReloadSentAll(f9fix::FixRecorder& fixr, const unsigned kTimes, const char* testName) {
+   std::cout << "[TEST ] " << testName;
+   unsigned pers = 0;
+   for (unsigned L = 0; L < kTimes; ++L) {
+      CheckReloadSent(fixr, L + 1, kTimes - L);
+      unsigned p = (L + 1) * 100 / kTimes;
+      if (pers != p) {
+         pers = p;
+         fprintf(stdout, "%3u%%\b\b\b\b", pers);
+         fflush(stdout);
+      }
+   }
+   std::cout << "\r" "[OK   ]" << std::endl;
+}
+f9fix::FixRecorderSP ReopenFixRecorder(const char* fixrFileName, const f9fix::CompIDs& compIds,
+                                       const f9fix::FixRecorderArgs& args = f9fix::FixRecorderArgs{}) {
+   f9fix::FixRecorderSP fixr{new f9fix::FixRecorder(f9fix_BEGIN_HEADER_V42, f9fix::CompIDs{compIds})};
+   fon9::File::Result   res;
+   int count = 100;
+   while (!(res = fixr->Initialize(fixrFileName, args))) {
+      if (--count <= 0) {
+         std::cout << "Reopen FixRecorder|fileName=" << fixrFileName
+            << "|err=" << fon9::RevPrintTo<std::string>(res) << std::endl;
+         abort();
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds{10});
+   }
+   return fixr;
+}
+//--------------------------------------------------------------------------//
+/// 使用 cfgstr 設定的寫檔方式, 寫入 kTimes 筆收送訊息後, 檢查統計資料, 並重新開檔檢查內容.
+void TestWriteMode(const f9fix::CompIDs& compIds, const char* cfgstr, const unsigned kTimes) {
+   std::cout << "[TEST ] WriteMode: " << cfgstr;
+   f9fix::FixRecorderArgs args;
+   fon9::RevBufferFixedSize<1024> rbuf;
+   if (!fon9::ParseConfig(args, fon9::StrView_cstr(cfgstr), rbuf)) {
+      std::cout << "|err=" << rbuf.ToStrT<std::string>() << "\r" "[ERROR]" << std::endl;
+      abort();
+   }
+   const char fixrFileName[] = "FixRecorder_UT.wm.log";
+   const char sidxFileName[] = "FixRecorder_UT.wm.log.sidx";
+   remove(fixrFileName);
+   remove(sidxFileName);
+   f9fix::FixRecorderSP fixr = ReopenFixRecorder(fixrFileName, compIds, args);
+   TestFixRecorder(*fixr, kTimes);
+   fixr->WaitFlushed();
+   // 只有 SyncInterval 時, 等候 SyncTimer_ 觸發.
+   for (unsigned L = 0; L < 100 && args.Mode_ != f9fix::FixRecorderWriteMode::Async; ++L) {
+      if (fixr->GetWriteStats().SyncTimes_ > 0)
+         break;
+      std::this_thread::sleep_for(std::chrono::milliseconds{10});
+   }
+   fixr->WaitFlushed();
+   const f9fix::FixRecorderWriteStats st = fixr->GetWriteStats();
+   std::cout << "|mode=" << f9fix::FixRecorderWriteModeToStr(st.Mode_).ToString()
+             << "|queuing=" << st.QueuingNodeCount_ << ',' << st.QueuingBytes_
+             << "|syncTimes=" << st.SyncTimes_
+             << "|lastSync=" << fon9::RevPrintTo<std::string>(st.LastSyncLatency_);
+   if (st.QueuingBytes_ != 0 || st.QueuingNodeCount_ != 0
+       || (args.Mode_ == f9fix::FixRecorderWriteMode::Async) != (st.SyncTimes_ == 0)) {
+      std::cout << "\r" "[ERROR]" << std::endl;
+      abort();
+   }
+   std::cout << "\r" "[OK   ]" << std::endl;
+   CheckReloadSentAll(*fixr, kTimes, "Reload sent.");
+   fixr.reset();
+
+   // Direct: 尾端不足一個 block 的部分, 補 0 寫入後必須調整檔案大小, 所以檔案內容不可有 '\0'.
+   std::cout << "[TEST ] WriteMode: Check file content.";
+   if (FILE* fd = fopen(fixrFileName, "rb")) {
+      char     buf[1024 * 4];
+      size_t   rdsz;
+      while ((rdsz = fread(buf, 1, sizeof(buf), fd)) > 0) {
+         if (memchr(buf, '\0', rdsz) != nullptr) {
+            std::cout << "|err=Found '\\0'" "\r" "[ERROR]" << std::endl;
+            abort();
+         }
+      }
+      fclose(fd);
+   }
+   std::cout << "\r" "[OK   ]" << std::endl;
+
+   fixr = ReopenFixRecorder(fixrFileName, compIds, args);
+   if (fixr->GetNextRecvSeq() != kTimes + 1 || fixr->GetNextSendSeq(fixr->Lock()) != kTimes + 1) {
+      std::cout << "Reopen FixRecorder|fileName=" << fixrFileName << "|err=Unexpected NextSeq" << std::endl;
+      abort();
+   }
+   // 重新開檔後, 接續寫入的內容也必須正確.
+   TestFixRecorder(*fixr, kTimes);
+   CheckReloadSentAll(*fixr, kTimes * 2, "Reload sent after reopen.");
+   fixr.reset();
+   fon9::WaitRemoveFile(fixrFileName);
+   fon9::WaitRemoveFile(sidxFileName);
+}
 //--------------------------------------------------------------------------//
 
 int main(int argc, char** argv) {
@@ -78,7 +173,9 @@ int main(int argc, char** argv) {
    f9fix::CompIDs       compIds{"SenderCoId", "SenderSubId", "TargetCoId", "TargetSubId"};
    f9fix::FixRecorderSP fixr{new f9fix::FixRecorder(f9fix_BEGIN_HEADER_V42, f9fix::CompIDs{compIds})};
    const char           fixrFileName[] = "FixRecorder_UT.log";
+   const char           sidxFileName[] = "FixRecorder_UT.log.sidx";
    remove(fixrFileName);
+   remove(sidxFileName);
    auto res = fixr->Initialize(fixrFileName);
    if (!res) {
       std::cout << "Open FixRecorder|fileName=" << fixrFileName
@@ -93,18 +190,7 @@ int main(int argc, char** argv) {
    TestFixRecorder(*fixr, kTimes);
    stopWatch.PrintResult("FixRecorder(recv + send)", kTimes);
 
-   std::cout << "[TEST ] Reload sent.";
-   unsigned pers = 0;
-   for (unsigned L = 0; L < kTimes; ++L) {
-      CheckReloadSent(*fixr, L + 1, kTimes - L);
-      unsigned p = (L + 1) * 100 / kTimes;
-      if (pers != p) {
-         pers = p;
-         fprintf(stdout, "%3u%%\b\b\b\b", pers);
-         fflush(stdout);
-      }
-   }
-   std::cout << "\r" "[OK   ]" << std::endl;
+   CheckReloadSentAll(*fixr, kTimes, "Reload sent.");
 
    // Test: 檔案已存在, NextSendSeq, NextRecvSeq 是否正確.
    // 再寫入一筆 recv, 讓 NextRecvSeq != NextSendSeq
@@ -112,16 +198,8 @@ int main(int argc, char** argv) {
    BuildTestMessage(fixb, ToStrView(fixr->CompIDs_.Header_), kTimes + 1, fixr->GetNextRecvSeq());
    fixr->WriteInputConform(fon9::ToStrView(fon9::BufferTo<std::string>(fixb.Final(ToStrView(fixr->BeginHeader_)))));
    fixr->WaitFlushed();
-   fixr.reset(new f9fix::FixRecorder(f9fix_BEGIN_HEADER_V42, f9fix::CompIDs{compIds}));
-   int count = 100;
-   do {
-      if (--count <= 0) {
-         std::cout << "Reopen FixRecorder|fileName=" << fixrFileName
-            << "|err=" << fon9::RevPrintTo<std::string>(res) << std::endl;
-         abort();
-      }
-      std::this_thread::sleep_for(std::chrono::milliseconds{10});
-   } while (!fixr->Initialize(fixrFileName));
+   fixr.reset();
+   fixr = ReopenFixRecorder(fixrFileName, compIds);
    if (fixr->GetNextRecvSeq() != kTimes + 2 || fixr->GetNextSendSeq(fixr->Lock()) != kTimes + 1) {
       std::cout << "Reopen FixRecorder|fileName=" << fixrFileName
          << "|err=Unexpected NextSeq|expectNextRecvSeq=" << kTimes + 2
@@ -132,8 +210,35 @@ int main(int argc, char** argv) {
       abort();
    }
 
+   CheckReloadSentAll(*fixr, kTimes, "Reload sent after reopen.");
+
+   // Test: SentIndex 不存在, 重新開啟時必須重建.
+   fixr.reset();
+   fon9::WaitRemoveFile(sidxFileName);
+   fixr = ReopenFixRecorder(fixrFileName, compIds);
+   CheckReloadSentAll(*fixr, kTimes, "Reload sent after SentIndex rebuild.");
+
+   // Test: SentIndex 與記錄檔不一致(最後一筆指向錯誤的位置), 且尾端有不完整的記錄.
+   fixr.reset();
+   if (FILE* fd = fopen(sidxFileName, "ab")) {
+      static const char kStaleRecord[] = "\x7f\xff\xff\xff" "\0\0\0\0" "\0\0\0\0\0\0\0\0" "\x01\x02\x03";
+      fwrite(kStaleRecord, sizeof(kStaleRecord) - 1, 1, fd);
+      fclose(fd);
+   }
+   fixr = ReopenFixRecorder(fixrFileName, compIds);
+   CheckReloadSentAll(*fixr, kTimes, "Reload sent after stale SentIndex.");
+
+   utinfo.PrintSplitter();
+   TestWriteMode(compIds, "Mode=Async", kTimes);
+   TestWriteMode(compIds, "Mode=GroupCommit", kTimes);
+   TestWriteMode(compIds, "Mode=GroupCommit|SyncCount=100", kTimes);
+   TestWriteMode(compIds, "Mode=GroupCommit|SyncInterval=5ms", kTimes);
+   TestWriteMode(compIds, "Mode=Direct|SyncCount=100|SyncInterval=5ms", kTimes);
+
    // 結束前刪除測試檔.
    fixr.reset();
-   if (!fon9::IsKeepTestFiles(argc, argv))
+   if (!fon9::IsKeepTestFiles(argc, argv)) {
       fon9::WaitRemoveFile(fixrFileName);
+      fon9::WaitRemoveFile(sidxFileName);
+   }
 }
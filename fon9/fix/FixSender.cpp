@@ -15,6 +15,8 @@ void FixSender::Send(Locker&&       locker,
                      FixBuilder&&   fixmsgBuilder,
                      FixSeqNum      nextSeqNum,
                      RevBufferList* fixmsgDupOut) {
+   // header 直接 RevPrint(): 曾試過預先建立 header 樣板(只填入 MsgSeqNum, SendingTime, 並累加 CheckSum),
+   // FixBench_UT 的 Build 反而較慢(約 175ns vs 165ns), 主要耗時在取時間及分配緩衝區, 所以不使用樣板.
    // CompIDs
    RevBuffer& msgRBuf = fixmsgBuilder.GetBuffer();
    RevPrint(msgRBuf, this->CompIDs_.Header_);
@@ -38,7 +40,8 @@ void FixSender::Send(Locker&&       locker,
       RevPrint(*fixmsgDupOut, fixmsg);
    // 建立要寫入 FixRecorder 的訊息.
    RevBufferList rlog{static_cast<BufferNodeSize>(64 + fixmsgSize)};
-   if (fon9_LIKELY(nextSeqNum == 0))
+   const bool    isRstSend = (nextSeqNum != 0);
+   if (fon9_LIKELY(!isRstSend))
       nextSeqNum = msgSeqNum + 1;
    else
       RevPrint(rlog, f9fix_kCSTR_HdrRst f9fix_kCSTR_HdrNextSendSeq, nextSeqNum, '\n');
@@ -48,7 +51,61 @@ void FixSender::Send(Locker&&       locker,
       this->OnSendFixMessage(locker, std::move(fixmsg));
    else
       DcQueueList{std::move(fixmsg)}.PopConsumed(fixmsgSize);
-   this->WriteAfterSend(std::move(locker), std::move(rlog), nextSeqNum);
+   this->WriteAfterSend(std::move(locker), std::move(rlog), nextSeqNum, msgSeqNum, isRstSend);
+}
+
+void FixSender::SendBatch(Locker&&       locker,
+                          const StrView& fldMsgType,
+                          FixBuilder*    fixmsgBuilders,
+                          size_t         count,
+                          RevBufferList* fixmsgDupOut) {
+   if (count <= 0)
+      return;
+   // 先依序完成全部的 FIX Message, 然後再由後往前建立要寫入 FixRecorder 的訊息.
+   struct SentMsg {
+      BufferList  FixMsg_;
+      TimeStamp   SentTime_;
+      size_t      LineSize_;
+   };
+   std::vector<SentMsg> msgs(count);
+   const FixSeqNum      firstSeqNum = this->GetNextSendSeq(locker);
+   size_t               fixmsgsSize = 0;
+   size_t               rlogSize = 0;
+   for (size_t L = 0; L < count; ++L) {
+      FixBuilder& fixmsgBuilder = fixmsgBuilders[L];
+      RevBuffer&  msgRBuf = fixmsgBuilder.GetBuffer();
+      // 欄位順序必須與 Send() 相同, 因為 Replayer::Rebuild() 依賴此順序.
+      RevPrint(msgRBuf, this->CompIDs_.Header_);
+      fixmsgBuilder.PutUtcNow();
+      RevPrint(msgRBuf, f9fix_SPLTAGEQ(SendingTime));
+      RevPrint(msgRBuf, fldMsgType, f9fix_SPLTAGEQ(MsgSeqNum), firstSeqNum + static_cast<FixSeqNum>(L));
+
+      SentMsg& msg = msgs[L];
+      msg.FixMsg_ = fixmsgBuilder.Final(ToStrView(this->BeginHeader_));
+      msg.SentTime_ = fixmsgBuilder.GetUtcNow();
+      const size_t fixmsgSize = CalcDataSize(msg.FixMsg_.cfront());
+      fixmsgsSize += fixmsgSize;
+      // "S " + timestamp + ' ' + FIX Message + '\n'
+      rlogSize += (msg.LineSize_ = sizeof(f9fix_kCSTR_HdrSend) - 1 + kTimeStampWidth + 1 + fixmsgSize + 1);
+   }
+   this->LastSentTime_ = msgs.back().SentTime_;
+   RevBufferList rlog{static_cast<BufferNodeSize>(64 + rlogSize)};
+   for (size_t L = count; L > 0;) {
+      const SentMsg& msg = msgs[--L];
+      RevPrint(rlog, f9fix_kCSTR_HdrSend, msg.SentTime_, ' ', msg.FixMsg_, '\n');
+   }
+   BufferList fixmsgs;
+   for (SentMsg& msg : msgs)
+      fixmsgs.push_back(std::move(msg.FixMsg_));
+   if (fixmsgDupOut)
+      RevPrint(*fixmsgDupOut, fixmsgs);
+   // 送出訊息.
+   if (fon9_LIKELY(!this->IsReplayingAll_))
+      this->OnSendFixMessage(locker, std::move(fixmsgs));
+   else
+      DcQueueList{std::move(fixmsgs)}.PopConsumed(fixmsgsSize);
+   this->WriteAfterSendBatch(std::move(locker), std::move(rlog), firstSeqNum, count,
+                             [&msgs](size_t idx) { return msgs[idx].LineSize_; });
 }
 
 void FixSender::ResetNextSendSeq(FixSeqNum nextSeqNum) {
@@ -56,7 +113,7 @@ void FixSender::ResetNextSendSeq(FixSeqNum nextSeqNum) {
       return;
    RevBufferList rlog{128};
    RevPrint(rlog, f9fix_kCSTR_HdrRst f9fix_kCSTR_HdrNextSendSeq, nextSeqNum, '\n');
-   this->WriteAfterSend(this->Lock(), std::move(rlog), nextSeqNum);
+   this->WriteAfterSend(this->Lock(), std::move(rlog), nextSeqNum, 0, true);
 }
 void FixSender::SequenceReset(FixSeqNum newSeqNo) {
    FixBuilder msgSequenceReset;
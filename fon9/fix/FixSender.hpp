@@ -80,6 +80,25 @@ public:
       this->Send(std::move(locker), fldMsgType, std::move(fixmsgBuilder), 0, fixmsgDupOut);
    }
 
+   /// 批次送出 count 筆相同 MsgType 的訊息(例: 大量刪單).
+   /// - 在同一次鎖定內, 依序取得連續的 count 個 MsgSeqNum, 完成全部的訊息;
+   /// - 合併成一個 BufferList, 只觸發一次 OnSendFixMessage();
+   /// - 合併成一次 Recorder 寫入.
+   /// \param fixmsgBuilders count 個已填妥 AP 欄位的訊息, 填寫規則與 Send() 相同.
+   ///                       返回後全部都已 Final(), 若要重複使用, 必須先 Restart().
+   /// \param fixmsgDupOut   如果 != nullptr, 則複製一份送出的 FIX Messages(依序相連).
+   void SendBatch(Locker&&       locker,
+                  const StrView& fldMsgType,
+                  FixBuilder*    fixmsgBuilders,
+                  size_t         count,
+                  RevBufferList* fixmsgDupOut = nullptr);
+   void SendBatch(const StrView& fldMsgType,
+                  FixBuilder*    fixmsgBuilders,
+                  size_t         count,
+                  RevBufferList* fixmsgDupOut = nullptr) {
+      this->SendBatch(this->Lock(), fldMsgType, fixmsgBuilders, count, fixmsgDupOut);
+   }
+
    /// 重設下一個輸出序號.
    /// - 送出 SequenceReset Message.
    /// - 在 Recorder 寫一個 "RST|S=newSeqNo" 記錄.
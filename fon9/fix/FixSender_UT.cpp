@@ -42,6 +42,32 @@ void TestFixSenderWrite2(f9fix::FixSender& fixSender, unsigned count, const fon9
    }
 }
 
+void TestFixSenderBatch(f9fix::FixSender& fixSender, unsigned count, const fon9::StrView& fldMsgType, fon9::StrView apFields) {
+   std::unique_ptr<f9fix::FixBuilder[]> fixbs{new f9fix::FixBuilder[count]};
+   for (unsigned L = 0; L < count; ++L)
+      RevPrint(fixbs[L].GetBuffer(), apFields);
+   fon9::RevBufferList  fixmsgDupOut{128};
+   fixSender.SendBatch(fldMsgType, fixbs.get(), count, &fixmsgDupOut);
+   // fixmsgDupOut 應包含 count 筆依序相連的訊息.
+   std::string       fixmsgStr = fon9::BufferTo<std::string>(fixmsgDupOut.MoveOut());
+   fon9::StrView     fixmsgs{&fixmsgStr};
+   f9fix::FixParser  fixpr;
+   for (unsigned L = 0; L < count; ++L) {
+      const char*             pbeg = fixmsgs.begin();
+      f9fix::FixParser::Result res = fixpr.Parse(fixmsgs);
+      if (res <= f9fix::FixParser::NeedsMore) {
+         std::cout << "|err=SendBatch() fixmsg dup out error.\r[ERROR]" << std::endl;
+         abort();
+      }
+      fixmsgs.Reset(pbeg + static_cast<size_t>(res), fixmsgStr.c_str() + fixmsgStr.size());
+      fixpr.Clear();
+   }
+   if (!fixmsgs.empty()) {
+      std::cout << "|err=SendBatch() fixmsg dup out too long.\r[ERROR]" << std::endl;
+      abort();
+   }
+}
+
 //--------------------------------------------------------------------------//
 
 fon9_WARN_DISABLE_PADDING;
@@ -56,7 +82,9 @@ int main(int argc, char** argv) {
    std::this_thread::sleep_for(std::chrono::milliseconds{10});
 
    const char  fixrFileName[] = "FixSender_UT.log";
+   const char  sidxFileName[] = "FixSender_UT.log.sidx";
    remove(fixrFileName);
+   remove(sidxFileName);
 
    struct FixSender : public f9fix::FixSender {
       fon9_NON_COPY_NON_MOVE(FixSender);
@@ -189,9 +217,26 @@ int main(int argc, char** argv) {
    fixFeeder.CheckReplayDone(nextSendSeq);
    std::cout << "|count(Include SeqReset)=" << fixFeeder.Count_ << "\r[OK   ]\n";
 
+   // SendBatch(): 一次 OnSendFixMessage() 包含全部的訊息, 且之後可正確 replay.
+   std::cout << "[TEST ] SendBatch 100";
+   const auto batchFirstSeq = nextSendSeq;
+   fixFeeder.Count_ = 0;
+   fixFeeder.ExpectedSeqNum_ = batchFirstSeq;
+   TestFixSenderBatch(*fixSender, 100, f9fix_SPLFLDMSGTYPE(ExecutionReport), f9fix_SPLTAGEQ(Text) "ExecutionReportBatch");
+   fixFeeder.CheckReplayDone(nextSendSeq += 100);
+   std::cout << "|count=" << fixFeeder.Count_ << "\r[OK   ]\n";
+
+   std::cout << "[TEST ] Replay SendBatch";
+   fixFeeder.Count_ = 0;
+   fixSender->Replay(fixConfig, fixFeeder.ExpectedSeqNum_ = batchFirstSeq + 10, 0);
+   fixFeeder.CheckReplayDone(nextSendSeq);
+   std::cout << "|count(Include SeqReset)=" << fixFeeder.Count_ << "\r[OK   ]\n";
+
    // 結束前刪除測試檔.
    fixSender.reset();
-   if (!fon9::IsKeepTestFiles(argc, argv))
+   if (!fon9::IsKeepTestFiles(argc, argv)) {
       fon9::WaitRemoveFile(fixrFileName);
+      fon9::WaitRemoveFile(sidxFileName);
+   }
 }
 fon9_WARN_POP;
@@ -0,0 +1,105 @@
+﻿// \file fon9/fix/FixSentIndex.cpp
+// \author fonwinz@gmail.com
+#include "fon9/fix/FixSentIndex.hpp"
+#include "fon9/Endian.hpp"
+#include <algorithm>
+
+namespace fon9 { namespace fix {
+
+FixSentIndex::~FixSentIndex() {
+   this->Flush();
+}
+File::Result FixSentIndex::Open(std::string fname) {
+   this->ClearEntries();
+   this->Pending_.clear();
+   this->HasLastRecord_ = false;
+   File::Result res = this->File_.Open(std::move(fname), FileMode::Append | FileMode::CreatePath | FileMode::Read | FileMode::DenyWrite);
+   if (!res || !(res = this->File_.GetFileSize()))
+      return res;
+   const PosType fsize = res.GetResult() - (res.GetResult() % kRecordSize);
+   if (fsize != res.GetResult()) {
+      // 尾端不完整的記錄(例: 寫入到一半時程式結束), 直接移除.
+      if (!(res = this->File_.SetFileSize(fsize)))
+         return res;
+   }
+   char    buf[kRecordSize * 1024];
+   PosType pos = 0;
+   while (pos < fsize) {
+      if (!(res = this->File_.Read(pos, buf, sizeof(buf))))
+         return res;
+      const size_t rdsz = static_cast<size_t>(res.GetResult());
+      if (rdsz < kRecordSize)
+         break;
+      const char* const pend = buf + (rdsz - rdsz % kRecordSize);
+      for (const char* prec = buf; prec != pend; prec += kRecordSize) {
+         Record rec;
+         rec.Seq_ = GetBigEndian<uint32_t>(prec);
+         rec.Kind_ = static_cast<RecordKind>(GetBigEndian<uint32_t>(prec + 4));
+         rec.Pos_ = GetBigEndian<uint64_t>(prec + 8);
+         this->AppendEntry(rec);
+      }
+      pos += static_cast<PosType>(pend - buf);
+   }
+   return File::Result{fsize};
+}
+File::Result FixSentIndex::Clear() {
+   this->ClearEntries();
+   this->Pending_.clear();
+   this->HasLastRecord_ = false;
+   return this->File_.SetFileSize(0);
+}
+void FixSentIndex::AppendEntry(const Record& rec) {
+   this->LastRecord_ = rec;
+   this->HasLastRecord_ = true;
+   if (rec.Kind_ != RecordKind::Sent)
+      this->ClearEntries();
+   else {
+      if (!this->Entries_.empty() && rec.Seq_ <= this->Entries_.back().Seq_)
+         this->ClearEntries();
+      else if (this->Entries_.size() >= kMaxEntries) {
+         this->Entries_.pop_front();
+         this->IsTrimmed_ = true;
+      }
+      this->Entries_.push_back(Entry{rec.Seq_, rec.Pos_});
+   }
+}
+void FixSentIndex::Append(RecordKind kind, FixSeqNum seq, PosType pos) {
+   this->AppendEntry(Record{seq, kind, pos});
+   if (!this->File_.IsOpened())
+      return;
+   char rec[kRecordSize];
+   PutBigEndian(rec, static_cast<uint32_t>(seq));
+   PutBigEndian(rec + 4, static_cast<uint32_t>(kind));
+   PutBigEndian(rec + 8, static_cast<uint64_t>(pos));
+   this->Pending_.append(rec, sizeof(rec));
+}
+void FixSentIndex::Flush() {
+   if (this->Pending_.empty() || !this->File_.IsOpened())
+      return;
+   this->File_.Append(&this->Pending_);
+   this->Pending_.clear();
+}
+bool FixSentIndex::LowerBound(FixSeqNum seq, Record& out) const {
+   if (this->Entries_.empty())
+      return false;
+   const Entry* pfound;
+   // 送出序號通常是連續的, 所以先直接用序號計算位置.
+   const FixSeqNum seqFront = this->Entries_.front().Seq_;
+   if (seq <= seqFront)
+      pfound = &this->Entries_.front();
+   else if (seq - seqFront < this->Entries_.size() && this->Entries_[seq - seqFront].Seq_ == seq)
+      pfound = &this->Entries_[seq - seqFront];
+   else {
+      auto ifind = std::lower_bound(this->Entries_.begin(), this->Entries_.end(), seq,
+                                    [](const Entry& e, FixSeqNum s) { return e.Seq_ < s; });
+      if (ifind == this->Entries_.end())
+         return false;
+      pfound = &*ifind;
+   }
+   out.Seq_ = pfound->Seq_;
+   out.Kind_ = RecordKind::Sent;
+   out.Pos_ = pfound->Pos_;
+   return true;
+}
+
+} } // namespaces
@@ -0,0 +1,120 @@
+﻿/// \file fon9/fix/FixSentIndex.hpp
+/// \author fonwinz@gmail.com
+#ifndef __fon9_fix_FixSentIndex_hpp__
+#define __fon9_fix_FixSentIndex_hpp__
+#include "fon9/fix/FixBase.hpp"
+#include "fon9/File.hpp"
+#include <deque>
+
+namespace fon9 { namespace fix {
+
+fon9_WARN_DISABLE_PADDING;
+/// \ingroup fix
+/// FixRecorder 送出訊息的序號索引: MsgSeqNum => 該筆 "S timestamp FIX Message" 在 FixRecorder 檔案的位置.
+/// - 附屬檔(sidecar), 只會在尾端附加, 每筆記錄 kRecordSize bytes(big endian):
+///   `uint32_t Seq_; uint32_t Kind_; uint64_t Pos_;`
+///   - Kind_ == RecordKind::Sent: 送出序號 Seq_ 的訊息位於 Pos_.
+///   - Kind_ == RecordKind::RstSend: 在 Pos_ 寫入的資料包含 "RST|S=Seq_".
+/// - 記憶體中只保留最後一次 RstSend 之後的索引, 與從檔尾往前搜尋的規則相同:
+///   遇到 "RST|S=" 就不再往前找.
+/// - 為了降低對送出訊息的影響, Append() 不寫檔, 記錄累積到 kFlushSize 之後(IsFlushRequired()),
+///   由 FixRecorder 用 MovePending() 取出, 放到記錄檔的寫入佇列, 在寫檔 thread 呼叫 WriteRecords().
+///   所以若程式異常結束, 附屬檔可能落後 FixRecorder 檔案, 重啟時由 FixRecorder 補上.
+/// - 記憶體中的索引每筆 16 bytes, 最多保留 kMaxEntries 筆(約 64MB):
+///   超過時移除最舊的索引, 被移除的序號 IsCovered() 傳回 false, 由 FixRecorder 改用從檔尾往前搜尋.
+/// - 除了 WriteRecords() 之外, 沒有 lock, 由 FixRecorder 負責保護.
+class fon9_API FixSentIndex {
+   fon9_NON_COPY_NON_MOVE(FixSentIndex);
+public:
+   using PosType = File::PosType;
+   enum class RecordKind : uint32_t {
+      Sent = 0,
+      RstSend = 1,
+   };
+   struct Record {
+      FixSeqNum   Seq_;
+      RecordKind  Kind_;
+      PosType     Pos_;
+   };
+   enum : size_t {
+      kRecordSize = sizeof(uint32_t) + sizeof(uint32_t) + sizeof(uint64_t),
+      kFlushSize = kRecordSize * 256,
+      kMaxEntries = 1024 * 1024 * 4,
+   };
+
+   FixSentIndex() = default;
+   /// 寫入尚未存檔的記錄.
+   ~FixSentIndex();
+
+   /// 開啟附屬檔, 並載入最後一次 RstSend 之後的索引.
+   /// 尾端若有不完整的記錄, 則移除.
+   File::Result Open(std::string fname);
+   bool IsOpened() const {
+      return this->File_.IsOpened();
+   }
+   /// 清除全部索引(包含附屬檔內容), 通常用在附屬檔與 FixRecorder 不一致, 需要重建時.
+   File::Result Clear();
+
+   /// 最後一筆記錄, 包含 RstSend; 若從未有過任何記錄, 則傳回 nullptr.
+   const Record* LastRecord() const {
+      return this->HasLastRecord_ ? &this->LastRecord_ : nullptr;
+   }
+   /// 加入一筆記錄.
+   /// - RecordKind::Sent: 若 seq 小於等於上一筆送出序號, 則視為序號重設, 先清除記憶體中的索引.
+   /// - RecordKind::RstSend: 清除記憶體中的索引.
+   void Append(RecordKind kind, FixSeqNum seq, PosType pos);
+   /// 尚未存檔的記錄已達 kFlushSize.
+   bool IsFlushRequired() const {
+      return this->Pending_.size() >= kFlushSize;
+   }
+   /// 取出尚未存檔的記錄, 之後再交給 WriteRecords() 寫入.
+   std::string MovePending() {
+      std::string retval;
+      retval.swap(this->Pending_);
+      return retval;
+   }
+   /// 將 MovePending() 取出的記錄寫入附屬檔.
+   /// 可在寫檔 thread 呼叫(不用 FixRecorder 的保護), 但必須依照 MovePending() 的順序.
+   File::Result WriteRecords(std::string& recs) {
+      return this->File_.Append(&recs);
+   }
+   /// 立即將尚未存檔的記錄寫入附屬檔, 只在沒有寫檔 thread 時使用(開檔, 解構).
+   void Flush();
+
+   /// seq 的索引是否還在記憶體中, 若已被移除(超過 kMaxEntries), 則 LowerBound() 的結果不可靠.
+   bool IsCovered(FixSeqNum seq) const {
+      return !this->IsTrimmed_ || this->Entries_.empty() || this->Entries_.front().Seq_ <= seq;
+   }
+   /// 尋找序號 >= seq 的第一筆送出記錄.
+   /// \retval false 找不到.
+   bool LowerBound(FixSeqNum seq, Record& out) const;
+   /// 記憶體中的索引數量(最後一次 RstSend 之後).
+   size_t size() const {
+      return this->Entries_.size();
+   }
+
+private:
+   struct Entry {
+      FixSeqNum   Seq_;
+      PosType     Pos_;
+   };
+   /// 使用 deque: 索引數量很多時, 不會有 vector 擴充時整批搬移的延遲, 也可以從前端移除.
+   using Entries = std::deque<Entry>;
+   void AppendEntry(const Record& rec);
+   void ClearEntries() {
+      this->Entries_.clear();
+      this->IsTrimmed_ = false;
+   }
+
+   File        File_;
+   Entries     Entries_;
+   std::string Pending_;
+   Record      LastRecord_;
+   bool        HasLastRecord_{false};
+   /// 曾因超過 kMaxEntries 而移除最舊的索引.
+   bool        IsTrimmed_{false};
+};
+fon9_WARN_POP;
+
+} } // namespaces
+#endif//__fon9_fix_FixSentIndex_hpp__
@@ -12,6 +12,9 @@ FixSession::FixSession(const FixConfig& cfg)
    this->RxArgs_.FixReceiver_ = this;
    this->RxArgs_.FixConfig_   = &cfg;
    this->RxArgs_.FixSender_   = nullptr;
+   this->FixParser_.SetInterestTagsSelector([&cfg](StrView msgType) {
+      return cfg.GetInterestTags(msgType);
+   });
 }
 FixSession::~FixSession() {
 }
@@ -31,6 +34,9 @@ FixSenderSP FixSession::OnFixSessionDisconnected(const StrView& info) {
    }
    return std::move(this->FixSender_);
 }
+void FixSession::OnFixSenderAttached(FixSender& fixout) {
+   (void)fixout;
+}
 void FixSession::OnFixSessionConnected() {
    this->ClearFixSession(FixSessionSt::Connected);
    this->FixSessionTimerRunAfter(this->RxArgs_.FixConfig_->TiWaitForLogon_);
@@ -133,6 +139,7 @@ void FixSession::SendLogon(FixSenderSP fixout, uint32_t heartBtInt, FixBuilder&&
    assert(this->FixSt_ < FixSessionSt::LogonSent);
    this->FixSt_ = FixSessionSt::LogonSent;
    this->HeartBtInt_ = heartBtInt;
+   this->OnFixSenderAttached(*fixout);
    if (this->ResetNextSendSeq_ > 0) {
       fixout->ResetNextSendSeq(this->ResetNextSendSeq_);
       this->ResetNextSendSeq_ = 0;
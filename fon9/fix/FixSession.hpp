@@ -81,6 +81,11 @@ protected:
    void OnRecoverDone(const FixRecvEvArgs& rxargs) override;
    void OnLogoutRequired(const FixRecvEvArgs& rxargs, FixBuilder&& fixb) override;
 
+   /// 在 FeedBuffer() 之前設定: 收到資料的時間, 之後解析出的訊息透過 FixRecvEvArgs::RxTime_ 提供.
+   void SetFixRxTime(TimeStamp rxTime) {
+      this->RxArgs_.RxTime_ = rxTime;
+   }
+
    /// 在指定時間後呼叫 FixSessionOnTimer(); 請參考 IoFixSession;
    virtual void FixSessionTimerRunAfter(TimeInterval after) = 0;
    virtual void FixSessionTimerStopNoWait() = 0;
@@ -92,6 +97,9 @@ protected:
    /// 必須由衍生者主動呼叫, 參考: `IoFixSession::OnDevice_StateChanged()`
    virtual FixSenderSP OnFixSessionDisconnected(const StrView& info);
    virtual void OnFixSessionConnected();
+   /// 在 SendLogon() 使用 fixout 送出 Logon 之前呼叫, 之後 fixout 成為此 session 的 FixSender_.
+   /// 預設: do nothing. 參考: `IoFixSession::OnFixSenderAttached()`
+   virtual void OnFixSenderAttached(FixSender& fixout);
    /// 檢驗登入訊息: this->FixManager_.OnRecvLogonRequest(rxargs);
    virtual void OnRecvLogonRequest(FixRecvEvArgs& rxargs) = 0;
    /// 強迫送出指定訊息: this->Dev_->Send(std::move(msg));
@@ -0,0 +1,89 @@
+﻿// \file fon9/fix/FixShard.cpp
+// \author fonwinz@gmail.com
+#include "fon9/fix/FixShard.hpp"
+#include "fon9/fix/FixRecorder.hpp"
+#include "fon9/RevPrint.hpp"
+
+namespace fon9 { namespace fix {
+
+static std::string MakeShardThreadName(StrView name, int index, StrView kind) {
+   return RevPrintTo<std::string>(name, '.', index, '.', kind);
+}
+
+FixShard::FixShard(int index, StrView name)
+   : Index_{index}
+   , TimerThread_{MakeShardThreadName(name, index, "Timer")} {
+   ThreadPoolArgs args;
+   args.ThreadCount_ = 1;
+   this->WriterPool_.StartThread(args, ToStrView(MakeShardThreadName(name, index, "Writer")));
+}
+FixShard::~FixShard() {
+   this->WriterPool_.WaitForEndAfterWorkDone();
+}
+void FixShard::AttachRecorder(FixRecorder& recorder) {
+   recorder.SetThreadPool(&this->WriterPool_);
+   recorder.SetSyncTimerThread(this->TimerThread_);
+}
+void FixShard::DetachRecorder(FixRecorder& recorder) {
+   recorder.SetThreadPool(nullptr);
+   recorder.SetSyncTimerThread(GetDefaultTimerThread());
+}
+
+//--------------------------------------------------------------------------//
+
+FixShardMgr::Shards FixShardMgr::MakeShards(uint32_t shardCount, StrView name) {
+   if (shardCount <= 0)
+      shardCount = 1;
+   Shards shards;
+   shards.reserve(shardCount);
+   for (uint32_t L = 0; L < shardCount; ++L)
+      shards.emplace_back(new FixShard{static_cast<int>(L), name});
+   return shards;
+}
+FixShardMgr::FixShardMgr(const io::IoServiceArgs& iosvArgs, TimeInterval rateInterval, StrView name)
+   : Shards_{MakeShards(iosvArgs.ThreadCount_, name)}
+   , RateInterval_{rateInterval}
+   , LastRateTime_{UtcNow()}
+   , RateTimer_{Shards_.front()->TimerThread_} {
+   if (rateInterval.GetOrigValue() > 0)
+      this->RateTimer_.RunAfter(rateInterval);
+}
+FixShardMgr::~FixShardMgr() {
+   this->RateTimer_.StopAndWait();
+}
+void FixShardMgr::EmitOnRateTimer(TimerEntry* timer, TimeStamp now) {
+   FixShardMgr& rthis = ContainerOf(*static_cast<RateTimer*>(timer), &FixShardMgr::RateTimer_);
+   rthis.UpdateMsgRates(now);
+   rthis.RateTimer_.RunAfter(rthis.RateInterval_);
+}
+void FixShardMgr::UpdateMsgRates(TimeStamp now) {
+   std::lock_guard<std::mutex> lk{this->RateMutex_};
+   const double secs = (now - this->LastRateTime_).To<double>();
+   if (secs <= 0)
+      return;
+   this->LastRateTime_ = now;
+   for (const ShardSP& shard : this->Shards_) {
+      const uint64_t count = shard->GetRxMsgCount();
+      const uint64_t rate = static_cast<uint64_t>(static_cast<double>(count - shard->LastRxMsgCount_) / secs);
+      shard->LastRxMsgCount_ = count;
+      shard->MsgRate_.store((shard->GetMsgRate() + rate) / 2, std::memory_order_relaxed);
+   }
+}
+FixShard& FixShardMgr::AllocShard() const {
+   FixShard* retval = this->Shards_.front().get();
+   uint64_t  minRate = retval->GetMsgRate();
+   uint32_t  minSessions = retval->GetSessionCount();
+   for (size_t L = 1; L < this->Shards_.size(); ++L) {
+      FixShard*      shard = this->Shards_[L].get();
+      const uint64_t rate = shard->GetMsgRate();
+      const uint32_t sessions = shard->GetSessionCount();
+      if (rate < minRate || (rate == minRate && sessions < minSessions)) {
+         retval = shard;
+         minRate = rate;
+         minSessions = sessions;
+      }
+   }
+   return *retval;
+}
+
+} } // namespaces
@@ -0,0 +1,136 @@
+﻿/// \file fon9/fix/FixShard.hpp
+/// \author fonwinz@gmail.com
+#ifndef __fon9_fix_FixShard_hpp__
+#define __fon9_fix_FixShard_hpp__
+#include "fon9/ThreadPool.hpp"
+#include "fon9/Timer.hpp"
+#include "fon9/io/IoServiceArgs.hpp"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace fon9 { namespace fix {
+
+class FixRecorder;
+
+fon9_WARN_DISABLE_PADDING;
+/// \ingroup fix
+/// 同一個 FixShard 的 IoFixSession 使用相同的:
+/// - io thread: IoService 的第 Index_ 個 thread(請參考 io::Session::GetDeviceIoThreadIndex()).
+///   - shard 數量由 FixShardMgr 建構時的 IoServiceArgs::ThreadCount_ 決定, 所以每個 io thread 對應一個 shard.
+/// - TimerThread_: heartbeat 計時(io::Device::CommonTimer_), 及 FixRecorder 的 group commit 計時.
+/// - WriterPool_(1 thread): FixRecorder 寫檔.
+/// - FixRecorder 由 IoFixSession 在 SendLogon() 時 AttachRecorder(), 斷線時 DetachRecorder().
+///
+/// 不同 shard 的 sessions 不會共用上述的 threads, 所以彼此之間沒有鎖的競爭.
+class fon9_API FixShard {
+   fon9_NON_COPY_NON_MOVE(FixShard);
+   friend class FixShardMgr;
+   /// 只會在此 shard 的 io thread 累加, 所以不會有跨 thread 的競爭.
+   std::atomic<uint64_t>   RxMsgCount_{0};
+   std::atomic<uint64_t>   MsgRate_{0};
+   std::atomic<uint32_t>   SessionCount_{0};
+   /// 由 FixShardMgr::UpdateMsgRates() 使用.
+   uint64_t                LastRxMsgCount_{0};
+
+public:
+   const int      Index_;
+   TimerThread    TimerThread_;
+   ThreadPool     WriterPool_;
+
+   FixShard(int index, StrView name);
+   /// 結束 WriterPool_ 之前, 會先寫完已加入的工作.
+   ~FixShard();
+
+   /// 讓 recorder 的寫檔在 WriterPool_ 執行, group commit 計時在 TimerThread_ 執行.
+   /// 在 DetachRecorder() 之前, recorder 必須比 this 早死亡, 或在 this 死亡前已不再寫入.
+   void AttachRecorder(FixRecorder& recorder);
+   /// 讓 recorder 恢復使用預設的 threads: GetDefaultThreadPool(), GetDefaultTimerThread();
+   void DetachRecorder(FixRecorder& recorder);
+
+   /// 每收到一筆 FIX 訊息, 由 IoFixSession 呼叫.
+   void AddRxMsgCount() {
+      this->RxMsgCount_.fetch_add(1, std::memory_order_relaxed);
+   }
+   uint64_t GetRxMsgCount() const {
+      return this->RxMsgCount_.load(std::memory_order_relaxed);
+   }
+   /// 最近量測到的訊息速率(筆/秒), 由 FixShardMgr::UpdateMsgRates() 更新.
+   uint64_t GetMsgRate() const {
+      return this->MsgRate_.load(std::memory_order_relaxed);
+   }
+
+   /// 由 IoFixSession 建構及解構時呼叫.
+   void AddSession() {
+      this->SessionCount_.fetch_add(1, std::memory_order_relaxed);
+   }
+   void RemoveSession() {
+      this->SessionCount_.fetch_sub(1, std::memory_order_relaxed);
+   }
+   uint32_t GetSessionCount() const {
+      return this->SessionCount_.load(std::memory_order_relaxed);
+   }
+};
+
+/// \ingroup fix
+/// 管理多個 FixShard, 並依量測到的訊息速率分配新的 session.
+/// \code
+///   fon9::io::IoServiceArgs iosvArgs;
+///   iosvArgs.ThreadCount_ = 4;
+///   // 使用相同的 iosvArgs 建立 IoService 及 FixShardMgr, 讓 shard 數量與 io threads 數量相同.
+///   fon9::io::FdrServiceSP iosv = fon9::io::MakeDefaultFdrService(iosvArgs, "FixIo", err);
+///   fon9::fix::FixShardMgr shardMgr{iosvArgs};
+///   // 在 SessionServer::OnDevice_Accepted() 或建立 Initiator 時:
+///   return new fon9::fix::IoFixSession{fixMgr, fixConfig, &shardMgr.AllocShard()};
+/// \endcode
+///
+/// - 不會搬移 session: 訊息速率只在 AllocShard() 分配新的 session 時使用.
+///   - 已連線的 session 固定在原本的 shard(fd 及 Device::CommonTimer_ 在建立時已決定 thread),
+///     即使所在的 shard 訊息量特別大, 也不會移到其他 shard.
+///   - Acceptor 每次連線都會建立新的 session, 所以斷線重連時會依當時的訊息速率重新分配.
+///   - Initiator 的 session 通常在重新連線時沿用, 所以會一直使用建構時分配的 shard.
+/// - FixShardMgr 必須比使用它的 sessions 晚死亡.
+class fon9_API FixShardMgr {
+   fon9_NON_COPY_NON_MOVE(FixShardMgr);
+   using ShardSP = std::unique_ptr<FixShard>;
+   using Shards = std::vector<ShardSP>;
+   const Shards         Shards_;
+   const TimeInterval   RateInterval_;
+   std::mutex           RateMutex_;
+   TimeStamp            LastRateTime_;
+
+   static void EmitOnRateTimer(TimerEntry* timer, TimeStamp now);
+   using RateTimer = DataMemberEmitOnTimer<&FixShardMgr::EmitOnRateTimer>;
+   /// 使用 Shards_[0] 的 TimerThread_, 不佔用 GetDefaultTimerThread();
+   RateTimer            RateTimer_;
+
+   static Shards MakeShards(uint32_t shardCount, StrView name);
+
+public:
+   /// \param iosvArgs     shard 數量 = iosvArgs.ThreadCount_(0 視為 1, 與 IoService 相同);
+   ///                     必須使用相同的 iosvArgs 建立 IoService.
+   /// \param rateInterval 多久更新一次訊息速率; <= 0 表示不自動更新, 由使用者自行呼叫 UpdateMsgRates().
+   FixShardMgr(const io::IoServiceArgs& iosvArgs, TimeInterval rateInterval = TimeInterval_Second(1), StrView name = "FixShard");
+   ~FixShardMgr();
+
+   size_t GetShardCount() const {
+      return this->Shards_.size();
+   }
+   FixShard& GetShard(size_t index) const {
+      return *this->Shards_[index];
+   }
+
+   /// 選擇負載最低的 shard, 這是唯一使用訊息速率的地方(不會搬移已分配的 session):
+   /// - 訊息速率(GetMsgRate())最低者.
+   /// - 若速率相同, 則選 session 數量最少者.
+   /// - 若仍相同, 則選 Index_ 最小者.
+   FixShard& AllocShard() const;
+
+   /// 依照上次呼叫至今各 shard 收到的訊息數量, 更新訊息速率.
+   /// 速率使用指數移動平均: rate = (rate + 本期速率) / 2; 避免瞬間的流量變化造成分配不均.
+   void UpdateMsgRates(TimeStamp now);
+};
+fon9_WARN_POP;
+
+} } // namespaces
+#endif//__fon9_fix_FixShard_hpp__
@@ -0,0 +1,298 @@
+﻿// \file fon9/fix/FixShard_UT.cpp
+// \author fonwinz@gmail.com
+#define _CRT_SECURE_NO_WARNINGS
+#include "fon9/TestTools.hpp"
+#include "fon9/fix/FixShard.hpp"
+#include "fon9/fix/IoFixSession.hpp"
+#include "fon9/fix/IoFixSender.hpp"
+#include "fon9/fix/FixAdminMsg.hpp"
+#include "fon9/io/SimpleManager.hpp"
+#include "fon9/io/Server.hpp"
+#include "fon9/DefaultThreadPool.hpp"
+#include "fon9/StrTo.hpp"
+
+#ifdef fon9_WINDOWS
+#include "fon9/io/win/IocpTcpClient.hpp"
+#include "fon9/io/win/IocpTcpServer.hpp"
+using IoService = fon9::io::IocpService;
+using IoServiceSP = fon9::io::IocpServiceSP;
+using TcpClient = fon9::io::IocpTcpClient;
+using TcpServer = fon9::io::IocpTcpServer;
+#else
+#include "fon9/io/FdrTcpClient.hpp"
+#include "fon9/io/FdrTcpServer.hpp"
+#include "fon9/io/FdrServiceEpoll.hpp"
+using IoService = fon9::io::FdrServiceEpoll;
+using IoServiceSP = fon9::io::FdrServiceSP;
+using TcpClient = fon9::io::FdrTcpClient;
+using TcpServer = fon9::io::FdrTcpServer;
+#endif
+
+namespace f9fix = fon9::fix;
+
+static const uint32_t   kShardCount = 2;
+static const unsigned   kInitiatorCount = 4;
+
+static std::string MakeRecorderFileName(unsigned id) {
+   return fon9::RevPrintTo<std::string>("./FixShardI", id, ".log");
+}
+static void RemoveRecorderFiles() {
+   for (unsigned L = 0; L < kInitiatorCount; ++L) {
+      const std::string fname = MakeRecorderFileName(L);
+      std::remove(fname.c_str());
+      std::remove((fname + ".sidx").c_str());
+   }
+}
+
+static bool WaitFor(const std::function<bool()>& pred, unsigned secs) {
+   const auto until = std::chrono::steady_clock::now() + std::chrono::seconds{secs};
+   while (!pred()) {
+      if (std::chrono::steady_clock::now() > until)
+         return false;
+      std::this_thread::yield();
+   }
+   return true;
+}
+
+//--------------------------------------------------------------------------//
+
+/// 使用 UpdateMsgRates() 模擬訊息速率, 檢查 AllocShard() 的分配結果.
+void TestAllocShard() {
+   std::cout << "[TEST ] FixShardMgr.AllocShard";
+   fon9::io::IoServiceArgs iosvArgs;
+   iosvArgs.ThreadCount_ = 3;
+   f9fix::FixShardMgr   shardMgr{iosvArgs, fon9::TimeInterval{}};
+   f9fix::IoFixManager  fixMgr;
+   f9fix::FixConfig     fixConfig;
+   f9fix::FixSession::InitFixConfig(fixConfig);
+   std::vector<f9fix::IoFixSessionSP> sessions;
+   // 沒有流量: 依照 session 數量平均分配.
+   for (int L = 0; L < 6; ++L) {
+      f9fix::FixShard& shard = shardMgr.AllocShard();
+      if (shard.Index_ != L % 3) {
+         std::cout << "|L=" << L << "|shard=" << shard.Index_ << "\r[ERROR]" << std::endl;
+         abort();
+      }
+      sessions.emplace_back(new f9fix::IoFixSession{fixMgr, fixConfig, &shard});
+   }
+   // shard[0] 流量最大, shard[1] 次之; 新的 session 應分配到 shard[2], 即使 shard[2] 的 session 數量較多.
+   sessions.emplace_back(new f9fix::IoFixSession{fixMgr, fixConfig, &shardMgr.GetShard(2)});
+   for (unsigned L = 0; L < 1000; ++L)
+      shardMgr.GetShard(0).AddRxMsgCount();
+   for (unsigned L = 0; L < 10; ++L)
+      shardMgr.GetShard(1).AddRxMsgCount();
+   shardMgr.UpdateMsgRates(fon9::UtcNow() + fon9::TimeInterval_Second(1));
+   if (!(shardMgr.GetShard(0).GetMsgRate() > shardMgr.GetShard(1).GetMsgRate()
+         && shardMgr.GetShard(1).GetMsgRate() > 0
+         && shardMgr.GetShard(2).GetMsgRate() == 0)) {
+      std::cout << "|rates=" << shardMgr.GetShard(0).GetMsgRate()
+         << ',' << shardMgr.GetShard(1).GetMsgRate()
+         << ',' << shardMgr.GetShard(2).GetMsgRate() << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   f9fix::FixShard& shard = shardMgr.AllocShard();
+   if (shard.Index_ != 2) {
+      std::cout << "|byRate|shard=" << shard.Index_ << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   // 流量停止後, 速率逐漸降低.
+   const uint64_t rate0 = shardMgr.GetShard(0).GetMsgRate();
+   shardMgr.UpdateMsgRates(fon9::UtcNow() + fon9::TimeInterval_Second(2));
+   if (shardMgr.GetShard(0).GetMsgRate() >= rate0) {
+      std::cout << "|decay|rate=" << shardMgr.GetShard(0).GetMsgRate() << "\r[ERROR]" << std::endl;
+      abort();
+   }
+   sessions.clear();
+   for (size_t L = 0; L < shardMgr.GetShardCount(); ++L) {
+      if (shardMgr.GetShard(L).GetSessionCount() != 0) {
+         std::cout << "|shard=" << L << "|sessions=" << shardMgr.GetShard(L).GetSessionCount() << "\r[ERROR]" << std::endl;
+         abort();
+      }
+   }
+   std::cout << "\r[OK   ]" << std::endl;
+}
+
+//--------------------------------------------------------------------------//
+
+fon9_WARN_DISABLE_PADDING;
+struct ShardTestMgr : public f9fix::IoFixManager {
+   fon9_NON_COPY_NON_MOVE(ShardTestMgr);
+   IoServiceSP             Iosv_;
+   f9fix::FixConfig        FixConfig_;
+   std::atomic<unsigned>   LogonCount_{0};
+   std::atomic<unsigned>   WrongThreadCount_{0};
+
+   ShardTestMgr(IoServiceSP iosv) : Iosv_{std::move(iosv)} {
+      f9fix::FixSession::InitFixConfig(this->FixConfig_);
+   }
+   /// Acceptor: 檢查收到 Logon 的 thread, 是否為 session 所屬 shard 的 io thread.
+   /// 不回覆 Logon, 避免 Initiator 斷線後重新連線, 影響 shard 的 session 數量.
+   void OnRecvLogonRequest(f9fix::FixRecvEvArgs& rxargs) override {
+   #ifndef fon9_WINDOWS
+      f9fix::IoFixSession* fixses = static_cast<f9fix::IoFixSession*>(rxargs.FixSession_);
+      if (!this->Iosv_->GetFdrThreads()[static_cast<size_t>(fixses->Shard_->Index_)]->IsThisThread())
+         ++this->WrongThreadCount_;
+   #else
+      (void)rxargs;
+   #endif
+      ++this->LogonCount_;
+   }
+};
+
+struct ShardInitiator : public f9fix::IoFixManager {
+   fon9_NON_COPY_NON_MOVE(ShardInitiator);
+   f9fix::IoFixSenderSP FixOut_;
+   f9fix::FixConfig     FixConfig_;
+   f9fix::FixShard&     Shard_;
+
+   ShardInitiator(unsigned id, f9fix::FixShard& shard) : Shard_(shard) {
+      this->FixOut_.reset(new f9fix::IoFixSender{f9fix_BEGIN_HEADER_V44, f9fix::CompIDs{"IComp", "ISub", "AComp", "ASub"}});
+      this->FixOut_->GetFixRecorder().Initialize(MakeRecorderFileName(id));
+      f9fix::FixSession::InitFixConfig(this->FixConfig_);
+   }
+   void OnFixSessionDisconnected(f9fix::IoFixSession&, f9fix::FixSenderSP&& fixout) override {
+      if (f9fix::IoFixSender* devout = dynamic_cast<f9fix::IoFixSender*>(fixout.get()))
+         devout->OnFixSessionDisconnected();
+   }
+   void OnFixSessionConnected(f9fix::IoFixSession& fixses) override {
+      f9fix::FixBuilder fixb;
+      fon9::RevPrint(fixb.GetBuffer(), f9fix_kFLD_EncryptMethod_None);
+      this->FixOut_->OnFixSessionConnected(fixses.GetDevice());
+      this->OnLogonInitiate(fixses, 30, std::move(fixb), this->FixOut_);
+   }
+   /// SendLogon() 之後, recorder 應使用 Shard_ 的 threads; 斷線之後, 應恢復使用預設的 threads.
+   bool IsRecorderAttached() {
+      f9fix::FixRecorder& recorder = this->FixOut_->GetFixRecorder();
+      return recorder.GetThreadPool() == &this->Shard_.WriterPool_
+         && &recorder.GetSyncTimerThread() == &this->Shard_.TimerThread_;
+   }
+   bool IsRecorderDetached() {
+      f9fix::FixRecorder& recorder = this->FixOut_->GetFixRecorder();
+      return recorder.GetThreadPool() == nullptr
+         && &recorder.GetSyncTimerThread() == &fon9::GetDefaultTimerThread();
+   }
+};
+
+struct ShardTestServer : public fon9::io::SessionServer {
+   fon9_NON_COPY_NON_MOVE(ShardTestServer);
+   ShardTestMgr&        FixMgr_;
+   f9fix::FixShardMgr&  ShardMgr_;
+   ShardTestServer(ShardTestMgr& mgr, f9fix::FixShardMgr& shardMgr) : FixMgr_(mgr), ShardMgr_(shardMgr) {
+   }
+   fon9::io::SessionSP OnDevice_Accepted(fon9::io::DeviceServer&) override {
+      return fon9::io::SessionSP{new f9fix::IoFixSession{this->FixMgr_, this->FixMgr_.FixConfig_, &this->ShardMgr_.AllocShard()}};
+   }
+};
+fon9_WARN_POP;
+
+/// 在 loopback 建立 kInitiatorCount 組 Initiator + Acceptor, 檢查 sessions 的分配及 io thread.
+void TestShardSessions(IoServiceSP iosv, const fon9::io::IoServiceArgs& iosvArgs, unsigned port) {
+   std::cout << "[TEST ] FixShard.Sessions";
+   f9fix::FixShardMgr   shardMgr{iosvArgs};
+   {
+      ShardTestMgr         acceptorMgr{iosv};
+      fon9::io::ManagerCSP ioMgr{new fon9::io::SimpleManager{}};
+      fon9::io::DeviceSP   srv{new TcpServer(iosv, new ShardTestServer{acceptorMgr, shardMgr}, ioMgr)};
+      srv->Initialize();
+      srv->AsyncOpen(fon9::RevPrintTo<std::string>(port));
+      srv->WaitGetDeviceId();
+
+      std::vector<std::unique_ptr<ShardInitiator>> initiatorMgrs;
+      std::vector<fon9::io::DeviceSP>              clis;
+      for (unsigned L = 0; L < kInitiatorCount; ++L) {
+         f9fix::FixShard& shard = shardMgr.AllocShard();
+         initiatorMgrs.emplace_back(new ShardInitiator{L, shard});
+         f9fix::IoFixSessionSP ses{new f9fix::IoFixSession{*initiatorMgrs.back(), initiatorMgrs.back()->FixConfig_, &shard}};
+         clis.emplace_back(new TcpClient(iosv, ses, ioMgr));
+      }
+      for (fon9::io::DeviceSP& cli : clis) {
+         cli->Initialize();
+         cli->AsyncOpen(fon9::RevPrintTo<std::string>("127.0.0.1:", port));
+      }
+      if (!WaitFor([&acceptorMgr]() { return acceptorMgr.LogonCount_.load() >= kInitiatorCount; }, 10)) {
+         std::cout << "|logon=" << acceptorMgr.LogonCount_.load() << "\r[ERROR]" << std::endl;
+         abort();
+      }
+      if (acceptorMgr.WrongThreadCount_ != 0) {
+         std::cout << "|wrongThread=" << acceptorMgr.WrongThreadCount_.load() << "\r[ERROR]" << std::endl;
+         abort();
+      }
+      for (size_t L = 0; L < initiatorMgrs.size(); ++L) {
+         if (!initiatorMgrs[L]->IsRecorderAttached()) {
+            std::cout << "|initiator=" << L << "|recorder not attached.\r[ERROR]" << std::endl;
+            abort();
+         }
+      }
+      const uint32_t expectedSessions = kInitiatorCount * 2 / kShardCount;
+      for (size_t L = 0; L < shardMgr.GetShardCount(); ++L) {
+         const f9fix::FixShard& shard = shardMgr.GetShard(L);
+         if (shard.GetSessionCount() != expectedSessions || shard.GetRxMsgCount() == 0) {
+            std::cout << "|shard=" << L << "|sessions=" << shard.GetSessionCount()
+               << "|rxMsgCount=" << shard.GetRxMsgCount() << "\r[ERROR]" << std::endl;
+            abort();
+         }
+      }
+      for (fon9::io::DeviceSP& cli : clis) {
+         cli->AsyncDispose("quit");
+         cli->WaitGetDeviceId();
+      }
+      srv->AsyncDispose("quit");
+      srv->WaitGetDeviceId();
+      clis.clear();
+      srv.reset();
+      // 必須等 Devices(及 sessions) 結束後, 才能結束 shardMgr 的 threads.
+      if (!WaitFor([&shardMgr]() {
+         for (size_t L = 0; L < shardMgr.GetShardCount(); ++L)
+            if (shardMgr.GetShard(L).GetSessionCount() != 0)
+               return false;
+         return true;
+      }, 10)) {
+         std::cout << "|sessions not released.\r[ERROR]" << std::endl;
+         abort();
+      }
+      for (size_t L = 0; L < initiatorMgrs.size(); ++L) {
+         if (!initiatorMgrs[L]->IsRecorderDetached()) {
+            std::cout << "|initiator=" << L << "|recorder not detached.\r[ERROR]" << std::endl;
+            abort();
+         }
+         initiatorMgrs[L]->FixOut_->GetFixRecorder().WaitFlushed();
+      }
+   }
+   std::cout << "\r[OK   ]" << std::endl;
+}
+
+//--------------------------------------------------------------------------//
+
+int main(int argc, char** argv) {
+#if defined(_MSC_VER) && defined(_DEBUG)
+   _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
+#endif
+   fon9::AutoPrintTestInfo utinfo{"FixShard"};
+   // argv: [port]
+   unsigned port = (argc > 1 ? fon9::StrTo(fon9::StrView_cstr(argv[1]), 0u) : 0u);
+   if (port <= 0)
+      port = 19310;
+   fon9::LogLevel_ = fon9::LogLevel::Warn;
+   fon9::GetDefaultTimerThread();
+   fon9::GetDefaultThreadPool();
+   std::this_thread::sleep_for(std::chrono::milliseconds{10});
+
+   TestAllocShard();
+
+   utinfo.PrintSplitter();
+   fon9::io::IoServiceArgs iosvArgs;
+   iosvArgs.ThreadCount_ = kShardCount;
+   IoService::MakeResult err;
+#ifdef fon9_WINDOWS
+   IoServiceSP iosv = IoService::MakeService(iosvArgs, "FixShard", err);
+#else
+   IoServiceSP iosv = fon9::io::MakeDefaultFdrService(iosvArgs, "FixShard", err);
+#endif
+   if (!iosv) {
+      std::cout << "[ERROR] IoService.MakeService|" << fon9::RevPrintTo<std::string>(err) << std::endl;
+      return 3;
+   }
+   RemoveRecorderFiles();
+   TestShardSessions(iosv, iosvArgs, port);
+   RemoveRecorderFiles();
+}
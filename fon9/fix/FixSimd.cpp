@@ -0,0 +1,209 @@
+﻿// \file fon9/fix/FixSimd.cpp
+// \author fonwinz@gmail.com
+#include "fon9/fix/FixSimd.hpp"
+#include <atomic>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#  define fon9_FIX_SIMD_X64
+#  include <immintrin.h>
+#  ifdef _MSC_VER
+#     include <intrin.h>
+#     define fon9_FIX_TARGET_AVX2
+#  else
+#     define fon9_FIX_TARGET_AVX2   __attribute__((target("avx2")))
+#  endif
+#endif
+
+namespace fon9 { namespace fix {
+
+using FnByteSum = uint32_t (*)(const byte* pbeg, size_t size);
+using FnScanDelims = size_t (*)(const byte* pbeg, size_t size, uint32_t* idxout, uint32_t* byteSum);
+
+//--------------------------------------------------------------------------//
+
+static uint32_t ByteSumScalar(const byte* pbeg, size_t size) {
+   uint32_t sum = 0;
+   while (size > 0) {
+      sum += *pbeg++;
+      --size;
+   }
+   return sum;
+}
+static size_t ScanDelimsScalar(const byte* pbeg, size_t size, uint32_t* idxout, uint32_t* byteSum) {
+   uint32_t* const   idxbeg = idxout;
+   uint32_t          sum = 0;
+   for (uint32_t pos = 0; pos < size; ++pos) {
+      const byte ch = pbeg[pos];
+      sum += ch;
+      if (ch == '=' || ch == f9fix_kCHAR_SPL)
+         *idxout++ = pos;
+   }
+   *byteSum = sum;
+   return static_cast<size_t>(idxout - idxbeg);
+}
+
+#ifdef fon9_FIX_SIMD_X64
+static inline unsigned CountTrailingZero(uint32_t mask) {
+#ifdef _MSC_VER
+   unsigned long res;
+   _BitScanForward(&res, mask);
+   return static_cast<unsigned>(res);
+#else
+   return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+/// 將 mask 的每個 bit 位置(+base) 填入 idxout.
+static inline uint32_t* MaskToIndex(uint32_t mask, uint32_t base, uint32_t* idxout) {
+   while (mask) {
+      *idxout++ = base + CountTrailingZero(mask);
+      mask &= mask - 1;
+   }
+   return idxout;
+}
+
+fon9_GCC_WARN_DISABLE("-Wold-style-cast"); // _mm_set1_epi8() 之類的 macro 使用了 old style cast.
+static uint32_t ByteSumSse2(const byte* pbeg, size_t size) {
+   const __m128i  zero = _mm_setzero_si128();
+   __m128i        acc = zero;
+   const byte*    pend = pbeg + (size & ~static_cast<size_t>(15));
+   for (; pbeg != pend; pbeg += 16)
+      acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pbeg)), zero));
+   const uint32_t sum = static_cast<uint32_t>(_mm_cvtsi128_si32(acc) + _mm_cvtsi128_si32(_mm_srli_si128(acc, 8)));
+   return sum + ByteSumScalar(pbeg, size & 15);
+}
+static size_t ScanDelimsSse2(const byte* pbeg, size_t size, uint32_t* idxout, uint32_t* byteSum) {
+   const __m128i     zero = _mm_setzero_si128();
+   const __m128i     chEq = _mm_set1_epi8('=');
+   const __m128i     chSpl = _mm_set1_epi8(f9fix_kCHAR_SPL);
+   __m128i           acc = zero;
+   uint32_t* const   idxbeg = idxout;
+   const uint32_t    wsize = static_cast<uint32_t>(size & ~static_cast<size_t>(15));
+   uint32_t          pos = 0;
+   for (; pos < wsize; pos += 16) {
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pbeg + pos));
+      acc = _mm_add_epi64(acc, _mm_sad_epu8(v, zero));
+      const __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, chEq), _mm_cmpeq_epi8(v, chSpl));
+      idxout = MaskToIndex(static_cast<uint32_t>(_mm_movemask_epi8(m)), pos, idxout);
+   }
+   uint32_t sum = static_cast<uint32_t>(_mm_cvtsi128_si32(acc) + _mm_cvtsi128_si32(_mm_srli_si128(acc, 8)));
+   uint32_t tailSum;
+   const size_t tailCount = ScanDelimsScalar(pbeg + pos, size - pos, idxout, &tailSum);
+   for (size_t L = 0; L < tailCount; ++L)
+      idxout[L] += pos;
+   *byteSum = sum + tailSum;
+   return static_cast<size_t>(idxout - idxbeg) + tailCount;
+}
+
+fon9_FIX_TARGET_AVX2 static uint32_t ByteSumAvx2(const byte* pbeg, size_t size) {
+   const __m256i  zero = _mm256_setzero_si256();
+   __m256i        acc = zero;
+   const byte*    pend = pbeg + (size & ~static_cast<size_t>(31));
+   for (; pbeg != pend; pbeg += 32)
+      acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pbeg)), zero));
+   const __m128i acc2 = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+   const uint32_t sum = static_cast<uint32_t>(_mm_cvtsi128_si32(acc2) + _mm_cvtsi128_si32(_mm_srli_si128(acc2, 8)));
+   // 尾端交給 SSE2(非 VEX 編碼) 處理前, 必須先清除 YMM 的高位元, 避免 AVX/SSE 切換的延遲.
+   _mm256_zeroupper();
+   return sum + ByteSumSse2(pbeg, size & 31);
+}
+fon9_FIX_TARGET_AVX2 static size_t ScanDelimsAvx2(const byte* pbeg, size_t size, uint32_t* idxout, uint32_t* byteSum) {
+   const __m256i     zero = _mm256_setzero_si256();
+   const __m256i     chEq = _mm256_set1_epi8('=');
+   const __m256i     chSpl = _mm256_set1_epi8(f9fix_kCHAR_SPL);
+   __m256i           acc = zero;
+   uint32_t* const   idxbeg = idxout;
+   const uint32_t    wsize = static_cast<uint32_t>(size & ~static_cast<size_t>(31));
+   uint32_t          pos = 0;
+   for (; pos < wsize; pos += 32) {
+      const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pbeg + pos));
+      acc = _mm256_add_epi64(acc, _mm256_sad_epu8(v, zero));
+      const __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(v, chEq), _mm256_cmpeq_epi8(v, chSpl));
+      idxout = MaskToIndex(static_cast<uint32_t>(_mm256_movemask_epi8(m)), pos, idxout);
+   }
+   const __m128i acc2 = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+   uint32_t sum = static_cast<uint32_t>(_mm_cvtsi128_si32(acc2) + _mm_cvtsi128_si32(_mm_srli_si128(acc2, 8)));
+   _mm256_zeroupper();
+   uint32_t tailSum;
+   const size_t tailCount = ScanDelimsSse2(pbeg + pos, size - pos, idxout, &tailSum);
+   for (size_t L = 0; L < tailCount; ++L)
+      idxout[L] += pos;
+   *byteSum = sum + tailSum;
+   return static_cast<size_t>(idxout - idxbeg) + tailCount;
+}
+fon9_GCC_WARN_POP;
+
+static bool IsCpuSupportAvx2() {
+#ifdef _MSC_VER
+   int regs[4];
+   __cpuid(regs, 0);
+   if (regs[0] < 7)
+      return false;
+   __cpuid(regs, 1);
+   // OSXSAVE(bit27) + AVX(bit28), 且 OS 有保存 YMM 暫存器.
+   if ((regs[2] & (1 << 27)) == 0 || (regs[2] & (1 << 28)) == 0)
+      return false;
+   if ((_xgetbv(0) & 6) != 6)
+      return false;
+   __cpuidex(regs, 7, 0);
+   return (regs[1] & (1 << 5)) != 0;
+#else
+   return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif // fon9_FIX_SIMD_X64
+
+//--------------------------------------------------------------------------//
+
+static uint32_t ByteSumFirst(const byte* pbeg, size_t size);
+static size_t ScanDelimsFirst(const byte* pbeg, size_t size, uint32_t* idxout, uint32_t* byteSum);
+/// 第一次使用時才判斷 CPU 支援的指令集, 避免 static 初始化順序的問題.
+static std::atomic<FnByteSum>    FnByteSum_{&ByteSumFirst};
+static std::atomic<FnScanDelims> FnScanDelims_{&ScanDelimsFirst};
+static std::atomic<FixSimdLevel> FixSimdLevel_{FixSimdLevel::Scalar};
+
+static uint32_t ByteSumFirst(const byte* pbeg, size_t size) {
+   FixSetSimdLevel(FixSimdLevel::Avx2);
+   return FnByteSum_.load(std::memory_order_relaxed)(pbeg, size);
+}
+static size_t ScanDelimsFirst(const byte* pbeg, size_t size, uint32_t* idxout, uint32_t* byteSum) {
+   FixSetSimdLevel(FixSimdLevel::Avx2);
+   return FnScanDelims_.load(std::memory_order_relaxed)(pbeg, size, idxout, byteSum);
+}
+
+fon9_API FixSimdLevel FixSetSimdLevel(FixSimdLevel maxLevel) {
+   FixSimdLevel   level = FixSimdLevel::Scalar;
+   FnByteSum      fnByteSum = &ByteSumScalar;
+   FnScanDelims   fnScanDelims = &ScanDelimsScalar;
+#ifdef fon9_FIX_SIMD_X64
+   if (maxLevel >= FixSimdLevel::Avx2 && IsCpuSupportAvx2()) {
+      level = FixSimdLevel::Avx2;
+      fnByteSum = &ByteSumAvx2;
+      fnScanDelims = &ScanDelimsAvx2;
+   }
+   else if (maxLevel >= FixSimdLevel::Sse2) {
+      level = FixSimdLevel::Sse2;
+      fnByteSum = &ByteSumSse2;
+      fnScanDelims = &ScanDelimsSse2;
+   }
+#else
+   (void)maxLevel;
+#endif
+   FnByteSum_.store(fnByteSum, std::memory_order_relaxed);
+   FnScanDelims_.store(fnScanDelims, std::memory_order_relaxed);
+   FixSimdLevel_.store(level, std::memory_order_relaxed);
+   return level;
+}
+fon9_API FixSimdLevel FixGetSimdLevel() {
+   if (FnByteSum_.load(std::memory_order_relaxed) == &ByteSumFirst)
+      return FixSetSimdLevel(FixSimdLevel::Avx2);
+   return FixSimdLevel_.load(std::memory_order_relaxed);
+}
+
+fon9_API uint32_t FixByteSum(const char* pbeg, const char* pend) {
+   return FnByteSum_.load(std::memory_order_relaxed)(reinterpret_cast<const byte*>(pbeg), static_cast<size_t>(pend - pbeg));
+}
+fon9_API size_t FixScanDelims(const char* pbeg, const char* pend, uint32_t* idxout, uint32_t* byteSum) {
+   return FnScanDelims_.load(std::memory_order_relaxed)(reinterpret_cast<const byte*>(pbeg), static_cast<size_t>(pend - pbeg), idxout, byteSum);
+}
+
+} } // namespaces
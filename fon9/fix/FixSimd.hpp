@@ -0,0 +1,43 @@
+﻿/// \file fon9/fix/FixSimd.hpp
+/// \author fonwinz@gmail.com
+#ifndef __fon9_fix_FixSimd_hpp__
+#define __fon9_fix_FixSimd_hpp__
+#include "fon9/fix/FixBase.hpp"
+#include "fon9/sys/Config.hpp"
+
+namespace fon9 { namespace fix {
+
+/// \ingroup fix
+/// FixParser 使用的指令集.
+enum class FixSimdLevel : uint8_t {
+   /// 逐一字元處理, FixParser 使用原本的解析方式.
+   Scalar,
+   /// 每次處理 16 bytes.
+   /// 尋找 '=', SOH 使用 pcmpeqb + pmovmskb, 比 SSE4.2 的 pcmpistri 快, 所以 SSE4.2 的 CPU 也使用此等級.
+   Sse2,
+   /// 每次處理 32 bytes.
+   Avx2,
+};
+
+/// \ingroup fix
+/// 取得目前使用的指令集: 預設為 CPU 支援的最高等級.
+fon9_API FixSimdLevel FixGetSimdLevel();
+/// \ingroup fix
+/// 設定使用的指令集, 若 CPU 不支援 maxLevel, 則使用可支援的最高等級.
+/// 通常用在測試及效能比較.
+/// \return 實際使用的等級.
+fon9_API FixSimdLevel FixSetSimdLevel(FixSimdLevel maxLevel);
+
+/// \ingroup fix
+/// 計算 [pbeg, pend) 每個 byte 的合計, 用來計算 CheckSum.
+fon9_API uint32_t FixByteSum(const char* pbeg, const char* pend);
+
+/// \ingroup fix
+/// 一次掃描 [pbeg, pend): 找出全部的 '=' 及 SOH 的位置(相對於 pbeg), 並計算每個 byte 的合計.
+/// - idxout 必須至少有 (pend - pbeg) 個空間.
+/// - *byteSum = 每個 byte 的合計.
+/// \return 找到的 '=' 及 SOH 的數量.
+fon9_API size_t FixScanDelims(const char* pbeg, const char* pend, uint32_t* idxout, uint32_t* byteSum);
+
+} } // namespaces
+#endif//__fon9_fix_FixSimd_hpp__
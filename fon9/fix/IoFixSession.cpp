@@ -65,12 +65,20 @@ bool IoFixManager::OnLogonAccepted(FixRecvEvArgs& rxargs, FixSenderSP fixout) {
    return false;
 }
 //--------------------------------------------------------------------------//
+IoFixSession::~IoFixSession() {
+   if (this->Shard_)
+      this->Shard_->RemoveSession();
+}
 void IoFixSession::OnRecvLogonRequest(FixRecvEvArgs& rxargs) {
    this->FixManager_.OnRecvLogonRequest(rxargs);
 }
 void IoFixSession::OnFixSessionApReady() {
    this->FixManager_.OnFixSessionApReady(*this);
 }
+void IoFixSession::OnFixSenderAttached(FixSender& fixout) {
+   if (this->Shard_)
+      this->Shard_->AttachRecorder(fixout.GetFixRecorder());
+}
 void IoFixSession::OnFixSessionForceSend(BufferList&& msg) {
    assert(this->Dev_);
    this->Dev_->Send(std::move(msg));
@@ -91,6 +99,17 @@ void IoFixSession::OnDevice_CommonTimer(io::Device& dev, TimeStamp now) {
    (void)now;
    dev.OpQueue_.AddTask(io::DeviceAsyncOp{std::bind(&IoFixSession::FixSessionOnTimer, IoFixSessionSP{this})});
 }
+TimerThread& IoFixSession::GetDeviceTimerThread() {
+   return this->Shard_ ? this->Shard_->TimerThread_ : this->FixManager_.FixTimerThread_;
+}
+int IoFixSession::GetDeviceIoThreadIndex() {
+   return this->Shard_ ? this->Shard_->Index_ : baseIo::GetDeviceIoThreadIndex();
+}
+void IoFixSession::OnFixMessageParsed(StrView fixmsg) {
+   if (this->Shard_)
+      this->Shard_->AddRxMsgCount();
+   baseFix::OnFixMessageParsed(fixmsg);
+}
 //--------------------------------------------------------------------------//
 void IoFixSession::OnDevice_Initialized(io::Device& dev) {
    assert(this->Dev_ == nullptr);
@@ -101,8 +120,11 @@ void IoFixSession::OnDevice_Destructing(io::Device&) {
 }
 void IoFixSession::OnDevice_StateChanged(io::Device&, const io::StateChangedArgs& e) {
    if (e.BeforeState_ == io::State::LinkReady) {
-      if (auto fixout = this->OnFixSessionDisconnected(e.After_.Info_))
+      if (auto fixout = this->OnFixSessionDisconnected(e.After_.Info_)) {
+         if (this->Shard_)
+            this->Shard_->DetachRecorder(fixout->GetFixRecorder());
          this->FixManager_.OnFixSessionDisconnected(*this, std::move(fixout));
+      }
    }
 }
 io::RecvBufferSize IoFixSession::OnDevice_LinkReady(io::Device&) {
@@ -127,7 +149,8 @@ std::string IoFixSession::SessionCommand(io::Device& dev, const StrView cmdln) {
    }
    return baseIo::SessionCommand(dev, cmdln);
 }
-io::RecvBufferSize IoFixSession::OnDevice_Recv(io::Device&, DcQueueList& rxbuf) {
+io::RecvBufferSize IoFixSession::OnDevice_Recv(io::Device& dev, DcQueueList& rxbuf) {
+   this->SetFixRxTime(dev.GetRecvTime());
    return this->FeedBuffer(rxbuf) < FixParser::NeedsMore
       ? io::RecvBufferSize::NoRecvEvent
       : static_cast<io::RecvBufferSize>(FixRecorder::kMaxFixMsgBufferSize);
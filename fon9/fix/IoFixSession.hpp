@@ -3,6 +3,7 @@
 #ifndef __fon9_fix_IoFixSession_hpp__
 #define __fon9_fix_IoFixSession_hpp__
 #include "fon9/fix/FixSession.hpp"
+#include "fon9/fix/FixShard.hpp"
 #include "fon9/io/Device.hpp"
 
 namespace fon9 { namespace fix {
@@ -31,7 +32,15 @@ protected:
    bool OnLogonAccepted(FixRecvEvArgs& rxargs, FixSenderSP fixout);
 
 public:
-   IoFixManager() = default;
+   /// IoFixSession 的 Device::CommonTimer_(FIX 的 heartbeat 計時) 使用的 TimerThread.
+   TimerThread&   FixTimerThread_;
+
+   /// 使用 GetDefaultTimerThread();
+   IoFixManager() : IoFixManager{GetDefaultTimerThread()} {
+   }
+   /// 若管理大量的 FIX sessions, 可使用 GetDefaultWheelTimerThread();
+   explicit IoFixManager(TimerThread& timerThread) : FixTimerThread_(timerThread) {
+   }
    virtual ~IoFixManager();
 
    /// 如果 fixses 的角色是 Initiator 則:
@@ -80,6 +89,13 @@ protected:
    io::RecvBufferSize OnDevice_Recv(io::Device& dev, DcQueueList& rxbuf) override;
    std::string SessionCommand(io::Device& dev, StrView cmdln) override;
    void OnDevice_CommonTimer(io::Device& dev, TimeStamp now) override;
+   /// 若有指定 Shard_, 則使用 Shard_->TimerThread_; 否則使用 FixManager_.FixTimerThread_;
+   TimerThread& GetDeviceTimerThread() override;
+   /// 若有指定 Shard_, 則使用 Shard_->Index_; 否則由 IoService 決定.
+   int GetDeviceIoThreadIndex() override;
+
+   // override FixFeeder
+   void OnFixMessageParsed(StrView fixmsg) override;
 
    // override FixSession
    void FixSessionTimerRunAfter(TimeInterval after) override;
@@ -88,14 +104,25 @@ protected:
 
    void OnRecvLogonRequest(FixRecvEvArgs& rxargs) override;
    void OnFixSessionForceSend(BufferList&& msg) override;
+   /// 若有指定 Shard_, 則 fixout 的 FixRecorder 在連線期間使用 Shard_ 的 threads: Shard_->AttachRecorder();
+   /// 斷線後(OnDevice_StateChanged) 再透過 Shard_->DetachRecorder() 恢復使用預設的 threads.
+   void OnFixSenderAttached(FixSender& fixout) override;
    void OnFixSessionApReady() override;
 
 public:
    IoFixManager&  FixManager_;
-   IoFixSession(IoFixManager& mgr, const FixConfig& cfg)
+   /// 此 session 所屬的 shard, 請參考 FixShardMgr::AllocShard();
+   /// nullptr 表示不使用 shard.
+   FixShard* const   Shard_;
+
+   IoFixSession(IoFixManager& mgr, const FixConfig& cfg, FixShard* shard = nullptr)
       : baseFix{cfg}
-      , FixManager_(mgr) {
+      , FixManager_(mgr)
+      , Shard_{shard} {
+      if (shard)
+         shard->AddSession();
    }
+   ~IoFixSession();
 
    /// 通常只會在 OnDevice_LinkReady() 事件時,
    /// 檢查連線來源的「黑白名單」時才會用到.
@@ -196,6 +196,8 @@ int main(int argc, char** args) {
 
    std::remove(kFixTestInitiatorRecorderFileName);
    std::remove(kFixTestAcceptorRecorderFileName);
+   std::remove("./FixTestI.log.sidx");
+   std::remove("./FixTestA.log.sidx");
    for (;;) {
       printf("Connection type(A:Acceptor or I:Initiator or q:quit) = ");
       char  strbuf[f9fix::FixRecorder::kMaxFixMsgBufferSize];
@@ -3,6 +3,11 @@
 #include "fon9/fmkt/SymbIn.hpp"
 #include "fon9/seed/FieldMaker.hpp"
 #include "fon9/seed/Plugins.hpp"
+#include <new>
+#include <cstdlib>
+#if defined(fon9_WINDOWS)
+#include <malloc.h>
+#endif
 
 namespace fon9 { namespace fmkt {
 
@@ -24,6 +29,24 @@ SymbData* SymbIn::GetSymbData(int tabid) {
 SymbData* SymbIn::FetchSymbData(int tabid) {
    return GetSymbInData(this, tabid);
 }
+void* SymbIn::operator new(size_t sz) {
+#if defined(fon9_WINDOWS)
+   if (void* p = _aligned_malloc(sz, alignof(SymbIn)))
+      return p;
+#else
+   void* p;
+   if (posix_memalign(&p, alignof(SymbIn), sz) == 0)
+      return p;
+#endif
+   throw std::bad_alloc{};
+}
+void SymbIn::operator delete(void* p) {
+#if defined(fon9_WINDOWS)
+   _aligned_free(p);
+#else
+   free(p);
+#endif
+}
 
 //--------------------------------------------------------------------------//
 
@@ -6,12 +6,22 @@
 #include "fon9/fmkt/SymbRef.hpp"
 #include "fon9/fmkt/SymbBS.hpp"
 #include "fon9/fmkt/SymbDeal.hpp"
+#include "fon9/SeqLock.hpp"
 
 namespace fon9 { namespace fmkt {
 
 class fon9_API SymbInTree;
 using SymbInTreeSP = intrusive_ptr<SymbInTree>;
 
+/// \ingroup fmkt
+/// SymbIn 的行情快照, 透過 SymbIn::Quote_ 讓其他 thread 讀取.
+struct SymbInQuote {
+   SymbRef::Data  Ref_;
+   SymbDeal::Data Deal_;
+   SymbBS::Data   BS_;
+};
+
+fon9_WARN_DISABLE_PADDING;
 /// \ingroup fmkt
 /// 所有商品資料直接機中在此:
 /// - 適用於: 追求速度(而非彈性)的系統.
@@ -23,12 +33,25 @@ public:
    SymbRef  Ref_;
    SymbBS   BS_;
    SymbDeal Deal_;
+   /// 行情快照: Ref_, Deal_, BS_ 只能由單一 thread(行情解析)直接讀寫,
+   /// 寫入者更新後呼叫 PublishQuote(), 其他 thread(策略、風控、推送...)則透過 Quote_.Load() 無鎖讀取一致的資料.
+   SeqLocked<SymbInQuote>  Quote_;
 
    using base::base;
 
+   /// 只能在行情寫入者的 thread 呼叫.
+   void PublishQuote() {
+      this->Quote_.Store(SymbInQuote{this->Ref_.Data_, this->Deal_.Data_, this->BS_.Data_});
+   }
+
    SymbData* GetSymbData(int tabid) override;
    SymbData* FetchSymbData(int tabid) override;
+
+   /// Quote_ 需要對齊 cache line, 所以使用對齊的記憶體配置.
+   static void* operator new(size_t sz);
+   static void operator delete(void* p);
 };
+fon9_WARN_POP;
 
 class fon9_API SymbInTree : public SymbTree {
    fon9_NON_COPY_NON_MOVE(SymbInTree);
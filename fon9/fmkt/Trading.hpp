@@ -76,7 +76,11 @@ class fon9_API TradingLineManager {
 public:
    using Locker = TradingLines::Locker;
 
+   /// 流量管制計時使用 GetDefaultTimerThread();
    TradingLineManager() = default;
+   /// 流量管制計時使用 timerThread.
+   explicit TradingLineManager(TimerThread& timerThread) : FlowControlTimer_{timerThread} {
+   }
    virtual ~TradingLineManager();
 
    /// 當 src 進入可下單狀態時的通知:
@@ -105,6 +109,8 @@ private:
    struct FlowControlTimer : public DataMemberTimer {
       fon9_NON_COPY_NON_MOVE(FlowControlTimer);
       FlowControlTimer() = default;
+      FlowControlTimer(TimerThread& timerThread) : DataMemberTimer{timerThread} {
+      }
       virtual void EmitOnTimer(TimeStamp now) override;
    };
    FlowControlTimer FlowControlTimer_;
@@ -2,6 +2,7 @@
 // \author fonwinz@gmail.com
 #include "fon9/framework/Framework.hpp"
 #include "fon9/seed/SysEnv.hpp"
+#include "fon9/seed/MemBlockTree.hpp"
 #include "fon9/ConfigLoader.hpp"
 #include "fon9/InnSyncerFile.hpp"
 #include "fon9/FilePath.hpp"
@@ -51,6 +52,7 @@ void Framework::Initialize(int argc, char** argv) {
    this->Root_.reset(new seed::MaTree{"Services"});
 
    auto sysEnv = seed::SysEnv::Plant(this->Root_);
+   seed::MemBlockTree::Plant(this->Root_);
    static const CmdArgDef  argConfigPath{
       StrView{fon9_kCSTR_SysEnvItem_ConfigPath}, //Name
       StrView{"fon9cfg"}, //DefaultValue
@@ -24,8 +24,15 @@ static DeviceFactorySP MakeIoFactoryFileIO(std::string name) {
       Factory(std::string name) : DeviceFactory(std::move(name)) {
       }
       io::DeviceSP CreateDevice(IoManagerSP mgr, SessionFactory& sesFactory, const IoConfigItem& cfg, std::string& errReason) override {
-         if (auto ses = sesFactory.CreateSession(*mgr, cfg, errReason))
+         if (auto ses = sesFactory.CreateSession(*mgr, cfg, errReason)) {
+         #ifdef fon9_POSIX
+            // 若 IoManager 使用 io_uring, 則檔案的讀寫也由 fdr thread 處理.
+            io::FdrServiceSP iosv = mgr->GetFdrService();
+            return new fon9::io::FileIO(std::move(iosv), std::move(ses), std::move(mgr));
+         #else
             return new fon9::io::FileIO(std::move(ses), std::move(mgr));
+         #endif
+         }
          return io::DeviceSP{};
       }
    };
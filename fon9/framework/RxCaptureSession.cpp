@@ -0,0 +1,215 @@
+﻿/// \file fon9/framework/RxCaptureSession.cpp
+/// \author fonwinz@gmail.com
+#include "fon9/framework/RxCaptureSession.hpp"
+#include "fon9/framework/IoManager.hpp"
+#include "fon9/io/Device.hpp"
+#include <map>
+
+namespace fon9 {
+
+RxCaptureSession::~RxCaptureSession() {
+}
+void RxCaptureSession::OnDevice_Initialized(io::Device& dev) {
+   if (this->Inner_)
+      this->Inner_->OnDevice_Initialized(dev);
+}
+void RxCaptureSession::OnDevice_Destructing(io::Device& dev) {
+   if (this->Inner_)
+      this->Inner_->OnDevice_Destructing(dev);
+}
+void RxCaptureSession::OnDevice_StateChanged(io::Device& dev, const io::StateChangedArgs& e) {
+   if (this->Inner_)
+      this->Inner_->OnDevice_StateChanged(dev, e);
+}
+void RxCaptureSession::OnDevice_StateUpdated(io::Device& dev, const io::StateUpdatedArgs& e) {
+   if (this->Inner_)
+      this->Inner_->OnDevice_StateUpdated(dev, e);
+}
+io::RecvBufferSize RxCaptureSession::OnDevice_LinkReady(io::Device& dev) {
+   this->RemainSize_ = 0;
+   if (this->Inner_) {
+      io::RecvBufferSize res = this->Inner_->OnDevice_LinkReady(dev);
+      // 若 Inner_ 不接收資料, 仍需要接收並錄製.
+      return res == io::RecvBufferSize::NoRecvEvent ? io::RecvBufferSize::Default : res;
+   }
+   return io::RecvBufferSize::Default;
+}
+io::RecvBufferSize RxCaptureSession::OnDevice_Recv(io::Device& dev, DcQueueList& rxbuf) {
+   const size_t rxsz = rxbuf.CalcSize();
+   if (rxsz < this->RemainSize_) // rxbuf 被清除過(例: 斷線後重新連線)?
+      this->RemainSize_ = 0;
+   this->Writer_->Append(this->LineId_, dev.GetRecvTime(), rxbuf, this->RemainSize_);
+   if (!this->Inner_) {
+      rxbuf.PopConsumed(rxsz);
+      return io::RecvBufferSize::Default;
+   }
+   io::RecvBufferSize res = this->Inner_->OnDevice_Recv(dev, rxbuf);
+   this->RemainSize_ = rxbuf.CalcSize();
+   return res;
+}
+void RxCaptureSession::OnDevice_CommonTimer(io::Device& dev, TimeStamp now) {
+   if (this->Inner_)
+      this->Inner_->OnDevice_CommonTimer(dev, now);
+}
+TimerThread& RxCaptureSession::GetDeviceTimerThread() {
+   return this->Inner_ ? this->Inner_->GetDeviceTimerThread() : io::Session::GetDeviceTimerThread();
+}
+int RxCaptureSession::GetDeviceIoThreadIndex() {
+   return this->Inner_ ? this->Inner_->GetDeviceIoThreadIndex() : io::Session::GetDeviceIoThreadIndex();
+}
+std::string RxCaptureSession::SessionCommand(io::Device& dev, StrView cmdln) {
+   return this->Inner_ ? this->Inner_->SessionCommand(dev, cmdln) : io::Session::SessionCommand(dev, cmdln);
+}
+
+//--------------------------------------------------------------------------//
+
+fon9_WARN_DISABLE_PADDING;
+struct RxCaptureSessionArgs {
+   StrView  FileName_;
+   uint32_t LineId_{0};
+   StrView  InnerName_;
+   StrView  InnerArgs_;
+
+   bool Parse(StrView cfg, std::string& errReason) {
+      StrView tag, value;
+      while (StrFetchTagValue(cfg, tag, value)) {
+         if (tag == "File")
+            this->FileName_ = value;
+         else if (tag == "Line")
+            this->LineId_ = StrTo(value, 0u);
+         else if (tag == "Session") {
+            this->InnerName_ = value;
+            this->InnerArgs_ = cfg;
+            break;
+         }
+         else {
+            errReason = "RxCapture|err=Unknown tag: " + tag.ToString();
+            return false;
+         }
+      }
+      if (this->FileName_.empty()) {
+         errReason = "RxCapture|err=Require: File=";
+         return false;
+      }
+      return true;
+   }
+   IoConfigItem MakeInnerConfig(const IoConfigItem& cfg) const {
+      IoConfigItem inner = cfg;
+      inner.SessionName_.assign(this->InnerName_);
+      inner.SessionArgs_.assign(this->InnerArgs_);
+      return inner;
+   }
+};
+
+class RxCaptureSessionFactory : public SessionFactory {
+   fon9_NON_COPY_NON_MOVE(RxCaptureSessionFactory);
+   using base = SessionFactory;
+   using WriterMap = std::map<std::string, RxCaptureWriterSP>;
+   using Writers = MustLock<WriterMap>;
+   Writers  Writers_;
+
+   RxCaptureWriterSP FetchWriter(StrView fileName, std::string& errReason) {
+      Writers::Locker   writers{this->Writers_};
+      RxCaptureWriterSP& writer = (*writers)[fileName.ToString()];
+      if (!writer) {
+         RxCaptureWriterSP w{new RxCaptureWriter};
+         auto res = w->Initialize(fileName.ToString());
+         if (!res) {
+            writers->erase(fileName.ToString());
+            errReason = RevPrintTo<std::string>("RxCapture|fname=", fileName, '|', res);
+            return nullptr;
+         }
+         writer = std::move(w);
+      }
+      return writer;
+   }
+
+   struct Server : public io::SessionServer {
+      fon9_NON_COPY_NON_MOVE(Server);
+      const RxCaptureWriterSP    Writer_;
+      const io::SessionServerSP  Inner_;
+      const uint32_t             LineId_;
+      Server(RxCaptureWriterSP writer, uint32_t lineId, io::SessionServerSP inner)
+         : Writer_{std::move(writer)}
+         , Inner_{std::move(inner)}
+         , LineId_{lineId} {
+      }
+      io::SessionSP OnDevice_Accepted(io::DeviceServer& dev) override {
+         io::SessionSP inner;
+         if (this->Inner_ && !(inner = this->Inner_->OnDevice_Accepted(dev)))
+            return nullptr;
+         return io::SessionSP{new RxCaptureSession{this->Writer_, this->LineId_, std::move(inner)}};
+      }
+   };
+
+   SessionFactorySP GetInnerFactory(IoManager& mgr, const RxCaptureSessionArgs& args, std::string& errReason) {
+      if (args.InnerName_.empty())
+         return nullptr;
+      auto fac = mgr.SessionFactoryPark_->Get(args.InnerName_);
+      if (!fac)
+         errReason = "RxCapture|err=Session not found: " + args.InnerName_.ToString();
+      return fac;
+   }
+
+public:
+   using base::base;
+
+   io::SessionSP CreateSession(IoManager& mgr, const IoConfigItem& cfg, std::string& errReason) override {
+      RxCaptureSessionArgs args;
+      if (!args.Parse(ToStrView(cfg.SessionArgs_), errReason))
+         return nullptr;
+      io::SessionSP inner;
+      if (!args.InnerName_.empty()) {
+         auto fac = this->GetInnerFactory(mgr, args, errReason);
+         if (!fac || !(inner = fac->CreateSession(mgr, args.MakeInnerConfig(cfg), errReason)))
+            return nullptr;
+      }
+      auto writer = this->FetchWriter(args.FileName_, errReason);
+      if (!writer)
+         return nullptr;
+      return io::SessionSP{new RxCaptureSession{std::move(writer), args.LineId_, std::move(inner)}};
+   }
+   io::SessionServerSP CreateSessionServer(IoManager& mgr, const IoConfigItem& cfg, std::string& errReason) override {
+      RxCaptureSessionArgs args;
+      if (!args.Parse(ToStrView(cfg.SessionArgs_), errReason))
+         return nullptr;
+      io::SessionServerSP inner;
+      if (!args.InnerName_.empty()) {
+         auto fac = this->GetInnerFactory(mgr, args, errReason);
+         if (!fac || !(inner = fac->CreateSessionServer(mgr, args.MakeInnerConfig(cfg), errReason)))
+            return nullptr;
+      }
+      auto writer = this->FetchWriter(args.FileName_, errReason);
+      if (!writer)
+         return nullptr;
+      return io::SessionServerSP{new Server{std::move(writer), args.LineId_, std::move(inner)}};
+   }
+};
+fon9_WARN_POP;
+
+fon9_API SessionFactorySP MakeRxCaptureSessionFactory(std::string name) {
+   return new RxCaptureSessionFactory(std::move(name));
+}
+
+static bool RxCapture_Start(seed::PluginsHolder& holder, StrView args) {
+   // plugins args: "Name=RxCapture|AddTo=FpSession"
+   struct ArgsParser : public SessionFactoryConfigParser {
+      ArgsParser() : SessionFactoryConfigParser{"RxCapture"} {}
+      SessionFactorySP CreateSessionFactory() override {
+         return MakeRxCaptureSessionFactory(this->Name_);
+      }
+   };
+   return ArgsParser{}.Parse(holder, args);
+}
+
+} // namespaces
+
+extern "C" fon9_API fon9::seed::PluginsDesc f9p_RxCapture;
+static fon9::seed::PluginsPark f9pRegister{"RxCapture", &f9p_RxCapture};
+
+fon9::seed::PluginsDesc f9p_RxCapture{
+   "",
+   &fon9::RxCapture_Start,
+   nullptr,
+   nullptr,
+};
@@ -0,0 +1,60 @@
+﻿/// \file fon9/framework/RxCaptureSession.hpp
+/// \author fonwinz@gmail.com
+#ifndef __fon9_framework_RxCaptureSession_hpp__
+#define __fon9_framework_RxCaptureSession_hpp__
+#include "fon9/framework/IoFactory.hpp"
+#include "fon9/RxCapture.hpp"
+
+namespace fon9 {
+
+fon9_WARN_DISABLE_PADDING;
+/// \ingroup io
+/// 將 Device 收到的資料, 原封不動的寫入 RxCaptureWriter(含收到的時間), 然後轉給 Inner_ 處理.
+/// - 用來錄製行情(或其他接收資料), 之後可用 RxCaptureReader 依原始時間間隔重播.
+/// - 若 Inner_ 為 nullptr, 則只錄製, 收到的資料全部拋棄.
+/// - 不支援 Inner_->FnOnDevice_RecvDirect_: 一律透過 Inner_->OnDevice_Recv() 處理.
+class fon9_API RxCaptureSession : public io::Session {
+   fon9_NON_COPY_NON_MOVE(RxCaptureSession);
+   const RxCaptureWriterSP Writer_;
+   const io::SessionSP     Inner_;
+   const uint32_t          LineId_;
+   /// 上次 Inner_->OnDevice_Recv() 返回時, rxbuf 剩餘的資料量, 這些資料已經錄製過了.
+   size_t                  RemainSize_{0};
+
+public:
+   RxCaptureSession(RxCaptureWriterSP writer, uint32_t lineId, io::SessionSP inner)
+      : Writer_{std::move(writer)}
+      , Inner_{std::move(inner)}
+      , LineId_{lineId} {
+   }
+   ~RxCaptureSession();
+
+   const io::SessionSP& GetInner() const {
+      return this->Inner_;
+   }
+
+   void OnDevice_Initialized(io::Device& dev) override;
+   void OnDevice_Destructing(io::Device& dev) override;
+   void OnDevice_StateChanged(io::Device& dev, const io::StateChangedArgs& e) override;
+   void OnDevice_StateUpdated(io::Device& dev, const io::StateUpdatedArgs& e) override;
+   io::RecvBufferSize OnDevice_LinkReady(io::Device& dev) override;
+   io::RecvBufferSize OnDevice_Recv(io::Device& dev, DcQueueList& rxbuf) override;
+   void OnDevice_CommonTimer(io::Device& dev, TimeStamp now) override;
+   TimerThread& GetDeviceTimerThread() override;
+   int GetDeviceIoThreadIndex() override;
+   std::string SessionCommand(io::Device& dev, StrView cmdln) override;
+};
+fon9_WARN_POP;
+
+/// \ingroup io
+/// 建立 RxCaptureSession 的 SessionFactory.
+/// - SessionArgs 格式: "File=fileName|Line=n|Session=InnerSessionFactoryName|inner SessionArgs..."
+///   - File: 必須提供, 相同檔名的 RxCaptureSession 共用同一個 RxCaptureWriter, 可用 Line 區分 A/B 線路.
+///   - Line: 預設為 0.
+///   - Session: 在 IoManager 的 SessionFactoryPark_ 尋找 InnerSessionFactoryName, 用來建立 Inner session;
+///     之後的內容, 為 Inner session 的 SessionArgs.
+///     若沒提供, 則只錄製, 不處理收到的資料.
+fon9_API SessionFactorySP MakeRxCaptureSessionFactory(std::string name = "RxCapture");
+
+} // namespaces
+#endif//__fon9_framework_RxCaptureSession_hpp__
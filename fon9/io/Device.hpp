@@ -22,6 +22,7 @@ class fon9_API Device : public intrusive_ref_counter<Device> {
    Bookmark       ManagerBookmark_{0};
    std::string    DeviceId_;
    DeviceOptions  Options_;
+   TimeStamp      RecvTime_{TimeStamp::Null()};
    
 public:
    const Style       Style_;
@@ -38,7 +39,7 @@ public:
       , Style_{style}
       , Manager_{std::move(mgr)}
       , Session_{std::move(ses)}
-      , CommonTimer_{GetDefaultTimerThread()} {
+      , CommonTimer_{this->Session_->GetDeviceTimerThread()} {
       assert(this->Session_);
       if (optsDefault)
          this->Options_ = *optsDefault;
@@ -58,6 +59,13 @@ public:
    void SetManagerBookmark(Bookmark n) { this->ManagerBookmark_ = n; }
    Bookmark GetManagerBookmark() const { return this->ManagerBookmark_; }
 
+   /// 在 OnDevice_Recv() 或 FnOnDevice_RecvDirect() 事件裡面, 取得這次收到資料的時間.
+   /// - 由 kernel 或網卡提供(例: FdrSocket 使用 "RecvTs=Sw" 或 "RecvTs=Hw" 設定), 可用來計算從收到封包到處理的延遲.
+   /// - 若 Device 沒有提供, 則為 TimeStamp::Null().
+   /// - 由 DeviceRecvBufferReady() 在觸發事件前設定.
+   TimeStamp GetRecvTime() const { return this->RecvTime_; }
+   void SetRecvTime(TimeStamp tm) { this->RecvTime_ = tm; }
+
    /// - 如果 !cfgstr.empty() 則使用 OpImpl_Open(cfgstr) 來開啟.
    /// - 如果 cfgstr.empty()  會先檢查現在狀態是否允許 reopen, 如果可以, 則使用 OpImpl_Reopen() 來開啟.
    void AsyncOpen(std::string cfgstr) {
@@ -11,6 +11,7 @@ fon9_WARN_DISABLE_PADDING;
 /// \ingroup io
 /// 輔助處理資料接收:
 /// - 觸發資料到達事件: dev.Session_->OnDevice_Recv();
+///   觸發前會先設定 dev.SetRecvTime(rbuf.GetRecvTime());
 /// - 繼續接收: aux.ContinueRecv();
 ///
 /// \code
@@ -27,6 +28,7 @@ void DeviceRecvBufferReady(Device& dev, DcQueueList& rxbuf, Aux& aux) {
    RecvBufferSize contRecvSize;
    RecvBuffer&    rbuf = RecvBuffer::StaticCast(rxbuf);
    DeviceOpLocker rlocker;
+   dev.SetRecvTime(rbuf.GetRecvTime());
    if (auto fnRecvDirect = dev.Session_->FnOnDevice_RecvDirect_) {
       struct RecvDirectAux : public RecvDirectArgs {
          fon9_NON_COPY_NON_MOVE(RecvDirectAux);
@@ -29,6 +29,10 @@ namespace fon9 { namespace io {
 //       Loopback=Y or N
 //       TTL=hops    必須有提供 Loopback 選項.
 //
+// 收(udp or multicast)的額外選項:
+//    RecvBatch=n    一次系統呼叫(recvmmsg)最多取得 n 個 datagram, 目前僅 Linux 支援.
+//                   每個 datagram 仍個別觸發 OnDevice_Recv().
+//
 
 bool DgramBase::CreateSocket(Socket& so, const SocketAddress& addr, SocketResult& soRes) {
    this->Config_.Options_.TCP_NODELAY_ = 0;
@@ -82,6 +86,7 @@ void DgramBase::OpImpl_Open(std::string cfgstr) {
    this->Interface_.Addr_.sa_family = AF_UNSPEC;
    this->TTL_ = 0;
    this->Loopback_ = -1;
+   this->RecvBatch_ = 0;
    base::OpImpl_Open(std::move(cfgstr));
 }
 ConfigParser::Result DgramBase::OpImpl_SetProperty(StrView tag, StrView& value) {
@@ -103,8 +108,22 @@ ConfigParser::Result DgramBase::OpImpl_SetProperty(StrView tag, StrView& value)
       this->Loopback_ = (toupper(value.Get1st()) == 'Y');
       return ConfigParser::Result::Success;
    }
+   if (iequals(tag, "RecvBatch")) {
+      this->RecvBatch_ = StrTo(value, this->RecvBatch_);
+      return ConfigParser::Result::Success;
+   }
    return base::OpImpl_SetProperty(tag, value);
 }
+void DgramBase::OpImpl_AppendDeviceInfo(std::string& info) {
+   if (this->RecvBatch_ <= 1)
+      return;
+   RevPrintAppendTo(info,
+                    "|RecvBatch=", this->RecvBatch_,
+                    "|batches=", this->RecvBatchStat_.BatchCount_.load(std::memory_order_relaxed),
+                    "|dgrams=", this->RecvBatchStat_.DgramCount_.load(std::memory_order_relaxed),
+                    "|full=", this->RecvBatchStat_.FullCount_.load(std::memory_order_relaxed),
+                    "|max=", this->RecvBatchStat_.MaxBatch_.load(std::memory_order_relaxed));
+}
 
 static inline const SocketAddress* GetAddrOrNull(const SocketAddress& addr) {
    return addr.GetPort() == 0 ? nullptr : &addr;
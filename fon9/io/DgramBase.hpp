@@ -7,6 +7,29 @@
 namespace fon9 { namespace io {
 
 fon9_WARN_DISABLE_PADDING;
+/// \ingroup io
+/// 使用 RecvBatch 時(一次系統呼叫取得多個 datagram)的統計.
+/// 只會在 io thread 更新, 所以不用 atomic 的 read-modify-write.
+struct DgramRecvBatchStat {
+   /// 取得資料的系統呼叫(recvmmsg)次數.
+   std::atomic<uint64_t>   BatchCount_{0};
+   /// 取得的 datagram 數量.
+   std::atomic<uint64_t>   DgramCount_{0};
+   /// 一次就取滿 RecvBatch 的次數: 若比例偏高, 表示 kernel 的接收緩衝有累積, 可考慮加大 RecvBatch.
+   std::atomic<uint64_t>   FullCount_{0};
+   /// 單次取得的最大 datagram 數量.
+   std::atomic<uint32_t>   MaxBatch_{0};
+
+   void Add(uint32_t count, bool isFull) {
+      this->BatchCount_.store(this->BatchCount_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      this->DgramCount_.store(this->DgramCount_.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+      if (isFull)
+         this->FullCount_.store(this->FullCount_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      if (this->MaxBatch_.load(std::memory_order_relaxed) < count)
+         this->MaxBatch_.store(count, std::memory_order_relaxed);
+   }
+};
+
 /// \ingroup io
 /// Dgram 基底, 衍生出: IocpDgram, FdrDgram;
 /// Dgram 包含 Udp, Multicast.
@@ -19,10 +42,13 @@ class fon9_API DgramBase : public SocketClientDevice {
    SocketAddress  Interface_;
    int            Loopback_;
    uint8_t        TTL_;
+   uint16_t       RecvBatch_;
 
 protected:
    void OpImpl_Open(std::string cfgstr) override;
    ConfigParser::Result OpImpl_SetProperty(StrView tag, StrView& value) override;
+   /// 若有設定 RecvBatch, 則加上 "|RecvBatch=n|batches=|dgrams=|full=|max=".
+   void OpImpl_AppendDeviceInfo(std::string& info) override;
    bool CreateSocket(Socket& so, const SocketAddress& addr, SocketResult& soRes) override;
    void OpImpl_Connected(Socket::socket_t so);
    void OpImpl_OnAddrListEmpty() override;
@@ -31,6 +57,15 @@ public:
    DgramBase(SessionSP ses, ManagerSP mgr)
       : base(std::move(ses), std::move(mgr), Style::Client) {
    }
+
+   /// 設定 "RecvBatch=n": 每次 readable 時, 一次系統呼叫最多取得 n 個 datagram(Linux: recvmmsg).
+   /// - 每個 datagram 仍會個別觸發 OnDevice_Recv(), 保留封包邊界.
+   /// - 0 or 1: 不使用, 每次系統呼叫取得一個 datagram.
+   /// - 僅在建立 socket 時取用, 所以變更後需要重新開啟(reopen)才會生效.
+   uint16_t GetRecvBatch() const {
+      return this->RecvBatch_;
+   }
+   DgramRecvBatchStat   RecvBatchStat_;
 };
 fon9_WARN_POP;
 
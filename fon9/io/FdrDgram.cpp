@@ -20,9 +20,121 @@ bool FdrDgramImpl::OpImpl_ConnectTo(const SocketAddress& addr, SocketResult& soR
    return true;
 }
 
+FdrDgramImpl::~FdrDgramImpl() {
+   for (FwdBufferNode* node : this->RecvBatchNodes_) {
+      if (node)
+         FreeNode(node);
+   }
+}
+
 void FdrDgramImpl::OnFdrEvent_Handling(FdrEventFlag evs) {
+   if ((this->RecvBatch_ > 1 || this->GetFdrRecvMode() == FdrRecvMode::Nodes)
+       && IsEnumContains(evs, FdrEventFlag::Readable) && this->State_ != State::Closing) {
+      if (!this->CheckReadBatch())
+         return;
+      // FdrRecvMode::Async: 不使用 recvmmsg(), 由 CheckRead() 透過 StartFdrAsyncIo() 每次讀取一個 datagram;
+      // 但若仍有保留的 datagrams, 則必須等這些 datagrams 處理完畢, 才能繼續讀取.
+      if (this->GetFdrRecvMode() != FdrRecvMode::Async || !this->FdrRecvNodes_.empty())
+         evs -= FdrEventFlag::Readable;
+   }
    FdrEventProcessor(this, *this->Owner_, evs);
 }
+
+bool FdrDgramImpl::RecvDgram(BufferNode* node, TimeStamp recvTime) {
+   if (fon9_UNLIKELY(this->RecvSize_ < RecvBufferSize::Default)) {
+      // Session 決定不要再處理 OnDevice_Recv() 事件, 所以拋棄收到的資料.
+      FreeNode(node);
+      return true;
+   }
+   BufferList rxnodes;
+   rxnodes.push_back(node);
+   CheckReadAux aux;
+   aux.FnIsRecvBufferAlive_ = &OwnerDevice::OpImpl_IsRecvBufferAlive;
+   this->RecvBuffer_.SetRecvTime(recvTime);
+   DeviceRecvBufferReady(*this->Owner_, this->RecvBuffer_.SetDataReceived(std::move(rxnodes)), aux);
+   return aux.IsNeedsUpdateFdrEvent_ == nullptr;
+}
+
+bool FdrDgramImpl::CheckReadBatch() {
+   // 先處理上次保留的 datagrams.
+   while (!this->FdrRecvNodes_.empty()) {
+      if (this->IsRecvSuspended())
+         return true;
+      TimeStamp recvTime = TimeStamp::Null();
+      if (this->IsRecvTs_ && !this->RecvBatchTimes_.empty()) {
+         recvTime = this->RecvBatchTimes_.front();
+         this->RecvBatchTimes_.pop_front();
+      }
+      if (!this->RecvDgram(this->FdrRecvNodes_.pop_front(), recvTime))
+         return true;
+   }
+   if (this->IsRecvSuspended() || this->GetFdrRecvMode() != FdrRecvMode::Ready)
+      return true;
+
+   size_t expectSize = (this->RecvSize_ <= RecvBufferSize::Default
+                        ? 1024 * 4
+                        : static_cast<size_t>(this->RecvSize_));
+   if (expectSize < 64)
+      expectSize = 64;
+   const unsigned batch = this->RecvBatch_;
+   struct mmsghdr msgs[kMaxRecvBatch];
+   struct iovec   iovs[kMaxRecvBatch];
+   RecvTsControl  ctrls[kMaxRecvBatch];
+   size_t         totrd = 0;
+   for (;;) {
+      for (unsigned L = 0; L < batch; ++L) {
+         FwdBufferNode*& node = this->RecvBatchNodes_[L];
+         if (node == nullptr || node->GetRemainSize() < expectSize) {
+            if (node)
+               FreeNode(node);
+            node = FwdBufferNode::Alloc(expectSize);
+         }
+         iovs[L].iov_base = node->GetDataEnd();
+         iovs[L].iov_len = node->GetRemainSize();
+         ZeroStruct(msgs[L].msg_hdr);
+         msgs[L].msg_hdr.msg_iov = &iovs[L];
+         msgs[L].msg_hdr.msg_iovlen = 1;
+         if (this->IsRecvTs_) {
+            msgs[L].msg_hdr.msg_control = ctrls[L].Buf_;
+            msgs[L].msg_hdr.msg_controllen = sizeof(ctrls[L].Buf_);
+         }
+      }
+      int count = recvmmsg(this->GetFD(), msgs, batch, 0, nullptr);
+      if (count <= 0) {
+         if (count < 0) {
+            if (int eno = ErrorCannotRetry(errno)) {
+               this->SocketError("Recv", eno);
+               return false;
+            }
+         }
+         return true;
+      }
+      this->Owner_->RecvBatchStat_.Add(static_cast<uint32_t>(count), static_cast<unsigned>(count) >= batch);
+      bool isSuspended = false;
+      for (int L = 0; L < count; ++L) {
+         const size_t rxsz = msgs[L].msg_len;
+         if (fon9_UNLIKELY(rxsz == 0)) // 空的 datagram: node 留給下次使用.
+            continue;
+         FwdBufferNode* node = this->RecvBatchNodes_[static_cast<unsigned>(L)];
+         this->RecvBatchNodes_[static_cast<unsigned>(L)] = nullptr;
+         node->SetDataEnd(node->GetDataEnd() + rxsz);
+         totrd += rxsz;
+         const TimeStamp recvTime = (this->IsRecvTs_ ? GetRecvTs(msgs[L].msg_hdr) : TimeStamp::Null());
+         if (isSuspended || (isSuspended = this->IsRecvSuspended()) == true) {
+            this->FdrRecvNodes_.push_back(node);
+            if (this->IsRecvTs_)
+               this->RecvBatchTimes_.push_back(recvTime);
+         }
+         else if (!this->RecvDgram(node, recvTime))
+            isSuspended = true;
+      }
+      // 沒取滿: kernel 已無資料; 或 readable 已關閉; 或避免一次占用太久; 都先結束.
+      if (static_cast<unsigned>(count) < batch || isSuspended || totrd > 1024 * 256)
+         return true;
+      if (this->IsRecvSuspended())
+         return true;
+   }
+}
 void FdrDgramImpl::OnFdrEvent_StartSend() {
    this->StartSend(*this->Owner_);
 }
@@ -4,6 +4,7 @@
 #define __fon9_io_FdrDgram_hpp__
 #include "fon9/io/DgramBase.hpp"
 #include "fon9/io/FdrSocketClient.hpp"
+#include <deque>
 
 namespace fon9 { namespace io {
 
@@ -15,15 +16,45 @@ struct FdrDgramImpl : public FdrSocketClientImpl {
    virtual void OnFdrSocket_Error(std::string errmsg) override;
    virtual void SocketError(StrView fnName, int eno) override;
 
+   /// 使用 recvmmsg() 一次最多取得 RecvBatch_ 個 datagram, 每個 datagram 各自觸發一次 OnDevice_Recv().
+   /// 若需要到 op thread 觸發 OnDevice_Recv(), 則剩餘的 datagram(每個 node 一個 datagram)先放在 FdrRecvNodes_,
+   /// 等 readable 重新啟用後, 再由 fdr thread 觸發 Readable 事件繼續處理.
+   /// - FdrRecvMode::Async(例: io_uring): 只處理保留的 datagrams, 不使用 recvmmsg(),
+   ///   因為 io_uring 已將讀取要求合併在 io_uring_enter() 裡面.
+   /// - FdrRecvMode::Nodes(例: io_uring multishot recv): fdr thread 放入 FdrRecvNodes_ 的每個 node 為一個 datagram,
+   ///   此時不論 RecvBatch_ 為何, 都在此逐一處理, 不使用 recvmmsg().
+   /// \retval false 讀取失敗, 返回前已呼叫 OnFdrSocket_Error();
+   bool CheckReadBatch();
+   /// \retval false 需要到 op thread 觸發 OnDevice_Recv(), readable 已關閉.
+   bool RecvDgram(BufferNode* node, TimeStamp recvTime);
+
+   enum : uint16_t {
+      kMaxRecvBatch = 256,
+   };
+   /// 在建構時從 Owner_ 取得, 避免在 io thread 裡面存取 Owner_ 的設定.
+   const uint16_t                RecvBatch_;
+   /// 提供給 recvmmsg() 的接收緩衝, 未用到的 node 留給下次使用.
+   std::vector<FwdBufferNode*>   RecvBatchNodes_;
+   /// 有設定 "RecvTs" 時, 保留在 FdrRecvNodes_ 的 datagram 的接收時間, 與 FdrRecvNodes_ 一一對應.
+   std::deque<TimeStamp>         RecvBatchTimes_;
+
 public:
    using OwnerDevice = DgramT<FdrServiceSP, FdrDgramImpl>;
    using OwnerDeviceSP = intrusive_ptr<OwnerDevice>;
    const OwnerDeviceSP  Owner_;
 
    FdrDgramImpl(OwnerDevice* owner, Socket&& so, SocketResult&)
-      : base{*owner->IoService_, std::move(so)}
+      : base{*owner->IoService_, std::move(so), owner->Session_->GetDeviceIoThreadIndex()}
+      , RecvBatch_{owner->GetRecvBatch() > kMaxRecvBatch ? static_cast<uint16_t>(kMaxRecvBatch) : owner->GetRecvBatch()}
       , Owner_{owner} {
+      if (this->RecvBatch_ > 1)
+         this->RecvBatchNodes_.resize(this->RecvBatch_);
+      // io_uring 的 multishot recv 無法取得接收時間, 所以有設定 "RecvTs" 時, 不使用 FdrRecvNodes_.
+      this->IsFdrRecvNodesAllowed_ = !this->IsRecvTs_;
+      this->IsFdrRecvNodesDgram_ = true;
    }
+   ~FdrDgramImpl();
+
    bool OpImpl_ConnectTo(const SocketAddress& addr, SocketResult& soRes);
 };
 
@@ -11,8 +11,10 @@ FdrService::FdrService(FdrThreads thrs, const IoServiceArgs& ioArgs, const std::
    : FdrThreads_{std::move(thrs)} {
    assert(!this->FdrThreads_.empty());
    size_t L = 0;
-   for (auto& thr : this->FdrThreads_)
+   for (auto& thr : this->FdrThreads_) {
+      thr->HowWait_ = ioArgs.HowWait_;
       thr->Thread_ = std::thread(&FdrThread::ThrRun, thr.get(), ServiceThreadArgs{ioArgs, thrName, L++});
+   }
 }
 FdrService::~FdrService() {
 }
@@ -51,6 +53,8 @@ void FdrThread::ThrRun(ServiceThreadArgs args) {
       }
    }
    this->Thread_.detach();
+   if (args.IsLoopHist_)
+      fon9_LOG_INFO("FdrThread.LoopHist|name=", args.Name_, "|index=", args.ThreadPoolIndex_ + 1, '|', this->LoopHist_);
    fon9_LOG_ThrRun("FdrThread.ThrRun.End|name=", args.Name_);
    delete this;
 }
@@ -59,6 +63,9 @@ void FdrThread::ProcessPendingSends() {
    for (FdrEventHandlerSP& sender : reqs)
       sender->OnFdrEvent_StartSend();
 }
+void FdrThread::StartAsyncIo(FdrAsyncIoReq& req) {
+   OnFdrEvent_AsyncIoDone(req, -ENOTSUP);
+}
 void FdrThread::PushToPendingReqs(PendingReqs& reqs, FdrEventHandlerSP&& handler) {
    {
       PendingReqs::Locker lk{reqs};
@@ -68,7 +75,7 @@ void FdrThread::PushToPendingReqs(PendingReqs& reqs, FdrEventHandlerSP&& handler
 }
 void FdrThread::WakeupThread() {
    if (this->WakeupRequests_.fetch_add(1, std::memory_order_relaxed) == 0)
-      if (!this->IsThisThread())
+      if (this->HowWait_ != HowWait::Spin && !this->IsThisThread())
          this->WakeupFdr_.Wakeup();
 }
 
@@ -76,6 +83,10 @@ void FdrThread::WakeupThread() {
 
 FdrEventHandler::~FdrEventHandler() {
 }
+void FdrEventHandler::OnFdrEvent_AsyncIoDone(FdrAsyncIoReq& req, ssize_t res) {
+   (void)req;
+   (void)res;
+}
 
 } } // namespaces
 #endif//fon9_POSIX
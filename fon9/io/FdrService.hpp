@@ -4,12 +4,16 @@
 #define __fon9_io_FdrService_hpp__
 #include "fon9/io/IoBase.hpp"
 #include "fon9/io/IoServiceArgs.hpp"
+#include "fon9/buffer/BufferList.hpp"
 #include "fon9/FdrNotify.hpp"
 #include "fon9/MustLock.hpp"
 #include "fon9/ThreadId.hpp"
+#include "fon9/LatencyHistogram.hpp"
 
 #include <thread>
 #include <vector>
+#include <sys/uio.h>
+#include <sys/socket.h>
 
 namespace fon9 { namespace io {
 
@@ -33,6 +37,56 @@ enum class FdrEventFlag {
 };
 fon9_ENABLE_ENUM_BITWISE_OP(FdrEventFlag);
 
+/// 由 fdr thread 決定, FdrEventHandler 在 Readable 事件時, 應如何取得資料.
+enum class FdrRecvMode : uint8_t {
+   /// 由 FdrEventHandler 自行 read(); 例: epoll.
+   Ready,
+   /// fdr thread 已將資料放在 FdrEventHandler::FdrRecvNodes_; 例: io_uring 的 multishot recv.
+   Nodes,
+   /// FdrEventHandler 透過 StartFdrAsyncIo() 讀取, 在完成時處理資料; 例: io_uring 的 IORING_OP_READV.
+   /// 此時 fdr thread 不偵測 readable, 而是在 Readable 啟用(UpdateFdrEvent)時觸發一次 Readable 事件,
+   /// 由 FdrEventHandler 決定是否啟動讀取.
+   Async,
+};
+
+fon9_WARN_DISABLE_PADDING;
+/// \ingroup io
+/// 由 fdr thread 執行的非同步讀寫要求, 請參考 FdrEventHandler::StartFdrAsyncIo();
+/// - 由 FdrEventHandler 擁有, 在完成(OnFdrEvent_AsyncIoDone)之前, 不可變動, 也不可釋放.
+/// - Iov_ 指向的緩衝區, 在完成之前, 也必須保持有效.
+struct FdrAsyncIoReq {
+   fon9_NON_COPY_NON_MOVE(FdrAsyncIoReq);
+   FdrAsyncIoReq() = default;
+
+   enum class Op : uint8_t {
+      /// writev(); IovCount_ == 1 時使用 write();
+      Write,
+      /// readv(); IovCount_ == 1 時使用 read();
+      Read,
+      /// recvmsg(&Msg_); 由使用者設定 Msg_, 通常 Msg_.msg_iov = Iov_;
+      RecvMsg,
+   };
+   enum : unsigned {
+      kMaxIovCount = 64,
+   };
+   Op             Op_{Op::Write};
+   unsigned       IovCount_{0};
+   /// 檔案的讀寫位置, -1 表示使用 fd 目前的位置(例: socket, 使用 O_APPEND 開啟的檔案).
+   int64_t        Offset_{-1};
+   struct iovec   Iov_[kMaxIovCount];
+   struct msghdr  Msg_;
+
+   /// 從送出要求, 到觸發 OnFdrEvent_AsyncIoDone() 之前, 由 fdr thread 保留 handler.
+   FdrEventHandlerSP Handler_;
+   /// 由 fdr thread 使用, 用來記錄尚未完成的要求.
+   uint32_t          FdrThreadSlot_{0};
+
+   bool IsPending() const {
+      return this->Handler_.get() != nullptr;
+   }
+};
+fon9_WARN_POP;
+
 //--------------------------------------------------------------------------//
 
 /// \ingroup io
@@ -51,15 +105,71 @@ protected:
    FdrNotify         WakeupFdr_;
    ThreadId::IdType  ThreadId_;
    std::atomic_uint_fast32_t  WakeupRequests_{0};
+   /// 由 FdrService 在啟動 thread 之前設定.
+   /// HowWait::Spin: 每次迴圈都會檢查 WakeupRequests_, 所以不使用 WakeupFdr_.
+   HowWait           HowWait_{HowWait::Block};
+   /// 衍生者(例: FdrThreadIoUring)若有實作 StartAsyncIo(), 則應在建構時設為 true.
+   bool              IsAsyncIoSupported_{false};
+   LatencyHistogram  LoopHist_;
 
    void ClearWakeup() {
       assert(this->IsThisThread());
-      this->WakeupFdr_.ClearWakeup();
+      if (this->HowWait_ != HowWait::Spin)
+         this->WakeupFdr_.ClearWakeup();
       this->WakeupRequests_.store(0, std::memory_order_relaxed);
    }
 
+   /// 若有設定 "LoopHist=Y": 記錄從「有事件要處理」到「處理完畢, 再次等候之前」的耗時.
+   /// \code
+   ///   LoopTimer loopTimer{*this, args};
+   ///   while (...) {
+   ///      if (has pendings) { loopTimer.Start(); ProcessPendings(); }
+   ///      loopTimer.Stop();
+   ///      wait...
+   ///      if (has events) { loopTimer.Start(); process events; }
+   ///   }
+   /// \endcode
+   class LoopTimer {
+      fon9_NON_COPY_NON_MOVE(LoopTimer);
+      using Clock = std::chrono::steady_clock;
+      LatencyHistogram* const Hist_;
+      Clock::time_point       StartTime_;
+      bool                    IsStarted_{false};
+   public:
+      LoopTimer(FdrThread& owner, const ServiceThreadArgs& args)
+         : Hist_{args.IsLoopHist_ ? &owner.LoopHist_ : nullptr} {
+      }
+      void Start() {
+         if (fon9_UNLIKELY(this->Hist_ != nullptr) && !this->IsStarted_) {
+            this->IsStarted_ = true;
+            this->StartTime_ = Clock::now();
+         }
+      }
+      void Stop() {
+         if (fon9_UNLIKELY(this->IsStarted_)) {
+            this->IsStarted_ = false;
+            this->Hist_->Add(static_cast<uint64_t>(
+               std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - this->StartTime_).count()));
+         }
+      }
+   };
+
    static void OnFdrEvent_Emit(FdrEventFlag evs, FdrEventHandler* handler);
    static void SetFdrEventHandlerBookmark(FdrEventHandler* handler, uint64_t bookmark);
+   static bool IsFdrRecvNodesAllowed(const FdrEventHandler* handler);
+   static bool IsFdrRecvNodesDgram(const FdrEventHandler* handler);
+   static bool IsFdrAsyncRecvAllowed(const FdrEventHandler* handler);
+   static BufferList& GetFdrRecvNodes(FdrEventHandler* handler);
+   static void SetFdrRecvMode(FdrEventHandler* handler, FdrRecvMode mode);
+   static bool IsFdrAsyncIoCanceled(const FdrEventHandler* handler);
+   /// handler 已移除, 之後的 StartFdrAsyncIo() 都直接以 -ECANCELED 結束.
+   static void SetFdrAsyncIoCanceled(FdrEventHandler* handler);
+   /// 觸發 req.Handler_->OnFdrEvent_AsyncIoDone(req, res);
+   /// 在觸發前會先取出 req.Handler_, 所以在事件裡面可以再次使用 req 送出新的要求.
+   static void OnFdrEvent_AsyncIoDone(FdrAsyncIoReq& req, ssize_t res);
+
+   /// 只會在 this thread 呼叫, 預設: 不支援, 直接以 -ENOTSUP 結束.
+   virtual void StartAsyncIo(FdrAsyncIoReq& req);
 
    static PendingReqsImpl MoveOutPendingImpl(PendingReqs& impl) {
       PendingReqs::Locker lk{impl};
@@ -74,6 +184,13 @@ public:
    bool IsThisThread() const {
       return this->ThreadId_ == ThisThread_.ThreadId_;
    }
+   bool IsAsyncIoSupported() const {
+      return this->IsAsyncIoSupported_;
+   }
+   /// 需要在 IoServiceArgs 設定 "LoopHist=Y" 才會有統計資料.
+   const LatencyHistogram& GetLoopHist() const {
+      return this->LoopHist_;
+   }
 
 private:
    std::thread Thread_;
@@ -122,6 +239,17 @@ public:
 
    /// 預設使用 [fd % thrCount] 決定使用哪個 fdr thread.
    virtual FdrThreadSP AllocFdrThread(Fdr::fdr_t fd);
+   /// - thrIndex >= 0: 使用 [thrIndex % thrCount] 的 fdr thread, 例: 讓 session 固定在指定的 thread.
+   /// - thrIndex < 0:  使用 AllocFdrThread(fd);
+   FdrThreadSP SelectFdrThread(Fdr::fdr_t fd, int thrIndex) {
+      if (thrIndex < 0)
+         return this->AllocFdrThread(fd);
+      return this->FdrThreads_[static_cast<size_t>(thrIndex) % this->FdrThreads_.size()];
+   }
+
+   const FdrThreads& GetFdrThreads() const {
+      return this->FdrThreads_;
+   }
 
 private:
    const FdrThreads  FdrThreads_;
@@ -130,6 +258,7 @@ using FdrServiceSP = intrusive_ptr<FdrService>;
 
 /// \ingroup io
 /// 各個 OS 有它自己的預設 FdrService: 例如 Linux = FdrServiceEpoll.
+/// - Linux: 若 ioArgs.ServiceKind_ == IoServiceKind::IoUring, 則使用 FdrServiceIoUring.
 fon9_API FdrServiceSP MakeDefaultFdrService(const IoServiceArgs& ioArgs, const std::string& thrName, Result2& err);
 
 //--------------------------------------------------------------------------//
@@ -140,9 +269,9 @@ class fon9_API FdrEventHandler {
    fon9_NON_COPY_NON_MOVE(FdrEventHandler);
 
 public:
-   /// 建構時由 iosv 分配 FdrThread.
-   FdrEventHandler(FdrService& iosv, FdrAuto&& fd)
-      : FdrThread_{iosv.AllocFdrThread(fd.GetFD())}
+   /// 建構時由 iosv 分配 FdrThread, 請參考 FdrService::SelectFdrThread();
+   FdrEventHandler(FdrService& iosv, FdrAuto&& fd, int thrIndex = -1)
+      : FdrThread_{iosv.SelectFdrThread(fd.GetFD(), thrIndex)}
       , Fdr_{std::move(fd)} {
    }
 
@@ -177,6 +306,20 @@ public:
    bool InFdrThread() const {
       return this->FdrThread_->IsThisThread();
    }
+
+   /// fdr thread 是否支援 StartFdrAsyncIo(); 例: FdrThreadIoUring.
+   bool IsFdrAsyncIoSupported() const {
+      return this->FdrThread_->IsAsyncIoSupported();
+   }
+   /// 透過 fdr thread 執行非同步讀寫(例: io_uring 的 IORING_OP_WRITEV), 完成時觸發 OnFdrEvent_AsyncIoDone();
+   /// - 只能在 fdr thread 裡面呼叫, 若 !IsFdrAsyncIoSupported(), 則直接以 -ENOTSUP 結束.
+   /// - 同一個 req 同時只能有一個要求.
+   /// - 已 RemoveFdrEvent() 的 handler: 尚未完成的要求會被取消(-ECANCELED), 之後的要求也會直接以 -ECANCELED 結束.
+   void StartFdrAsyncIo(FdrAsyncIoReq& req) {
+      assert(this->InFdrThread() && !req.IsPending());
+      req.Handler_.reset(this);
+      this->FdrThread_->StartAsyncIo(req);
+   }
    uint64_t GetFdrEventHandlerBookmark() const {
       return this->FdrThreadBookmark_;
    }
@@ -189,12 +332,25 @@ public:
    ///   但是沒有從 fdr thread 移除, 若要移除, 應使用 RemoveFdrEvent();
    virtual FdrEventFlag GetRequiredFdrEventFlag() const = 0;
 
-private:
-   friend class FdrThread;
-   // 在建構時就決定了要使用哪個 FdrThread & 處理哪個 fd 的事件.
-   const FdrThreadSP FdrThread_;
-   const FdrAuto     Fdr_;
-   uint64_t          FdrThreadBookmark_{0};
+protected:
+   /// 若 fdr thread 支援「由 kernel 直接填入資料的接收緩衝」(例: io_uring 的 multishot recv + provided buffer ring),
+   /// 則收到的資料會先放在這裡, 然後觸發 OnFdrEvent_Handling(FdrEventFlag::Readable);
+   /// - 只能在 fdr thread 裡面使用.
+   /// - 衍生者(例: FdrSocket)在 Readable 事件時, 應優先取用這裡的資料, 若這裡沒資料, 才需要 read();
+   /// - 衍生者也可將「已讀入但暫時無法處理」的資料保留在此(例: FdrDgram 使用 recvmmsg() 取得的 datagrams);
+   /// - 當 Readable 重新啟用(UpdateFdrEvent)時, 若這裡仍有資料, fdr thread 會再觸發一次 Readable 事件.
+   BufferList  FdrRecvNodes_;
+   /// 衍生者若能處理 FdrRecvNodes_, 則應在建構時設為 true.
+   bool        IsFdrRecvNodesAllowed_{false};
+   /// FdrRecvNodes_ 的每個 node 為一個 datagram(例: FdrDgram), fdr thread 不可將資料合併到同一個 node.
+   bool        IsFdrRecvNodesDgram_{false};
+   /// 衍生者若能在 FdrRecvMode::Async 時, 透過 StartFdrAsyncIo() 讀取, 則應在建構時設為 true.
+   bool        IsFdrAsyncRecvAllowed_{false};
+
+   /// 由 fdr thread 決定, 只能在 fdr thread 裡面使用.
+   FdrRecvMode GetFdrRecvMode() const {
+      return this->FdrRecvMode_;
+   }
 
    /// 可能同時有多種事件通知.
    /// 只會在 fdr thread 裡面呼叫.
@@ -203,6 +359,20 @@ private:
    /// 透過 StartSendInFdrThread() 啟動在 fdr thread 的傳送.
    virtual void OnFdrEvent_StartSend() = 0;
 
+   /// StartFdrAsyncIo() 的結果, 只會在 fdr thread 裡面呼叫.
+   /// - res 與 readv()/writev() 的傳回值相同, 但失敗時為 -errno.
+   /// - 預設 do nothing.
+   virtual void OnFdrEvent_AsyncIoDone(FdrAsyncIoReq& req, ssize_t res);
+
+private:
+   friend class FdrThread;
+   // 在建構時就決定了要使用哪個 FdrThread & 處理哪個 fd 的事件.
+   const FdrThreadSP FdrThread_;
+   const FdrAuto     Fdr_;
+   uint64_t          FdrThreadBookmark_{0};
+   FdrRecvMode       FdrRecvMode_{FdrRecvMode::Ready};
+   bool              IsFdrAsyncIoCanceled_{false};
+
    virtual void OnFdrEvent_AddRef() = 0;
    virtual void OnFdrEvent_ReleaseRef() = 0;
 
@@ -222,6 +392,31 @@ inline void FdrThread::OnFdrEvent_Emit(FdrEventFlag evs, FdrEventHandler* handle
 inline void FdrThread::SetFdrEventHandlerBookmark(FdrEventHandler* handler, uint64_t bookmark) {
    handler->FdrThreadBookmark_ = bookmark;
 }
+inline bool FdrThread::IsFdrRecvNodesAllowed(const FdrEventHandler* handler) {
+   return handler->IsFdrRecvNodesAllowed_;
+}
+inline bool FdrThread::IsFdrRecvNodesDgram(const FdrEventHandler* handler) {
+   return handler->IsFdrRecvNodesDgram_;
+}
+inline bool FdrThread::IsFdrAsyncRecvAllowed(const FdrEventHandler* handler) {
+   return handler->IsFdrAsyncRecvAllowed_;
+}
+inline BufferList& FdrThread::GetFdrRecvNodes(FdrEventHandler* handler) {
+   return handler->FdrRecvNodes_;
+}
+inline void FdrThread::SetFdrRecvMode(FdrEventHandler* handler, FdrRecvMode mode) {
+   handler->FdrRecvMode_ = mode;
+}
+inline bool FdrThread::IsFdrAsyncIoCanceled(const FdrEventHandler* handler) {
+   return handler->IsFdrAsyncIoCanceled_;
+}
+inline void FdrThread::SetFdrAsyncIoCanceled(FdrEventHandler* handler) {
+   handler->IsFdrAsyncIoCanceled_ = true;
+}
+inline void FdrThread::OnFdrEvent_AsyncIoDone(FdrAsyncIoReq& req, ssize_t res) {
+   FdrEventHandlerSP handler{std::move(req.Handler_)};
+   handler->OnFdrEvent_AsyncIoDone(req, res);
+}
 
 } } // namespaces
 #endif//__fon9_io_FdrService_hpp__
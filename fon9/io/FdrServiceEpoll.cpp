@@ -2,12 +2,28 @@
 /// \author fonwinz@gmail.com
 #ifdef __linux__
 #include "fon9/io/FdrServiceEpoll.hpp"
+#include "fon9/io/FdrServiceIoUring.hpp"
 #include "fon9/Log.hpp"
 #include <sys/epoll.h>
+#include <sys/ioctl.h>
+
+// Linux 6.9 之後才有 EPIOCSPARAMS, 若編譯環境的 header 比較舊, 則自行定義.
+#ifndef EPIOCSPARAMS
+struct epoll_params {
+   uint32_t busy_poll_usecs;
+   uint16_t busy_poll_budget;
+   uint8_t  prefer_busy_poll;
+   uint8_t  __pad;
+};
+#define EPOLL_IOC_TYPE  0x8A
+#define EPIOCSPARAMS    _IOW(EPOLL_IOC_TYPE, 0x01, struct epoll_params)
+#endif
 
 namespace fon9 { namespace io {
 
 fon9_API FdrServiceSP MakeDefaultFdrService(const IoServiceArgs& ioArgs, const std::string& thrName, Result2& err) {
+   if (ioArgs.ServiceKind_ == IoServiceKind::IoUring)
+      return FdrServiceIoUring::MakeService(ioArgs, thrName, err);
    return FdrServiceEpoll::MakeService(ioArgs, thrName, err);
 }
 FdrServiceSP FdrServiceEpoll::MakeService(const IoServiceArgs& ioArgs, const std::string& thrName, MakeResult& err) {
@@ -59,6 +75,16 @@ void FdrThreadEpoll::ThrRunImpl(const ServiceThreadArgs& args) {
    EvHandlers  evHandlers{args.Capacity_};
    Fdr::fdr_t  epFdr = this->FdrEpoll_.GetFD();
    const int   kEpollWaitMS = (IsBlockWait(args.HowWait_) ? -1 : 0);
+   LoopTimer   loopTimer{*this, args};
+   if (args.BusyPollUs_ > 0) {
+      struct epoll_params epParams;
+      ZeroStruct(epParams);
+      epParams.busy_poll_usecs = args.BusyPollUs_;
+      epParams.busy_poll_budget = 8; // = kernel 的 BUSY_POLL_BUDGET; 超過 NAPI_POLL_WEIGHT(64) 需要 CAP_NET_ADMIN.
+      epParams.prefer_busy_poll = 1;
+      if (ioctl(epFdr, EPIOCSPARAMS, &epParams) != 0)
+         fon9_LOG_WARN("FdrThreadEpoll.ThrRun|fn=ioctl(EPIOCSPARAMS)|BusyPoll=", args.BusyPollUs_, "|err=", GetSysErrC());
+   }
    while (this->use_count() > 0) {
       // 再次進入 epoll_wait() 之前, 必須先將 Pending Removes, Updates 處理完,
       // 因為: 在 OnFdrEvent_Emit() 裡面關閉 readable, writable 偵測, 必須確實執行.
@@ -66,6 +92,7 @@ void FdrThreadEpoll::ThrRunImpl(const ServiceThreadArgs& args) {
       //       如果沒有確實禁止 readable, writable, 則可能會發生非預期的結果.
       int msWait = kEpollWaitMS;
       if (fon9_UNLIKELY(this->WakeupRequests_.load(std::memory_order_relaxed) != 0)) {
+         loopTimer.Start();
          this->ClearWakeup();
          this->ProcessPendings(epFdr, evHandlers);
          // 如果在 ProcessPendings() 時有再增加 Wakeup,
@@ -73,9 +100,11 @@ void FdrThreadEpoll::ThrRunImpl(const ServiceThreadArgs& args) {
          if (this->WakeupRequests_.load(std::memory_order_relaxed) != 0)
             msWait = 0;
       }
+      loopTimer.Stop();
       struct epoll_event* pEvBeg = &*epEvents.begin();
       int epRes = epoll_wait(epFdr, pEvBeg, static_cast<int>(epEvents.size()), msWait);
       if (fon9_LIKELY(epRes > 0)) {
+         loopTimer.Start();
          for (int L = 0; L < epRes; ++L, ++pEvBeg) {
             if (FdrEventHandler* hdr = static_cast<FdrEventHandler*>(pEvBeg->data.ptr)) {
                if (fon9_LIKELY(hdr->GetFdrEventHandlerBookmark() > 0)) {
@@ -132,11 +161,16 @@ void FdrThreadEpoll::ProcessPendings(Fdr::fdr_t epFdr, EvHandlers& evHandlers) {
       this->SetFdrEventHandlerBookmark(hdr, 0);
    }
    reqs = this->MoveOutPendingImpl(this->PendingUpdates_);
+   // 重新啟用 Readable 時, 若 FdrRecvNodes_ 仍有之前保留的資料, 則必須再觸發一次 Readable,
+   // 因為 kernel 可能已沒有資料, 不會再有 EPOLLIN.
+   std::vector<FdrEventHandler*> recvPendings;
    for (FdrEventHandlerSP& sp : reqs) {
       FdrEventHandler* hdr = sp.get();
       auto idx1 = hdr->GetFdrEventHandlerBookmark();
       int  op;
       FdrEventFlag evs = hdr->GetRequiredFdrEventFlag();
+      if (fon9_UNLIKELY(!GetFdrRecvNodes(hdr).empty()) && IsEnumContains(evs, FdrEventFlag::Readable))
+         recvPendings.push_back(hdr);
       if (fon9_LIKELY(idx1 > 0)) {
          EvHandler*  pEvObj = evHandlers.GetObjPtr(idx1 - 1);
          if (fon9_UNLIKELY(pEvObj == nullptr))
@@ -174,6 +208,10 @@ void FdrThreadEpoll::ProcessPendings(Fdr::fdr_t epFdr, EvHandlers& evHandlers) {
                         "|err=", GetSysErrC(eno));
       }
    }
+   for (FdrEventHandler* hdr : recvPendings) {
+      if (hdr->GetFdrEventHandlerBookmark() > 0)
+         this->OnFdrEvent_Emit(FdrEventFlag::Readable, hdr);
+   }
 }
 
 } } // namespaces
@@ -0,0 +1,656 @@
+﻿/// \file fon9/io/FdrServiceIoUring.cpp
+/// \author fonwinz@gmail.com
+#ifdef __linux__
+#include "fon9/io/FdrServiceIoUring.hpp"
+#include "fon9/Log.hpp"
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace fon9 { namespace io {
+
+FdrServiceSP FdrServiceIoUring::MakeService(const IoServiceArgs& ioArgs, const std::string& thrName, MakeResult& err) {
+   size_t thrCount = ioArgs.ThreadCount_;
+   if (thrCount <= 0)
+      thrCount = 1;
+   FdrService::FdrThreads thrs(thrCount);
+   for (size_t L = 0; L < thrCount; ++L) {
+      thrs[L].reset(new FdrThreadIoUring{ioArgs, err});
+      if (err.IsError())
+         return FdrServiceSP{};
+   }
+   thrs.shrink_to_fit();
+   return FdrServiceSP{new FdrService{std::move(thrs), ioArgs, thrName + ".iouring"}};
+}
+
+//--------------------------------------------------------------------------//
+
+/// user_data 的編碼:
+/// - kWakeupUserData: WakeupFdr_ 的 POLL_ADD;
+/// - kCancelUserData: POLL_REMOVE 或 ASYNC_CANCEL 的結果, 不用處理.
+/// - (ptr | kAsyncIoTag): StartAsyncIo(FdrAsyncIoReq* ptr);
+/// - 其他: (idx+1) << 32 | (seq << 1); handler 的 POLL_ADD 或 multishot recv.
+static constexpr uint64_t kCancelUserData = ~static_cast<uint64_t>(0);
+static constexpr uint64_t kWakeupUserData = 0;
+static constexpr uint64_t kAsyncIoTag = 1;
+/// 只有一個 provided buffer ring, 所以 buffer group id 固定為 0.
+static constexpr uint16_t kRecvBufGroupId = 0;
+
+static inline uint64_t MakePollUserData(uint32_t idx, uint32_t seq) {
+   return (static_cast<uint64_t>(idx + 1) << 32) | (static_cast<uint64_t>(seq) << 1);
+}
+static inline uint64_t MakeAsyncIoUserData(FdrAsyncIoReq* req) {
+   return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(req)) | kAsyncIoTag;
+}
+static inline unsigned LoadAcquire(const unsigned* p) {
+   return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+static inline void StoreRelease(unsigned* p, unsigned v) {
+   __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+template <class T>
+static inline T* RingPtr(void* base, uint32_t offset) {
+   return reinterpret_cast<T*>(reinterpret_cast<char*>(base) + offset);
+}
+
+void FdrThreadIoUring::Ring::Close() {
+   if (this->SqesMmap_)
+      munmap(this->SqesMmap_, this->SqesMmapSize_);
+   if (this->CqMmap_ && this->CqMmap_ != this->SqMmap_)
+      munmap(this->CqMmap_, this->CqMmapSize_);
+   if (this->SqMmap_)
+      munmap(this->SqMmap_, this->SqMmapSize_);
+   this->SqesMmap_ = this->CqMmap_ = this->SqMmap_ = nullptr;
+   this->RingFdr_.Close();
+}
+Result2 FdrThreadIoUring::Ring::Open(unsigned entries) {
+   struct io_uring_params params;
+   ZeroStruct(params);
+   int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+   if (fd < 0)
+      return Result2{"io_uring_setup", GetSysErrC()};
+   this->RingFdr_.SetFD(fd);
+   this->Features_ = params.features;
+
+   this->SqMmapSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+   this->CqMmapSize_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+   if (params.features & IORING_FEAT_SINGLE_MMAP) {
+      if (this->CqMmapSize_ > this->SqMmapSize_)
+         this->SqMmapSize_ = this->CqMmapSize_;
+      this->CqMmapSize_ = this->SqMmapSize_;
+   }
+   void* p = mmap(nullptr, this->SqMmapSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+   if (p == MAP_FAILED)
+      return Result2{"mmap(SQ_RING)", GetSysErrC()};
+   this->SqMmap_ = p;
+   if (params.features & IORING_FEAT_SINGLE_MMAP)
+      this->CqMmap_ = p;
+   else {
+      p = mmap(nullptr, this->CqMmapSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+      if (p == MAP_FAILED)
+         return Result2{"mmap(CQ_RING)", GetSysErrC()};
+      this->CqMmap_ = p;
+   }
+   this->SqesMmapSize_ = params.sq_entries * sizeof(struct io_uring_sqe);
+   p = mmap(nullptr, this->SqesMmapSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+   if (p == MAP_FAILED)
+      return Result2{"mmap(SQES)", GetSysErrC()};
+   this->SqesMmap_ = p;
+
+   this->SqHead_ = RingPtr<unsigned>(this->SqMmap_, params.sq_off.head);
+   this->SqTail_ = RingPtr<unsigned>(this->SqMmap_, params.sq_off.tail);
+   this->SqMask_ = *RingPtr<unsigned>(this->SqMmap_, params.sq_off.ring_mask);
+   this->SqEntries_ = *RingPtr<unsigned>(this->SqMmap_, params.sq_off.ring_entries);
+   this->SqArray_ = RingPtr<unsigned>(this->SqMmap_, params.sq_off.array);
+   this->Sqes_ = reinterpret_cast<io_uring_sqe*>(this->SqesMmap_);
+   this->SqLocalTail_ = *this->SqTail_;
+
+   this->CqHead_ = RingPtr<unsigned>(this->CqMmap_, params.cq_off.head);
+   this->CqTail_ = RingPtr<unsigned>(this->CqMmap_, params.cq_off.tail);
+   this->CqMask_ = *RingPtr<unsigned>(this->CqMmap_, params.cq_off.ring_mask);
+   this->Cqes_ = RingPtr<io_uring_cqe>(this->CqMmap_, params.cq_off.cqes);
+   return Result2{};
+}
+io_uring_sqe* FdrThreadIoUring::Ring::GetSqe() {
+   while (this->SqLocalTail_ - LoadAcquire(this->SqHead_) >= this->SqEntries_) {
+      // SQ 已滿, 先把已填妥的送出.
+      if (this->Enter(0) < 0)
+         std::this_thread::yield();
+   }
+   unsigned       idx = this->SqLocalTail_ & this->SqMask_;
+   io_uring_sqe*  sqe = this->Sqes_ + idx;
+   memset(sqe, 0, sizeof(*sqe));
+   this->SqArray_[idx] = idx;
+   ++this->SqLocalTail_;
+   ++this->SqPending_;
+   return sqe;
+}
+int FdrThreadIoUring::Ring::Enter(unsigned minComplete) {
+   StoreRelease(this->SqTail_, this->SqLocalTail_);
+   unsigned flags = (minComplete > 0 ? IORING_ENTER_GETEVENTS : 0u);
+   if (this->SqPending_ == 0 && flags == 0)
+      return 0;
+   int res = static_cast<int>(syscall(__NR_io_uring_enter, this->RingFdr_.GetFD(),
+                                      this->SqPending_, minComplete, flags, nullptr, 0));
+   if (fon9_LIKELY(res >= 0)) {
+      this->SqPending_ -= (static_cast<unsigned>(res) < this->SqPending_ ? static_cast<unsigned>(res) : this->SqPending_);
+      return res;
+   }
+   return -errno;
+}
+
+//--------------------------------------------------------------------------//
+
+FdrThreadIoUring::RecvRing::~RecvRing() {
+   for (FwdBufferNode* node : this->Nodes_)
+      FreeNode(node);
+   free(this->BufRing_);
+}
+Result2 FdrThreadIoUring::RecvRing::Open(int ringfd, uint32_t count, uint32_t bufSize) {
+   // ring entries 必須是 2 的 n 次方, 且 kernel 限制最多 32768.
+   uint32_t entries = 1;
+   while (entries < count && entries < 32768)
+      entries <<= 1;
+   const size_t memsz = entries * sizeof(struct io_uring_buf);
+   void*        mem;
+   if (int eno = posix_memalign(&mem, static_cast<size_t>(sysconf(_SC_PAGESIZE)), memsz))
+      return Result2{"RecvRing.posix_memalign", GetSysErrC(eno)};
+   memset(mem, 0, memsz);
+   struct io_uring_buf_reg reg;
+   ZeroStruct(reg);
+   reg.ring_addr = reinterpret_cast<uintptr_t>(mem);
+   reg.ring_entries = entries;
+   reg.bgid = kRecvBufGroupId;
+   if (syscall(__NR_io_uring_register, ringfd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0) {
+      Result2 res{"io_uring_register(PBUF_RING)", GetSysErrC()};
+      free(mem);
+      return res;
+   }
+   this->BufRing_ = reinterpret_cast<io_uring_buf_ring*>(mem);
+   this->Mask_ = static_cast<uint16_t>(entries - 1);
+   // FwdBufferNode::Alloc(sz) 會再加上 sizeof(FwdBufferNode), 若直接使用 bufSize, 則會用到下一個等級的 MemBlock;
+   // 例: Alloc(4096) 實際使用 16K 的區塊.
+   this->NodeExtSize_ = static_cast<uint32_t>(bufSize - sizeof(FwdBufferNode));
+   // 複製上限: 1/16 個接收緩衝, 複製的目的 node 剛好使用較小等級的 MemBlock; 例: 16K 的接收緩衝, 使用 1K 的 node.
+   // 較大的資料直接交出 node, 避免複製的成本大於節省的記憶體.
+   this->CopyMax_ = static_cast<uint32_t>(bufSize / 16 - sizeof(FwdBufferNode));
+   this->Nodes_.resize(entries);
+   for (uint32_t bid = 0; bid < entries; ++bid) {
+      this->Nodes_[bid] = FwdBufferNode::Alloc(this->NodeExtSize_);
+      this->Provide(static_cast<uint16_t>(bid));
+   }
+   this->Commit();
+   return Result2{};
+}
+void FdrThreadIoUring::RecvRing::Provide(uint16_t bid) {
+   // 不可改變 buf.resv: bufs[0].resv 就是 ring 的 tail.
+   // 在 C++ 裡面, <linux/io_uring.h> 的 __DECLARE_FLEX_ARRAY(bufs) 會多出一個空的 struct, 造成 bufs 的位置不正確,
+   // 所以不使用 BufRing_->bufs, 直接把 BufRing_ 當成 io_uring_buf 陣列.
+   FwdBufferNode* node = this->Nodes_[bid];
+   io_uring_buf&  buf = reinterpret_cast<io_uring_buf*>(this->BufRing_)[this->LocalTail_ & this->Mask_];
+   buf.addr = reinterpret_cast<uintptr_t>(node->GetDataEnd());
+   buf.len = node->GetRemainSize();
+   buf.bid = bid;
+   ++this->LocalTail_;
+}
+void FdrThreadIoUring::RecvRing::Commit() {
+   __atomic_store_n(&this->BufRing_->tail, this->LocalTail_, __ATOMIC_RELEASE);
+}
+
+//--------------------------------------------------------------------------//
+
+FdrThreadIoUring::FdrThreadIoUring(const IoServiceArgs& ioArgs, FdrServiceIoUring::MakeResult& res) {
+   // 每個 handler 通常同時有 [1個 POLL_ADD + 1個 POLL_REMOVE],
+   // 再加上 StartFdrAsyncIo() 的讀寫要求(使用 RecvRing 時, 則是 multishot recv 及 ASYNC_CANCEL),
+   // 所以 SQ 大小預設為 Capacity 的 2 倍.
+   // SQ 不足時, 會先送出再繼續, 所以這裡只是減少 io_uring_enter() 的次數.
+   unsigned entries = 256;
+   if (ioArgs.Capacity_ * 2 > entries)
+      entries = static_cast<unsigned>(ioArgs.Capacity_ * 2 > 4096 ? 4096 : ioArgs.Capacity_ * 2);
+   res = this->Ring_.Open(entries);
+   if (res.IsError())
+      return;
+   // IORING_FEAT_RSRC_TAGS 與 IORING_POLL_ADD_MULTI 同在 Linux 5.13 加入;
+   // IORING_FEAT_RW_CUR_POS(Linux 5.6): 支援 IORING_OP_READ/WRITE, 且 offset=-1 表示使用目前位置.
+   this->IsPollMulti_ = ((this->Ring_.Features_ & IORING_FEAT_RSRC_TAGS) != 0);
+   this->IsAsyncIoSupported_ = ((this->Ring_.Features_ & IORING_FEAT_RW_CUR_POS) != 0);
+
+   FdrNotify::Result resEvFd = this->WakeupFdr_.Open();
+   if (resEvFd.IsError()) {
+      res = FdrServiceIoUring::MakeResult{"WakeupFdr.Open", resEvFd.GetError()};
+      return;
+   }
+   if (ioArgs.RecvRingCount_ > 0) {
+      // 不支援 provided buffer ring(Linux 5.19 之前), 仍可使用 IORING_OP_READV(或 POLLIN + read()), 所以不視為錯誤.
+      Result2 resRecvRing = this->RecvRing_.Open(this->Ring_.RingFdr_.GetFD(), ioArgs.RecvRingCount_, ioArgs.RecvRingBufSize_);
+      if (resRecvRing.IsError())
+         fon9_LOG_WARN("FdrThreadIoUring.RecvRing|count=", ioArgs.RecvRingCount_, "|bufSize=", ioArgs.RecvRingBufSize_, "|err=", resRecvRing);
+   }
+}
+FdrThreadIoUring::~FdrThreadIoUring() {
+}
+
+//--------------------------------------------------------------------------//
+
+void FdrThreadIoUring::ArmWakeup() {
+   io_uring_sqe* sqe = this->Ring_.GetSqe();
+   sqe->opcode = IORING_OP_POLL_ADD;
+   sqe->fd = this->WakeupFdr_.GetReadFD();
+   sqe->poll32_events = POLLIN;
+   if (this->IsPollMulti_)
+      sqe->len = IORING_POLL_ADD_MULTI;
+   sqe->user_data = kWakeupUserData;
+}
+void FdrThreadIoUring::ArmPoll(EvHandler& evh, uint32_t idx) {
+   assert(evh.ArmSeq_ == 0);
+   // 不論是否設定 FdrEventFlag::Error, 都要偵測錯誤事件.
+   unsigned mask = POLLERR | POLLHUP;
+   // FdrRecvMode::Nodes: 由 multishot recv 的結果觸發 Readable;
+   // FdrRecvMode::Async: 由 handler 自行送出 IORING_OP_READV;
+   // 所以只有 FdrRecvMode::Ready 需要 POLLIN.
+   if (IsEnumContains(evh.Events_, FdrEventFlag::Readable) && evh.RecvMode_ == FdrRecvMode::Ready)
+      mask |= POLLIN | POLLPRI | POLLRDHUP;
+   if (IsEnumContains(evh.Events_, FdrEventFlag::Writable))
+      mask |= POLLOUT;
+   io_uring_sqe* sqe = this->Ring_.GetSqe();
+   sqe->opcode = IORING_OP_POLL_ADD;
+   sqe->fd = evh->GetFD();
+   sqe->poll32_events = mask;
+   if (this->IsPollMulti_)
+      sqe->len = IORING_POLL_ADD_MULTI;
+   sqe->user_data = MakePollUserData(idx, evh.ArmSeq_ = this->NextArmSeq());
+}
+void FdrThreadIoUring::CancelPoll(EvHandler& evh, uint32_t idx) {
+   if (evh.ArmSeq_ == 0)
+      return;
+   io_uring_sqe* sqe = this->Ring_.GetSqe();
+   sqe->opcode = IORING_OP_POLL_REMOVE;
+   sqe->fd = -1;
+   sqe->addr = MakePollUserData(idx, evh.ArmSeq_);
+   sqe->user_data = kCancelUserData;
+   evh.ArmSeq_ = 0;
+}
+void FdrThreadIoUring::SetRecvMode(EvHandler& evh) {
+   FdrEventHandler* hdr = evh.get();
+   if (this->RecvRing_.IsEnabled() && !evh.IsRecvFallback_ && IsFdrRecvNodesAllowed(hdr))
+      evh.RecvMode_ = FdrRecvMode::Nodes;
+   else if (this->IsAsyncIoSupported_ && IsFdrAsyncRecvAllowed(hdr))
+      evh.RecvMode_ = FdrRecvMode::Async;
+   else
+      evh.RecvMode_ = FdrRecvMode::Ready;
+   SetFdrRecvMode(hdr, evh.RecvMode_);
+}
+void FdrThreadIoUring::ArmRecv(EvHandler& evh, uint32_t idx) {
+   assert(evh.RecvSeq_ == 0);
+   io_uring_sqe* sqe = this->Ring_.GetSqe();
+   sqe->opcode = IORING_OP_RECV;
+   sqe->fd = evh->GetFD();
+   sqe->ioprio = IORING_RECV_MULTISHOT;
+   sqe->flags = IOSQE_BUFFER_SELECT;
+   sqe->buf_group = kRecvBufGroupId;
+   sqe->user_data = MakePollUserData(idx, evh.RecvSeq_ = this->NextArmSeq());
+}
+void FdrThreadIoUring::CancelRecv(EvHandler& evh, uint32_t idx) {
+   if (evh.RecvSeq_ == 0 || evh.IsRecvCanceling_)
+      return;
+   // recv 真正結束時(收到沒有 IORING_CQE_F_MORE 的 completion), 才會清除 RecvSeq_;
+   // 在此之前已收到的資料, 仍會放到 FdrRecvNodes_.
+   io_uring_sqe* sqe = this->Ring_.GetSqe();
+   sqe->opcode = IORING_OP_ASYNC_CANCEL;
+   sqe->fd = -1;
+   sqe->addr = MakePollUserData(idx, evh.RecvSeq_);
+   sqe->user_data = kCancelUserData;
+   evh.IsRecvCanceling_ = true;
+}
+
+//--------------------------------------------------------------------------//
+
+void FdrThreadIoUring::StartAsyncIo(FdrAsyncIoReq& req) {
+   assert(this->IsThisThread());
+   FdrEventHandler* hdr = req.Handler_.get();
+   if (fon9_UNLIKELY(IsFdrAsyncIoCanceled(hdr) || !this->Ring_.SqMmap_)) {
+      OnFdrEvent_AsyncIoDone(req, -ECANCELED);
+      return;
+   }
+   if (this->AsyncIoFreeSlots_.empty()) {
+      req.FdrThreadSlot_ = static_cast<uint32_t>(this->AsyncIoReqs_.size());
+      this->AsyncIoReqs_.push_back(&req);
+   }
+   else {
+      req.FdrThreadSlot_ = this->AsyncIoFreeSlots_.back();
+      this->AsyncIoFreeSlots_.pop_back();
+      this->AsyncIoReqs_[req.FdrThreadSlot_] = &req;
+   }
+   io_uring_sqe* sqe = this->Ring_.GetSqe();
+   sqe->fd = hdr->GetFD();
+   if (req.Op_ == FdrAsyncIoReq::Op::RecvMsg) {
+      sqe->opcode = IORING_OP_RECVMSG;
+      sqe->addr = reinterpret_cast<uintptr_t>(&req.Msg_);
+      sqe->len = 1;
+   }
+   else {
+      const bool isWrite = (req.Op_ == FdrAsyncIoReq::Op::Write);
+      sqe->off = static_cast<uint64_t>(req.Offset_);
+      if (req.IovCount_ == 1) {
+         sqe->opcode = static_cast<uint8_t>(isWrite ? IORING_OP_WRITE : IORING_OP_READ);
+         sqe->addr = reinterpret_cast<uintptr_t>(req.Iov_[0].iov_base);
+         sqe->len = static_cast<uint32_t>(req.Iov_[0].iov_len);
+      }
+      else {
+         sqe->opcode = static_cast<uint8_t>(isWrite ? IORING_OP_WRITEV : IORING_OP_READV);
+         sqe->addr = reinterpret_cast<uintptr_t>(req.Iov_);
+         sqe->len = req.IovCount_;
+      }
+   }
+   sqe->user_data = MakeAsyncIoUserData(&req);
+}
+void FdrThreadIoUring::OnAsyncIoCompletion(FdrAsyncIoReq& req, int res) {
+   assert(this->AsyncIoReqs_[req.FdrThreadSlot_] == &req);
+   this->AsyncIoReqs_[req.FdrThreadSlot_] = nullptr;
+   this->AsyncIoFreeSlots_.push_back(req.FdrThreadSlot_);
+   OnFdrEvent_AsyncIoDone(req, res);
+}
+void FdrThreadIoUring::CancelAsyncIos(FdrEventHandler* hdr) {
+   for (FdrAsyncIoReq* req : this->AsyncIoReqs_) {
+      if (req == nullptr || req->Handler_.get() != hdr)
+         continue;
+      // 一般檔案的讀寫可能無法取消, 此時仍會等到完成才觸發 OnFdrEvent_AsyncIoDone().
+      io_uring_sqe* sqe = this->Ring_.GetSqe();
+      sqe->opcode = IORING_OP_ASYNC_CANCEL;
+      sqe->fd = -1;
+      sqe->addr = MakeAsyncIoUserData(req);
+      sqe->user_data = kCancelUserData;
+   }
+}
+void FdrThreadIoUring::AbortAsyncIos() {
+   // 必須先關閉 io_uring, 確定 kernel 不會再使用 req 的緩衝區, 才能通知 handler.
+   this->Ring_.Close();
+   for (size_t L = 0; L < this->AsyncIoReqs_.size(); ++L) {
+      if (FdrAsyncIoReq* req = this->AsyncIoReqs_[L])
+         this->OnAsyncIoCompletion(*req, -ECANCELED);
+   }
+}
+
+//--------------------------------------------------------------------------//
+
+void FdrThreadIoUring::ThrRunImpl(const ServiceThreadArgs& args) {
+   EvHandlers  evHandlers{args.Capacity_};
+   const bool  isBlockWait = IsBlockWait(args.HowWait_);
+   LoopTimer   loopTimer{*this, args};
+   if (args.BusyPollUs_ > 0)
+      fon9_LOG_WARN("FdrThreadIoUring.ThrRun|BusyPoll=", args.BusyPollUs_, "|info=not supported, ignored.");
+   this->ArmWakeup();
+   while (this->use_count() > 0) {
+      // 與 FdrThreadEpoll 相同: 再次等候之前, 必須先將 Pending Removes, Updates 處理完.
+      unsigned minComplete = (isBlockWait ? 1u : 0u);
+      if (fon9_UNLIKELY(this->WakeupRequests_.load(std::memory_order_relaxed) != 0)) {
+         loopTimer.Start();
+         this->ClearWakeup();
+         this->ProcessPendings(evHandlers);
+         if (this->WakeupRequests_.load(std::memory_order_relaxed) != 0)
+            minComplete = 0;
+      }
+      this->ProcessRearms(evHandlers);
+      loopTimer.Stop();
+      // 一次 io_uring_enter(): 送出全部的 poll 及 讀寫要求, 並等候 completion.
+      int res = this->Ring_.Enter(minComplete);
+      if (fon9_UNLIKELY(res < 0)) {
+         if (int eno = ErrorCannotRetry(-res)) {
+            if (eno != EBUSY) { // EBUSY: CQ overflow, 先處理已完成的 completion 再重試.
+               fon9_LOG_FATAL("FdrThreadIoUring.ThrRun|fn=io_uring_enter|err=", GetSysErrC(eno));
+               break;
+            }
+         }
+      }
+      if (LoadAcquire(this->Ring_.CqTail_) != *this->Ring_.CqHead_) {
+         loopTimer.Start();
+         this->ProcessCompletions(evHandlers);
+      }
+      else if (args.HowWait_ == HowWait::Yield)
+         std::this_thread::yield();
+   }
+   // 尚未完成的要求會保留 handler, 若不結束這些要求, 則 handler 永遠不會釋放 this.
+   if (this->use_count() > 0)
+      this->AbortAsyncIos();
+}
+
+void FdrThreadIoUring::ProcessCompletions(EvHandlers& evHandlers) {
+   unsigned head = *this->Ring_.CqHead_;
+   unsigned tail = LoadAcquire(this->Ring_.CqTail_);
+   for (; head != tail; ++head) {
+      const io_uring_cqe&  cqe = this->Ring_.Cqes_[head & this->Ring_.CqMask_];
+      const uint64_t       udata = cqe.user_data;
+      if (udata == kCancelUserData)
+         continue;
+      if (udata & kAsyncIoTag) {
+         // OnFdrEvent_AsyncIoDone() 可能會再送出新的要求(GetSqe()), 但不會改變 CQ, 所以 cqe 仍有效.
+         this->OnAsyncIoCompletion(*reinterpret_cast<FdrAsyncIoReq*>(static_cast<uintptr_t>(udata & ~kAsyncIoTag)), cqe.res);
+         continue;
+      }
+      if (udata == kWakeupUserData) {
+         this->WakeupRequests_.store(1, std::memory_order_relaxed);
+         // 此時 eventfd 可能仍是 readable, 但下次迴圈會先 ClearWakeup(), 所以不會一直觸發.
+         // 若 Wakeup 的 POLL_ADD 已失效(沒有 IORING_CQE_F_MORE), 則要重新啟用.
+         if (!(cqe.flags & IORING_CQE_F_MORE))
+            this->ArmWakeup();
+         continue;
+      }
+      const uint32_t idx = static_cast<uint32_t>(udata >> 32) - 1;
+      const uint32_t seq = static_cast<uint32_t>(udata) >> 1;
+      EvHandler*     evh = evHandlers.GetObjPtr(idx);
+      if (evh == nullptr || evh->ArmSeq_ != seq) {
+         if (evh && evh->RecvSeq_ == seq)
+            this->OnRecvCompletion(*evh, idx, cqe);
+         else if (cqe.flags & IORING_CQE_F_BUFFER) {
+            // 已移除的 handler 的 recv 結果: 直接歸還 buffer.
+            this->RecvRing_.Provide(static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+         }
+         // 已移除 or 已更新 的 poll: 忽略.
+         continue;
+      }
+      if (!(cqe.flags & IORING_CQE_F_MORE)) {
+         // one shot poll, 或 kernel 已結束 multishot poll: 需要重新送出.
+         evh->ArmSeq_ = 0;
+         this->Rearms_.push_back(idx);
+      }
+      FdrEventHandler* hdr = evh->get();
+      if (fon9_UNLIKELY(hdr == nullptr || hdr->GetFdrEventHandlerBookmark() <= 0))
+         continue;
+      FdrEventFlag evs;
+      if (fon9_LIKELY(cqe.res >= 0)) {
+         const unsigned eflags = static_cast<unsigned>(cqe.res);
+         evs = (eflags & POLLOUT) ? FdrEventFlag::Writable : FdrEventFlag::None;
+         if (eflags & (POLLIN | POLLPRI | POLLRDHUP))
+            evs |= FdrEventFlag::Readable;
+         if (fon9_UNLIKELY(eflags & (POLLHUP | POLLERR | POLLNVAL)))
+            evs |= FdrEventFlag::Error;
+      }
+      else {
+         fon9_LOG_ERROR("FdrThreadIoUring.PollAdd|fd=", hdr->GetFD(), "|err=", GetSysErrC(-cqe.res));
+         evs = FdrEventFlag::Error;
+      }
+      if (fon9_UNLIKELY(IsEnumContains(evs, FdrEventFlag::Error))) {
+         // multishot poll 在移除前可能會再觸發, 所以先取消, 避免重複通知錯誤.
+         this->CancelPoll(*evh, idx);
+         hdr->RemoveFdrEvent();
+         // 發生錯誤前, multishot recv 已收到的資料, 仍要先交給 handler 處理.
+         if (!GetFdrRecvNodes(hdr).empty())
+            evs |= FdrEventFlag::Readable;
+      }
+      else {
+         // 只觸發 handler 目前仍需要的事件:
+         // 例: FdrSocket 已改用 IORING_OP_WRITEV 傳送, 此時若觸發已在 CQ 裡面的 Writable, 會造成重複傳送.
+         evs &= hdr->GetRequiredFdrEventFlag();
+         if (evs == FdrEventFlag::None)
+            continue;
+      }
+      // OnFdrEvent_Emit() 可能會 UpdateFdrEvent() 或 RemoveFdrEvent(),
+      // 但都會放到 Pending 在下次迴圈處理, 不會改變 evHandlers, 所以 evh, cqe 仍有效.
+      this->OnFdrEvent_Emit(evs, hdr);
+   }
+   StoreRelease(this->Ring_.CqHead_, head);
+   if (this->RecvRing_.IsEnabled())
+      this->RecvRing_.Commit();
+   this->EmitRecvReadys(evHandlers);
+}
+
+void FdrThreadIoUring::OnRecvCompletion(EvHandler& evh, uint32_t idx, const io_uring_cqe& cqe) {
+   if (cqe.flags & IORING_CQE_F_BUFFER) {
+      const uint16_t bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+      // datagram 的 res 可能為 0(空的 datagram), 此時仍有 IORING_CQE_F_MORE, 直接歸還 buffer.
+      if (fon9_LIKELY(cqe.res > 0)) {
+         this->TakeRecvNode(evh.get(), bid, static_cast<uint32_t>(cqe.res));
+         if (IsEnumContains(evh.Events_, FdrEventFlag::Readable))
+            this->QueueRecvReady(evh, idx);
+      }
+      this->RecvRing_.Provide(bid);
+   }
+   if (cqe.flags & IORING_CQE_F_MORE)
+      return;
+   // multishot recv 已結束: 被取消 or 沒有可用的 buffer(-ENOBUFS) or EOF or 錯誤.
+   evh.RecvSeq_ = 0;
+   evh.IsRecvCanceling_ = false;
+   bool isFallback = (cqe.res == 0 || (cqe.res < 0 && cqe.res != -ENOBUFS && cqe.res != -ECANCELED));
+   // datagram 的 ECONNREFUSED(對方 port 沒有開啟, 收到 ICMP), 與 FdrDgramImpl::SocketError() 相同, 不視為錯誤.
+   if (cqe.res == -ECONNREFUSED && IsFdrRecvNodesDgram(evh.get()))
+      isFallback = false;
+   if (isFallback) {
+      // EOF 或 錯誤: 不再使用 multishot recv, 由 handler 自行讀取, 取得 EOF 或 錯誤碼.
+      evh.IsRecvFallback_ = true;
+      this->SetRecvMode(evh);
+      if (evh.RecvMode_ == FdrRecvMode::Ready)
+         this->CancelPoll(evh, idx); // 在 ProcessRearms() 重新註冊 POLLIN.
+      else if (IsEnumContains(evh.Events_, FdrEventFlag::Readable))
+         this->QueueRecvReady(evh, idx);
+   }
+   // 若仍需要 recv(或 POLLIN), 則在 ProcessRearms() 重新送出.
+   this->Rearms_.push_back(idx);
+}
+
+void FdrThreadIoUring::TakeRecvNode(FdrEventHandler* hdr, uint16_t bid, uint32_t rxsz) {
+   FwdBufferNode* node = this->RecvRing_.Nodes_[bid];
+   BufferList&    rxnodes = GetFdrRecvNodes(hdr);
+   if (rxsz <= this->RecvRing_.CopyMax_) {
+      // 資料量小: 複製資料, node 不變(沒有 SetDataEnd()), 由呼叫端直接 Provide(bid) 給 kernel 重複使用.
+      // stream: 盡量附加到最後一個 node, 連續的小封包只需要一個 node;
+      // datagram: 每個 datagram 必須是獨立的 node.
+      FwdBufferNode* dst;
+      if (IsFdrRecvNodesDgram(hdr))
+         rxnodes.push_back(dst = FwdBufferNode::Alloc(rxsz));
+      else if ((dst = FwdBufferNode::CastFrom(rxnodes.back())) == nullptr || dst->GetRemainSize() < rxsz)
+         rxnodes.push_back(dst = FwdBufferNode::Alloc(this->RecvRing_.CopyMax_));
+      memcpy(dst->GetDataEnd(), node->GetDataEnd(), rxsz);
+      dst->SetDataEnd(dst->GetDataEnd() + rxsz);
+      return;
+   }
+   node->SetDataEnd(node->GetDataEnd() + rxsz);
+   rxnodes.push_back(node);
+   this->RecvRing_.Nodes_[bid] = FwdBufferNode::Alloc(this->RecvRing_.NodeExtSize_);
+}
+
+void FdrThreadIoUring::EmitRecvReadys(EvHandlers& evHandlers) {
+   for (uint32_t idx : this->RecvReadys_) {
+      EvHandler* evh = evHandlers.GetObjPtr(idx);
+      if (evh == nullptr || !evh->IsRecvReadyQueued_)
+         continue;
+      evh->IsRecvReadyQueued_ = false;
+      FdrEventHandler* hdr = evh->get();
+      // FdrRecvMode::Async: 沒有資料也要觸發, 由 handler 決定是否要啟動讀取.
+      if (hdr && hdr->GetFdrEventHandlerBookmark() > 0
+          && IsEnumContains(evh->Events_, FdrEventFlag::Readable)
+          && (!GetFdrRecvNodes(hdr).empty() || evh->RecvMode_ == FdrRecvMode::Async))
+         this->OnFdrEvent_Emit(FdrEventFlag::Readable, hdr);
+   }
+   this->RecvReadys_.clear();
+}
+
+void FdrThreadIoUring::ProcessRearms(EvHandlers& evHandlers) {
+   for (uint32_t idx : this->Rearms_) {
+      EvHandler* evh = evHandlers.GetObjPtr(idx);
+      if (evh == nullptr || !evh->get())
+         continue;
+      if (evh->ArmSeq_ == 0)
+         this->ArmPoll(*evh, idx);
+      if (evh->RecvSeq_ == 0 && this->IsRecvRequired(*evh))
+         this->ArmRecv(*evh, idx);
+   }
+   this->Rearms_.clear();
+}
+
+void FdrThreadIoUring::ProcessPendings(EvHandlers& evHandlers) {
+   this->ProcessPendingSends();
+
+   PendingReqsImpl reqs = this->MoveOutPendingImpl(this->PendingRemoves_);
+   for (FdrEventHandlerSP& spRemove : reqs) {
+      FdrEventHandler* hdr = spRemove.get();
+      // 不論是否有註冊事件(例: FileIO 只使用 StartFdrAsyncIo()), 都要取消尚未完成的讀寫要求.
+      SetFdrAsyncIoCanceled(hdr);
+      this->CancelAsyncIos(hdr);
+      auto idx1 = hdr->GetFdrEventHandlerBookmark();
+      if (fon9_UNLIKELY(idx1 <= 0))
+         continue;
+      const uint32_t idx = static_cast<uint32_t>(idx1 - 1);
+      if (EvHandler* evh = evHandlers.GetObjPtr(idx)) {
+         if (evh->get() == hdr) {
+            this->CancelPoll(*evh, idx);
+            this->CancelRecv(*evh, idx);
+            // 已移除, 不會再觸發 Readable 事件, 所以拋棄尚未處理的資料.
+            BufferList autoFree{std::move(GetFdrRecvNodes(hdr))};
+         }
+      }
+      if (!evHandlers.RemoveObj(idx, hdr))
+         fon9_LOG_ERROR("FdrServiceIoUring.Remove|fd=", hdr->GetFD(), "|idx=", idx1, "|hdr=", ToPtr{hdr}, "|err=Not found");
+      this->SetFdrEventHandlerBookmark(hdr, 0);
+   }
+   reqs = this->MoveOutPendingImpl(this->PendingUpdates_);
+   for (FdrEventHandlerSP& sp : reqs) {
+      FdrEventHandler* hdr = sp.get();
+      auto idx1 = hdr->GetFdrEventHandlerBookmark();
+      FdrEventFlag evs = hdr->GetRequiredFdrEventFlag();
+      uint32_t     idx;
+      EvHandler*   pEvObj;
+      if (fon9_LIKELY(idx1 > 0)) {
+         pEvObj = evHandlers.GetObjPtr(idx = static_cast<uint32_t>(idx1 - 1));
+         if (fon9_UNLIKELY(pEvObj == nullptr))
+            continue;
+         if (pEvObj->get() != hdr)
+            continue;
+         if (pEvObj->Events_ != evs || pEvObj->ArmSeq_ == 0) {
+            pEvObj->Events_ = evs;
+            this->CancelPoll(*pEvObj, idx);
+            this->ArmPoll(*pEvObj, idx);
+         }
+      }
+      else {
+         if (fon9_UNLIKELY(evs == FdrEventFlag::None))
+            continue;
+         EvHandler evh{hdr};
+         evh.Events_ = evs;
+         idx = static_cast<uint32_t>(evHandlers.Add(evh));
+         this->SetFdrEventHandlerBookmark(hdr, idx + 1u);
+         pEvObj = evHandlers.GetObjPtr(idx);
+         this->SetRecvMode(*pEvObj);
+         this->ArmPoll(*pEvObj, idx);
+      }
+      if (this->RecvRing_.IsEnabled()) {
+         if (!this->IsRecvRequired(*pEvObj))
+            this->CancelRecv(*pEvObj, idx);
+         else if (pEvObj->RecvSeq_ == 0)
+            this->ArmRecv(*pEvObj, idx);
+      }
+      // 重新啟用 Readable 時:
+      // - 若已有之前收到(或保留)的資料, 則需要再觸發一次 Readable 事件.
+      // - FdrRecvMode::Async: 觸發 Readable 讓 handler 啟動讀取(若已在讀取中, handler 會忽略此次事件).
+      //   因為 [關閉 => 開啟] 可能在同一次 ProcessPendings() 之前就完成了, 所以無法只在 Events_ 改變時觸發.
+      if (IsEnumContains(evs, FdrEventFlag::Readable)
+          && (!GetFdrRecvNodes(hdr).empty() || pEvObj->RecvMode_ == FdrRecvMode::Async))
+         this->QueueRecvReady(*pEvObj, idx);
+   }
+   this->EmitRecvReadys(evHandlers);
+}
+
+} } // namespaces
+#endif
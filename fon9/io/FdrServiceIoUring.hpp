@@ -0,0 +1,197 @@
+﻿/// \file fon9/io/FdrServiceIoUring.hpp
+/// \author fonwinz@gmail.com
+#ifndef __fon9_io_FdrServiceIoUring_hpp__
+#define __fon9_io_FdrServiceIoUring_hpp__
+#ifdef __linux__
+#include "fon9/io/FdrService.hpp"
+#include "fon9/buffer/FwdBufferList.hpp"
+#include "fon9/ObjPool.hpp"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf_ring;
+
+namespace fon9 { namespace io {
+
+struct FdrServiceIoUring {
+   using MakeResult = Result2;
+   static FdrServiceSP MakeService(const IoServiceArgs& ioArgs, const std::string& thrName, MakeResult& err);
+};
+
+/// \ingroup io
+/// 使用 io_uring(Linux 5.1+) 處理 non-blocking fd 讀寫事件服務.
+/// - 使用 IORING_OP_POLL_ADD + IORING_POLL_ADD_MULTI(Linux 5.13+) 偵測事件:
+///   註冊一次之後, 每次事件都會產生 completion, 不用每次重新註冊;
+///   只有在事件旗標改變(UpdateFdrEvent)、或 kernel 結束 multishot poll 時, 才需要重新送出.
+///   - 與 epoll(level-triggered) 不同, multishot poll 只在「狀態改變(例: 有新資料到達)」時觸發,
+///     所以使用 FdrRecvMode::Ready 的 FdrEventHandler(例: FdrTcpListener), 必須讀到 EAGAIN 為止.
+///   - 不支援 IORING_POLL_ADD_MULTI 的 kernel, 使用 one shot poll, 每次事件之後重新送出.
+/// - 支援 FdrEventHandler::StartFdrAsyncIo():
+///   由 IORING_OP_WRITEV/IORING_OP_READV/IORING_OP_RECVMSG 執行讀寫, 在 completion 觸發 OnFdrEvent_AsyncIoDone();
+///   - FdrSocket 的傳送(在 fdr thread 裡面)、接收(FdrRecvMode::Async), 都使用此方式, 不再需要 POLLIN/POLLOUT.
+///   - FileIO 也使用此方式讀寫檔案, 檔案的 read/write 不在 timer thread 或 op thread 執行.
+/// - 若 IoServiceArgs::RecvRingCount_ > 0 (Linux 5.19+):
+///   對允許的 FdrEventHandler(FdrSocket) 使用 multishot recv + provided buffer ring,
+///   由 kernel 直接將資料填入預先分配的 FwdBufferNode, 放入 FdrEventHandler::FdrRecvNodes_ 之後觸發 Readable(FdrRecvMode::Nodes).
+///   - 每個接收緩衝的大小為 IoServiceArgs::RecvRingBufSize_(剛好是一個 MemBlock 區塊).
+///   - 資料量小(<= RecvRing::CopyMax_): 複製到 FdrRecvNodes_ 尾端的 node(或新的小 node), 緩衝直接還給 kernel 重複使用,
+///     避免每次 completion 都占用一個完整的接收緩衝.
+///   - 資料量大: 直接將接收緩衝交給 handler(不複製), 再從 fdr thread 的 MemBlock cache 補上新的緩衝;
+///     handler 通常也在 fdr thread 用完並釋放, 所以會回到同一個 cache.
+///   - FdrDgram 也可使用, 每個 completion 為一個 datagram(FdrEventHandler::IsFdrRecvNodesDgram_).
+/// - 每次迴圈把全部的「poll 註冊/移除、讀寫要求」放在 SQ, 然後用一次 io_uring_enter() 同時送出及等候結果.
+///   與 epoll 相比, 省下的是 FdrEventHandler 的 read()/writev() system call(由 io_uring_enter() 批次處理),
+///   epoll(level-triggered) 本身並不需要每次事件都呼叫 epoll_ctl().
+/// - 不使用 liburing, 直接呼叫 system call.
+class FdrThreadIoUring : public FdrThread {
+   fon9_NON_COPY_NON_MOVE(FdrThreadIoUring);
+   struct EvHandler : public FdrEventHandlerSP {
+      using FdrEventHandlerSP::FdrEventHandlerSP;
+      FdrEventFlag   Events_{FdrEventFlag::None};
+      /// 最後一次送出 POLL_ADD 的序號, 0 表示目前沒有 POLL_ADD 在 kernel 裡面.
+      /// 用來排除: 已移除(或已更新)的 poll 所產生的 completion.
+      uint32_t       ArmSeq_{0};
+      /// 最後一次送出 multishot recv 的序號, 0 表示目前沒有 recv 在 kernel 裡面.
+      uint32_t       RecvSeq_{0};
+      /// 已送出 ASYNC_CANCEL, 等候 recv 結束; 在 recv 結束前, 不能再送出新的 recv, 避免資料順序錯亂.
+      bool           IsRecvCanceling_{false};
+      /// recv 已結束(EOF 或 錯誤), 不再使用 multishot recv:
+      /// 改用 FdrRecvMode::Async(或 POLLIN), 讓 FdrEventHandler 自行讀取結果.
+      bool           IsRecvFallback_{false};
+      /// 已放入 RecvReadys_, 等候觸發 Readable 事件.
+      bool           IsRecvReadyQueued_{false};
+      /// 與 FdrEventHandler::GetFdrRecvMode() 相同, 在 SetRecvMode() 設定.
+      FdrRecvMode    RecvMode_{FdrRecvMode::Ready};
+   };
+   using EvHandlers = ObjPool<EvHandler>;
+
+   struct Ring {
+      fon9_NON_COPY_NON_MOVE(Ring);
+      Ring() = default;
+      ~Ring() {
+         this->Close();
+      }
+
+      FdrAuto  RingFdr_;
+      void*    SqMmap_{nullptr};
+      size_t   SqMmapSize_{0};
+      void*    CqMmap_{nullptr};
+      size_t   CqMmapSize_{0};
+      void*    SqesMmap_{nullptr};
+      size_t   SqesMmapSize_{0};
+
+      unsigned*      SqHead_;
+      unsigned*      SqTail_;
+      unsigned       SqMask_;
+      unsigned       SqEntries_;
+      unsigned*      SqArray_;
+      io_uring_sqe*  Sqes_;
+      /// 尚未送給 kernel 的 sqe 數量.
+      unsigned       SqPending_{0};
+      /// 本地的 SQ tail, 在 Submit() 時才寫入 *SqTail_.
+      unsigned       SqLocalTail_{0};
+
+      unsigned*      CqHead_;
+      unsigned*      CqTail_;
+      unsigned       CqMask_;
+      io_uring_cqe*  Cqes_;
+
+      /// io_uring_params::features
+      uint32_t       Features_{0};
+
+      Result2 Open(unsigned entries);
+      /// 關閉 io_uring, kernel 會取消全部尚未完成的要求.
+      void Close();
+      /// 取得一個可用的 sqe, 若 SQ 已滿, 則會先送出已填妥的 sqe.
+      io_uring_sqe* GetSqe();
+      /// 送出全部的 sqe, 並等候至少 minComplete 個 completion.
+      /// \retval <0  -errno
+      int Enter(unsigned minComplete);
+   };
+
+   /// multishot recv 使用的 provided buffer ring.
+   /// 每個 buffer id 對應一個 FwdBufferNode, 收到資料後:
+   /// - 資料量 <= CopyMax_: 複製到 handler 的 FdrRecvNodes_, 該 node 直接再提供給 kernel.
+   /// - 否則: 該 node 交給 FdrEventHandler, 然後補上新的 node.
+   struct RecvRing {
+      fon9_NON_COPY_NON_MOVE(RecvRing);
+      RecvRing() = default;
+      ~RecvRing();
+
+      io_uring_buf_ring*            BufRing_{nullptr};
+      std::vector<FwdBufferNode*>   Nodes_;
+      uint16_t                      Mask_{0};
+      uint16_t                      LocalTail_{0};
+      /// FwdBufferNode::Alloc(NodeExtSize_): 讓整個 node 剛好是一個 MemBlock 區塊.
+      uint32_t                      NodeExtSize_{0};
+      /// 資料量 <= CopyMax_ 時, 複製資料, 不交出 node.
+      uint32_t                      CopyMax_{0};
+
+      bool IsEnabled() const {
+         return this->BufRing_ != nullptr;
+      }
+      Result2 Open(int ringfd, uint32_t count, uint32_t bufSize);
+      /// 將 Nodes_[bid] 放到 ring 尾端, 在 Commit() 之後, kernel 才能使用.
+      void Provide(uint16_t bid);
+      void Commit();
+   };
+
+   // RecvRing_ 必須在 Ring_ 之後解構: 先關閉 io_uring(結束全部的 recv), 才能釋放 kernel 可能寫入的 nodes.
+   RecvRing RecvRing_;
+   Ring     Ring_;
+   uint32_t ArmSeq_{0};
+   /// kernel 支援 IORING_POLL_ADD_MULTI.
+   bool     IsPollMulti_{false};
+   /// 在處理完 completion 之後, 需要重新送出 POLL_ADD 或 recv 的 handlers(poll 或 multishot recv 已結束).
+   std::vector<uint32_t>   Rearms_;
+   /// 已收到資料(FdrRecvNodes_), 或 FdrRecvMode::Async 需要啟動讀取, 等候觸發 Readable 事件的 handlers.
+   std::vector<uint32_t>   RecvReadys_;
+   /// 尚未完成的 StartFdrAsyncIo() 要求, FdrAsyncIoReq::FdrThreadSlot_ 為此處的索引.
+   std::vector<FdrAsyncIoReq*>   AsyncIoReqs_;
+   std::vector<uint32_t>         AsyncIoFreeSlots_;
+
+   /// ArmSeq_ 使用 31 bits, 請參考 FdrServiceIoUring.cpp 的 user_data 編碼.
+   uint32_t NextArmSeq() {
+      if (fon9_UNLIKELY((this->ArmSeq_ = (this->ArmSeq_ + 1) & 0x7fffffff) == 0))
+         this->ArmSeq_ = 1;
+      return this->ArmSeq_;
+   }
+   void ArmWakeup();
+   void ArmPoll(EvHandler& evh, uint32_t idx);
+   void CancelPoll(EvHandler& evh, uint32_t idx);
+   void SetRecvMode(EvHandler& evh);
+   bool IsRecvRequired(const EvHandler& evh) const {
+      return evh.RecvMode_ == FdrRecvMode::Nodes && IsEnumContains(evh.Events_, FdrEventFlag::Readable);
+   }
+   void ArmRecv(EvHandler& evh, uint32_t idx);
+   void CancelRecv(EvHandler& evh, uint32_t idx);
+   void OnRecvCompletion(EvHandler& evh, uint32_t idx, const io_uring_cqe& cqe);
+   /// 將 Nodes_[bid] 收到的 rxsz bytes 放到 handler 的 FdrRecvNodes_; 必要時補上新的 node.
+   void TakeRecvNode(FdrEventHandler* hdr, uint16_t bid, uint32_t rxsz);
+   void QueueRecvReady(EvHandler& evh, uint32_t idx) {
+      if (!evh.IsRecvReadyQueued_) {
+         evh.IsRecvReadyQueued_ = true;
+         this->RecvReadys_.push_back(idx);
+      }
+   }
+   void EmitRecvReadys(EvHandlers& evHandlers);
+   void OnAsyncIoCompletion(FdrAsyncIoReq& req, int res);
+   /// handler 已移除: 取消尚未完成的 StartFdrAsyncIo() 要求.
+   void CancelAsyncIos(FdrEventHandler* hdr);
+   /// io_uring 無法使用時(例: io_uring_enter() 失敗), 結束全部尚未完成的要求.
+   void AbortAsyncIos();
+   void ProcessPendings(EvHandlers& evHandlers);
+   void ProcessRearms(EvHandlers& evHandlers);
+   void ProcessCompletions(EvHandlers& evHandlers);
+   virtual void ThrRunImpl(const ServiceThreadArgs& args) override;
+   virtual void StartAsyncIo(FdrAsyncIoReq& req) override;
+
+public:
+   FdrThreadIoUring(const IoServiceArgs& ioArgs, FdrServiceIoUring::MakeResult& res);
+
+   virtual ~FdrThreadIoUring();
+};
+
+} } // namespaces
+#endif//__linux__
+#endif//__fon9_io_FdrServiceIoUring_hpp__
@@ -0,0 +1,263 @@
+﻿// \file fon9/io/FdrService_UT.cpp
+// \author fonwinz@gmail.com
+#include "fon9/io/FdrServiceEpoll.hpp"
+#include "fon9/io/FdrServiceIoUring.hpp"
+#include "fon9/StrTo.hpp"
+#include "fon9/RevPrint.hpp"
+#include "fon9/TestTools.hpp"
+#include "fon9/LatencyHistogram.hpp"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+// 比較 FdrServiceEpoll 與 FdrServiceIoUring 的效率:
+// - 在 loopback 建立 kPairCount 組 TCP 連線.
+// - 每組連線的 client 送出 kMsgSize bytes, server 收到後立即回送, client 收到完整訊息後再送下一筆.
+// - 全部連線完成 kRoundTrips 次來回後, 計算每次來回的平均時間.
+// - 直接使用 FdrEventHandler 讀寫, 排除 Device/Session 的負擔, 只比較 FdrService 本身.
+// - "IoUring+Ring": 使用 multishot recv + provided buffer ring(IoServiceArgs::RecvRingCount_),
+//   由 FdrEventHandler::FdrRecvNodes_ 取得收到的資料.
+// - "IoUring+Async": 使用 FdrRecvMode::Async, 由 StartFdrAsyncIo() 送出 IORING_OP_READ 接收,
+//   echo 端也使用 IORING_OP_WRITE 回送.
+// - 每種 service 分別使用 Wait=Block 及 Wait=Spin 測試, 並列出:
+//   - rtt:  每次來回的耗時分布.
+//   - loop: FdrThread 每次迴圈處理事件的耗時分布(IoServiceArgs::IsLoopHist_).
+//   Spin 會占滿 cpu, 在 cpu 數量 <= threadCount 的環境, 結果沒有參考價值.
+
+static const size_t  kMsgSize = 64;
+
+fon9_WARN_DISABLE_PADDING;
+class PingpongHandler : public fon9::io::FdrEventHandler {
+   fon9_NON_COPY_NON_MOVE(PingpongHandler);
+   using base = fon9::io::FdrEventHandler;
+   std::atomic<int>  RefCount_{0};
+   const bool        IsEcho_;
+   size_t            RecvBytes_{0};
+   size_t            RemainRoundTrips_;
+   std::atomic<size_t>* PendingPairs_;
+   std::chrono::steady_clock::time_point  SentTime_;
+   fon9::io::FdrAsyncIoReq RdReq_;
+   fon9::io::FdrAsyncIoReq WrReq_;
+   char                    RdBuf_[1024 * 4];
+   char                    WrBuf_[1024 * 4];
+
+   virtual fon9::io::FdrEventFlag GetRequiredFdrEventFlag() const override {
+      return fon9::io::FdrEventFlag::Readable;
+   }
+   virtual void OnFdrEvent_Handling(fon9::io::FdrEventFlag evs) override {
+      if (!IsEnumContains(evs, fon9::io::FdrEventFlag::Readable))
+         return;
+      if (this->GetFdrRecvMode() == fon9::io::FdrRecvMode::Async) {
+         if (!this->RdReq_.IsPending())
+            this->StartAsyncRead();
+         return;
+      }
+      while (fon9::BufferNode* node = this->FdrRecvNodes_.pop_front()) {
+         const size_t sz = node->GetDataSize();
+         if (this->IsEcho_) {
+            if (write(this->GetFD(), node->GetDataBegin(), sz) != static_cast<ssize_t>(sz))
+               std::cout << "[ERROR] Echo.write()" << std::endl;
+         }
+         else if (!this->OnRecv(sz)) {
+            fon9::FreeNode(node);
+            return;
+         }
+         fon9::FreeNode(node);
+      }
+      char buf[1024 * 4];
+      for (;;) {
+         ssize_t rdsz = read(this->GetFD(), buf, sizeof(buf));
+         if (rdsz <= 0)
+            break;
+         if (this->IsEcho_) {
+            if (write(this->GetFD(), buf, static_cast<size_t>(rdsz)) != rdsz)
+               std::cout << "[ERROR] Echo.write()" << std::endl;
+            continue;
+         }
+         if (!this->OnRecv(static_cast<size_t>(rdsz)))
+            return;
+      }
+   }
+   bool OnRecv(size_t sz) {
+      this->RecvBytes_ += sz;
+      while (this->RecvBytes_ >= kMsgSize) {
+         this->RecvBytes_ -= kMsgSize;
+         this->RttHist_.Add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - this->SentTime_).count()));
+         if (--this->RemainRoundTrips_ == 0) {
+            --*this->PendingPairs_;
+            return false;
+         }
+         this->SendMsg();
+      }
+      return true;
+   }
+   void StartAsyncRead() {
+      this->RdReq_.Op_ = fon9::io::FdrAsyncIoReq::Op::Read;
+      this->RdReq_.IovCount_ = 1;
+      this->RdReq_.Iov_[0].iov_base = this->RdBuf_;
+      this->RdReq_.Iov_[0].iov_len = sizeof(this->RdBuf_);
+      this->StartFdrAsyncIo(this->RdReq_);
+   }
+   virtual void OnFdrEvent_AsyncIoDone(fon9::io::FdrAsyncIoReq& req, ssize_t res) override {
+      if (&req == &this->WrReq_) {
+         if (res != static_cast<ssize_t>(req.Iov_[0].iov_len) && res != -ECANCELED)
+            std::cout << "[ERROR] Echo.AsyncWrite()|res=" << res << std::endl;
+         return;
+      }
+      if (res <= 0) // -ECANCELED 或 EOF.
+         return;
+      const size_t sz = static_cast<size_t>(res);
+      if (this->IsEcho_) {
+         if (this->WrReq_.IsPending()) {
+            if (write(this->GetFD(), this->RdBuf_, sz) != res)
+               std::cout << "[ERROR] Echo.write()" << std::endl;
+         }
+         else {
+            memcpy(this->WrBuf_, this->RdBuf_, sz);
+            this->WrReq_.Op_ = fon9::io::FdrAsyncIoReq::Op::Write;
+            this->WrReq_.IovCount_ = 1;
+            this->WrReq_.Iov_[0].iov_base = this->WrBuf_;
+            this->WrReq_.Iov_[0].iov_len = sz;
+            this->StartFdrAsyncIo(this->WrReq_);
+         }
+      }
+      else if (!this->OnRecv(sz))
+         return;
+      this->StartAsyncRead();
+   }
+   virtual void OnFdrEvent_StartSend() override {
+   }
+   virtual void OnFdrEvent_AddRef() override {
+      ++this->RefCount_;
+   }
+   virtual void OnFdrEvent_ReleaseRef() override {
+      if (--this->RefCount_ == 0)
+         delete this;
+   }
+
+public:
+   fon9::LatencyHistogram  RttHist_;
+
+   PingpongHandler(fon9::io::FdrService& iosv, int fd, bool isEcho, size_t roundTrips, std::atomic<size_t>* pendingPairs, bool isAsyncRecv)
+      : base{iosv, fon9::FdrAuto{fd}}
+      , IsEcho_{isEcho}
+      , RemainRoundTrips_{roundTrips}
+      , PendingPairs_{pendingPairs} {
+      this->IsFdrRecvNodesAllowed_ = true;
+      this->IsFdrAsyncRecvAllowed_ = isAsyncRecv;
+   }
+   void SendMsg() {
+      char msg[kMsgSize];
+      memset(msg, 'a', sizeof(msg));
+      this->SentTime_ = std::chrono::steady_clock::now();
+      if (write(this->GetFD(), msg, sizeof(msg)) != static_cast<ssize_t>(sizeof(msg)))
+         std::cout << "[ERROR] SendMsg.write()" << std::endl;
+   }
+};
+fon9_WARN_POP;
+
+//--------------------------------------------------------------------------//
+
+static bool MakeLoopbackPair(int fdListen, const sockaddr_in& addr, int fds[2]) {
+   fds[0] = socket(AF_INET, SOCK_STREAM, 0);
+   if (connect(fds[0], reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0)
+      return false;
+   fds[1] = accept(fdListen, nullptr, nullptr);
+   if (fds[1] < 0)
+      return false;
+   int flag = 1;
+   for (int L = 0; L < 2; ++L) {
+      setsockopt(fds[L], IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+      fon9::Fdr{fds[L]}.SetNonBlock();
+   }
+   return true;
+}
+
+template <class FdrServiceT>
+void TestFdrService(const char* svcName, fon9::io::HowWait howWait, unsigned pairCount, size_t roundTrips, unsigned thrCount, uint32_t recvRingCount = 0, bool isAsyncRecv = false) {
+   fon9::io::IoServiceArgs iosvArgs;
+   iosvArgs.ThreadCount_ = thrCount;
+   iosvArgs.RecvRingCount_ = recvRingCount;
+   iosvArgs.HowWait_ = howWait;
+   iosvArgs.IsLoopHist_ = true;
+   typename FdrServiceT::MakeResult err;
+   fon9::io::FdrServiceSP iosv = FdrServiceT::MakeService(iosvArgs, svcName, err);
+   if (!iosv) {
+      std::cout << "[WARN ] " << svcName << ".MakeService|" << fon9::RevPrintTo<std::string>(err) << std::endl;
+      return;
+   }
+
+   int fdListen = socket(AF_INET, SOCK_STREAM, 0);
+   sockaddr_in addr;
+   fon9::ZeroStruct(addr);
+   addr.sin_family = AF_INET;
+   addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   socklen_t addrlen = sizeof(addr);
+   if (bind(fdListen, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0
+       || listen(fdListen, static_cast<int>(pairCount)) != 0
+       || getsockname(fdListen, reinterpret_cast<sockaddr*>(&addr), &addrlen) != 0) {
+      std::cout << "[ERROR] listen()" << std::endl;
+      close(fdListen);
+      return;
+   }
+
+   std::atomic<size_t> pendingPairs{pairCount};
+   std::vector<fon9::io::FdrEventHandlerSP> handlers;
+   for (unsigned L = 0; L < pairCount; ++L) {
+      int fds[2];
+      if (!MakeLoopbackPair(fdListen, addr, fds)) {
+         std::cout << "[ERROR] MakeLoopbackPair()" << std::endl;
+         abort();
+      }
+      handlers.emplace_back(new PingpongHandler{*iosv, fds[0], false, roundTrips, &pendingPairs, isAsyncRecv});
+      handlers.emplace_back(new PingpongHandler{*iosv, fds[1], true, 0, &pendingPairs, isAsyncRecv});
+   }
+   close(fdListen);
+
+   fon9::StopWatch stopWatch;
+   for (auto& h : handlers)
+      h->UpdateFdrEvent();
+   for (size_t L = 0; L < handlers.size(); L += 2)
+      static_cast<PingpongHandler*>(handlers[L].get())->SendMsg();
+   while (pendingPairs.load() > 0)
+      std::this_thread::sleep_for(std::chrono::milliseconds{1});
+   stopWatch.PrintResultNoEOL(svcName, roundTrips * pairCount) << "|Wait=" << fon9::io::HowWaitToStr(howWait).ToString() << std::endl;
+
+   fon9::LatencyHistogram rttHist;
+   for (size_t L = 0; L < handlers.size(); L += 2)
+      rttHist.Merge(static_cast<PingpongHandler*>(handlers[L].get())->RttHist_);
+   std::cout << "   rtt:  " << fon9::RevPrintTo<std::string>(rttHist) << std::endl;
+   for (auto& thr : iosv->GetFdrThreads())
+      std::cout << "   loop: " << fon9::RevPrintTo<std::string>(thr->GetLoopHist()) << std::endl;
+
+   for (auto& h : handlers)
+      h->RemoveFdrEvent();
+   handlers.clear();
+}
+
+int main(int argc, char** argv) {
+   fon9::AutoPrintTestInfo utinfo{"FdrService"};
+   // argv: [pairCount] [roundTrips] [threadCount]
+   unsigned pairCount = (argc > 1 ? fon9::StrTo(fon9::StrView_cstr(argv[1]), 0u) : 0u);
+   size_t   roundTrips = (argc > 2 ? fon9::StrTo(fon9::StrView_cstr(argv[2]), 0u) : 0u);
+   unsigned thrCount = (argc > 3 ? fon9::StrTo(fon9::StrView_cstr(argv[3]), 0u) : 0u);
+   if (pairCount <= 0)
+      pairCount = 16;
+   if (roundTrips <= 0)
+      roundTrips = 10000;
+   if (thrCount <= 0)
+      thrCount = 1;
+   std::cout << "pairs=" << pairCount << "|roundTrips=" << roundTrips << "|threads=" << thrCount << "|msgSize=" << kMsgSize << std::endl;
+
+   for (int L = 0; L < 2; ++L) {
+      for (fon9::io::HowWait howWait : {fon9::io::HowWait::Block, fon9::io::HowWait::Spin}) {
+         TestFdrService<fon9::io::FdrServiceEpoll>("Epoll        ", howWait, pairCount, roundTrips, thrCount);
+         TestFdrService<fon9::io::FdrServiceIoUring>("IoUring      ", howWait, pairCount, roundTrips, thrCount);
+         TestFdrService<fon9::io::FdrServiceIoUring>("IoUring+Ring ", howWait, pairCount, roundTrips, thrCount, 256);
+         TestFdrService<fon9::io::FdrServiceIoUring>("IoUring+Async", howWait, pairCount, roundTrips, thrCount, 0, true);
+      }
+      utinfo.PrintSplitter();
+   }
+}
@@ -23,6 +23,10 @@ void FdrSocket::SocketError(StrView fnName, int eno) {
 }
 
 int FdrSocket::Sendv(DeviceOpLocker& sc, DcQueueList& toSend) {
+   if (this->IsFdrAsyncIoSupported() && this->InFdrThread()) {
+      if (this->StartAsyncSend(toSend))
+         return 0;
+   }
    struct iovec   bufv[IOV_MAX];
    size_t         bufCount = toSend.PeekBlockVector(bufv);
    ssize_t        wrsz = writev(this->GetFD(), bufv, static_cast<int>(bufCount));
@@ -31,16 +35,48 @@ int FdrSocket::Sendv(DeviceOpLocker& sc, DcQueueList& toSend) {
       if (fon9_LIKELY(toSend.empty()))
          this->CheckSendQueueEmpty(sc);
       else
-         this->EnableEventBit(FdrEventFlag::Writable);
+         this->ContinueSendLater();
       return 0;
    }
    if (int eno = ErrorCannotRetry(errno)) {
       this->SocketError("Sendv", eno);
       return eno;
    }
-   this->EnableEventBit(FdrEventFlag::Writable);
+   this->ContinueSendLater();
    return 0;
 }
+bool FdrSocket::StartAsyncSend(DcQueueList& toSend) {
+   FdrAsyncIoReq& req = this->GetAsyncReqs().Send_;
+   assert(!req.IsPending());
+   req.IovCount_ = static_cast<unsigned>(toSend.PeekBlockVector(req.Iov_));
+   if (fon9_UNLIKELY(req.IovCount_ == 0))
+      return false;
+   // 由 StartFdrAsyncIo() 等候可寫入, 所以不需要 writable 偵測.
+   if (this->SetDisableEventBit(FdrEventFlag::Writable))
+      this->UpdateFdrEvent();
+   req.Op_ = FdrAsyncIoReq::Op::Write;
+   this->StartFdrAsyncIo(req);
+   return true;
+}
+void FdrSocket::OnFdrEvent_AsyncIoDone(FdrAsyncIoReq& req, ssize_t res) {
+   if (&req == &this->AsyncReqs_->Recv_) {
+      this->AsyncRecvRes_ = res;
+      this->IsAsyncRecvDone_ = true;
+      // 由衍生者的 Readable 事件處理, 最終會到 CheckRead() => CheckAsyncRead();
+      this->OnFdrEvent_Handling(FdrEventFlag::Readable);
+      return;
+   }
+   if (fon9_LIKELY(res >= 0)) {
+      this->AsyncSentBytes_ = static_cast<size_t>(res);
+      this->OnFdrEvent_StartSend();
+   }
+   else if (res != -ECANCELED) { // -ECANCELED: 已 RemoveFdrEvent(), 不用再處理.
+      if (int eno = ErrorCannotRetry(static_cast<int>(-res)))
+         this->SocketError("Sendv", eno);
+      else
+         this->OnFdrEvent_StartSend();
+   }
+}
 
 void FdrSocket::CheckSendQueueEmpty(DeviceOpLocker& sc) {
    auto& alocker = sc.GetALocker();
@@ -64,7 +100,81 @@ void FdrSocket::CheckSendQueueEmpty(DeviceOpLocker& sc) {
    this->StartSendInFdrThread();
 }
 
+bool FdrSocket::IsRecvTsEnabled(int fd) {
+#ifdef __linux__
+   int       val = 0;
+   socklen_t len = sizeof(val);
+   if (getsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &val, &len) == 0 && val)
+      return true;
+   val = 0;
+   len = sizeof(val);
+   if (getsockopt(fd, SOL_SOCKET, SO_TIMESTAMPING, &val, &len) == 0 && val)
+      return true;
+#else
+   (void)fd;
+#endif
+   return false;
+}
+TimeStamp FdrSocket::GetRecvTs(const struct msghdr& msg) {
+#ifdef __linux__
+   for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(const_cast<struct msghdr*>(&msg), cmsg)) {
+      if (cmsg->cmsg_level != SOL_SOCKET)
+         continue;
+      const struct timespec* ts;
+      if (cmsg->cmsg_type == SCM_TIMESTAMPING) {
+         // ts[0] = software; ts[1] = 已廢棄; ts[2] = raw hardware.
+         ts = reinterpret_cast<const struct timespec*>(CMSG_DATA(cmsg));
+         if (ts[2].tv_sec != 0 || ts[2].tv_nsec != 0)
+            ts += 2;
+      }
+      else if (cmsg->cmsg_type == SCM_TIMESTAMPNS)
+         ts = reinterpret_cast<const struct timespec*>(CMSG_DATA(cmsg));
+      else
+         continue;
+      if (ts->tv_sec == 0 && ts->tv_nsec == 0)
+         continue;
+      return TimeStamp{TimeInterval_Microsecond(static_cast<int64_t>(ts->tv_sec) * 1000000 + ts->tv_nsec / 1000)};
+   }
+#else
+   (void)msg;
+#endif
+   return TimeStamp::Null();
+}
+ssize_t FdrSocket::ReadWithTs(struct iovec* bufv, size_t bufCount) {
+   RecvTsControl  ctrl;
+   struct msghdr  msg;
+   ZeroStruct(msg);
+   msg.msg_iov = bufv;
+   msg.msg_iovlen = bufCount;
+   msg.msg_control = ctrl.Buf_;
+   msg.msg_controllen = sizeof(ctrl.Buf_);
+   ssize_t rdsz = recvmsg(this->GetFD(), &msg, 0);
+   if (rdsz > 0)
+      this->RecvBuffer_.SetRecvTime(GetRecvTs(msg));
+   return rdsz;
+}
+
 bool FdrSocket::CheckRead(Device& dev, bool (*fnIsRecvBufferAlive)(Device& dev, RecvBuffer& rbuf)) {
+   if (!this->FdrRecvNodes_.empty()) {
+      // fdr thread 已從 kernel 取得資料(例: io_uring multishot recv), 不用再 read().
+      if (this->IsRecvSuspended())
+         return true;
+      if (fon9_UNLIKELY(this->RecvSize_ < RecvBufferSize::Default)) {
+         // Session 決定不要再處理 OnDevice_Recv() 事件, 所以拋棄全部已收到的資料.
+         BufferList autoFree{std::move(this->FdrRecvNodes_)};
+      }
+      else {
+         CheckReadAux aux;
+         aux.FnIsRecvBufferAlive_ = fnIsRecvBufferAlive;
+         DeviceRecvBufferReady(dev, this->RecvBuffer_.SetDataReceived(std::move(this->FdrRecvNodes_)), aux);
+      }
+      // multishot recv 結束(EOF 或 錯誤)後, 改用 FdrRecvMode::Async 讀取, 此時要繼續啟動讀取.
+      if (this->GetFdrRecvMode() != FdrRecvMode::Async)
+         return true;
+   }
+   if (this->GetFdrRecvMode() == FdrRecvMode::Async)
+      return this->CheckAsyncRead(dev, fnIsRecvBufferAlive);
+
    size_t   totrd = 0;
    if (fon9_LIKELY(this->RecvSize_ >= RecvBufferSize::Default)) {
       for (;;) {
@@ -78,17 +188,12 @@ bool FdrSocket::CheckRead(Device& dev, bool (*fnIsRecvBufferAlive)(Device& dev,
          bufv[1].iov_len = 0;
 
          size_t   bufCount = this->RecvBuffer_.GetRecvBlockVector(bufv, expectSize);
-         ssize_t  bytesTransfered = readv(this->GetFD(), bufv, static_cast<int>(bufCount));
+         ssize_t  bytesTransfered = (fon9_LIKELY(!this->IsRecvTs_)
+                                     ? readv(this->GetFD(), bufv, static_cast<int>(bufCount))
+                                     : this->ReadWithTs(bufv, bufCount));
          if (fon9_LIKELY(bytesTransfered > 0)) {
             DcQueueList&   rxbuf = this->RecvBuffer_.SetDataReceived(bytesTransfered);
-
-            struct RecvAux : public FdrRecvAux {
-               bool (*FnIsRecvBufferAlive_)(Device& dev, RecvBuffer& rbuf);
-               bool IsRecvBufferAlive(Device& dev, RecvBuffer& rbuf) const {
-                  return this->FnIsRecvBufferAlive_ == nullptr || this->FnIsRecvBufferAlive_(dev, rbuf);
-               }
-            };
-            RecvAux aux;
+            CheckReadAux   aux;
             aux.FnIsRecvBufferAlive_ = fnIsRecvBufferAlive;
             DeviceRecvBufferReady(dev, rxbuf, aux);
 
@@ -142,11 +247,72 @@ __READ_ERROR:
    return true;
 }
 
+bool FdrSocket::CheckAsyncRead(Device& dev, bool (*fnIsRecvBufferAlive)(Device& dev, RecvBuffer& rbuf)) {
+   if (this->IsAsyncRecvDone_) {
+      this->IsAsyncRecvDone_ = false;
+      const ssize_t res = this->AsyncRecvRes_;
+      if (fon9_LIKELY(res > 0)) {
+         if (this->IsRecvTs_)
+            this->RecvBuffer_.SetRecvTime(GetRecvTs(this->AsyncReqs_->Recv_.Msg_));
+         DcQueueList& rxbuf = this->RecvBuffer_.SetDataReceived(static_cast<size_t>(res));
+         if (fon9_UNLIKELY(this->RecvSize_ < RecvBufferSize::Default)) {
+            // Session 決定不要再處理 OnDevice_Recv() 事件, 所以拋棄收到的資料.
+            this->RecvBuffer_.Clear();
+         }
+         else {
+            CheckReadAux aux;
+            aux.FnIsRecvBufferAlive_ = fnIsRecvBufferAlive;
+            DeviceRecvBufferReady(dev, rxbuf, aux);
+         }
+      }
+      else {
+         this->RecvBuffer_.SetDataReceived(0);
+         this->RecvBuffer_.SetContinueRecv();
+         if (res == -ECANCELED) // 已 RemoveFdrEvent(), 不用再處理.
+            return true;
+         if (res == 0) {
+            this->SocketError("Recv", 0);
+            return false;
+         }
+         if (int eno = ErrorCannotRetry(static_cast<int>(-res))) {
+            this->SocketError("Recv", eno);
+            return false;
+         }
+      }
+   }
+   // 正在讀取(RecvBuffer_.IsReceiving()), 或 readable 已關閉, 或正在處理收到的資料: 不用啟動讀取.
+   if (this->IsRecvSuspended())
+      return true;
+   size_t expectSize = (this->RecvSize_ <= RecvBufferSize::Default
+                        ? 1024 * 4
+                        : static_cast<size_t>(this->RecvSize_));
+   if (expectSize < 64)
+      expectSize = 64;
+   AsyncReqs&     areqs = this->GetAsyncReqs();
+   FdrAsyncIoReq& req = areqs.Recv_;
+   struct iovec   bufv[2];
+   req.IovCount_ = static_cast<unsigned>(this->RecvBuffer_.GetRecvBlockVector(bufv, expectSize));
+   memcpy(req.Iov_, bufv, sizeof(bufv[0]) * req.IovCount_);
+   if (fon9_LIKELY(!this->IsRecvTs_))
+      req.Op_ = FdrAsyncIoReq::Op::Read;
+   else {
+      req.Op_ = FdrAsyncIoReq::Op::RecvMsg;
+      ZeroStruct(req.Msg_);
+      req.Msg_.msg_iov = req.Iov_;
+      req.Msg_.msg_iovlen = req.IovCount_;
+      req.Msg_.msg_control = areqs.RecvCtrl_.Buf_;
+      req.Msg_.msg_controllen = sizeof(areqs.RecvCtrl_.Buf_);
+   }
+   this->StartFdrAsyncIo(req);
+   return true;
+}
+
 //--------------------------------------------------------------------------//
 
 SendDirectResult FdrSocket::FdrRecvAux::SendDirect(RecvDirectArgs& e, BufferList&& txbuf) {
    FdrSocket&  so = ContainerOf(RecvBuffer::StaticCast(e.RecvBuffer_), &FdrSocket::RecvBuffer_);
-   if (fon9_LIKELY(so.SendBuffer_.IsEmpty())) {
+   // fdr thread 支援 StartFdrAsyncIo() 時, 由 SendASAP_AuxBuf 使用 StartAsyncSend() 傳送.
+   if (fon9_LIKELY(so.SendBuffer_.IsEmpty()) && !so.IsFdrAsyncIoSupported()) {
       // 使用 SendDirect() 不考慮另一 thread 同時送.
       DcQueueList    toSend{std::move(txbuf)};
       struct iovec   bufv[IOV_MAX];
@@ -16,6 +16,58 @@ protected:
    RecvBufferSize             RecvSize_;
    RecvBuffer                 RecvBuffer_;
    SendBuffer                 SendBuffer_;
+   /// socket 有設定 SO_TIMESTAMPNS 或 SO_TIMESTAMPING("RecvTs=Sw|Hw"),
+   /// 此時改用 recvmsg() 讀取, 並將接收時間設定到 RecvBuffer_.
+   const bool                 IsRecvTs_;
+
+   /// 提供給 recvmsg() 存放接收時間的 control message 緩衝區.
+   union RecvTsControl {
+      struct cmsghdr Align_;
+      char           Buf_[CMSG_SPACE(sizeof(struct timespec) * 3) + CMSG_SPACE(sizeof(struct timespec))];
+   };
+   /// 從 recvmsg() 取得的 control message 解析接收時間:
+   /// - SCM_TIMESTAMPING: 優先使用網卡的硬體時間, 若沒有則使用 kernel 的時間.
+   /// - SCM_TIMESTAMPNS: kernel 的時間.
+   /// - 若都沒有, 則傳回 TimeStamp::Null().
+   static TimeStamp GetRecvTs(const struct msghdr& msg);
+   static bool IsRecvTsEnabled(int fd);
+   /// 使用 recvmsg() 讀取資料, 並設定 RecvBuffer_.SetRecvTime();
+   ssize_t ReadWithTs(struct iovec* bufv, size_t bufCount);
+
+   /// fdr thread 支援 StartFdrAsyncIo() 時(例: io_uring), 傳送及接收使用的要求.
+   /// 只在 fdr thread 裡面建立及使用.
+   struct AsyncReqs {
+      FdrAsyncIoReq  Send_;
+      FdrAsyncIoReq  Recv_;
+      RecvTsControl  RecvCtrl_;
+   };
+   std::unique_ptr<AsyncReqs> AsyncReqs_;
+   /// Send_ 完成時設定, 在 ContinueSendAux::GetContinueToSend() 從 SendBuffer_ 移除已送出的資料.
+   size_t   AsyncSentBytes_{0};
+   /// Recv_ 的結果, 在 CheckRead() 處理.
+   ssize_t  AsyncRecvRes_{0};
+   bool     IsAsyncRecvDone_{false};
+
+   AsyncReqs& GetAsyncReqs() {
+      if (fon9_UNLIKELY(!this->AsyncReqs_))
+         this->AsyncReqs_.reset(new AsyncReqs);
+      return *this->AsyncReqs_;
+   }
+   /// 在 fdr thread 裡面, 使用 StartFdrAsyncIo() 送出 toSend, 完成後透過 OnFdrEvent_StartSend() 繼續傳送.
+   /// \retval false toSend 沒有可送出的資料區塊, 應改用 writev() 處理.
+   bool StartAsyncSend(DcQueueList& toSend);
+   /// 尚有資料未送出:
+   /// - 若 fdr thread 支援 StartFdrAsyncIo(): 到 fdr thread 使用 StartAsyncSend() 繼續傳送.
+   /// - 否則啟動 writable 偵測.
+   void ContinueSendLater() {
+      if (this->IsFdrAsyncIoSupported())
+         this->StartSendInFdrThread();
+      else
+         this->EnableEventBit(FdrEventFlag::Writable);
+   }
+   /// FdrRecvMode::Async: 處理 Recv_ 的結果, 然後使用 StartFdrAsyncIo() 繼續讀取.
+   bool CheckAsyncRead(Device& dev, bool (*fnIsRecvBufferAlive)(Device& dev, RecvBuffer& rbuf));
+   virtual void OnFdrEvent_AsyncIoDone(FdrAsyncIoReq& req, ssize_t res) override;
 
    /// 建立錯誤訊息字串, 觸發事件:
    /// `this->OnFdrSocket_Error("fnName:" + GetSocketErrC(eno));`
@@ -33,7 +85,8 @@ protected:
       }
    }
 
-   /// \retval 0     success;  返回前, 若已無資料則: CheckSendQueueEmpty(); 若仍有資料則: 啟動 writable 偵測.
+   /// - 若在 fdr thread 裡面, 且 fdr thread 支援 StartFdrAsyncIo(), 則使用 StartAsyncSend() 傳送.
+   /// \retval 0     success;  返回前, 若已無資料則: CheckSendQueueEmpty(); 若仍有資料則: ContinueSendLater().
    /// \retval else  errno;    返回前, 已先呼叫 this->OnFdrSocket_Error("fn=Sendv|err=", retval);
    int Sendv(DeviceOpLocker& sc, DcQueueList& toSend);
    
@@ -43,7 +96,10 @@ protected:
    }
 
 public:
-   FdrSocket(FdrService& iosv, Socket&& so) : FdrEventHandler{iosv, so.MoveOut()} {
+   FdrSocket(FdrService& iosv, Socket&& so, int thrIndex = -1)
+      : FdrEventHandler{iosv, so.MoveOut(), thrIndex}
+      , IsRecvTs_{IsRecvTsEnabled(this->GetFD())} {
+      this->IsFdrAsyncRecvAllowed_ = true;
    }
 
    void EnableEventBit(FdrEventFlag ev) {
@@ -103,6 +159,22 @@ public:
    /// \retval false read 失敗, 返回前已呼叫 OnFdrSocket_Error();
    bool CheckRead(Device& dev, bool (*fnIsRecvBufferAlive)(Device& dev, RecvBuffer& rbuf));
 
+protected:
+   struct CheckReadAux : public FdrRecvAux {
+      bool (*FnIsRecvBufferAlive_)(Device& dev, RecvBuffer& rbuf);
+      bool IsRecvBufferAlive(Device& dev, RecvBuffer& rbuf) const {
+         return this->FnIsRecvBufferAlive_ == nullptr || this->FnIsRecvBufferAlive_(dev, rbuf);
+      }
+   };
+   /// readable 已關閉(例: 正在 op thread 處理 OnDevice_Recv()), 或 RecvBuffer 正在使用中.
+   /// 此時若 FdrRecvNodes_ 有資料, 則應先保留, 等重新啟用 readable 時, fdr thread 會再觸發 Readable 事件.
+   bool IsRecvSuspended() const {
+      return (this->EnabledEvents_.load(std::memory_order_relaxed) & static_cast<FdrEventFlagU>(FdrEventFlag::Readable)) == 0
+         || this->RecvBuffer_.IsInvokingEvent() || this->RecvBuffer_.IsReceiving();
+   }
+
+public:
+
    //--------------------------------------------------------------------------//
 
    SendBuffer& GetSendBuffer() {
@@ -115,12 +187,18 @@ public:
          this->DisableEvent(ContainerOf(sbuf, &FdrSocket::SendBuffer_), FdrEventFlag::Writable);
       }
       static DcQueueList* GetContinueToSend(SendBuffer& sbuf) {
+         // StartAsyncSend() 完成: 先移除已送出的資料.
+         FdrSocket& impl = ContainerOf(sbuf, &FdrSocket::SendBuffer_);
+         if (const size_t sent = impl.AsyncSentBytes_) {
+            impl.AsyncSentBytes_ = 0;
+            return sbuf.OpImpl_ContinueSend(sent);
+         }
          return sbuf.OpImpl_CheckSendQueue();
       }
       void ContinueToSend(ContinueSendChecker& sc, DcQueueList& toSend) const {
          sc.GetALocker().UnlockForInplace();
          // 可能的呼叫點:
-         // - 在 io thread 的 writable 事件裡面呼叫.
+         // - 在 io thread 的 writable 事件(或 StartAsyncSend() 完成)裡面呼叫.
          // - DisableWritableEvent() 之後, 在 op thread 的 Async.
          SendBuffer& sbuf = SendBuffer::StaticCast(toSend);
          FdrSocket&  impl = ContainerOf(sbuf, &FdrSocket::SendBuffer_);
@@ -133,6 +211,13 @@ public:
 
       Device::SendResult StartToSend(DeviceOpLocker& sc, DcQueueList& toSend) {
          FdrSocket&  impl = ContainerOf(SendBuffer::StaticCast(toSend), &FdrSocket::SendBuffer_);
+         if (impl.IsFdrAsyncIoSupported() && impl.InFdrThread()) {
+            // 在 fdr thread 裡面: 使用 StartAsyncSend(), 與其他要求一起在 io_uring_enter() 送出.
+            toSend.Append(this->Src_, this->Size_);
+            if (int eno = impl.Sendv(sc, toSend))
+               return GetSysErrC(eno);
+            return Device::SendResult{0};
+         }
          auto        wrsz = write(impl.GetFD(), this->Src_, this->Size_);
          if (fon9_UNLIKELY(wrsz < 0)) {
             if (int eno = ErrorCannotRetry(errno)) {
@@ -146,7 +231,7 @@ public:
             impl.CheckSendQueueEmpty(sc);
          else {
             toSend.Append(reinterpret_cast<const char*>(this->Src_) + wrsz, this->Size_ - wrsz);
-            impl.EnableEventBit(FdrEventFlag::Writable);
+            impl.ContinueSendLater();
          }
          return Device::SendResult{static_cast<size_t>(wrsz)};
       }
@@ -55,8 +55,8 @@ protected:
    }
 
 public:
-   FdrSocketClientImpl(FdrService& iosv, Socket&& so)
-      : FdrSocket{iosv, std::move(so)} {
+   FdrSocketClientImpl(FdrService& iosv, Socket&& so, int thrIndex = -1)
+      : FdrSocket{iosv, std::move(so), thrIndex} {
    }
    bool IsClosing() const {
       return this->State_ == State::Closing;
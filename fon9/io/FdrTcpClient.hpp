@@ -20,8 +20,10 @@ public:
    const OwnerDeviceSP  Owner_;
 
    FdrTcpClientImpl(OwnerDevice* owner, Socket&& so, SocketResult&)
-      : base{*owner->IoService_, std::move(so)}
+      : base{*owner->IoService_, std::move(so), owner->Session_->GetDeviceIoThreadIndex()}
       , Owner_{owner} {
+      // io_uring 的 multishot recv 無法取得接收時間, 所以有設定 "RecvTs" 時, 不使用 FdrRecvNodes_.
+      this->IsFdrRecvNodesAllowed_ = !this->IsRecvTs_;
    }
    bool OpImpl_ConnectTo(const SocketAddress& addr, SocketResult& soRes);
 };
@@ -54,7 +54,9 @@ class FdrTcpListener::AcceptedClient : public DeviceAcceptedClient, public FdrSo
 public:
    AcceptedClient(FdrTcpListener& owner, Socket soAccepted, SessionSP ses, ManagerSP mgr, const DeviceOptions& optsDefault)
       : base(&owner, std::move(ses), std::move(mgr), &optsDefault)
-      , FdrSocket(*owner.IoServiceSP_, std::move(soAccepted)) {
+      , FdrSocket(*owner.IoServiceSP_, std::move(soAccepted), this->Session_->GetDeviceIoThreadIndex()) {
+      // io_uring 的 multishot recv 無法取得接收時間, 所以有設定 "RecvTs" 時, 不使用 FdrRecvNodes_.
+      this->IsFdrRecvNodesAllowed_ = !this->IsRecvTs_;
    }
 
    using Impl = DeviceImpl_DeviceStartSend<DeviceAcceptedClientWithSend<AcceptedClient>, FdrSocket>;
@@ -163,7 +165,9 @@ void FdrTcpListener::OnFdrEvent_Handling(FdrEventFlag evs) {
          fon9_LOG_ERROR("TcpServer.Accepted"
                         "|dev=", ToHex{devAccepted},
                         "|err=", soRes, '|', strConnUID);
-         break;
+         // 拒絕此連線後, 仍要繼續 accept() 直到 EAGAIN:
+         // 若使用 io_uring 的 multishot poll, 只有在「新連線到達」時才會再觸發 Readable, 所以不能留下尚未處理的連線.
+         continue;
       }
       fon9_LOG_INFO("TcpServer.Accepted"
                     "|dev=", ToHex{devAccepted},
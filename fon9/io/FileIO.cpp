@@ -112,6 +112,13 @@ struct iovec {
 
 void FileIO::Impl::OnTimer(TimeStamp now) {
    (void)now;
+#ifdef fon9_POSIX
+   if (this->InIo_) {
+      // 到 fdr thread 讀取: StartAsyncRead();
+      this->InIo_->StartSendInFdrThread();
+      return;
+   }
+#endif
    iovec  blks[2];
    size_t expsz = this->RecvSize_ > RecvBufferSize::Default ? static_cast<size_t>(this->RecvSize_) : 1024;
    size_t blkc = this->InBuffer_.GetRecvBlockVector(blks, expsz);
@@ -137,6 +144,9 @@ void FileIO::Impl::OnTimer(TimeStamp now) {
       ++pblk;
       --blkc;
    }
+   this->OnReadDone(rdsz);
+}
+void FileIO::Impl::OnReadDone(size_t rdsz) {
    DcQueueList& rxbuf = this->InBuffer_.SetDataReceived(rdsz);
    if (rdsz <= 0) { // AtEOF or ReadError
       this->InBuffer_.SetContinueRecv();
@@ -160,6 +170,13 @@ void FileIO::Impl::OnTimer(TimeStamp now) {
       SendDirectResult SendDirect(RecvDirectArgs& e, BufferList&& txbuf) {
          // SendDirect() 不考慮現在 impl.OutBuffer_ 的狀態?
          Impl&       impl = ContainerOf(RecvBuffer::StaticCast(e.RecvBuffer_), &Impl::InBuffer_);
+      #ifdef fon9_POSIX
+         if (impl.OutIo_) {
+            // 使用 OutIo_ 時, 必須依序寫入, 所以放到 OutQueue_ 等候.
+            impl.PushToOutIo(std::move(txbuf));
+            return SendDirectResult::Sent;
+         }
+      #endif
          DcQueueList buf{std::move(txbuf)};
          impl.OutFile_.Append(buf);
          return SendDirectResult::Sent;
@@ -209,6 +226,142 @@ void FileIO::Impl::CheckContinueRecv() {
    this->RunAfter(ti);
 }
 //--------------------------------------------------------------------------//
+#ifdef fon9_POSIX
+FdrEventFlag FileIO::Impl::FdrFileIo::GetRequiredFdrEventFlag() const {
+   return FdrEventFlag::None;
+}
+void FileIO::Impl::FdrFileIo::OnFdrEvent_Handling(FdrEventFlag evs) {
+   // 不註冊事件, 所以只會收到 OperationCanceled(fdr thread 無法服務), 此時不用處理.
+   (void)evs;
+}
+void FileIO::Impl::FdrFileIo::OnFdrEvent_StartSend() {
+   if (this == this->Impl_.InIo_.get())
+      this->Impl_.StartAsyncRead();
+   else
+      this->Impl_.StartAsyncWrite();
+}
+void FileIO::Impl::FdrFileIo::OnFdrEvent_AsyncIoDone(FdrAsyncIoReq& req, ssize_t res) {
+   (void)req;
+   if (this == this->Impl_.InIo_.get())
+      this->Impl_.OnAsyncReadDone(res);
+   else
+      this->Impl_.OnAsyncWriteDone(res);
+}
+void FileIO::Impl::FdrFileIo::OnFdrEvent_AddRef() {
+   intrusive_ptr_add_ref(static_cast<TimerEntry*>(&this->Impl_));
+}
+void FileIO::Impl::FdrFileIo::OnFdrEvent_ReleaseRef() {
+   intrusive_ptr_release(static_cast<TimerEntry*>(&this->Impl_));
+}
+
+void FileIO::Impl::OpenFdrIo(FdrService& iosv) {
+   // 全部的 fdr thread 都是同一種類, 所以只要檢查第一個.
+   if (!iosv.GetFdrThreads().front()->IsAsyncIoSupported())
+      return;
+   if (this->InFile_.IsOpened()) {
+      FdrAuto fd{this->InFile_.Duplicate().ReleaseFD()};
+      if (fd.IsReadyFD())
+         this->InIo_.reset(new FdrFileIo{iosv, std::move(fd), *this});
+   }
+   if (this->OutFile_.IsOpened()) {
+      FdrAuto fd{this->OutFile_.Duplicate().ReleaseFD()};
+      if (fd.IsReadyFD())
+         this->OutIo_.reset(new FdrFileIo{iosv, std::move(fd), *this});
+   }
+}
+void FileIO::Impl::CloseFdrIo() {
+   // 取消尚未完成的讀取; 但 OutIo_ 仍會將 OutQueue_ 寫完, 與 AsyncFlushOutBuffer() 相同.
+   if (this->InIo_)
+      this->InIo_->RemoveFdrEvent();
+}
+void FileIO::Impl::StartAsyncRead() {
+   FdrAsyncIoReq& req = this->InIo_->Req_;
+   if (req.IsPending())
+      return;
+   iovec  blks[2];
+   size_t expsz = this->RecvSize_ > RecvBufferSize::Default ? static_cast<size_t>(this->RecvSize_) : 1024;
+   size_t blkc = this->InBuffer_.GetRecvBlockVector(blks, expsz);
+   expsz = this->Owner_->InProps_.ReadSize_; // 每次讀入資料量.
+   req.IovCount_ = 0;
+   for (size_t L = 0; L < blkc; ++L) {
+      iovec& iov = req.Iov_[req.IovCount_++];
+      iov = blks[L];
+      if (expsz > 0) {
+         if (iov.iov_len >= expsz) {
+            iov.iov_len = expsz;
+            break;
+         }
+         expsz -= iov.iov_len;
+      }
+   }
+   req.Op_ = FdrAsyncIoReq::Op::Read;
+   req.Offset_ = static_cast<int64_t>(this->InCurPos_);
+   this->InIo_->StartFdrAsyncIo(req);
+}
+void FileIO::Impl::OnAsyncReadDone(ssize_t res) {
+   if (fon9_UNLIKELY(res == -ECANCELED)) { // 已 CloseFdrIo();
+      this->InBuffer_.SetDataReceived(0);
+      this->InBuffer_.SetContinueRecv();
+      return;
+   }
+   size_t rdsz = 0;
+   if (fon9_UNLIKELY(res < 0))
+      this->InSt_ = InFileSt::ReadError;
+   else {
+      rdsz = static_cast<size_t>(res);
+      this->InCurPos_ += rdsz;
+      const FdrAsyncIoReq& req = this->InIo_->Req_;
+      size_t expsz = 0;
+      for (unsigned L = 0; L < req.IovCount_; ++L)
+         expsz += req.Iov_[L].iov_len;
+      if (rdsz < expsz)
+         this->InSt_ = InFileSt::AtEOF;
+   }
+   this->OnReadDone(rdsz);
+}
+void FileIO::Impl::PushToOutIo(BufferList&& buf) {
+   {
+      OutQueue::Locker out{this->OutQueue_};
+      out->Queue_.push_back(std::move(buf));
+      if (out->IsWriting_)
+         return;
+      out->IsWriting_ = true;
+   }
+   this->OutIo_->StartSendInFdrThread();
+}
+void FileIO::Impl::StartAsyncWrite() {
+   FdrAsyncIoReq& req = this->OutIo_->Req_;
+   if (req.IsPending())
+      return;
+   if (this->OutWriting_.empty()) {
+      OutQueue::Locker out{this->OutQueue_};
+      if (out->Queue_.empty()) {
+         out->IsWriting_ = false;
+         return;
+      }
+      this->OutWriting_.push_back(std::move(out->Queue_));
+   }
+   req.IovCount_ = static_cast<unsigned>(this->OutWriting_.PeekBlockVector(req.Iov_));
+   req.Op_ = FdrAsyncIoReq::Op::Write;
+   req.Offset_ = -1; // OutFile_ 使用 O_APPEND 開啟.
+   this->OutIo_->StartFdrAsyncIo(req);
+}
+void FileIO::Impl::OnAsyncWriteDone(ssize_t res) {
+   if (fon9_LIKELY(res >= 0))
+      this->OutWriting_.PopConsumed(static_cast<size_t>(res));
+   else {
+      this->OutWriting_.ConsumeErr(GetSysErrC(static_cast<int>(-res)));
+      if (res == -ECANCELED) { // fdr thread 已無法服務.
+         OutQueue::Locker out{this->OutQueue_};
+         BufferListConsumeErr(std::move(out->Queue_), std::errc::operation_canceled);
+         out->IsWriting_ = false;
+         return;
+      }
+   }
+   this->StartAsyncWrite();
+}
+#endif
+//--------------------------------------------------------------------------//
 void FileIO::OpImpl_StartRecv(RecvBufferSize preallocSize) {
    assert(this->ImplSP_);
    this->ImplSP_->RecvSize_ = preallocSize;
@@ -217,6 +370,9 @@ void FileIO::OpImpl_StartRecv(RecvBufferSize preallocSize) {
 void FileIO::OpImpl_StopRunning() {
    if (auto impl = this->ImplSP_.get()) {
       impl->StopAndWait();
+   #ifdef fon9_POSIX
+      impl->CloseFdrIo();
+   #endif
       this->ImplSP_.reset();
    }
 }
@@ -291,6 +447,10 @@ void FileIO::OpenImpl() {
    ImplSP    impl{new Impl{*this}};
    if (this->OpenFile("OutFile", this->OutFileCfg_, impl->OutFile_, now)
        && this->OpenFile("InFile", this->InFileCfg_, impl->InFile_, now)) {
+   #ifdef fon9_POSIX
+      if (this->FdrService_)
+         impl->OpenFdrIo(*this->FdrService_);
+   #endif
       this->ImplSP_ = std::move(impl);
       OpThr_SetLinkReady(*this, std::string{});
    }
@@ -304,8 +464,13 @@ ConfigParser::Result FileIO::OpImpl_SetProperty(StrView tag, StrView& value) {
 bool FileIO::IsSendBufferEmpty() const {
    bool res;
    this->OpQueue_.InplaceOrWait(AQueueTaskKind::Send, DeviceAsyncOp{[&res](Device& dev) {
-      if (auto impl = static_cast<FileIO*>(&dev)->ImplSP_.get())
+      if (auto impl = static_cast<FileIO*>(&dev)->ImplSP_.get()) {
          res = impl->OutBuffer_.empty();
+      #ifdef fon9_POSIX
+         if (res && impl->OutIo_)
+            res = !Impl::OutQueue::Locker{impl->OutQueue_}->IsWriting_;
+      #endif
+      }
       else
          res = true;
    }});
@@ -323,6 +488,14 @@ FileIO::SendResult FileIO::SendBuffered(const void* src, size_t size) {
    StartSendChecker sc;
    if (fon9_LIKELY(sc.IsLinkReady(*this))) {
       assert(this->ImplSP_);
+   #ifdef fon9_POSIX
+      if (this->ImplSP_->OutIo_) {
+         BufferList buf;
+         AppendToBuffer(buf, src, size);
+         this->ImplSP_->PushToOutIo(std::move(buf));
+         return Device::SendResult{0};
+      }
+   #endif
       AppendToBuffer(this->ImplSP_->OutBuffer_, src, size);
       this->ImplSP_->AsyncFlushOutBuffer(sc.GetALocker());
       return Device::SendResult{0};
@@ -333,6 +506,12 @@ FileIO::SendResult FileIO::SendBuffered(BufferList&& src) {
    StartSendChecker sc;
    if (fon9_LIKELY(sc.IsLinkReady(*this))) {
       assert(this->ImplSP_);
+   #ifdef fon9_POSIX
+      if (this->ImplSP_->OutIo_) {
+         this->ImplSP_->PushToOutIo(std::move(src));
+         return Device::SendResult{0};
+      }
+   #endif
       this->ImplSP_->OutBuffer_.push_back(std::move(src));
       this->ImplSP_->AsyncFlushOutBuffer(sc.GetALocker());
       return Device::SendResult{0};
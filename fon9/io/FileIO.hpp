@@ -6,6 +6,9 @@
 #include "fon9/io/RecvBuffer.hpp"
 #include "fon9/File.hpp"
 #include "fon9/Timer.hpp"
+#ifdef fon9_POSIX
+#include "fon9/io/FdrService.hpp"
+#endif
 
 namespace fon9 { namespace io {
 
@@ -39,6 +42,9 @@ fon9_WARN_DISABLE_PADDING;
 ///   - I+O mode:    "|I=InFN|O=OutFN"
 /// - DeviceInfo:
 ///   - LinkReady: ("I" or "O" or "I+O") + "|InCur=|InFileTime=|InFileSize=|InSpeed=n*ti"
+/// - 若建構時提供的 FdrService 支援 StartFdrAsyncIo()(例: io_uring),
+///   則檔案的 read/write 由 fdr thread 透過 IORING_OP_READV/IORING_OP_WRITEV 執行,
+///   timer thread 只負責讀取間隔, op thread 不再執行寫檔.
 class fon9_API FileIO : public Device {
    fon9_NON_COPY_NON_MOVE(FileIO);
    using base = Device;
@@ -46,6 +52,12 @@ public:
    FileIO(SessionSP ses, ManagerSP mgr, const DeviceOptions* optsDefault = nullptr)
       : base(std::move(ses), std::move(mgr), Style::Simulation, optsDefault) {
    }
+#ifdef fon9_POSIX
+   FileIO(FdrServiceSP iosv, SessionSP ses, ManagerSP mgr, const DeviceOptions* optsDefault = nullptr)
+      : base(std::move(ses), std::move(mgr), Style::Simulation, optsDefault)
+      , FdrService_{std::move(iosv)} {
+   }
+#endif
 
    bool IsSendBufferEmpty() const override;
    SendResult SendASAP(const void* src, size_t size) override;
@@ -110,11 +122,57 @@ private:
          , InCurPos_{owner.InProps_.StartPos_} {
       }
       void OnTimer(TimeStamp now) override;
+      /// 已讀入 rdsz bytes 到 InBuffer_(已設定 InSt_, InCurPos_), 觸發 OnDevice_Recv() 或繼續等候.
+      void OnReadDone(size_t rdsz);
       void CheckContinueRecv();
       void AsyncFlushOutBuffer(DeviceOpQueue::ALockerForInplace& alocker);
+
+   #ifdef fon9_POSIX
+      /// 透過 fdr thread 的 StartFdrAsyncIo() 讀(或寫)檔案, 不註冊任何事件.
+      /// 使用 dup() 的 fd, 參考計數轉給 Impl.
+      struct FdrFileIo : public FdrEventHandler {
+         fon9_NON_COPY_NON_MOVE(FdrFileIo);
+         Impl&          Impl_;
+         FdrAsyncIoReq  Req_;
+         FdrFileIo(FdrService& iosv, FdrAuto&& fd, Impl& impl)
+            : FdrEventHandler{iosv, std::move(fd)}
+            , Impl_(impl) {
+         }
+         FdrEventFlag GetRequiredFdrEventFlag() const override;
+         void OnFdrEvent_Handling(FdrEventFlag evs) override;
+         void OnFdrEvent_StartSend() override;
+         void OnFdrEvent_AsyncIoDone(FdrAsyncIoReq& req, ssize_t res) override;
+         void OnFdrEvent_AddRef() override;
+         void OnFdrEvent_ReleaseRef() override;
+      };
+      std::unique_ptr<FdrFileIo> InIo_;
+      std::unique_ptr<FdrFileIo> OutIo_;
+      struct OutQueueImpl {
+         BufferList  Queue_;
+         /// OutIo_ 正在 fdr thread 寫入(或已要求 StartSendInFdrThread()).
+         bool        IsWriting_{false};
+      };
+      using OutQueue = MustLock<OutQueueImpl>;
+      /// 使用 OutIo_ 時, 等候寫入的資料放在這裡, 不使用 OutBuffer_.
+      OutQueue       OutQueue_;
+      /// 正在寫入的資料, 只在 fdr thread 使用.
+      DcQueueList    OutWriting_;
+
+      /// 若 iosv 支援 StartFdrAsyncIo(), 則建立 InIo_, OutIo_;
+      void OpenFdrIo(FdrService& iosv);
+      void CloseFdrIo();
+      void StartAsyncRead();
+      void OnAsyncReadDone(ssize_t res);
+      void PushToOutIo(BufferList&& buf);
+      void StartAsyncWrite();
+      void OnAsyncWriteDone(ssize_t res);
+   #endif
    };
    using ImplSP = intrusive_ptr<Impl>;
    ImplSP   ImplSP_;
+#ifdef fon9_POSIX
+   FdrServiceSP   FdrService_;
+#endif
 
    void OpImpl_StopRunning();
    void OpenImpl();
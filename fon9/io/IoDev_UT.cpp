@@ -2,6 +2,7 @@
 /// \author fonwinz@gmail.com
 #include "fon9/io/SimpleManager.hpp"
 #include "fon9/TestTools.hpp"
+#include "fon9/buffer/MemBlockImpl.hpp"
 
 #ifdef fon9_WINDOWS
 #include "fon9/io/win/IocpTcpClient.hpp"
@@ -44,12 +45,13 @@ class PingpongSession : public fon9::io::SessionServer {
       return fon9::io::RecvBufferSize::Default;
    }
    virtual std::string SessionCommand(fon9::io::Device& dev, fon9::StrView cmdln) override {
-      // cmdln = "a size" or "b size" or "s string"
-      // a = ASAP, b = Buffered
+      // cmdln = "a size" or "b size" or "s string" or "m count size"
+      // a = ASAP, b = Buffered, m = count 筆 size bytes 的訊息(SendASAP)
       // size = 1024 or 1024k or 100m ...
       //        k=*1000, m=*1000000
       TimeUS         usElapsed;
       size_t         size;
+      size_t         count;
       fon9::StrView  strSend;
       std::string    retval;
       fon9::io::Device::SendResult res;
@@ -69,6 +71,22 @@ __NEXT_CMD:
          usElapsed = GetTimeUS();
          res = dev.StrSend(cmdln);
          break;
+      case 'm':
+         cmdln.SetBegin(cmdln.begin() + 1);
+         if ((count = fon9::StrTo(fon9::StrFetchTrim(cmdln, &fon9::isspace), 0u)) <= 0)
+            return "msg count empty.";
+         if ((size = fon9::StrTo(cmdln, 0u)) <= 0)
+            return "msg size empty.";
+         {
+            std::string msg(size, 'm');
+            strSend = "SendASAP.Msgs";
+            this->LastSendTime_ = fon9::UtcNow();
+            usElapsed = GetTimeUS();
+            for (size_t L = 0; L < count; ++L)
+               res = dev.SendASAP(msg.data(), msg.size());
+            size *= count;
+         }
+         break;
       case 'a': case 'b':
          cmdln.SetBegin(cmdln.begin() + 1);
          const char* endp;
@@ -129,10 +147,13 @@ public:
    fon9::TimeStamp   LastRecvTime_;
    uint64_t          RecvBytes_{0};
    uint64_t          RecvCount_{0};
+   fon9::impl::MemBlockLevelStats   MemStats_{};
 
    void PrintInfo() {
-      if (this->RecvCount_ <= 0)
+      if (this->RecvCount_ <= 0) {
+         fon9::impl::MemBlockGetLevelStats(this->MemStats_);
          return;
+      }
       bool isEchoMode = this->IsEchoMode_;
       if (this->IsEchoMode_) {
          this->IsEchoMode_ = false;
@@ -148,6 +169,17 @@ public:
                     "|avgBytes=", this->RecvBytes_ / this->RecvCount_,
                     "|throughput=", fon9::Decimal<uint64_t,3>(static_cast<double>(this->RecvBytes_) / (elapsed.To<double>() * 1024 * 1024)),
                     "(MB/s)");
+      // 顯示此段期間 MemBlock 各 level 的分配次數, 可用來觀察接收緩衝(例: io_uring RecvRing)的分配量.
+      fon9::impl::MemBlockLevelStats memStats;
+      fon9::impl::MemBlockGetLevelStats(memStats);
+      std::string memInfo;
+      for (size_t L = 0; L < memStats.size(); ++L) {
+         const uint64_t allocs = memStats[L].AllocCount_ - this->MemStats_[L].AllocCount_;
+         if (allocs > 0)
+            memInfo += fon9::RevPrintTo<std::string>('|', memStats[L].BlockSize_, '=', allocs);
+      }
+      this->MemStats_ = memStats;
+      fon9_LOG_INFO("MemBlock.Allocs", memInfo);
       this->RecvBytes_ = this->RecvCount_ = 0;
       this->IsEchoMode_ = isEchoMode;
    }
@@ -169,6 +201,7 @@ Usage:
 e.g.
     c "127.0.0.1:9000|Timeout=30" "ThreadCount=2|Wait=Block|Cpus="
     s "9000|ThreadCount=2|Wait=Block|Cpus="
+    c "127.0.0.1:9000" "Service=IoUring|RecvRing=256"
 )**"
          << std::endl;
       return 3;
@@ -199,7 +232,12 @@ e.g.
          return 3;
       }
       IoService::MakeResult   err;
+#ifdef fon9_WINDOWS
       iosv = IoService::MakeService(iosvArgs, "IoTest", err);
+#else
+      // 使用 MakeDefaultFdrService(): 可透過 "Service=IoUring|RecvRing=256" 測試 FdrServiceIoUring.
+      iosv = fon9::io::MakeDefaultFdrService(iosvArgs, "IoTest", err);
+#endif
       if (!iosv) {
          std::cout << "IoService.MakeService|" << fon9::RevPrintTo<std::string>(err) << std::endl;
          return 3;
@@ -254,6 +292,7 @@ Commands:
                   size can use k=*1000, m=*1000000;
                   e.g. "b 2k" = dev.SendBuffered(data, 2000);
    ses s string   dev.StrSend(string);
+   ses m count size  dev.SendASAP(data, size); count times.
 
    open param     dev.AsyncOpen(param);
    close cause    dev.AsyncClose("DeviceCommand.close:" + cause);
@@ -11,6 +11,7 @@ static const StrView howWaitStrMap[]{
    fon9_MAKE_ENUM_CLASS_StrView_NoSeq(1, HowWait, Block),
    fon9_MAKE_ENUM_CLASS_StrView_NoSeq(2, HowWait, Yield),
    fon9_MAKE_ENUM_CLASS_StrView_NoSeq(3, HowWait, Busy),
+   fon9_MAKE_ENUM_CLASS_StrView_NoSeq(4, HowWait, Spin),
 };
 
 fon9_API HowWait StrToHowWait(StrView value) {
@@ -32,6 +33,31 @@ fon9_API StrView HowWaitToStr(HowWait value) {
 
 //--------------------------------------------------------------------------//
 
+static const StrView ioServiceKindStrMap[]{
+   fon9_MAKE_ENUM_CLASS_StrView_NoSeq(0, IoServiceKind, Default),
+   fon9_MAKE_ENUM_CLASS_StrView_NoSeq(1, IoServiceKind, Epoll),
+   fon9_MAKE_ENUM_CLASS_StrView_NoSeq(2, IoServiceKind, IoUring),
+};
+
+fon9_API IoServiceKind StrToIoServiceKind(StrView value) {
+   int idx = 0;
+   for (const StrView& v : ioServiceKindStrMap) {
+      if (v == value)
+         return static_cast<IoServiceKind>(idx);
+      ++idx;
+   }
+   return IoServiceKind::Default;
+}
+
+fon9_API StrView IoServiceKindToStr(IoServiceKind value) {
+   size_t idx = static_cast<size_t>(value);
+   if (idx >= numofele(ioServiceKindStrMap))
+      return StrView("Unknown");
+   return ioServiceKindStrMap[idx];
+}
+
+//--------------------------------------------------------------------------//
+
 ConfigParser::Result IoServiceArgs::OnTagValue(StrView tag, StrView& value) {
    const char* pvalbeg = value.begin();
    if (tag == "ThreadCount") {
@@ -43,12 +69,35 @@ ConfigParser::Result IoServiceArgs::OnTagValue(StrView tag, StrView& value) {
    }
    else if (tag == "Capacity")
       this->Capacity_ = StrTo(value, 0u);
+   else if (tag == "RecvRing")
+      this->RecvRingCount_ = StrTo(value, 0u);
+   else if (tag == "RecvRingBuf") {
+      const char* pend;
+      this->RecvRingBufSize_ = StrTo(value, 0u, &pend);
+      if (pend < value.end() && toupper(static_cast<unsigned char>(*pend)) == 'K')
+         this->RecvRingBufSize_ *= 1024;
+      if (this->RecvRingBufSize_ < 1024 || this->RecvRingBufSize_ > 1024 * 64) {
+         const bool isTooSmall = (this->RecvRingBufSize_ < 1024);
+         this->RecvRingBufSize_ = 1024 * 16;
+         value.SetBegin(pvalbeg);
+         return isTooSmall ? ConfigParser::Result::EValueTooSmall : ConfigParser::Result::EValueTooLarge;
+      }
+   }
+   else if (tag == "BusyPoll")
+      this->BusyPollUs_ = StrTo(value, 0u);
+   else if (tag == "LoopHist")
+      this->IsLoopHist_ = (toupper(static_cast<unsigned char>(value.Get1st())) == 'Y');
    else if (tag == "Wait") {
       if ((this->HowWait_ = StrToHowWait(value)) == HowWait::Unknown) {
          this->HowWait_ = HowWait::Block;
          return ConfigParser::Result::EInvalidValue;
       }
    }
+   else if (tag == "Service") {
+      if ((this->ServiceKind_ = StrToIoServiceKind(value)) == IoServiceKind::Default
+          && value != IoServiceKindToStr(IoServiceKind::Default))
+         return ConfigParser::Result::EInvalidValue;
+   }
    else if (tag == "Cpus") {
       while (!value.empty()) {
          StrView v1 = StrFetchTrim(value, ',');
@@ -95,7 +144,9 @@ void ServiceThreadArgs::OnThrRunBegin(StrView msgHead) const {
                    "|index=", this->ThreadPoolIndex_ + 1,
                    "|Cpu=", this->CpuAffinity_, ':', cpuAffinityResult,
                    "|Wait=", HowWaitToStr(this->HowWait_),
-                   "|Capacity=", this->Capacity_);
+                   "|Capacity=", this->Capacity_,
+                   "|BusyPoll=", this->BusyPollUs_,
+                   "|LoopHist=", this->IsLoopHist_ ? 'Y' : 'N');
 
 }
 
@@ -16,6 +16,11 @@ enum class HowWait {
    Block,
    Yield,
    Busy,
+   /// 與 Busy 相同, 不會 yield, 也不會進入 kernel 等候;
+   /// 但更進一步: io thread 每次迴圈都會主動檢查是否有新的要求(例: 更新事件、送出資料),
+   /// 所以要求者不用透過 eventfd 喚醒 io thread, 可省去要求者及 io thread 的 system call.
+   /// 適用於: 獨占 cpu(搭配 Cpus 設定), 且追求最低延遲的連線.
+   Spin,
 };
 inline bool IsBlockWait(HowWait value) {
    return value <= HowWait::Block;
@@ -24,8 +29,21 @@ fon9_API HowWait StrToHowWait(StrView value);
 fon9_API StrView HowWaitToStr(HowWait value);
 
 /// \ingroup io
-/// args: "ThreadCount=n|Wait=Policy|Cpus=List|Capacity=0"
-/// Policy: Block(default)
+/// 使用哪種 io service 實作.
+/// - Default: 由 OS 決定, 例如: Linux = Epoll; Windows = Iocp;
+/// - IoUring: Linux 5.1 以上才支援, 若無法使用, 則在建立 service 時會傳回失敗.
+enum class IoServiceKind {
+   Default,
+   Epoll,
+   IoUring,
+};
+fon9_API IoServiceKind StrToIoServiceKind(StrView value);
+fon9_API StrView IoServiceKindToStr(IoServiceKind value);
+
+/// \ingroup io
+/// args: "ThreadCount=n|Wait=Policy|Cpus=List|Capacity=0|Service=Kind|RecvRing=0|RecvRingBuf=16384|BusyPoll=0|LoopHist=N"
+/// Policy: Block(default), Yield, Busy, Spin
+/// Kind: Default, Epoll, IoUring
 struct fon9_API IoServiceArgs {
    /// 若有設定 CpuAffinity, 則每個 io service thread 會綁定一個固定的 cpu, 而不是所有的 thread 共用這裡設定的 cpu.
    /// 例如: ThreadCount_=3; CpuAffinity=0,1;
@@ -34,13 +52,33 @@ struct fon9_API IoServiceArgs {
    using CpuAffinity = std::vector<uint32_t>;
    CpuAffinity CpuAffinity_;
 
-   uint32_t ThreadCount_{2};
-   HowWait  HowWait_{HowWait::Block};
+   uint32_t       ThreadCount_{2};
+   HowWait        HowWait_{HowWait::Block};
+   IoServiceKind  ServiceKind_{IoServiceKind::Default};
 
    /// 每個 io service thread 可服務的容量, 例如: MaxConnections.
    /// 0 = 由 io service 自行決定最佳值.
    size_t   Capacity_{0};
 
+   /// 每個 io service thread 預先提供給 kernel 的接收緩衝數量.
+   /// - 目前僅 IoServiceKind::IoUring 支援: 使用 multishot recv + provided buffer ring.
+   /// - 0 = 不使用, 由 FdrSocket 在 readable 時自行 read().
+   uint32_t RecvRingCount_{0};
+   /// RecvRing 每個接收緩衝的大小(包含 BufferNode 的額外空間), 會調整成 MemBlock 的等級(1K, 4K, 16K, 64K).
+   /// - 若用於 datagram(例: FdrDgram), 大於此值的 datagram 會被截斷, 此時應設定較大的值.
+   uint32_t RecvRingBufSize_{1024 * 16};
+
+   /// 讓 kernel 在等候事件時, 直接 busy poll 網卡的接收佇列(NAPI), 最多 BusyPollUs_ 微秒.
+   /// - 目前僅 IoServiceKind::Epoll 支援: 使用 ioctl(EPIOCSPARAMS), 需要 Linux 6.9+;
+   ///   若 kernel 不支援, 僅記錄 log, 不影響 service 的建立.
+   /// - 單一 socket 的設定, 請參考 SocketOptions::BusyPollUs_;
+   /// - 0 = 不使用(由系統設定 net.core.busy_poll 決定).
+   uint32_t BusyPollUs_{0};
+
+   /// 是否記錄每個 io thread 每次迴圈「處理事件」的耗時, 可透過 FdrThread::GetLoopHist() 取得.
+   /// thread 結束時, 也會將統計結果寫入 log.
+   bool     IsLoopHist_{false};
+
    IoServiceArgs() = default;
 
    int GetCpuAffinity(size_t threadPoolIndex) const {
@@ -54,8 +92,13 @@ struct fon9_API IoServiceArgs {
    /// ------------|------------------------------
    /// ThreadCount | > 0
    /// Capacity    | >= 0
-   /// Wait        | "Block" or "Busy" or "Yield"
+   /// Wait        | "Block" or "Busy" or "Yield" or "Spin"
    /// Cpus        | c0, c1, c2 ... 根據 thread pool index 依序選擇 c0 或 c1 或 c2...
+   /// Service     | "Default" or "Epoll" or "IoUring"
+   /// RecvRing    | >= 0, 會調整成 2 的 n 次方, 最多 32768.
+   /// RecvRingBuf | 1024..65536, 可使用 k=*1024, 例: 16k
+   /// BusyPoll    | >= 0, 微秒.
+   /// LoopHist    | "Y" or "N"
    ConfigParser::Result OnTagValue(StrView tag, StrView& value);
 };
 
@@ -67,6 +110,8 @@ struct fon9_API ServiceThreadArgs {
    int         CpuAffinity_;
    HowWait     HowWait_;
    size_t      Capacity_;
+   uint32_t    BusyPollUs_;
+   bool        IsLoopHist_;
 
    ServiceThreadArgs() = default;
    ServiceThreadArgs(const IoServiceArgs& ioArgs, const std::string& name, size_t index)
@@ -74,7 +119,9 @@ struct fon9_API ServiceThreadArgs {
       , ThreadPoolIndex_{index}
       , CpuAffinity_{ioArgs.GetCpuAffinity(index)}
       , HowWait_{ioArgs.HowWait_}
-      , Capacity_{ioArgs.Capacity_} {
+      , Capacity_{ioArgs.Capacity_}
+      , BusyPollUs_{ioArgs.BusyPollUs_}
+      , IsLoopHist_{ioArgs.IsLoopHist_} {
    }
 
    /// - 透過 fon9_LOG_ThrRun(msgHead, ".ThrRun|name=", this->Name_...) 記錄 log.
@@ -5,6 +5,7 @@
 #include "fon9/io/IoBase.hpp"
 #include "fon9/buffer/DcQueueList.hpp"
 #include "fon9/buffer/FwdBufferList.hpp"
+#include "fon9/TimeStamp.hpp"
 
 namespace fon9 { namespace io {
 
@@ -32,6 +33,7 @@ class fon9_API RecvBuffer {
    FwdBufferNode*    NodeBack_{nullptr};
    FwdBufferNode*    NodeReserve_{nullptr};
    RecvBufferState   State_{RecvBufferState::NotInUse};
+   TimeStamp         RecvTime_{TimeStamp::Null()};
 
    FwdBufferNode* AllocReserve(size_t expectSize);
 
@@ -88,6 +90,15 @@ public:
    /// 當資料接收完成, 透過這裡設定接收到的資料量, 然後進入 RecvBufferState::InvokingEvent 狀態.
    /// \return 存放接收資料的 DcQueueList.
    DcQueueList& SetDataReceived(size_t rxsz);
+   /// 資料已由其他方式(例: io_uring 的 provided buffer ring)填妥, 直接加入 Queue_,
+   /// 不用經過 GetRecvBlockVector(), 然後進入 RecvBufferState::InvokingEvent 狀態.
+   /// \return 存放接收資料的 DcQueueList.
+   DcQueueList& SetDataReceived(BufferList&& rxnodes) {
+      assert(this->State_ == RecvBufferState::NotInUse);
+      this->State_ = RecvBufferState::InvokingEvent;
+      this->Queue_.push_back(std::move(rxnodes));
+      return this->Queue_;
+   }
 
    /// 僅能在 OnDevice_Recv() 事件之後呼叫一次.
    void SetContinueRecv() {
@@ -100,6 +111,14 @@ public:
       this->State_ = RecvBufferState::WaitingEventInvoke;
    }
 
+   /// 由 Device 實作者設定: kernel(或網卡)提供的接收時間, 在 DeviceRecvBufferReady() 觸發事件前轉給 Device.
+   void SetRecvTime(TimeStamp tm) {
+      this->RecvTime_ = tm;
+   }
+   TimeStamp GetRecvTime() const {
+      return this->RecvTime_;
+   }
+
    bool IsInvokingEvent() const {
       return(this->State_ >= RecvBufferState::InvokingEvent);
    }
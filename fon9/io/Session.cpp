@@ -29,6 +29,12 @@ RecvBufferSize Session::OnDevice_Recv(Device& dev, DcQueueList& rxbuf) {
 void Session::OnDevice_CommonTimer(Device& dev, TimeStamp now) {
    (void)dev; (void)now;
 }
+TimerThread& Session::GetDeviceTimerThread() {
+   return GetDefaultTimerThread();
+}
+int Session::GetDeviceIoThreadIndex() {
+   return -1;
+}
 //void Session::OnDevice_SendBufferEmpty(Device& dev) {
 //   (void)dev;
 //}
@@ -4,7 +4,7 @@
 #define __fon9_io_Session_hpp__
 #include "fon9/io/IoBase.hpp"
 #include "fon9/buffer/DcQueueList.hpp"
-#include "fon9/TimeStamp.hpp"
+#include "fon9/Timer.hpp"
 
 namespace fon9 { namespace io {
 
@@ -120,6 +120,15 @@ public:
    /// 如果需要 op safe, 則必須自行使用 dev.OpQueue_ 來處理.
    virtual void OnDevice_CommonTimer(Device& dev, TimeStamp now);
 
+   /// Device 建構時, 透過這裡取得 Device::CommonTimer_ 使用的 TimerThread.
+   /// 預設: GetDefaultTimerThread();
+   /// 若有大量的 Device 需要經常重設計時器, 可改用 GetDefaultWheelTimerThread();
+   virtual TimerThread& GetDeviceTimerThread();
+   /// Device 建立 io 資源時(例: 建立 FdrEventHandler), 透過這裡取得偏好的 io thread 索引.
+   /// 預設: -1, 由 IoService 自行分配(例: FdrService 使用 fd % threadCount).
+   /// 可讓 session 的 io 事件固定在某個 thread, 請參考 fix::FixShardMgr.
+   virtual int GetDeviceIoThreadIndex();
+
    /*
    幾經思考, 似乎已無必要提供此事件:
    因為可加入自訂的 BufferNodeVirtual，在消費到該節點時取得通知，執行必要的後續作業。
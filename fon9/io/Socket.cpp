@@ -10,6 +10,9 @@ fon9_BEFORE_INCLUDE_STD;
 #include <arpa/inet.h>
 #include <netinet/tcp.h>
 #include <signal.h>
+#ifdef __linux__
+#include <linux/net_tstamp.h>//SOF_TIMESTAMPING_*
+#endif
 /// 將 size_t size 轉成 static_cast<socklen_t>(size) 避免警告.
 #define inet_ntop(af,src,dst,size)  inet_ntop(af, src, dst, static_cast<socklen_t>(size))
 #endif
@@ -189,6 +192,22 @@ bool Socket::SetSocketOptions(const SocketOptions& opts, SocketResult& soRes) co
       #endif
       }
    }
+#ifdef __linux__
+   if (opts.BusyPollUs_ > 0) {
+      SetOpt(so, SOL_SOCKET, SO_BUSY_POLL, opts.BusyPollUs_, "BusyPoll", soRes);
+   #ifdef SO_PREFER_BUSY_POLL
+      int   preferBusyPoll = 1;
+      SetOpt(so, SOL_SOCKET, SO_PREFER_BUSY_POLL, preferBusyPoll, "BusyPoll.Prefer", soRes);
+   #endif
+   }
+   if (opts.RecvTimestamp_ == 1)
+      SetOpt(so, SOL_SOCKET, SO_TIMESTAMPNS, opts.RecvTimestamp_, "RecvTs.Sw", soRes);
+   else if (opts.RecvTimestamp_ > 1) {
+      int   tsFlags = SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE
+                    | SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+      SetOpt(so, SOL_SOCKET, SO_TIMESTAMPING, tsFlags, "RecvTs.Hw", soRes);
+   }
+#endif
    return soRes.IsSuccess();
 }
 
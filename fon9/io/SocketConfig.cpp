@@ -55,6 +55,15 @@ ConfigParser::Result SocketOptions::OnTagValue(StrView tag, StrView& value) {
    }
    else if (tag == "KeepAlive")
       this->KeepAliveInterval_ = StrTo(value, int{});
+   else if (tag == "BusyPoll")
+      this->BusyPollUs_ = StrTo(value, int{});
+   else if (tag == "RecvTs") {
+      switch (toupper(static_cast<unsigned char>(value.Get1st()))) {
+      case 'S': this->RecvTimestamp_ = 1; break;
+      case 'H': this->RecvTimestamp_ = 2; break;
+      default:  this->RecvTimestamp_ = 0; break;
+      }
+   }
    else
       return ConfigParser::Result::EUnknownTag;
    return ConfigParser::Result::Success;
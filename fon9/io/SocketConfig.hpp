@@ -40,6 +40,22 @@ struct fon9_API SocketOptions {
    /// - >1:  TCP_KEEPIDLE,TCP_KEEPINTVL 的間隔秒數, 此時 TCP_KEEPCNT 一律設為 3.
    int KeepAliveInterval_;
 
+   /// 使用 "RecvTs=Sw" 或 "RecvTs=Hw" 設定: 由 kernel(或網卡)提供收到資料的時間 (目前僅 Linux 支援).
+   /// 在 Session 收到資料時, 可透過 Device::GetRecvTime() 取得, 不用每次自行取得系統時間.
+   /// - 0: 不使用(預設).
+   /// - 1 = "Sw": SO_TIMESTAMPNS, kernel 收到封包的時間.
+   /// - 2 = "Hw": SO_TIMESTAMPING, 優先使用網卡的硬體時間, 若網卡沒有提供, 則使用 kernel 收到封包的時間.
+   ///   網卡必須另外啟用 hardware timestamp(SIOCSHWTSTAMP, 例: `hwstamp_ctl -i eth0 -r 1`),
+   ///   且網卡時鐘(PHC)應與系統時間同步(例: phc2sys), 才能與 UtcNow() 比較.
+   int RecvTimestamp_;
+
+   /// 使用 "BusyPoll=us" 設定 (目前僅 Linux 支援):
+   /// SO_BUSY_POLL=us 及 SO_PREFER_BUSY_POLL=1, 讓 kernel 在此 socket 沒資料時, 直接 busy poll 網卡的接收佇列.
+   /// - 若 us 大於系統設定(net.core.busy_read), 則需要 CAP_NET_ADMIN 權限, 否則開啟 socket 會失敗.
+   /// - 使用 epoll 時, 另可參考 IoServiceArgs::BusyPollUs_;
+   /// - 0 = 不使用(預設).
+   int BusyPollUs_;
+
    void SetDefaults();
 
    ConfigParser::Result OnTagValue(StrView tag, StrView& value);
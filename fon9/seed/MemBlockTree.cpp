@@ -0,0 +1,221 @@
+﻿// \file fon9/seed/MemBlockTree.cpp
+// \author fonwinz@gmail.com
+#include "fon9/seed/MemBlockTree.hpp"
+#include "fon9/seed/FieldMaker.hpp"
+#include "fon9/seed/PodOp.hpp"
+#include "fon9/buffer/MemBlockImpl.hpp"
+#include "fon9/StrTo.hpp"
+#include <algorithm>
+
+namespace fon9 { namespace seed {
+
+/// 有訂閱時的通知間隔.
+static const TimeInterval  kMemBlockTree_NotifyInterval{TimeInterval_Second(1)};
+
+using HitRate = Decimal<uint32_t, 2>;
+static HitRate CalcHitRate(uint64_t hitCount, uint64_t allocCount) {
+   HitRate retval;
+   retval.Assign<2>(allocCount ? (hitCount * 10000 / allocCount) : 0u);
+   return retval;
+}
+
+fon9_WARN_DISABLE_PADDING;
+fon9_MSC_WARN_DISABLE_NO_PUSH(4265 /* class has virtual functions, but destructor is not virtual. */);
+/// 唯讀的統計表: 每次操作時透過 FnSnapshot_ 取得一份(依照 key 排序的)快照, 所以不用 lock.
+/// Rec 必須提供 uint64_t GetKey() const;
+template <class Rec>
+class MemBlockStatTree : public Tree {
+   fon9_NON_COPY_NON_MOVE(MemBlockStatTree);
+   using base = Tree;
+   using Recs = std::vector<Rec>;
+   using FnSnapshot = void (*)(Recs& recs);
+   const FnSnapshot  FnSnapshot_;
+   SeedSubj          Subj_;
+
+   static void EmitOnTimer(TimerEntry* timer, TimeStamp) {
+      MemBlockStatTree& rthis = ContainerOf(*static_cast<decltype(MemBlockStatTree::Timer_)*>(timer), &MemBlockStatTree::Timer_);
+      if (rthis.Subj_.IsEmpty())
+         return;
+      SeedSubj_TableChanged(rthis.Subj_, rthis, *rthis.LayoutSP_->GetTab(0));
+      timer->RunAfter(kMemBlockTree_NotifyInterval);
+   }
+   DataMemberEmitOnTimer<&MemBlockStatTree::EmitOnTimer> Timer_;
+
+   static typename Recs::iterator LowerBound(Recs& recs, StrView keyText) {
+      if (IsTextBegin(keyText))
+         return recs.begin();
+      if (IsTextEnd(keyText))
+         return recs.end();
+      const uint64_t key = StrTo(keyText, uint64_t{0});
+      return std::lower_bound(recs.begin(), recs.end(), key, [](const Rec& rec, uint64_t k) {
+         return rec.GetKey() < k;
+      });
+   }
+
+   struct TreeOp : public seed::TreeOp {
+      fon9_NON_COPY_NON_MOVE(TreeOp);
+      using base = seed::TreeOp;
+      TreeOp(MemBlockStatTree& tree) : base{tree} {
+      }
+      static void MakeRowView(typename Recs::iterator ivalue, Tab* tab, RevBuffer& rbuf) {
+         if (tab)
+            FieldsCellRevPrint(tab->Fields_, SimpleRawRd{*ivalue}, rbuf, GridViewResult::kCellSplitter);
+         RevPrint(rbuf, ivalue->GetKey());
+      }
+      void GridView(const GridViewRequest& req, FnGridViewOp fnCallback) override {
+         Recs recs;
+         static_cast<MemBlockStatTree*>(&this->Tree_)->FnSnapshot_(recs);
+         GridViewResult res{this->Tree_, req.Tab_};
+         MakeGridView(recs, LowerBound(recs, req.OrigKey_), req, res, &MakeRowView);
+         fnCallback(res);
+      }
+      void Get(StrView strKeyText, FnPodOp fnCallback) override {
+         Recs recs;
+         static_cast<MemBlockStatTree*>(&this->Tree_)->FnSnapshot_(recs);
+         auto ifind = LowerBound(recs, strKeyText);
+         if (ifind == recs.end()
+             || (!IsTextBegin(strKeyText) && ifind->GetKey() != StrTo(strKeyText, uint64_t{0})))
+            fnCallback(PodOpResult{this->Tree_, OpResult::not_found_key, strKeyText}, nullptr);
+         else {
+            PodOpReadonly<Rec> op{*ifind, this->Tree_, strKeyText};
+            fnCallback(op, &op);
+         }
+      }
+      OpResult Subscribe(SubConn* pSubConn, Tab& tab, SeedSubr subr) override {
+         (void)tab; assert(&tab == this->Tree_.LayoutSP_->GetTab(0));
+         MemBlockStatTree& tree = *static_cast<MemBlockStatTree*>(&this->Tree_);
+         *pSubConn = tree.Subj_.Subscribe(subr);
+         if (tree.Subj_.GetSubscriberCount() == 1)
+            tree.Timer_.RunAfter(kMemBlockTree_NotifyInterval);
+         return OpResult::no_error;
+      }
+      OpResult Unsubscribe(SubConn pSubConn) override {
+         static_cast<MemBlockStatTree*>(&this->Tree_)->Subj_.Unsubscribe(pSubConn);
+         return OpResult::no_error;
+      }
+   };
+
+public:
+   MemBlockStatTree(LayoutSP layout, FnSnapshot fnSnapshot)
+      : base{std::move(layout)}
+      , FnSnapshot_{fnSnapshot} {
+   }
+   ~MemBlockStatTree() {
+      this->Timer_.DisposeAndWait();
+   }
+   void OnTreeOp(FnTreeOp fnCallback) override {
+      TreeOp op{*this};
+      fnCallback(TreeOpResult{this, OpResult::no_error}, &op);
+   }
+   void OnParentSeedClear() override {
+      SeedSubj_ParentSeedClear(this->Subj_, *this);
+   }
+};
+fon9_WARN_POP;
+
+//--------------------------------------------------------------------------//
+
+struct MemBlockLevelRec {
+   impl::MemBlockLevelStat Stat_;
+   HitRate                 HitRate_;
+   uint64_t                TCacheHeldBytes_;
+   uint64_t GetKey() const {
+      return this->Stat_.BlockSize_;
+   }
+};
+static void MemBlockLevelsSnapshot(std::vector<MemBlockLevelRec>& recs) {
+   impl::MemBlockLevelStats stats;
+   impl::MemBlockGetLevelStats(stats);
+   recs.resize(stats.size());
+   auto irec = recs.begin();
+   for (const impl::MemBlockLevelStat& st : stats) {
+      irec->Stat_ = st;
+      irec->HitRate_ = CalcHitRate(st.HitCount_, st.AllocCount_);
+      irec->TCacheHeldBytes_ = st.TCacheHeldCount_ * st.BlockSize_;
+      ++irec;
+   }
+}
+static LayoutSP MakeMemBlockLevelsLayout() {
+   Fields flds;
+   flds.Add(fon9_MakeField_const(Named{"AllocCount"}, MemBlockLevelRec, Stat_.AllocCount_));
+   flds.Add(fon9_MakeField_const(Named("HitCount", "", "直接從 TCache 取得的次數"), MemBlockLevelRec, Stat_.HitCount_));
+   flds.Add(fon9_MakeField_const(Named("HitRate", "Hit%"), MemBlockLevelRec, HitRate_));
+   flds.Add(fon9_MakeField_const(Named("CenterCount", "", "TCache 用完, 從 MemBlockCenter 取得一個串列的次數"), MemBlockLevelRec, Stat_.CenterCount_));
+   flds.Add(fon9_MakeField_const(Named("EmptyCount", "", "MemBlockCenter 也用完, 改用 malloc() 的次數"), MemBlockLevelRec, Stat_.EmptyCount_));
+   flds.Add(fon9_MakeField_const(Named{"FreeCount"}, MemBlockLevelRec, Stat_.FreeCount_));
+   flds.Add(fon9_MakeField_const(Named{"InUse"}, MemBlockLevelRec, Stat_.InUseCount_));
+   flds.Add(fon9_MakeField_const(Named{"InUseHighWater"}, MemBlockLevelRec, Stat_.InUseHighWater_));
+   flds.Add(fon9_MakeField_const(Named("TCacheHeld", "", "全部 thread 的 TCache 保留的區塊數量"), MemBlockLevelRec, Stat_.TCacheHeldCount_));
+   flds.Add(fon9_MakeField_const(Named{"TCacheHeldBytes"}, MemBlockLevelRec, TCacheHeldBytes_));
+   flds.Add(fon9_MakeField_const(Named("CenterReserved", "", "MemBlockCenter 保留的串列數量"), MemBlockLevelRec, Stat_.CenterReservedLists_));
+   flds.Add(fon9_MakeField_const(Named("ReservedCount", "", "MemBlockInit() 設定的最少保留串列數量"), MemBlockLevelRec, Stat_.CenterReservedCount_));
+   flds.Add(fon9_MakeField_const(Named("RequiredCount", "", "使用此 level 的 thread 數量"), MemBlockLevelRec, Stat_.CenterRequiredCount_));
+   flds.Add(fon9_MakeField_const(Named("MaxNodeCount", "", "每個串列最多的區塊數量"), MemBlockLevelRec, Stat_.MaxNodeCount_));
+   return new Layout1(fon9_MakeField_const(Named{"BlockSize"}, MemBlockLevelRec, Stat_.BlockSize_),
+                      new Tab{Named{"Levels"}, std::move(flds), TabFlag::NoSapling | TabFlag::NoSeedCommand});
+}
+
+//--------------------------------------------------------------------------//
+
+struct MemBlockThreadRec {
+   ThreadId::IdType              ThreadId_;
+   uint32_t                      NodeId_;
+   impl::MemBlockThreadLevelStat Sum_;
+   uint64_t                      HitCount_;
+   HitRate                       HitRate_;
+   uint64_t                      HeldBytes_;
+   uint64_t GetKey() const {
+      return this->ThreadId_;
+   }
+};
+static void MemBlockThreadsSnapshot(std::vector<MemBlockThreadRec>& recs) {
+   impl::MemBlockThreadStats stats;
+   impl::MemBlockGetThreadStats(stats);
+   recs.resize(stats.size());
+   auto irec = recs.begin();
+   for (const impl::MemBlockThreadStat& st : stats) {
+      MemBlockThreadRec& rec = *irec++;
+      rec.ThreadId_ = st.ThreadId_;
+      rec.NodeId_ = st.NodeId_;
+      rec.Sum_ = impl::MemBlockThreadLevelStat{};
+      rec.HeldBytes_ = 0;
+      for (unsigned lvidx = 0; lvidx < kMemBlockLevelCount; ++lvidx) {
+         const impl::MemBlockThreadLevelStat& lv = st.Levels_[lvidx];
+         rec.Sum_.AllocCount_ += lv.AllocCount_;
+         rec.Sum_.CenterCount_ += lv.CenterCount_;
+         rec.Sum_.EmptyCount_ += lv.EmptyCount_;
+         rec.Sum_.FreeCount_ += lv.FreeCount_;
+         rec.Sum_.HeldCount_ += lv.HeldCount_;
+         rec.HeldBytes_ += lv.HeldCount_ * MemBlockLevelSize_[lvidx];
+      }
+      rec.HitCount_ = rec.Sum_.AllocCount_ - rec.Sum_.CenterCount_ - rec.Sum_.EmptyCount_;
+      rec.HitRate_ = CalcHitRate(rec.HitCount_, rec.Sum_.AllocCount_);
+   }
+}
+static LayoutSP MakeMemBlockThreadsLayout() {
+   Fields flds;
+   flds.Add(fon9_MakeField_const(Named{"NodeId"}, MemBlockThreadRec, NodeId_));
+   flds.Add(fon9_MakeField_const(Named{"AllocCount"}, MemBlockThreadRec, Sum_.AllocCount_));
+   flds.Add(fon9_MakeField_const(Named{"HitCount"}, MemBlockThreadRec, HitCount_));
+   flds.Add(fon9_MakeField_const(Named("HitRate", "Hit%"), MemBlockThreadRec, HitRate_));
+   flds.Add(fon9_MakeField_const(Named{"CenterCount"}, MemBlockThreadRec, Sum_.CenterCount_));
+   flds.Add(fon9_MakeField_const(Named{"EmptyCount"}, MemBlockThreadRec, Sum_.EmptyCount_));
+   flds.Add(fon9_MakeField_const(Named{"FreeCount"}, MemBlockThreadRec, Sum_.FreeCount_));
+   flds.Add(fon9_MakeField_const(Named{"TCacheHeld"}, MemBlockThreadRec, Sum_.HeldCount_));
+   flds.Add(fon9_MakeField_const(Named{"TCacheHeldBytes"}, MemBlockThreadRec, HeldBytes_));
+   return new Layout1(fon9_MakeField_const(Named{"ThreadId"}, MemBlockThreadRec, ThreadId_),
+                      new Tab{Named{"Threads"}, std::move(flds), TabFlag::NoSapling | TabFlag::NoSeedCommand});
+}
+
+//--------------------------------------------------------------------------//
+
+TreeSP MemBlockTree::MakeSapling() {
+   MaTreeSP ma{new MaTree{"MemBlock"}};
+   ma->Add(new NamedSapling(new MemBlockStatTree<MemBlockLevelRec>{MakeMemBlockLevelsLayout(), &MemBlockLevelsSnapshot},
+                            "Levels", "Statistics per block size"));
+   ma->Add(new NamedSapling(new MemBlockStatTree<MemBlockThreadRec>{MakeMemBlockThreadsLayout(), &MemBlockThreadsSnapshot},
+                            "Threads", "Statistics per thread"));
+   return ma;
+}
+
+} } // namespaces
@@ -0,0 +1,38 @@
+﻿/// \file fon9/seed/MemBlockTree.hpp
+/// \author fonwinz@gmail.com
+#ifndef __fon9_seed_MemBlockTree_hpp__
+#define __fon9_seed_MemBlockTree_hpp__
+#include "fon9/seed/MaTree.hpp"
+
+namespace fon9 { namespace seed {
+
+class fon9_API MemBlockTree;
+using MemBlockTreeSP = NamedSeedSPT<MemBlockTree>;
+
+/// \ingroup seed
+/// 提供 MemBlock 的使用統計(唯讀), 可用來評估 MemBlockInit() 的保留數量.
+/// - 底下有 2 個 tree:
+///   - "Levels":  每個 level 一筆, key = 區塊大小.
+///   - "Threads": 每個使用 MemBlock 且尚未結束的 thread 一筆, key = ThreadId.
+/// - 每次查詢時取得最新的統計.
+/// - 有訂閱時, 每秒通知一次 TableChanged.
+class fon9_API MemBlockTree : public NamedSapling {
+   fon9_NON_COPY_NON_MOVE(MemBlockTree);
+   using base = NamedSapling;
+   static TreeSP MakeSapling();
+public:
+   MemBlockTree(const MaTree* /*maTree*/, std::string name)
+      : base(MakeSapling(), std::move(name)) {
+      this->SetTitle("MemBlock statistics");
+   }
+   #define fon9_kCSTR_MemBlockTree_DefaultName  "MemBlock"
+   /// 在 maTree 上面種一個 MemBlockTree.
+   /// \retval nullptr   seedName已存在.
+   /// \retval !=nullptr 種到 maTree 的 MemBlockTree 物件.
+   static MemBlockTreeSP Plant(const MaTreeSP& maTree, std::string seedName = fon9_kCSTR_MemBlockTree_DefaultName) {
+      return maTree->Plant<MemBlockTree>("MemBlockTree.Plant", std::move(seedName));
+   }
+};
+
+} } // namespaces
+#endif//__fon9_seed_MemBlockTree_hpp__
@@ -68,6 +68,13 @@ static File::Result OpenFileFD(FdrAuto& fd, const std::string& fname, FileMode f
       oflag |= O_TRUNC;
    if (IsEnumContains(fmode, FileMode::WriteThrough))
       oflag |= O_DSYNC;
+   if (IsEnumContains(fmode, FileMode::DirectIO)) {
+#ifdef O_DIRECT
+      oflag |= O_DIRECT;
+#else
+      return File::Result{std::errc::not_supported};
+#endif
+   }
    if (IsEnumContains(fmode, FileMode::MustNew))
       oflag |= O_CREAT | O_EXCL;
    else
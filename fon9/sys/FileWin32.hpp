@@ -156,6 +156,8 @@ static File::Result OpenFileFD(FdrAuto& fd, const std::string& fname, FileMode f
    DWORD flagsAndAttributes = FILE_ATTRIBUTE_NORMAL;
    if (IsEnumContains(fmode, FileMode::WriteThrough))
       flagsAndAttributes |= FILE_FLAG_WRITE_THROUGH;
+   if (IsEnumContains(fmode, FileMode::DirectIO))
+      flagsAndAttributes |= FILE_FLAG_NO_BUFFERING;
 
    struct stat fst;
    if (creationDisposition == TRUNCATE_EXISTING && desiredAccess == FILE_APPEND_DATA) {